@@ -0,0 +1 @@
+../src/merkle.c
\ No newline at end of file
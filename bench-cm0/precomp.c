@@ -0,0 +1 @@
+../src/precomp.c
\ No newline at end of file
@@ -0,0 +1 @@
+../src/batch.c
\ No newline at end of file
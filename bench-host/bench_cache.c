@@ -0,0 +1,268 @@
+/*
+ * Cache-sensitivity benchmark.
+ *
+ * Microbenchmark loops keep the code and the tables (e.g. the windows
+ * for G used by curve9767_point_mulgen(), or the large generator table)
+ * in the caches, which is not representative of services where curve
+ * operations are interleaved with unrelated work. This program measures
+ * the latency of generator multiplication, point multiplication and
+ * signature generation in several modes:
+ *
+ *   first     first call after process start (mulgen, then mul, then
+ *             sign; later operations find the shared code partially
+ *             warmed up by the earlier ones)
+ *   warm      back-to-back calls (usual microbenchmark)
+ *   cold      a large buffer is streamed through the caches before each
+ *             call (not included in the measured time), which evicts
+ *             the tables and the code from the data and unified caches
+ *   neighbour back-to-back calls while another thread continuously
+ *             streams its own large buffer (co-located cache-thrashing
+ *             tenant; use taskset to choose which cores are shared)
+ *
+ * For each operation and mode, the median, 90th and 99th percentile
+ * latencies are reported. With -g, the large generator table is built
+ * (after the first-call measurements) and used by the generator
+ * multiplications and signatures.
+ *
+ * Usage: bench_cache [ -n iterations ] [ -e megabytes ] [ -g ]
+ * The default is 1000 iterations and a 64 MB eviction buffer.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "curve9767.h"
+
+#define OP_MULGEN   0
+#define OP_MUL      1
+#define OP_SIGN     2
+
+static const char *const op_names[] = { "mulgen", "mul", "sign" };
+
+static curve9767_gtable gt;
+
+static curve9767_scalar sk;
+static uint8_t sk_t[32];
+static curve9767_point pk;
+static uint8_t hv[32];
+
+static unsigned char *evict_buf;
+static size_t evict_len;
+static atomic_int neighbour_stop;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/*
+ * Read and write one byte per 64-byte line of a buffer, so that the
+ * lines are loaded (in exclusive state) into the caches, evicting
+ * everything else. The returned value keeps the reads alive.
+ */
+static unsigned
+stream_buffer(unsigned char *buf, size_t len)
+{
+	unsigned acc;
+	size_t u;
+
+	acc = 0;
+	for (u = 0; u < len; u += 64) {
+		acc += buf[u];
+		buf[u] = (unsigned char)(acc + u);
+	}
+	return acc;
+}
+
+static void *
+neighbour(void *arg)
+{
+	unsigned char *buf;
+	volatile unsigned sink;
+
+	buf = malloc(evict_len);
+	if (buf == NULL) {
+		fprintf(stderr, "malloc() failed\n");
+		exit(EXIT_FAILURE);
+	}
+	memset(buf, 0, evict_len);
+	sink = 0;
+	while (!atomic_load(&neighbour_stop)) {
+		sink += stream_buffer(buf, evict_len);
+	}
+	(void)sink;
+	free(buf);
+	return arg;
+}
+
+/*
+ * Run one operation. Each call uses the output of the previous one, so
+ * that calls cannot be optimized away or overlapped.
+ */
+static void
+run_op(int op, curve9767_scalar *s, curve9767_point *Q)
+{
+	uint8_t tmp[64];
+
+	switch (op) {
+	case OP_MULGEN:
+		curve9767_point_mulgen(Q, s);
+		curve9767_point_encode(tmp, Q);
+		curve9767_scalar_decode_reduce(s, tmp, 32);
+		break;
+	case OP_MUL:
+		curve9767_point_mul(Q, Q, s);
+		curve9767_point_encode(tmp, Q);
+		curve9767_scalar_decode_reduce(s, tmp, 32);
+		break;
+	default:
+		curve9767_sign_generate(tmp, &sk, sk_t, &pk,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv);
+		memcpy(hv, tmp, sizeof hv);
+		break;
+	}
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+	double x, y;
+
+	x = *(const double *)a;
+	y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * Measure num calls of an operation; if cold is non-zero, the caches
+ * are flushed (by streaming the eviction buffer) before each call.
+ * Percentiles are printed, in microseconds.
+ */
+static void
+bench_op(int op, const char *mode, long num, int cold, double *t)
+{
+	curve9767_scalar s;
+	curve9767_point Q;
+	volatile unsigned sink;
+	uint8_t tmp[32];
+	long i;
+
+	memset(tmp, 0x5A, sizeof tmp);
+	curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+	curve9767_point_mulgen(&Q, &s);
+	sink = 0;
+	for (i = 0; i < num; i ++) {
+		double t0;
+
+		if (cold) {
+			sink += stream_buffer(evict_buf, evict_len);
+		}
+		t0 = now();
+		run_op(op, &s, &Q);
+		t[i] = now() - t0;
+	}
+	(void)sink;
+	qsort(t, (size_t)num, sizeof *t, cmp_double);
+	printf("%-7s %-10s %10.2f %10.2f %10.2f\n", op_names[op], mode,
+		t[num / 2] * 1000000.0,
+		t[(num * 9) / 10] * 1000000.0,
+		t[(num * 99) / 100] * 1000000.0);
+	fflush(stdout);
+}
+
+int
+main(int argc, char *argv[])
+{
+	double first[3], *t, t0;
+	curve9767_scalar s;
+	curve9767_point Q;
+	uint8_t tmp[32];
+	pthread_t th;
+	long num;
+	int i, op, use_gtable;
+
+	/*
+	 * First-call latency: nothing from the library must run before
+	 * these measurements (scalar decoding uses only scalar code).
+	 */
+	memset(tmp, 0x5A, sizeof tmp);
+	curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+	for (op = OP_MULGEN; op <= OP_MUL; op ++) {
+		t0 = now();
+		run_op(op, &s, &Q);
+		first[op] = now() - t0;
+	}
+	curve9767_keygen(&sk, sk_t, &pk, "bench_cache", 11);
+	memset(hv, 0xA5, sizeof hv);
+	t0 = now();
+	run_op(OP_SIGN, &s, &Q);
+	first[OP_SIGN] = now() - t0;
+
+	num = 1000;
+	evict_len = (size_t)64 << 20;
+	use_gtable = 0;
+	for (i = 1; i < argc; i ++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			num = strtol(argv[++ i], NULL, 10);
+		} else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+			evict_len = (size_t)strtol(argv[++ i], NULL, 10) << 20;
+		} else if (strcmp(argv[i], "-g") == 0) {
+			use_gtable = 1;
+		} else {
+			fprintf(stderr, "usage: bench_cache"
+				" [ -n iterations ] [ -e megabytes ] [ -g ]\n");
+			return EXIT_FAILURE;
+		}
+	}
+	if (num < 1 || evict_len == 0) {
+		fprintf(stderr, "invalid parameters\n");
+		return EXIT_FAILURE;
+	}
+	t = malloc((size_t)num * sizeof *t);
+	evict_buf = malloc(evict_len);
+	if (t == NULL || evict_buf == NULL) {
+		fprintf(stderr, "malloc() failed\n");
+		return EXIT_FAILURE;
+	}
+	memset(evict_buf, 0, evict_len);
+	if (use_gtable) {
+		curve9767_gtable_init(&gt);
+	}
+
+	printf("eviction buffer: %lu MB, iterations: %ld, gtable: %s\n",
+		(unsigned long)(evict_len >> 20), num,
+		use_gtable ? "yes" : "no");
+	printf("%-7s %-10s %10s %10s %10s   (us)\n",
+		"op", "mode", "median", "p90", "p99");
+	for (op = OP_MULGEN; op <= OP_SIGN; op ++) {
+		printf("%-7s %-10s %10.2f\n", op_names[op], "first",
+			first[op] * 1000000.0);
+	}
+	for (op = OP_MULGEN; op <= OP_SIGN; op ++) {
+		bench_op(op, "warm", num, 0, t);
+		bench_op(op, "cold", num, 1, t);
+	}
+
+	atomic_init(&neighbour_stop, 0);
+	if (pthread_create(&th, NULL, neighbour, NULL) != 0) {
+		fprintf(stderr, "pthread_create() failed\n");
+		return EXIT_FAILURE;
+	}
+	for (op = OP_MULGEN; op <= OP_SIGN; op ++) {
+		bench_op(op, "neighbour", num, 0, t);
+	}
+	atomic_store(&neighbour_stop, 1);
+	pthread_join(th, NULL);
+
+	free(t);
+	free(evict_buf);
+	return 0;
+}
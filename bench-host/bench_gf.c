@@ -0,0 +1,170 @@
+/*
+ * Field arithmetic benchmark.
+ *
+ * This measures multiplications and squarings in GF(9767^19), and some
+ * operations that use them (inversion, point doubling, point
+ * multiplication), as well as scalar multiplications (one at a time,
+ * and in batches, where four scalars are processed in parallel with
+ * SIMD intrinsics; the batch figure is per scalar). The Makefile builds
+ * two versions: bench_gf uses the default (integer) field
+ * multiplication, and bench_gf_fma uses the floating-point FMA
+ * multiplication (ops_ref.c compiled with CURVE9767_FMA=1; this
+ * requires a CPU with AVX2 and FMA).
+ *
+ * Each figure is the best average time over several runs.
+ *
+ * Usage: bench_gf
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "inner.h"
+
+#define NUM_RUNS   15
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/*
+ * Each benchmarked function performs 'num' operations, chained so that
+ * they cannot be optimized away or overlapped.
+ */
+
+static field_element fa, fb;
+static curve9767_point Q;
+static curve9767_scalar s;
+
+static void
+run_mul(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_inner_gf_mul(fa.v, fa.v, fb.v);
+	}
+}
+
+static void
+run_sqr(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_inner_gf_sqr(fa.v, fa.v);
+	}
+}
+
+static void
+run_inv(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_inner_gf_inv(fa.v, fa.v);
+	}
+}
+
+static void
+run_mul2k(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_point_mul2k(&Q, &Q, 5);
+	}
+}
+
+static void
+run_point_mul(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_point_mul(&Q, &Q, &s);
+	}
+}
+
+#define SBATCH   64
+
+static curve9767_scalar sb[SBATCH];
+
+static void
+run_scalar_mul(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_scalar_mul(&s, &s, &sb[i & (SBATCH - 1)]);
+	}
+}
+
+static void
+run_scalar_mul_batch(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i += SBATCH) {
+		curve9767_scalar_mul_batch(sb, sb, sb, SBATCH);
+	}
+}
+
+static void
+bench(const char *name, void (*fn)(long), long num, double scale,
+	const char *unit)
+{
+	double best;
+	int r;
+
+	fn(num / 10);
+	best = 0.0;
+	for (r = 0; r < NUM_RUNS; r ++) {
+		double t;
+
+		t = now();
+		fn(num);
+		t = (now() - t) / (double)num;
+		if (r == 0 || t < best) {
+			best = t;
+		}
+	}
+	printf("%-22s %10.2f %s\n", name, best * scale, unit);
+	fflush(stdout);
+}
+
+int
+main(void)
+{
+	uint8_t tmp[32];
+	int i;
+
+	for (i = 0; i < 32; i ++) {
+		tmp[i] = (uint8_t)(i * 37 + 11);
+	}
+	curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+	curve9767_point_mulgen(&Q, &s);
+	memcpy(fa.v, Q.x, sizeof Q.x);
+	memcpy(fb.v, Q.y, sizeof Q.y);
+	for (i = 0; i < SBATCH; i ++) {
+		tmp[0] = (uint8_t)i;
+		curve9767_scalar_decode_reduce(&sb[i], tmp, sizeof tmp);
+	}
+
+	bench("gf_mul", run_mul, 1000000, 1000000000.0, "ns");
+	bench("gf_sqr", run_sqr, 1000000, 1000000000.0, "ns");
+	bench("gf_inv", run_inv, 100000, 1000000000.0, "ns");
+	bench("point_mul2k (k = 5)", run_mul2k, 20000, 1000000000.0, "ns");
+	bench("point_mul", run_point_mul, 1000, 1000000.0, "us");
+	bench("scalar_mul", run_scalar_mul, 100000, 1000000000.0, "ns");
+	bench("scalar_mul_batch", run_scalar_mul_batch, 100032,
+		1000000000.0, "ns");
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Field multiplication kernel selection.
+ *
+ * This checks all kernels generated by extra/mkgfkernels.py (in
+ * gf_kernels.c) against curve9767_inner_gf_mul() and
+ * curve9767_inner_gf_sqr(), then measures them, along with the kernels
+ * of ops_ref.c ("builtin"). The fastest generated kernels are printed as
+ * the --select option for mkgfkernels.py, which produces src/gf_kernel.h
+ * (used by ops_ref.c when compiled with CURVE9767_GF_KERNEL=1).
+ *
+ * Each figure is the best average time over several runs. The Makefile
+ * target 'gfk' generates the kernels and builds this program; the target
+ * and number of accumulators may be set with GFK_FLAGS, e.g.:
+ *
+ *   make gfk GFK_FLAGS="--target x86-64"
+ *
+ * Usage: bench_gfk
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "inner.h"
+#include "gf_kernels.h"
+
+#define NUM_RUNS     15
+#define NUM_OPS      200000
+#define NUM_CHECKS   10000
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/*
+ * Small deterministic PRNG for test values (coefficients in 1..p).
+ */
+static uint32_t rng_state = 1;
+
+static void
+rand_fe(uint16_t *a)
+{
+	int i;
+
+	for (i = 0; i < 19; i ++) {
+		rng_state = rng_state * 1103515245u + 12345u;
+		a[i] = (uint16_t)(1 + ((rng_state >> 8) % 9767));
+	}
+}
+
+/*
+ * Check a kernel against the reference functions; this includes the
+ * extreme values (all coefficients equal to 1, or to p). Returned value
+ * is 1 on success, 0 on mismatch.
+ */
+static int
+check_kernel(const gf_kernel *k)
+{
+	field_element a, b, c1, c2;
+	int i, j;
+
+	for (i = 0; i < NUM_CHECKS; i ++) {
+		switch (i) {
+		case 0:
+			for (j = 0; j < 19; j ++) {
+				a.v[j] = 9767;
+				b.v[j] = 9767;
+			}
+			break;
+		case 1:
+			for (j = 0; j < 19; j ++) {
+				a.v[j] = 1;
+				b.v[j] = 9767;
+			}
+			break;
+		default:
+			rand_fe(a.v);
+			rand_fe(b.v);
+			break;
+		}
+		curve9767_inner_gf_mul(c1.v, a.v, b.v);
+		k->mul(c2.v, a.v, b.v);
+		if (memcmp(c1.v, c2.v, 19 * sizeof(uint16_t)) != 0) {
+			return 0;
+		}
+		curve9767_inner_gf_sqr(c1.v, a.v);
+		k->sqr(c2.v, a.v);
+		if (memcmp(c1.v, c2.v, 19 * sizeof(uint16_t)) != 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void
+builtin_mul(uint16_t *c, const uint16_t *a, const uint16_t *b)
+{
+	curve9767_inner_gf_mul(c, a, b);
+}
+
+static void
+builtin_sqr(uint16_t *c, const uint16_t *a)
+{
+	curve9767_inner_gf_sqr(c, a);
+}
+
+static const gf_kernel builtin = { "builtin", builtin_mul, builtin_sqr };
+
+/*
+ * Return the best time per operation (in nanoseconds) for a kernel
+ * (squaring if sqr is non-zero, multiplication otherwise). Operations
+ * are chained so that they cannot be optimized away or overlapped.
+ */
+static double
+bench_kernel(const gf_kernel *k, int sqr)
+{
+	field_element a, b;
+	double best;
+	int r;
+
+	rand_fe(a.v);
+	rand_fe(b.v);
+	best = 0.0;
+	for (r = 0; r < NUM_RUNS; r ++) {
+		double t;
+		long i;
+
+		t = now();
+		if (sqr) {
+			for (i = 0; i < NUM_OPS; i ++) {
+				k->sqr(a.v, a.v);
+			}
+		} else {
+			for (i = 0; i < NUM_OPS; i ++) {
+				k->mul(a.v, a.v, b.v);
+			}
+		}
+		t = (now() - t) / (double)NUM_OPS;
+		if (r == 0 || t < best) {
+			best = t;
+		}
+	}
+	if (a.v[0] == 0) {
+		/* Never happens; this keeps the result alive. */
+		printf("?\n");
+	}
+	return best * 1000000000.0;
+}
+
+int
+main(void)
+{
+	const gf_kernel *k, *best_mul, *best_sqr;
+	double tm, ts, bm, bs;
+	int err;
+
+	printf("kernels: %s\n", gf_kernel_target);
+	printf("%-10s %10s %10s\n", "kernel", "mul (ns)", "sqr (ns)");
+	tm = bench_kernel(&builtin, 0);
+	ts = bench_kernel(&builtin, 1);
+	printf("%-10s %10.2f %10.2f\n", builtin.name, tm, ts);
+	fflush(stdout);
+
+	err = 0;
+	best_mul = NULL;
+	best_sqr = NULL;
+	bm = 0.0;
+	bs = 0.0;
+	for (k = gf_kernel_table; k->name != NULL; k ++) {
+		if (!check_kernel(k)) {
+			printf("%-10s MISMATCH\n", k->name);
+			err = 1;
+			continue;
+		}
+		tm = bench_kernel(k, 0);
+		ts = bench_kernel(k, 1);
+		printf("%-10s %10.2f %10.2f\n", k->name, tm, ts);
+		fflush(stdout);
+		if (best_mul == NULL || tm < bm) {
+			best_mul = k;
+			bm = tm;
+		}
+		if (best_sqr == NULL || ts < bs) {
+			best_sqr = k;
+			bs = ts;
+		}
+	}
+	if (best_mul != NULL) {
+		printf("fastest: --select mul=%s,sqr=%s\n",
+			best_mul->name, best_sqr->name);
+	}
+	return err;
+}
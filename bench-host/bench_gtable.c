@@ -0,0 +1,163 @@
+/*
+ * Large generator table benchmark.
+ *
+ * This simulates a service that starts computing generator
+ * multiplications ("requests", e.g. signatures) immediately, while the
+ * large table for G is being built by background threads (eager
+ * parallel build with curve9767_gtable_init()). Reported figures are:
+ *
+ *   time to first request   delay between startup and the completion
+ *                           of the first request (served with the
+ *                           built-in windows)
+ *   time to full speed      delay between startup and the completion
+ *                           of the first request that uses the table
+ *
+ * as well as the cost of a generator multiplication with the built-in
+ * windows and with the table. With -t 0, no thread is started, and the
+ * first request builds the whole table before being served (lazy
+ * blocking build, for comparison).
+ *
+ * Usage: bench_gtable [ -t threads ]
+ * The default number of build threads is the number of online CPUs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "curve9767.h"
+
+#define NUM_RUNS    15
+#define NUM_OPS     200
+#define MAX_THREADS 64
+
+static curve9767_gtable gt;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static void *
+builder(void *arg)
+{
+	(void)arg;
+	curve9767_gtable_init(&gt);
+	return NULL;
+}
+
+/*
+ * Return the best time per generator multiplication (in microseconds).
+ */
+static double
+bench_mulgen(curve9767_scalar *s)
+{
+	curve9767_point Q;
+	uint8_t tmp[32];
+	double best;
+	int r;
+
+	best = 0.0;
+	for (r = 0; r < NUM_RUNS; r ++) {
+		double t;
+		int i;
+
+		t = now();
+		for (i = 0; i < NUM_OPS; i ++) {
+			curve9767_point_mulgen(&Q, s);
+			curve9767_point_encode(tmp, &Q);
+			curve9767_scalar_decode_reduce(s, tmp, sizeof tmp);
+		}
+		t = (now() - t) / (double)NUM_OPS;
+		if (r == 0 || t < best) {
+			best = t;
+		}
+	}
+	return best * 1000000.0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	pthread_t th[MAX_THREADS];
+	curve9767_scalar s;
+	curve9767_point Q;
+	uint8_t tmp[32];
+	double t0, t_first, t_full, t_builtin, t_table;
+	long num_threads, n, num_slow;
+	int i;
+
+	num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	for (i = 1; i < argc; i ++) {
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			num_threads = strtol(argv[++ i], NULL, 10);
+		} else {
+			fprintf(stderr, "usage: bench_gtable [ -t threads ]\n");
+			return EXIT_FAILURE;
+		}
+	}
+	if (num_threads < 0) {
+		num_threads = 0;
+	} else if (num_threads > MAX_THREADS) {
+		num_threads = MAX_THREADS;
+	}
+
+	for (i = 0; i < 32; i ++) {
+		tmp[i] = (uint8_t)(i * 37 + 11);
+	}
+	curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+	t_builtin = bench_mulgen(&s);
+
+	/*
+	 * Startup: build threads are started, and requests are served
+	 * in the main thread until the table is used.
+	 */
+	t0 = now();
+	for (n = 0; n < num_threads; n ++) {
+		if (pthread_create(&th[n], NULL, builder, NULL) != 0) {
+			fprintf(stderr, "pthread_create() failed\n");
+			return EXIT_FAILURE;
+		}
+	}
+	t_first = 0.0;
+	num_slow = 0;
+	for (;;) {
+		int fast;
+
+		if (num_threads == 0) {
+			curve9767_gtable_init(&gt);
+		}
+		fast = curve9767_gtable_ready();
+		curve9767_point_mulgen(&Q, &s);
+		curve9767_point_encode(tmp, &Q);
+		curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+		if (t_first == 0.0) {
+			t_first = now() - t0;
+		}
+		if (fast) {
+			t_full = now() - t0;
+			break;
+		}
+		num_slow ++;
+	}
+	for (n = 0; n < num_threads; n ++) {
+		pthread_join(th[n], NULL);
+	}
+	t_table = bench_mulgen(&s);
+
+	printf("table size:              %d bytes\n", CURVE9767_GTABLE_SIZE);
+	printf("build threads:           %ld\n", num_threads);
+	printf("mulgen (built-in):       %10.2f us\n", t_builtin);
+	printf("mulgen (table):          %10.2f us\n", t_table);
+	printf("time to first request:   %10.2f ms\n", t_first * 1000.0);
+	printf("time to full speed:      %10.2f ms\n", t_full * 1000.0);
+	printf("requests before table:   %ld\n", num_slow);
+	return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * Multi-threaded MSM benchmark.
+ *
+ * The windows of a Pippenger MSM are distributed over T threads: each
+ * thread has its own bucket scratch area, and repeatedly takes the next
+ * unprocessed window index from a shared atomic counter. Each window
+ * result is written in its own slot of the MSM context, so no lock is
+ * needed; the merge is performed by the calling thread once all workers
+ * have finished.
+ *
+ * For each MSM size n and each thread count T, the best time over
+ * several runs is reported, along with the scaling efficiency
+ * t(1) / (T * t(T)) (1.00 is perfect scaling).
+ *
+ * Usage: bench_msm [ max_threads [ n ... ] ]
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "curve9767.h"
+
+#define MAX_THREADS   64
+#define NUM_RUNS      5
+
+typedef struct {
+	curve9767_msm_context *mc;
+	atomic_uint next;
+} job;
+
+typedef struct {
+	job *j;
+	void *scratch;
+	pthread_t th;
+} worker;
+
+static void *
+worker_run(void *arg)
+{
+	worker *wk;
+	job *j;
+
+	wk = arg;
+	j = wk->j;
+	for (;;) {
+		unsigned w;
+
+		w = atomic_fetch_add_explicit(&j->next, 1, memory_order_relaxed);
+		if (w >= j->mc->num_windows) {
+			return NULL;
+		}
+		curve9767_msm_window(j->mc, w, wk->scratch);
+	}
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/*
+ * Run one MSM with num_threads workers; the calling thread is one of
+ * them. Returned value is the elapsed time (in seconds).
+ */
+static double
+run_msm(curve9767_point *Q, worker *wk, unsigned num_threads,
+	const curve9767_point *points, const uint8_t *scalars, size_t n)
+{
+	curve9767_msm_context mc;
+	job j;
+	double t0;
+	unsigned i;
+
+	t0 = now();
+	curve9767_msm_init(&mc, points, scalars, n,
+		curve9767_msm_window_bits(n));
+	j.mc = &mc;
+	atomic_init(&j.next, 0);
+	for (i = 0; i < num_threads; i ++) {
+		wk[i].j = &j;
+	}
+	for (i = 1; i < num_threads; i ++) {
+		if (pthread_create(&wk[i].th, NULL, worker_run, &wk[i]) != 0) {
+			fprintf(stderr, "pthread_create() failed\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	worker_run(&wk[0]);
+	for (i = 1; i < num_threads; i ++) {
+		pthread_join(wk[i].th, NULL);
+	}
+	curve9767_msm_merge(Q, &mc);
+	return now() - t0;
+}
+
+static void
+bench(worker *wk, unsigned max_threads, size_t n)
+{
+	curve9767_point *points, Q;
+	uint8_t *scalars, ref[32], tmp[32];
+	shake_context rng;
+	double t1;
+	unsigned num_threads;
+	size_t u;
+
+	points = malloc(n * sizeof *points);
+	scalars = malloc(n * 32);
+	if (points == NULL || scalars == NULL) {
+		fprintf(stderr, "malloc() failed\n");
+		exit(EXIT_FAILURE);
+	}
+	shake_init(&rng, 256);
+	shake_inject(&rng, "bench_msm", 9);
+	shake_flip(&rng);
+	for (u = 0; u < n; u ++) {
+		uint8_t buf[40];
+		curve9767_scalar s;
+
+		shake_extract(&rng, buf, sizeof buf);
+		curve9767_scalar_decode_reduce(&s, buf, sizeof buf);
+		curve9767_point_mulgen(&points[u], &s);
+		shake_extract(&rng, buf, sizeof buf);
+		curve9767_scalar_decode_reduce(&s, buf, sizeof buf);
+		curve9767_scalar_encode(scalars + (u << 5), &s);
+	}
+
+	t1 = 0.0;
+	for (num_threads = 1; num_threads <= max_threads; num_threads ++) {
+		double best;
+		int r;
+
+		best = 0.0;
+		for (r = 0; r < NUM_RUNS; r ++) {
+			double t;
+
+			t = run_msm(&Q, wk, num_threads, points, scalars, n);
+			if (r == 0 || t < best) {
+				best = t;
+			}
+		}
+
+		/*
+		 * All thread counts must yield the same result.
+		 */
+		if (num_threads == 1) {
+			t1 = best;
+			curve9767_point_encode(ref, &Q);
+		} else {
+			curve9767_point_encode(tmp, &Q);
+			if (memcmp(ref, tmp, sizeof ref) != 0) {
+				fprintf(stderr, "MSM results differ\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		printf("n = %6lu  c = %2u  threads = %2u  %10.3f ms"
+			"  %7.2f us/point  eff = %4.2f\n",
+			(unsigned long)n, curve9767_msm_window_bits(n),
+			num_threads, best * 1000.0,
+			best * 1000000.0 / (double)n,
+			t1 / ((double)num_threads * best));
+		fflush(stdout);
+	}
+
+	free(points);
+	free(scalars);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const size_t def_n[] = { 64, 256, 1024, 4096 };
+	worker wk[MAX_THREADS];
+	unsigned max_threads, i;
+	size_t scratch_len;
+	long ncpu;
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	max_threads = ncpu > 0 ? (unsigned)ncpu : 1;
+	if (argc > 1) {
+		max_threads = (unsigned)strtoul(argv[1], NULL, 0);
+	}
+	if (max_threads < 1 || max_threads > MAX_THREADS) {
+		fprintf(stderr, "invalid thread count\n");
+		exit(EXIT_FAILURE);
+	}
+	scratch_len = curve9767_msm_scratch_size(16);
+	for (i = 0; i < max_threads; i ++) {
+		wk[i].scratch = malloc(scratch_len);
+		if (wk[i].scratch == NULL) {
+			fprintf(stderr, "malloc() failed\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (argc > 2) {
+		int k;
+
+		for (k = 2; k < argc; k ++) {
+			bench(wk, max_threads,
+				(size_t)strtoul(argv[k], NULL, 0));
+		}
+	} else {
+		for (i = 0; i < (sizeof def_n) / sizeof def_n[0]; i ++) {
+			bench(wk, max_threads, def_n[i]);
+		}
+	}
+
+	for (i = 0; i < max_threads; i ++) {
+		free(wk[i].scratch);
+	}
+	return 0;
+}
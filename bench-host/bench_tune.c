@@ -0,0 +1,186 @@
+/*
+ * Autotuning tool.
+ *
+ * This measures the costs of field operations, prints the resulting
+ * configuration (including its exported form, as hexadecimal, which
+ * can be persisted and later pinned with curve9767_tune_import() and
+ * curve9767_tune_set()), and compares the speed of point
+ * multiplications with the default and tuned configurations. If a
+ * hexadecimal configuration is provided, it is imported and used
+ * instead of the measured one.
+ *
+ * Usage: bench_tune [ config_hex ]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "curve9767.h"
+
+#define NUM_RUNS   9
+
+static uint64_t
+clock_ns(void *ctx)
+{
+	struct timespec ts;
+
+	(void)ctx;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static curve9767_point Q;
+static curve9767_scalar s1, s2;
+
+static void
+run_mul(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_point_mul(&Q, &Q, &s1);
+	}
+}
+
+static void
+run_mul_mulgen_add(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_point_mul_mulgen_add(&Q, &Q, &s1, &s2);
+	}
+}
+
+static void
+run_mulgen(long num)
+{
+	long i;
+
+	for (i = 0; i < num; i ++) {
+		curve9767_point_mulgen(&Q, &s1);
+	}
+}
+
+/*
+ * Returned value is the best time per operation, in microseconds.
+ */
+static double
+bench(void (*fn)(long), long num)
+{
+	double best;
+	int r;
+
+	fn(num / 10);
+	best = 0.0;
+	for (r = 0; r < NUM_RUNS; r ++) {
+		double t;
+
+		t = (double)clock_ns(NULL);
+		fn(num);
+		t = ((double)clock_ns(NULL) - t) / (1000.0 * (double)num);
+		if (r == 0 || t < best) {
+			best = t;
+		}
+	}
+	return best;
+}
+
+static int
+hexval(int c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - ('a' - 10);
+	} else if (c >= 'A' && c <= 'F') {
+		return c - ('A' - 10);
+	} else {
+		return -1;
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const struct {
+		const char *name;
+		void (*fn)(long);
+	} ops[] = {
+		{ "point_mul", run_mul },
+		{ "point_mul_mulgen_add", run_mul_mulgen_add },
+		{ "point_mulgen", run_mulgen }
+	};
+	curve9767_tune_config tc, tc0;
+	uint8_t buf[CURVE9767_TUNE_ENCODED_SIZE], tmp[32];
+	size_t u;
+	int i;
+
+	if (argc > 1) {
+		const char *hex;
+
+		hex = argv[1];
+		if (strlen(hex) != 2 * sizeof buf) {
+			fprintf(stderr, "invalid configuration\n");
+			exit(EXIT_FAILURE);
+		}
+		for (u = 0; u < sizeof buf; u ++) {
+			int hi, lo;
+
+			hi = hexval(hex[2 * u]);
+			lo = hexval(hex[2 * u + 1]);
+			if (hi < 0 || lo < 0) {
+				fprintf(stderr, "invalid configuration\n");
+				exit(EXIT_FAILURE);
+			}
+			buf[u] = (uint8_t)((hi << 4) | lo);
+		}
+		if (!curve9767_tune_import(&tc, buf, sizeof buf)) {
+			fprintf(stderr, "invalid configuration\n");
+			exit(EXIT_FAILURE);
+		}
+	} else {
+		if (!curve9767_tune_measure(&tc, clock_ns, NULL)) {
+			fprintf(stderr, "clock resolution is too coarse\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	printf("costs (64 ops): mul = %lu  sqr = %lu  inv = %lu\n",
+		(unsigned long)tc.cost_mul, (unsigned long)tc.cost_sqr,
+		(unsigned long)tc.cost_inv);
+	printf("Jacobian accumulator: mul = %d  mul_mulgen_add = %d"
+		"  mulgen = %d\n",
+		(tc.mul_jacobian & CURVE9767_TUNE_JAC_MUL) != 0,
+		(tc.mul_jacobian & CURVE9767_TUNE_JAC_MUL_ADD) != 0,
+		(tc.mul_jacobian & CURVE9767_TUNE_JAC_MULGEN) != 0);
+	printf("MSM bucket cost: %lu/16\n", (unsigned long)tc.msm_bucket_cost);
+	curve9767_tune_export(buf, &tc);
+	printf("exported: ");
+	for (u = 0; u < sizeof buf; u ++) {
+		printf("%02x", buf[u]);
+	}
+	printf("\n\n");
+
+	for (i = 0; i < 32; i ++) {
+		tmp[i] = (uint8_t)(i * 37 + 11);
+	}
+	curve9767_scalar_decode_reduce(&s1, tmp, sizeof tmp);
+	curve9767_scalar_add(&s2, &s1, &s1);
+	curve9767_point_mulgen(&Q, &s1);
+
+	curve9767_tune_default(&tc0);
+	printf("%-22s %10s %10s\n", "", "default", "tuned");
+	for (u = 0; u < (sizeof ops) / sizeof ops[0]; u ++) {
+		double t0, t1;
+
+		curve9767_tune_set(&tc0);
+		t0 = bench(ops[u].fn, 300);
+		curve9767_tune_set(&tc);
+		t1 = bench(ops[u].fn, 300);
+		printf("%-22s %7.2f us %7.2f us\n", ops[u].name, t0, t1);
+		fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1 @@
+../src/curve9767.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/frost.c
\ No newline at end of file
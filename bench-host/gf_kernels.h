@@ -0,0 +1,27 @@
+#ifndef GF_KERNELS_H__
+#define GF_KERNELS_H__
+
+#include <stdint.h>
+
+/*
+ * Field multiplication and squaring kernels, generated by
+ * extra/mkgfkernels.py (into gf_kernels.c). Kernels have the same
+ * semantics as curve9767_inner_gf_mul() and curve9767_inner_gf_sqr().
+ */
+typedef struct {
+	const char *name;
+	void (*mul)(uint16_t *c, const uint16_t *a, const uint16_t *b);
+	void (*sqr)(uint16_t *c, const uint16_t *a);
+} gf_kernel;
+
+/*
+ * All generated kernels; the table ends with an entry whose name is NULL.
+ */
+extern const gf_kernel gf_kernel_table[];
+
+/*
+ * Description of the generation parameters (target, accumulators).
+ */
+extern const char *const gf_kernel_target;
+
+#endif
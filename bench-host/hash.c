@@ -0,0 +1 @@
+../src/hash.c
\ No newline at end of file
@@ -0,0 +1 @@
+../src/ops_ref.c
\ No newline at end of file
@@ -0,0 +1 @@
+../src/sha3.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/vcache.c
\ No newline at end of file
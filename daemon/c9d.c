@@ -0,0 +1,249 @@
+/*
+ * Client library for the curve9767d daemon.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "c9d.h"
+
+/* see c9d.h */
+int
+c9d_connect(const char *path)
+{
+	struct sockaddr_un sa;
+	int fd;
+
+	if (path == NULL) {
+		path = C9D_DEFAULT_PATH;
+	}
+	if (strlen(path) >= sizeof sa.sun_path) {
+		return -1;
+	}
+	memset(&sa, 0, sizeof sa);
+	sa.sun_family = AF_UNIX;
+	strcpy(sa.sun_path, path);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)&sa, sizeof sa) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* see c9d.h */
+void
+c9d_close(int fd)
+{
+	close(fd);
+}
+
+static int
+write_all(int fd, const uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t r;
+
+		r = write(fd, buf, len);
+		if (r < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		buf += r;
+		len -= (size_t)r;
+	}
+	return 0;
+}
+
+static int
+read_all(int fd, uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t r;
+
+		r = read(fd, buf, len);
+		if (r < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		if (r == 0) {
+			return -1;
+		}
+		buf += r;
+		len -= (size_t)r;
+	}
+	return 0;
+}
+
+static void
+enc32be(uint8_t *buf, uint32_t x)
+{
+	buf[0] = (uint8_t)(x >> 24);
+	buf[1] = (uint8_t)(x >> 16);
+	buf[2] = (uint8_t)(x >> 8);
+	buf[3] = (uint8_t)x;
+}
+
+/*
+ * Send a request (code and payload, without the length header) and
+ * receive the response. The response payload must have length exactly
+ * resp_len bytes (for an error status, an empty payload is also
+ * accepted). Returned value is the response status, or -1 on error.
+ */
+static int
+transact(int fd, uint8_t *req, size_t req_len, void *resp, size_t resp_len)
+{
+	uint8_t hdr[5];
+	uint32_t len;
+
+	/*
+	 * The caller reserved 4 bytes before the request for the header.
+	 */
+	enc32be(req - 4, (uint32_t)req_len);
+	if (write_all(fd, req - 4, req_len + 4) < 0) {
+		return -1;
+	}
+	if (read_all(fd, hdr, sizeof hdr) < 0) {
+		return -1;
+	}
+	len = ((uint32_t)hdr[0] << 24) | ((uint32_t)hdr[1] << 16)
+		| ((uint32_t)hdr[2] << 8) | (uint32_t)hdr[3];
+	if (len == 1 && hdr[4] == C9D_STATUS_ERROR) {
+		return -1;
+	}
+	if (len != resp_len + 1) {
+		return -1;
+	}
+	if (read_all(fd, resp, resp_len) < 0) {
+		return -1;
+	}
+	return hdr[4];
+}
+
+/*
+ * Allocate a request buffer (with room for the length header) and
+ * write the request code. The tail (oid, hv) is appended by the caller.
+ */
+static uint8_t *
+make_request(size_t len, int op)
+{
+	uint8_t *buf;
+
+	if (len > C9D_MAX_MESSAGE) {
+		return NULL;
+	}
+	buf = malloc(len + 4);
+	if (buf == NULL) {
+		return NULL;
+	}
+	buf[4] = (uint8_t)op;
+	return buf;
+}
+
+/*
+ * Append the hash identifier and hashed message.
+ */
+static void
+put_oid_hv(uint8_t *buf, const char *hash_oid, const void *hv, size_t hv_len)
+{
+	size_t oid_len;
+
+	oid_len = strlen(hash_oid);
+	buf[0] = (uint8_t)oid_len;
+	memcpy(buf + 1, hash_oid, oid_len);
+	memcpy(buf + 1 + oid_len, hv, hv_len);
+}
+
+/* see c9d.h */
+int
+c9d_sign_verify(int fd, const void *sig, const uint8_t encoded_Q[32],
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	uint8_t *buf;
+	size_t len;
+	int r;
+
+	if (strlen(hash_oid) > 255) {
+		return -1;
+	}
+	len = 1 + 64 + 32 + 1 + strlen(hash_oid) + hv_len;
+	buf = make_request(len, C9D_OP_VERIFY);
+	if (buf == NULL) {
+		return -1;
+	}
+	memcpy(buf + 5, sig, 64);
+	memcpy(buf + 69, encoded_Q, 32);
+	put_oid_hv(buf + 101, hash_oid, hv, hv_len);
+	r = transact(fd, buf + 4, len, NULL, 0);
+	free(buf);
+	return r;
+}
+
+/* see c9d.h */
+int
+c9d_ecdh_recv(int fd, void *shared_secret, size_t shared_secret_len,
+	const uint8_t encoded_s[32], const uint8_t encoded_Q2[32])
+{
+	uint8_t *buf;
+	size_t len;
+	int r;
+
+	if (shared_secret_len > 65535
+		|| shared_secret_len + 1 > C9D_MAX_MESSAGE)
+	{
+		return -1;
+	}
+	len = 1 + 32 + 32 + 2;
+	buf = make_request(len, C9D_OP_ECDH);
+	if (buf == NULL) {
+		return -1;
+	}
+	memcpy(buf + 5, encoded_s, 32);
+	memcpy(buf + 37, encoded_Q2, 32);
+	buf[69] = (uint8_t)(shared_secret_len >> 8);
+	buf[70] = (uint8_t)shared_secret_len;
+	r = transact(fd, buf + 4, len, shared_secret, shared_secret_len);
+	memset(buf, 0, len + 4);
+	free(buf);
+	return r;
+}
+
+/* see c9d.h */
+int
+c9d_sign_generate(int fd, void *sig,
+	const uint8_t encoded_s[32], const uint8_t t[32],
+	const uint8_t encoded_Q[32],
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	uint8_t *buf;
+	size_t len;
+	int r;
+
+	if (strlen(hash_oid) > 255) {
+		return -1;
+	}
+	len = 1 + 32 + 32 + 32 + 1 + strlen(hash_oid) + hv_len;
+	buf = make_request(len, C9D_OP_SIGN);
+	if (buf == NULL) {
+		return -1;
+	}
+	memcpy(buf + 5, encoded_s, 32);
+	memcpy(buf + 37, t, 32);
+	memcpy(buf + 69, encoded_Q, 32);
+	put_oid_hv(buf + 101, hash_oid, hv, hv_len);
+	r = transact(fd, buf + 4, len, sig, 64);
+	memset(buf, 0, len + 4);
+	free(buf);
+	return r;
+}
@@ -0,0 +1,99 @@
+#ifndef C9D_H__
+#define C9D_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Client API for the curve9767d daemon.
+ *
+ * The daemon listens on a UNIX-domain stream socket. Each request and
+ * each response is a message: a 4-byte length (big-endian, counting
+ * the bytes that follow), then a 1-byte code, then a payload. The
+ * daemon answers requests from a given connection in order; requests
+ * from distinct connections are batched together.
+ *
+ * Requests (code, then payload):
+ *
+ *   C9D_OP_VERIFY   sig (64) | Q (32) | oid_len (1) | oid | hv
+ *   C9D_OP_ECDH     s (32) | Q2 (32) | secret_len (2, big-endian)
+ *   C9D_OP_SIGN     s (32) | t (32) | Q (32) | oid_len (1) | oid | hv
+ *
+ * Points are encoded (32 bytes), scalars use curve9767_scalar_encode().
+ *
+ * Responses: the code is the result (1 or 0, as returned by the
+ * corresponding curve9767_*() function), or C9D_STATUS_ERROR if the
+ * request was malformed. The payload is empty (verify), the shared
+ * secret (ECDH) or the signature (sign).
+ *
+ * Secret scalars are sent to the daemon for ECDH and signing; the
+ * socket must therefore be protected with filesystem permissions, as
+ * any other key storage. The daemon creates the socket with mode 0600
+ * (owner only).
+ */
+
+#define C9D_OP_VERIFY       1
+#define C9D_OP_ECDH         2
+#define C9D_OP_SIGN         3
+
+#define C9D_STATUS_ERROR    0xFF
+
+/*
+ * Maximum message length (excluding the 4-byte length header).
+ */
+#define C9D_MAX_MESSAGE     65536
+
+/*
+ * Default socket path.
+ */
+#define C9D_DEFAULT_PATH    "/tmp/curve9767d.sock"
+
+/*
+ * Connect to the daemon. If path is NULL, the default path is used.
+ * Returned value is a socket descriptor, or -1 on error.
+ */
+int c9d_connect(const char *path);
+
+/*
+ * Close a connection.
+ */
+void c9d_close(int fd);
+
+/*
+ * The functions below mirror the synchronous API from curve9767.h.
+ * Points are provided in encoded format. On I/O or protocol error,
+ * -1 is returned.
+ */
+
+/*
+ * Verify a signature (see curve9767_sign_verify()).
+ */
+int c9d_sign_verify(int fd, const void *sig, const uint8_t encoded_Q[32],
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+/*
+ * Compute an ECDH shared secret (see curve9767_ecdh_recv()). The secret
+ * scalar is provided in encoded format (32 bytes).
+ */
+int c9d_ecdh_recv(int fd, void *shared_secret, size_t shared_secret_len,
+	const uint8_t encoded_s[32], const uint8_t encoded_Q2[32]);
+
+/*
+ * Generate a signature (see curve9767_sign_generate()). The secret
+ * scalar is provided in encoded format (32 bytes). Returned value is 1
+ * on success.
+ */
+int c9d_sign_generate(int fd, void *sig,
+	const uint8_t encoded_s[32], const uint8_t t[32],
+	const uint8_t encoded_Q[32],
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
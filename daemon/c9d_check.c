@@ -0,0 +1,145 @@
+/*
+ * Check program for curve9767d: requests are sent to a running daemon
+ * over several concurrent connections, and results are compared with
+ * the library functions computed locally.
+ *
+ * Usage: c9d_check [ path ]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "curve9767.h"
+#include "c9d.h"
+
+#define NUM_PROCS   4
+#define NUM_ITER    20
+
+static void
+fail(const char *msg, int k)
+{
+	fprintf(stderr, "c9d_check: %s (%d)\n", msg, k);
+	exit(EXIT_FAILURE);
+}
+
+static void
+run(const char *path, int id)
+{
+	int fd, i;
+
+	fd = c9d_connect(path);
+	if (fd < 0) {
+		fail("cannot connect", id);
+	}
+	for (i = 0; i < NUM_ITER; i ++) {
+		uint8_t seed[8], t[32], bs[32], bQ[32], sig[64], sig2[64];
+		uint8_t bQ2[32], ss1[40], ss2[40], hv[32];
+		curve9767_scalar s, s2;
+		curve9767_point Q;
+
+		seed[0] = (uint8_t)id;
+		seed[1] = (uint8_t)i;
+		memset(seed + 2, 0x5A, sizeof seed - 2);
+		curve9767_keygen(&s, t, &Q, seed, sizeof seed);
+		curve9767_scalar_encode(bs, &s);
+		curve9767_point_encode(bQ, &Q);
+		memset(hv, i, sizeof hv);
+
+		/*
+		 * Signature by the daemon must match a local signature,
+		 * and verify (both locally and with the daemon). A
+		 * modified signature must be rejected.
+		 */
+		if (c9d_sign_generate(fd, sig, bs, t, bQ,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 1)
+		{
+			fail("sign request failed", i);
+		}
+		curve9767_sign_generate(sig2, &s, t, &Q,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv);
+		if (memcmp(sig, sig2, sizeof sig) != 0) {
+			fail("wrong signature", i);
+		}
+		if (c9d_sign_verify(fd, sig, bQ,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 1)
+		{
+			fail("valid signature rejected", i);
+		}
+		if (c9d_sign_verify(fd, sig, bQ,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 1)
+		{
+			fail("valid signature rejected (cached)", i);
+		}
+		sig[40] ^= 0x01;
+		if (c9d_sign_verify(fd, sig, bQ,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 0)
+		{
+			fail("invalid signature accepted", i);
+		}
+
+		/*
+		 * ECDH with another key pair.
+		 */
+		seed[0] ^= 0x80;
+		curve9767_ecdh_keygen(&s2, bQ2, seed, sizeof seed);
+		if (c9d_ecdh_recv(fd, ss1, sizeof ss1, bs, bQ2) != 1) {
+			fail("ECDH request failed", i);
+		}
+		curve9767_ecdh_recv(ss2, sizeof ss2, &s, bQ2);
+		if (memcmp(ss1, ss2, sizeof ss1) != 0) {
+			fail("wrong ECDH secret", i);
+		}
+		bQ2[0] ^= 0x01;
+		if (c9d_ecdh_recv(fd, ss1, sizeof ss1, bs, bQ2)
+			!= curve9767_ecdh_recv(ss2, sizeof ss2, &s, bQ2)
+			|| memcmp(ss1, ss2, sizeof ss1) != 0)
+		{
+			fail("wrong ECDH result on modified point", i);
+		}
+	}
+	c9d_close(fd);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *path;
+	int i, ok;
+
+	path = argc > 1 ? argv[1] : NULL;
+	printf("Test curve9767d: ");
+	fflush(stdout);
+	for (i = 0; i < NUM_PROCS; i ++) {
+		pid_t pid;
+
+		pid = fork();
+		if (pid < 0) {
+			fail("fork", i);
+		}
+		if (pid == 0) {
+			run(path, i);
+			exit(EXIT_SUCCESS);
+		}
+	}
+	ok = 1;
+	for (i = 0; i < NUM_PROCS; i ++) {
+		int st;
+
+		if (wait(&st) < 0 || !WIFEXITED(st)
+			|| WEXITSTATUS(st) != EXIT_SUCCESS)
+		{
+			ok = 0;
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	if (!ok) {
+		printf(" FAILED.\n");
+		return EXIT_FAILURE;
+	}
+	printf(" done.\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1 @@
+../src/curve9767.c
\ No newline at end of file
@@ -0,0 +1,866 @@
+/*
+ * curve9767d: local signature verification / ECDH / signing daemon.
+ *
+ * The daemon listens on a UNIX-domain socket (protocol is described in
+ * c9d.h). It is single-threaded: a poll() loop reads data from all
+ * clients, then all complete requests gathered in that cycle are
+ * processed as one batch, and responses are queued back to the
+ * clients. A batch is processed in two passes: first, all public keys
+ * used by the batch are resolved (decoded) through a shared cache of
+ * decoded keys, then requests are computed. Successful signature
+ * verifications are remembered in a shared verification cache (see
+ * curve9767_vcache_lookup()), so that a token verified by one process
+ * is not verified again by another one. Verification requests of a
+ * batch that miss the cache are verified together, with a single call
+ * to curve9767_sign_verify_strided() per hash function (one combined
+ * multi-scalar multiplication per chunk).
+ *
+ * Usage: curve9767d [ -s path ] [ -k keys ] [ -c entries ] [ -t ttl ]
+ *                   [ -b batch ]
+ *   -s path      socket path (default: C9D_DEFAULT_PATH)
+ *   -k keys      number of decoded keys to cache (default: 4096)
+ *   -c entries   verification cache size, in entries (default: 65536;
+ *                0 disables the cache)
+ *   -t ttl       verification cache entry lifetime, in seconds
+ *                (default: 300)
+ *   -b batch     maximum number of requests per batch (default: 256)
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "curve9767.h"
+#include "c9d.h"
+
+/* ==================================================================== */
+/*
+ * Growable byte buffer.
+ */
+
+typedef struct {
+	uint8_t *buf;
+	size_t ptr, len, cap;
+} bytebuf;
+
+static void *
+xrealloc(void *p, size_t len)
+{
+	p = realloc(p, len);
+	if (p == NULL) {
+		fprintf(stderr, "curve9767d: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	return p;
+}
+
+/*
+ * Ensure that at least 'extra' bytes can be appended. Already consumed
+ * data (before ptr) is discarded.
+ */
+static void
+bytebuf_reserve(bytebuf *bb, size_t extra)
+{
+	if (bb->ptr > 0) {
+		memmove(bb->buf, bb->buf + bb->ptr, bb->len - bb->ptr);
+		bb->len -= bb->ptr;
+		bb->ptr = 0;
+	}
+	if (bb->cap - bb->len < extra) {
+		size_t ncap;
+
+		ncap = bb->cap < 4096 ? 4096 : bb->cap;
+		while (ncap - bb->len < extra) {
+			ncap <<= 1;
+		}
+		bb->buf = xrealloc(bb->buf, ncap);
+		bb->cap = ncap;
+	}
+}
+
+static void
+bytebuf_free(bytebuf *bb)
+{
+	free(bb->buf);
+	bb->buf = NULL;
+	bb->ptr = bb->len = bb->cap = 0;
+}
+
+/* ==================================================================== */
+/*
+ * Clients.
+ */
+
+/*
+ * A client is removed when it has been flagged as bad (I/O or protocol
+ * error), or when it closed its side of the connection and all its
+ * requests have been answered.
+ */
+typedef struct {
+	int fd;
+	bytebuf in, out;
+	int eof, bad;
+} client;
+
+static client *clients;
+static size_t num_clients, cap_clients;
+
+static void
+client_add(int fd)
+{
+	if (num_clients == cap_clients) {
+		cap_clients = cap_clients == 0 ? 16 : cap_clients << 1;
+		clients = xrealloc(clients, cap_clients * sizeof *clients);
+	}
+	memset(&clients[num_clients], 0, sizeof clients[num_clients]);
+	clients[num_clients].fd = fd;
+	num_clients ++;
+}
+
+static void
+client_remove(size_t k)
+{
+	close(clients[k].fd);
+	bytebuf_free(&clients[k].in);
+	bytebuf_free(&clients[k].out);
+	clients[k] = clients[-- num_clients];
+}
+
+/*
+ * Maximum backlog per client (unprocessed input, or output not yet
+ * written). A client whose backlog exceeds this limit is not read from
+ * until the backlog drains; a client that pipelines requests without
+ * reading the responses thus cannot make the daemon memory grow
+ * without bound.
+ */
+#define CLIENT_BACKLOG_MAX   (4 * (C9D_MAX_MESSAGE + 4))
+
+static int
+client_can_read(const client *c)
+{
+	return !c->eof
+		&& c->in.len - c->in.ptr < CLIENT_BACKLOG_MAX
+		&& c->out.len - c->out.ptr < CLIENT_BACKLOG_MAX;
+}
+
+/*
+ * Test whether a client has a complete request in its input buffer.
+ */
+static int
+has_request(const client *c)
+{
+	const uint8_t *buf;
+	size_t mlen;
+
+	if (c->in.len - c->in.ptr < 4) {
+		return 0;
+	}
+	buf = c->in.buf + c->in.ptr;
+	mlen = ((size_t)buf[0] << 24) | ((size_t)buf[1] << 16)
+		| ((size_t)buf[2] << 8) | (size_t)buf[3];
+	return c->in.len - c->in.ptr - 4 >= mlen;
+}
+
+/*
+ * Queue a response for a client.
+ */
+static void
+client_respond(client *c, int status, const void *data, size_t len)
+{
+	uint8_t *buf;
+
+	bytebuf_reserve(&c->out, len + 5);
+	buf = c->out.buf + c->out.len;
+	buf[0] = (uint8_t)((len + 1) >> 24);
+	buf[1] = (uint8_t)((len + 1) >> 16);
+	buf[2] = (uint8_t)((len + 1) >> 8);
+	buf[3] = (uint8_t)(len + 1);
+	buf[4] = (uint8_t)status;
+	if (len > 0) {
+		memcpy(buf + 5, data, len);
+	}
+	c->out.len += len + 5;
+}
+
+/* ==================================================================== */
+/*
+ * Decoded key cache. This is a direct-mapped table indexed by a salted
+ * hash of the encoded point; each slot contains an encoded point and
+ * its decoded version (or a flag recording that decoding failed).
+ */
+
+typedef struct {
+	uint8_t enc[32];
+	uint32_t used, ok;
+	curve9767_point Q;
+} key_slot;
+
+static key_slot *key_cache;
+static size_t key_cache_mask;
+static uint8_t key_cache_salt[32];
+
+static size_t
+key_index(const uint8_t *enc)
+{
+	shake_context sc;
+	uint8_t tmp[8];
+	uint64_t x;
+	int i;
+
+	/*
+	 * We use a salted hash so that clients cannot force collisions.
+	 * This costs a single Keccak invocation, which is negligible
+	 * compared to point decoding.
+	 */
+	turboshake_init(&sc, 128, 0x1F);
+	shake_inject(&sc, key_cache_salt, sizeof key_cache_salt);
+	shake_inject(&sc, enc, 32);
+	shake_flip(&sc);
+	shake_extract(&sc, tmp, sizeof tmp);
+	x = 0;
+	for (i = 0; i < 8; i ++) {
+		x |= (uint64_t)tmp[i] << (i << 3);
+	}
+	return (size_t)x & key_cache_mask;
+}
+
+/*
+ * Get the decoded point for an encoded public key. Returned value is
+ * 1 on success, 0 if the point is invalid.
+ */
+static int
+key_get(curve9767_point *Q, const uint8_t *enc)
+{
+	key_slot *ks;
+
+	ks = &key_cache[key_index(enc)];
+	if (!ks->used || memcmp(ks->enc, enc, 32) != 0) {
+		memcpy(ks->enc, enc, 32);
+		ks->used = 1;
+		ks->ok = curve9767_point_decode(&ks->Q, enc);
+	}
+	*Q = ks->Q;
+	return (int)ks->ok;
+}
+
+/* ==================================================================== */
+/*
+ * Request processing.
+ */
+
+static curve9767_vcache vcache;
+static curve9767_vcache *vcache_ptr;
+
+/*
+ * A pending request: client index, and request data (code and
+ * payload) which is a slice of the client input buffer.
+ */
+typedef struct {
+	size_t client;
+	const uint8_t *data;
+	size_t len;
+	int Q_ok;
+	curve9767_point Q;
+	int vr;
+} request;
+
+static request *batch;
+static size_t batch_max;
+
+/*
+ * Batch verification buffers: records (signature, encoded public key,
+ * hashed message length and hashed message), indices of the requests
+ * that produced them, result bitmap, and work area.
+ */
+#define VREC_SIG_OFF      0
+#define VREC_Q_OFF        64
+#define VREC_HV_LEN_OFF   96
+#define VREC_HV_OFF       97
+#define VREC_HV_MAX       255
+#define VREC_STRIDE       (VREC_HV_OFF + VREC_HV_MAX)
+
+static uint8_t *vrec;
+static size_t *vrec_index;
+static uint8_t *vrec_results;
+static void *vtmp;
+static size_t vtmp_len;
+
+/*
+ * Parse the "oid_len | oid | hv" tail of a request. The oid is copied
+ * into a NUL-terminated buffer. Returned value is 0 on error.
+ */
+static int
+parse_oid_hv(const uint8_t *buf, size_t len, char *oid,
+	const uint8_t **hv, size_t *hv_len)
+{
+	size_t oid_len;
+
+	if (len < 1) {
+		return 0;
+	}
+	oid_len = buf[0];
+	if (len < 1 + oid_len) {
+		return 0;
+	}
+	memcpy(oid, buf + 1, oid_len);
+	oid[oid_len] = 0;
+	*hv = buf + 1 + oid_len;
+	*hv_len = len - 1 - oid_len;
+	return 1;
+}
+
+/*
+ * First pass: resolve public keys. For verification and signing
+ * requests, the public key is decoded (through the cache); since
+ * batches are typically dominated by a few keys, this pass mostly
+ * consists of cache hits.
+ */
+static void
+resolve_keys(request *rq)
+{
+	rq->Q_ok = 0;
+	rq->vr = -1;
+	switch (rq->data[0]) {
+	case C9D_OP_VERIFY:
+		if (rq->len >= 1 + 64 + 32) {
+			rq->Q_ok = key_get(&rq->Q, rq->data + 1 + 64);
+		}
+		break;
+	case C9D_OP_SIGN:
+		if (rq->len >= 1 + 96) {
+			rq->Q_ok = key_get(&rq->Q, rq->data + 1 + 64);
+		}
+		break;
+	}
+}
+
+static void
+process_request(request *rq, uint64_t now)
+{
+	client *c;
+	const uint8_t *buf, *hv;
+	size_t len, hv_len;
+	char oid[256];
+	curve9767_scalar s;
+	uint8_t tmp[65535];
+	int r;
+
+	c = &clients[rq->client];
+	buf = rq->data + 1;
+	len = rq->len - 1;
+	switch (rq->data[0]) {
+	case C9D_OP_VERIFY:
+		if (len < 96 || !parse_oid_hv(buf + 96, len - 96,
+			oid, &hv, &hv_len))
+		{
+			break;
+		}
+		if (!rq->Q_ok) {
+			client_respond(c, 0, NULL, 0);
+			return;
+		}
+		if (rq->vr >= 0) {
+			r = rq->vr;
+		} else {
+			r = curve9767_sign_verify_cached(vcache_ptr, now,
+				buf, &rq->Q, oid, hv, hv_len);
+		}
+		client_respond(c, r, NULL, 0);
+		return;
+
+	case C9D_OP_ECDH:
+		if (len != 66) {
+			break;
+		}
+		if (!curve9767_scalar_decode_strict(&s, buf, 32)) {
+			break;
+		}
+		hv_len = ((size_t)buf[64] << 8) | (size_t)buf[65];
+		r = curve9767_ecdh_recv(tmp, hv_len, &s, buf + 32);
+		client_respond(c, r, tmp, hv_len);
+		memset(tmp, 0, hv_len);
+		memset(&s, 0, sizeof s);
+		return;
+
+	case C9D_OP_SIGN:
+		if (len < 96 || !rq->Q_ok
+			|| !parse_oid_hv(buf + 96, len - 96,
+			oid, &hv, &hv_len))
+		{
+			break;
+		}
+		if (!curve9767_scalar_decode_strict(&s, buf, 32)) {
+			break;
+		}
+		curve9767_sign_generate(tmp, &s, buf + 32, &rq->Q,
+			oid, hv, hv_len);
+		client_respond(c, 1, tmp, 64);
+		memset(&s, 0, sizeof s);
+		return;
+	}
+	client_respond(c, C9D_STATUS_ERROR, NULL, 0);
+}
+
+/*
+ * Second pass: verify all well-formed verification requests of the
+ * batch. Cache hits are answered directly; misses (with a hashed
+ * message of at most VREC_HV_MAX bytes) are copied into records and
+ * verified with one curve9767_sign_verify_strided() call for each
+ * distinct hash function identifier; valid signatures are then added
+ * to the cache. The results are stored in the requests (vr field);
+ * other requests are left to process_request().
+ */
+static void
+verify_batch(size_t n, uint64_t now)
+{
+	curve9767_record_layout rl;
+	const uint8_t *hv;
+	size_t k, j, m, hv_len;
+	char oid[256], oid2[256];
+
+	for (k = 0; k < n; k ++) {
+		request *rq;
+
+		rq = &batch[k];
+		if (rq->data[0] != C9D_OP_VERIFY || !rq->Q_ok
+			|| !parse_oid_hv(rq->data + 97, rq->len - 97,
+			oid, &hv, &hv_len))
+		{
+			continue;
+		}
+		if (vcache_ptr != NULL && curve9767_vcache_lookup(vcache_ptr,
+			now, rq->data + 1, &rq->Q, oid, hv, hv_len))
+		{
+			rq->vr = 1;
+		} else if (hv_len <= VREC_HV_MAX) {
+			/* Marked for batch verification. */
+			rq->vr = -2;
+		}
+	}
+
+	rl.stride = VREC_STRIDE;
+	rl.sig_off = VREC_SIG_OFF;
+	rl.Q_off = VREC_Q_OFF;
+	rl.hv_off = VREC_HV_OFF;
+	rl.hv_len_off = VREC_HV_LEN_OFF;
+	rl.hv_len = 0;
+	hv = NULL;
+	hv_len = 0;
+	for (k = 0; k < n; k ++) {
+		if (batch[k].vr != -2) {
+			continue;
+		}
+
+		/*
+		 * Gather all marked requests with the same hash function
+		 * identifier as request k.
+		 */
+		parse_oid_hv(batch[k].data + 97, batch[k].len - 97,
+			oid, &hv, &hv_len);
+		m = 0;
+		for (j = k; j < n; j ++) {
+			request *rq;
+			uint8_t *rec;
+
+			rq = &batch[j];
+			if (rq->vr != -2) {
+				continue;
+			}
+			parse_oid_hv(rq->data + 97, rq->len - 97,
+				oid2, &hv, &hv_len);
+			if (strcmp(oid, oid2) != 0) {
+				continue;
+			}
+			rec = vrec + m * VREC_STRIDE;
+			memcpy(rec + VREC_SIG_OFF, rq->data + 1, 96);
+			rec[VREC_HV_LEN_OFF] = (uint8_t)hv_len;
+			memcpy(rec + VREC_HV_OFF, hv, hv_len);
+			vrec_index[m ++] = j;
+		}
+		curve9767_sign_verify_strided(vrec_results, vrec, m, &rl,
+			oid, vtmp, vtmp_len);
+		for (j = 0; j < m; j ++) {
+			request *rq;
+			uint8_t *rec;
+
+			rq = &batch[vrec_index[j]];
+			rq->vr = (vrec_results[j >> 3] >> (j & 7)) & 1;
+			if (rq->vr && vcache_ptr != NULL) {
+				rec = vrec + j * VREC_STRIDE;
+				curve9767_vcache_insert(vcache_ptr, now,
+					rec + VREC_SIG_OFF, &rq->Q, oid,
+					rec + VREC_HV_OFF,
+					rec[VREC_HV_LEN_OFF]);
+			}
+		}
+	}
+}
+
+/*
+ * Upper bound on the length of the response to a request (including
+ * the 4-byte length header).
+ */
+static size_t
+response_max_len(const uint8_t *data, size_t len)
+{
+	if (data[0] == C9D_OP_ECDH && len == 67) {
+		return 5 + (((size_t)data[65] << 8) | (size_t)data[66]);
+	}
+	return 5 + 64;
+}
+
+/*
+ * Gather complete requests from all clients, up to the batch size,
+ * then process them. Returned value is the number of processed
+ * requests.
+ */
+static size_t
+process_batch(void)
+{
+	size_t k, n, *consumed;
+	uint64_t now;
+
+	n = 0;
+	consumed = xrealloc(NULL, (num_clients + 1) * sizeof *consumed);
+	for (k = 0; k < num_clients; k ++) {
+		client *c;
+		size_t ptr, olen;
+
+		/*
+		 * Requests are taken from a client only as long as its
+		 * output backlog, counting the worst-case size of the
+		 * responses to the requests already taken in this batch,
+		 * stays below CLIENT_BACKLOG_MAX; remaining requests are
+		 * left for later cycles, once the client has read its
+		 * responses.
+		 */
+		c = &clients[k];
+		ptr = c->in.ptr;
+		olen = c->out.len - c->out.ptr;
+		while (n < batch_max && !c->bad) {
+			const uint8_t *buf;
+			size_t mlen;
+
+			if (c->in.len - ptr < 4) {
+				break;
+			}
+			buf = c->in.buf + ptr;
+			mlen = ((size_t)buf[0] << 24) | ((size_t)buf[1] << 16)
+				| ((size_t)buf[2] << 8) | (size_t)buf[3];
+			if (mlen == 0 || mlen > C9D_MAX_MESSAGE) {
+				c->bad = 1;
+				break;
+			}
+			if (c->in.len - ptr - 4 < mlen) {
+				break;
+			}
+			olen += response_max_len(buf + 4, mlen);
+			if (olen > CLIENT_BACKLOG_MAX) {
+				break;
+			}
+			batch[n].client = k;
+			batch[n].data = buf + 4;
+			batch[n].len = mlen;
+			n ++;
+			ptr += 4 + mlen;
+		}
+		consumed[k] = ptr;
+		if (n == batch_max) {
+			for (k ++; k < num_clients; k ++) {
+				consumed[k] = clients[k].in.ptr;
+			}
+			break;
+		}
+	}
+
+	for (k = 0; k < n; k ++) {
+		resolve_keys(&batch[k]);
+	}
+	now = (uint64_t)time(NULL);
+	verify_batch(n, now);
+	for (k = 0; k < n; k ++) {
+		process_request(&batch[k], now);
+	}
+
+	/*
+	 * Request data points into input buffers, which are released
+	 * only now.
+	 */
+	for (k = 0; k < num_clients; k ++) {
+		clients[k].in.ptr = consumed[k];
+	}
+	free(consumed);
+	return n;
+}
+
+/* ==================================================================== */
+
+static volatile sig_atomic_t stop;
+
+static void
+on_signal(int sig)
+{
+	(void)sig;
+	stop = 1;
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr,
+"usage: curve9767d [ -s path ] [ -k keys ] [ -c entries ] [ -t ttl ]"
+" [ -b batch ]\n");
+	exit(EXIT_FAILURE);
+}
+
+static size_t
+parse_size(const char *s)
+{
+	char *end;
+	unsigned long x;
+
+	x = strtoul(s, &end, 0);
+	if (*s == 0 || *end != 0) {
+		usage();
+	}
+	return (size_t)x;
+}
+
+static void
+set_nonblock(int fd)
+{
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *path;
+	size_t num_keys, num_entries, ttl, u;
+	struct sockaddr_un sa;
+	struct pollfd *pfd;
+	mode_t old_mask;
+	int lfd, i;
+	void *vmem;
+	uint8_t seed[32];
+	FILE *f;
+
+	path = C9D_DEFAULT_PATH;
+	num_keys = 4096;
+	num_entries = 65536;
+	ttl = 300;
+	batch_max = 256;
+	for (i = 1; i < argc; i ++) {
+		if (i + 1 >= argc) {
+			usage();
+		}
+		if (strcmp(argv[i], "-s") == 0) {
+			path = argv[++ i];
+		} else if (strcmp(argv[i], "-k") == 0) {
+			num_keys = parse_size(argv[++ i]);
+		} else if (strcmp(argv[i], "-c") == 0) {
+			num_entries = parse_size(argv[++ i]);
+		} else if (strcmp(argv[i], "-t") == 0) {
+			ttl = parse_size(argv[++ i]);
+		} else if (strcmp(argv[i], "-b") == 0) {
+			batch_max = parse_size(argv[++ i]);
+		} else {
+			usage();
+		}
+	}
+	if (num_keys == 0 || batch_max == 0) {
+		usage();
+	}
+
+	/*
+	 * Cache salts are obtained from the OS.
+	 */
+	f = fopen("/dev/urandom", "rb");
+	if (f == NULL || fread(seed, 1, sizeof seed, f) != sizeof seed) {
+		fprintf(stderr, "curve9767d: cannot read /dev/urandom\n");
+		return EXIT_FAILURE;
+	}
+	fclose(f);
+
+	/*
+	 * Decoded key cache size is rounded down to a power of two.
+	 */
+	while ((num_keys & (num_keys - 1)) != 0) {
+		num_keys &= num_keys - 1;
+	}
+	key_cache = xrealloc(NULL, num_keys * sizeof *key_cache);
+	memset(key_cache, 0, num_keys * sizeof *key_cache);
+	key_cache_mask = num_keys - 1;
+	memcpy(key_cache_salt, seed, sizeof seed);
+	key_cache_salt[0] ^= 0x01;
+
+	if (num_entries > 0) {
+		size_t vlen;
+
+		vlen = num_entries * sizeof(curve9767_vcache_entry);
+		vmem = xrealloc(NULL, vlen);
+		if (!curve9767_vcache_init(&vcache, vmem, vlen,
+			ttl == 0 ? 1 : ttl, seed, sizeof seed))
+		{
+			fprintf(stderr, "curve9767d: invalid cache size\n");
+			return EXIT_FAILURE;
+		}
+		vcache_ptr = &vcache;
+	}
+	batch = xrealloc(NULL, batch_max * sizeof *batch);
+	vrec = xrealloc(NULL, batch_max * VREC_STRIDE);
+	vrec_index = xrealloc(NULL, batch_max * sizeof *vrec_index);
+	vrec_results = xrealloc(NULL, (batch_max + 7) >> 3);
+	vtmp_len = 2 * batch_max * CURVE9767_VERIFY_BATCH_RECORD_SIZE;
+	vtmp = xrealloc(NULL, vtmp_len);
+
+	/*
+	 * Open the listening socket.
+	 */
+	if (strlen(path) >= sizeof sa.sun_path) {
+		fprintf(stderr, "curve9767d: socket path too long\n");
+		return EXIT_FAILURE;
+	}
+	memset(&sa, 0, sizeof sa);
+	sa.sun_family = AF_UNIX;
+	strcpy(sa.sun_path, path);
+	lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (lfd < 0) {
+		perror("socket");
+		return EXIT_FAILURE;
+	}
+	unlink(path);
+
+	/*
+	 * The socket carries secret scalars: it is created with mode
+	 * 0600, regardless of the inherited umask.
+	 */
+	old_mask = umask(077);
+	if (bind(lfd, (struct sockaddr *)&sa, sizeof sa) < 0) {
+		perror("bind");
+		return EXIT_FAILURE;
+	}
+	umask(old_mask);
+	if (chmod(path, 0600) < 0 || listen(lfd, 64) < 0) {
+		perror("chmod/listen");
+		return EXIT_FAILURE;
+	}
+	set_nonblock(lfd);
+
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	pfd = NULL;
+	while (!stop) {
+		size_t n;
+		int timeout;
+
+		/*
+		 * If some requests are already complete (e.g. the previous
+		 * batch was full), we do not wait. Clients whose backlog is
+		 * too large are not polled for input (back-pressure); such
+		 * a client has either pending output (POLLOUT) or complete
+		 * requests (the next batch is processed without waiting).
+		 */
+		n = process_batch();
+		timeout = n > 0 ? 0 : -1;
+		pfd = xrealloc(pfd, (num_clients + 1) * sizeof *pfd);
+		pfd[0].fd = lfd;
+		pfd[0].events = POLLIN;
+		for (u = 0; u < num_clients; u ++) {
+			pfd[u + 1].fd = clients[u].fd;
+			pfd[u + 1].events = 0;
+			if (client_can_read(&clients[u])) {
+				pfd[u + 1].events |= POLLIN;
+			}
+			if (clients[u].out.len > clients[u].out.ptr) {
+				pfd[u + 1].events |= POLLOUT;
+			}
+		}
+		if (poll(pfd, num_clients + 1, timeout) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("poll");
+			break;
+		}
+
+		/*
+		 * Read and write data. Clients are scanned in reverse
+		 * order so that removals do not disturb the pollfd
+		 * mapping.
+		 */
+		for (u = num_clients; u -- > 0;) {
+			client *c;
+			short ev;
+
+			c = &clients[u];
+			ev = pfd[u + 1].revents;
+			if ((ev & POLLIN) && !c->eof) {
+				ssize_t r;
+
+				bytebuf_reserve(&c->in, 16384);
+				r = read(c->fd, c->in.buf + c->in.len,
+					c->in.cap - c->in.len);
+				if (r > 0) {
+					c->in.len += (size_t)r;
+				} else if (r == 0) {
+					c->eof = 1;
+				} else if (errno != EAGAIN && errno != EINTR) {
+					c->bad = 1;
+				}
+			}
+			if (c->out.len > c->out.ptr) {
+				ssize_t r;
+
+				r = write(c->fd, c->out.buf + c->out.ptr,
+					c->out.len - c->out.ptr);
+				if (r > 0) {
+					c->out.ptr += (size_t)r;
+				} else if (r < 0 && errno != EAGAIN
+					&& errno != EINTR)
+				{
+					c->bad = 1;
+				}
+			}
+			if ((ev & POLLERR) != 0) {
+				c->bad = 1;
+			}
+			if (c->bad || (c->eof && c->out.len == c->out.ptr
+				&& !has_request(c)))
+			{
+				client_remove(u);
+			}
+		}
+
+		/*
+		 * Accept new clients.
+		 */
+		if (pfd[0].revents & POLLIN) {
+			for (;;) {
+				int fd;
+
+				fd = accept(lfd, NULL, NULL);
+				if (fd < 0) {
+					break;
+				}
+				set_nonblock(fd);
+				client_add(fd);
+			}
+		}
+	}
+
+	close(lfd);
+	unlink(path);
+	return EXIT_SUCCESS;
+}
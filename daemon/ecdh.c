@@ -0,0 +1 @@
+../src/ecdh.c
\ No newline at end of file
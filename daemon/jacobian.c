@@ -0,0 +1 @@
+../src/jacobian.c
\ No newline at end of file
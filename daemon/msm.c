@@ -0,0 +1 @@
+../src/msm.c
\ No newline at end of file
@@ -0,0 +1 @@
+../src/sha3.c
\ No newline at end of file
@@ -0,0 +1,354 @@
+#! /usr/bin/env python3
+
+# This script generates C code for multiplication and squaring in
+# GF(9767^19) (the field elements used in src/ops_ref.c: 19 coefficients,
+# each in the 1..p range, reduction modulo z^19-2, Montgomery reduction
+# of each output coefficient).
+#
+# Kernel shapes:
+#
+#   school   schoolbook product (361 multiplications for gf_mul)
+#   kara1    one Karatsuba level (10+9 split, 300 multiplications); this is
+#            the shape of the hand-written kernels in ops_ref.c
+#   kara2    two Karatsuba levels (5+5 / 5+4 splits, 243 multiplications)
+#
+# and for each shape, two scanning orders for the schoolbook products:
+#
+#   ps       product scanning: each output word is one sum of products;
+#            for the 'school' shape, the reduction modulo z^19-2 is
+#            merged into the sums (one accumulator per output coefficient)
+#   os       operand scanning: the output words are computed by blocks of
+#            R words; for each input word a[i], the products with b[] are
+#            added to the R accumulators of the current block
+#
+# R is the number of accumulators (register pressure); it is set from the
+# target (--target) or explicitly (--regs).
+#
+# All intermediate computations are over 32-bit words and may wrap
+# around; this is harmless since the true value of each unreduced output
+# coefficient is less than 37*p^2 < 2^32, and subtractions in the
+# Karatsuba fix-ups are exact modulo 2^32.
+#
+# Usage:
+#
+#   mkgfkernels.py [ --target name ] [ --regs num ] > gf_kernels.c
+#      Generate all kernels, and a table of kernels (gf_kernel_table[],
+#      see bench-host/gf_kernels.h); this is used by bench-host/bench_gfk.
+#
+#   mkgfkernels.py [ --target name ] [ --regs num ] \
+#                  --select mul=name,sqr=name > ../src/gf_kernel.h
+#      Generate one multiplication and one squaring kernel, as the
+#      functions gfk_mul() and gfk_sqr(); ops_ref.c uses them instead of
+#      its own kernels when compiled with CURVE9767_GF_KERNEL=1.
+#
+# Kernel names are 'shape-order' (e.g. 'kara1-ps').
+
+import sys
+
+P = 9767
+P1I = 3635353193
+N = 19
+
+# Number of accumulators for operand scanning, per target.
+TARGETS = {
+    'generic': 8,
+    'cm0': 4,
+    'arm': 8,
+    'x86': 6,
+    'x86-64': 12,
+    'aarch64': 24,
+}
+
+SHAPES = {
+    'school': 0,
+    'kara1': 1,
+    'kara2': 2,
+}
+
+ORDERS = [ 'ps', 'os' ]
+
+class Gen:
+    def __init__(self, order, regs, sqr):
+        self.order = order
+        self.regs = regs
+        self.sqr = sqr
+        self.lines = []
+        self.decls = []
+        self.ntmp = 0
+
+    def tmp(self, n):
+        name = 't%d' % self.ntmp
+        self.ntmp += 1
+        self.decls.append('uint32_t %s[%d];' % (name, n))
+        return name
+
+    def emit(self, s):
+        self.lines.append('\t' + s)
+
+    def school(self, d, A, B, na, nb):
+        # d[0..na+nb-2] = A*B (A and B are lists of C expressions).
+        nd = na + nb - 1
+        if self.order == 'ps':
+            for k in range(nd):
+                self.emit('%s[%d] = %s;' % (d, k, self.column(A, B, na, nb, k)))
+            return
+        # Operand scanning, by blocks of 'regs' output words.
+        k0 = 0
+        while k0 < nd:
+            k1 = min(k0 + self.regs, nd)
+            first = [ True ] * nd
+            for i in range(na):
+                for k in range(k0, k1):
+                    j = k - i
+                    if j < 0 or j >= nb:
+                        continue
+                    if self.sqr and A is B:
+                        if j < i:
+                            continue
+                        if j == i:
+                            t = '%s * %s' % (A[i], A[i])
+                        else:
+                            t = '((%s * %s) << 1)' % (A[i], A[j])
+                    else:
+                        t = '%s * %s' % (A[i], B[j])
+                    if first[k]:
+                        self.emit('%s[%d] = %s;' % (d, k, t))
+                        first[k] = False
+                    else:
+                        self.emit('%s[%d] += %s;' % (d, k, t))
+            k0 = k1
+
+    def column(self, A, B, na, nb, k):
+        # Sum of A[i]*B[k-i] (one output column).
+        if self.sqr and A is B:
+            dbl = []
+            for i in range(na):
+                j = k - i
+                if j > i and j < nb:
+                    dbl.append('%s * %s' % (A[i], A[j]))
+            s = ''
+            if (k & 1) == 0 and (k >> 1) < na:
+                s = '%s * %s' % (A[k >> 1], A[k >> 1])
+            if len(dbl) > 0:
+                t = '((%s) << 1)' % ' + '.join(dbl)
+                s = t if s == '' else s + ' + ' + t
+            return s
+        terms = []
+        for i in range(na):
+            j = k - i
+            if j >= 0 and j < nb:
+                terms.append('%s * %s' % (A[i], B[j]))
+        return ' + '.join(terms)
+
+    def mul(self, d, A, B, na, nb, level):
+        # d[0..na+nb-2] = A*B, with 'level' Karatsuba steps.
+        if level == 0 or nb < 2:
+            self.school(d, A, B, na, nb)
+            return
+        h = (na + 1) >> 1
+        sq = self.sqr and A is B
+        # aL*bL -> t1 (2*h-1 words)
+        # aH*bH -> t2
+        # (aL+aH)*(bL+bH) -> t3
+        # (for squarings, the same list is passed twice, so that the
+        # sub-products are squarings too)
+        AL = A[:h]
+        AH = A[h:]
+        t1 = self.tmp(2 * h - 1)
+        self.mul(t1, AL, AL if sq else B[:h], h, h, level - 1)
+        t2 = self.tmp(na + nb - 2 * h - 1)
+        self.mul(t2, AH, AH if sq else B[h:], na - h, nb - h, level - 1)
+        t4 = self.tmp(h)
+        for i in range(h):
+            if i + h < na:
+                self.emit('%s[%d] = %s + %s;' % (t4, i, A[i], A[i + h]))
+            else:
+                self.emit('%s[%d] = %s;' % (t4, i, A[i]))
+        A4 = [ '%s[%d]' % (t4, i) for i in range(h) ]
+        if sq:
+            B5 = A4
+        else:
+            t5 = self.tmp(h)
+            for i in range(h):
+                if i + h < nb:
+                    self.emit('%s[%d] = %s + %s;'
+                        % (t5, i, B[i], B[i + h]))
+                else:
+                    self.emit('%s[%d] = %s;' % (t5, i, B[i]))
+            B5 = [ '%s[%d]' % (t5, i) for i in range(h) ]
+        t3 = self.tmp(2 * h - 1)
+        self.mul(t3, A4, B5, h, h, level - 1)
+        # Fix-up: d = t1 + (t3 - t1 - t2)*z^h + t2*z^(2*h)
+        n2 = na + nb - 2 * h - 1
+        nd = na + nb - 1
+        for k in range(nd):
+            terms = []
+            if k < 2 * h - 1:
+                terms.append('%s[%d]' % (t1, k))
+            if k >= 2 * h and k - 2 * h < n2:
+                terms.append('%s[%d]' % (t2, k - 2 * h))
+            m = k - h
+            if m >= 0 and m < 2 * h - 1:
+                terms.append('%s[%d] - %s[%d]' % (t3, m, t1, m))
+                if m < n2:
+                    terms.append('- %s[%d]' % (t2, m))
+            s = ' + '.join(terms).replace('+ -', '-')
+            self.emit('%s[%d] = %s;' % (d, k, s))
+
+def gen_kernel(fname, shape, order, regs, sqr):
+    g = Gen(order, regs, sqr)
+    A = [ '(uint32_t)a[%d]' % i for i in range(N) ]
+    if sqr:
+        B = A
+    else:
+        B = [ '(uint32_t)b[%d]' % i for i in range(N) ]
+    level = SHAPES[shape]
+    if level == 0 and order == 'ps':
+        # Schoolbook with product scanning: one accumulator per output
+        # coefficient, reduction modulo z^19-2 merged into the sums.
+        for k in range(N):
+            lo = g.column(A, B, N, N, k)
+            hi = g.column(A, B, N, N, k + N)
+            if hi != '':
+                s = '%s + ((%s) << 1)' % (lo, hi)
+            else:
+                s = lo
+            g.emit('c[%d] = gfk_frommonty(%s);' % (k, s))
+    else:
+        g.decls.append('uint32_t u[%d];' % (2 * N - 1))
+        g.mul('u', A, B, N, N, level)
+        for k in range(N):
+            if k + N < 2 * N - 1:
+                g.emit('c[%d] = gfk_frommonty(u[%d] + (u[%d] << 1));'
+                    % (k, k, k + N))
+            else:
+                g.emit('c[%d] = gfk_frommonty(u[%d]);' % (k, k))
+    out = []
+    if sqr:
+        out.append('static void')
+        out.append('%s(uint16_t *c, const uint16_t *a)' % fname)
+    else:
+        out.append('static void')
+        out.append('%s(uint16_t *c, const uint16_t *a, const uint16_t *b)'
+            % fname)
+    out.append('{')
+    for d in g.decls:
+        out.append('\t' + d)
+    if len(g.decls) > 0:
+        out.append('')
+    out.extend(g.lines)
+    out.append('}')
+    return '\n'.join(out) + '\n'
+
+def wrap(s):
+    # Wrap long lines at ' + ' boundaries (tabs count as 8 columns);
+    # continuation lines get one extra tab.
+    res = []
+    for line in s.split('\n'):
+        ind = len(line) - len(line.lstrip('\t'))
+        while len(line.expandtabs(8)) > 78:
+            cut = -1
+            pos = line.find(' + ')
+            while pos >= 0 and len(line[:pos].expandtabs(8)) <= 76:
+                cut = pos
+                pos = line.find(' + ', pos + 1)
+            if cut < 0:
+                break
+            res.append(line[:cut])
+            line = '\t' * (ind + 1) + line[cut + 1:]
+        res.append(line)
+    return '\n'.join(res)
+
+HEADER = '''/*
+ * Generated by extra/mkgfkernels.py (%s).
+ * Do not edit.
+ *
+ * Inputs are field elements with coefficients in the 1..p range; outputs
+ * are Montgomery-reduced (see mp_frommonty() in ops_ref.c).
+ */
+'''
+
+REDUCE = '''
+static inline uint16_t
+gfk_frommonty(uint32_t x)
+{
+	return (uint16_t)(1 + ((((uint32_t)(x * (uint32_t)%dU) >> 16)
+		* (uint32_t)%d) >> 16));
+}
+''' % (P1I, P)
+
+def usage():
+    sys.stderr.write('usage: mkgfkernels.py [ --target name ] [ --regs num ]'
+        ' [ --select mul=name,sqr=name ]\n')
+    sys.stderr.write('targets: %s\n' % ' '.join(sorted(TARGETS)))
+    sys.stderr.write('kernels: %s\n' % ' '.join(
+        [ '%s-%s' % (s, o) for s in SHAPES for o in ORDERS ]))
+    sys.exit(2)
+
+def parse_name(name):
+    w = name.split('-')
+    if len(w) != 2 or w[0] not in SHAPES or w[1] not in ORDERS:
+        usage()
+    return w[0], w[1]
+
+def main(argv):
+    target = 'generic'
+    regs = None
+    select = None
+    i = 1
+    while i < len(argv):
+        if argv[i] == '--target' and i + 1 < len(argv):
+            target = argv[i + 1]
+            if target not in TARGETS:
+                usage()
+            i += 2
+        elif argv[i] == '--regs' and i + 1 < len(argv):
+            regs = int(argv[i + 1])
+            if regs < 1:
+                usage()
+            i += 2
+        elif argv[i] == '--select' and i + 1 < len(argv):
+            select = {}
+            for kv in argv[i + 1].split(','):
+                w = kv.split('=')
+                if len(w) != 2 or w[0] not in ('mul', 'sqr'):
+                    usage()
+                select[w[0]] = parse_name(w[1])
+            if len(select) != 2:
+                usage()
+            i += 2
+        else:
+            usage()
+    if regs is None:
+        regs = TARGETS[target]
+    desc = 'target %s, %d accumulators' % (target, regs)
+
+    out = [ HEADER % desc ]
+    if select is not None:
+        s, o = select['mul']
+        out.append('/* gf_mul: %s-%s */\n' % (s, o))
+        out.append(REDUCE)
+        out.append('\n' + gen_kernel('gfk_mul', s, o, regs, False))
+        s, o = select['sqr']
+        out.append('\n/* gf_sqr: %s-%s */\n' % (s, o))
+        out.append(gen_kernel('gfk_sqr', s, o, regs, True))
+    else:
+        out.append('\n#include "inner.h"\n#include "gf_kernels.h"\n')
+        out.append(REDUCE)
+        names = []
+        for s in SHAPES:
+            for o in ORDERS:
+                fn = '%s_%s' % (s, o)
+                names.append(('%s-%s' % (s, o), fn))
+                out.append('\n' + gen_kernel('gfk_mul_' + fn, s, o,
+                    regs, False))
+                out.append('\n' + gen_kernel('gfk_sqr_' + fn, s, o,
+                    regs, True))
+        out.append('\nconst gf_kernel gf_kernel_table[] = {\n')
+        for n, fn in names:
+            out.append('\t{ "%s", gfk_mul_%s, gfk_sqr_%s },\n' % (n, fn, fn))
+        out.append('\t{ 0, 0, 0 }\n};\n')
+        out.append('\nconst char *const gf_kernel_target = "%s";\n' % desc)
+    sys.stdout.write(wrap(''.join(out)))
+
+main(sys.argv)
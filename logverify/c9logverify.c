@@ -0,0 +1,767 @@
+/*
+ * Pipelined verifier for signed append-only logs.
+ *
+ * Log format: a sequence of entries, each consisting of:
+ *   payload length L (4 bytes, little-endian)
+ *   signature (64 bytes)
+ *   encoded public key (32 bytes)
+ *   payload (L bytes)
+ * The signature is computed over SHA3-256(payload), with the hash
+ * function identifier CURVE9767_OID_SHA3_256.
+ *
+ * Verification runs as a pipeline of three stages, connected by bounded
+ * queues, each stage having its own threads:
+ *
+ *  - reader (one thread): splits the log into batches of entries, from
+ *    a memory-mapped file (payloads are not copied) or from a stream
+ *    (entries are copied into the batch buffer);
+ *
+ *  - hashing (-h threads): computes SHA3-256 of each payload, and lays
+ *    out the batch records (signature, public key, hashed message);
+ *
+ *  - verification (-v threads): verifies each batch in place with
+ *    curve9767_sign_verify_strided(), which decodes the points,
+ *    computes the challenges, and checks the batch with a single MSM
+ *    (bisecting on failure).
+ *
+ * Batches come from a fixed pool, and queues have a bounded depth: when
+ * the verifiers fall behind, the queues fill up, then the hashers and
+ * the reader block (back-pressure), so memory usage is bounded. For
+ * each stage, the number of entries, busy time, and time spent waiting
+ * for input or for room in the output queue are reported at the end.
+ *
+ * Usage:
+ *
+ *   c9logverify [ options ] logfile
+ *     -h num    number of hashing threads (default: 1)
+ *     -v num    number of verification threads (default: number of
+ *               CPUs minus 2, at least 1)
+ *     -b num    entries per batch (default: 1024)
+ *     -q num    queue depth, in batches (default: 4)
+ *     -s        streaming input (read() instead of mmap()); this is
+ *               implied if logfile is "-" (standard input)
+ *
+ *   c9logverify -g num [ -x k ] logfile
+ *     Generate a test log with num entries; if k is not zero, then
+ *     every k-th entry (entries k-1, 2*k-1...) has an invalid signature.
+ *
+ * Invalid entries are printed on standard output. The exit status is 0
+ * if all entries are valid, 1 if some entries are invalid, 2 on error
+ * (including a truncated log).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "curve9767.h"
+
+#define ENTRY_HEADER   (4 + 64 + 32)
+#define MAX_PAYLOAD    ((size_t)1 << 28)
+#define MAX_THREADS    64
+
+/*
+ * Batch records, as seen by curve9767_sign_verify_strided().
+ */
+#define REC_STRIDE     128
+
+static const curve9767_record_layout rec_layout = {
+	REC_STRIDE, 0, 64, 96, CURVE9767_RECORD_FIXED_LEN, 32
+};
+
+typedef struct {
+	/* number of the first entry, and number of entries */
+	uint64_t first;
+	size_t num;
+
+	/* entry data: the mapped file, or buf (streaming mode) */
+	const uint8_t *data;
+	uint8_t *buf;
+	size_t buf_len, buf_size;
+
+	/* per-entry offset in data, and offset in the log */
+	size_t *off;
+	uint64_t *pos;
+
+	/* records (REC_STRIDE bytes per entry) and result bitmap */
+	uint8_t *recs;
+	uint8_t *results;
+} batch;
+
+/*
+ * Bounded queue of batches. get() returns NULL when the queue is empty
+ * and all producers have closed it.
+ */
+typedef struct {
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty, not_full;
+	batch **items;
+	size_t cap, head, count;
+	unsigned producers;
+} queue;
+
+/*
+ * Per-thread statistics (times in seconds).
+ */
+typedef struct {
+	uint64_t entries, bytes, invalid;
+	double busy, wait_in, wait_out;
+} stats;
+
+typedef struct {
+	const char *name;
+	unsigned num_threads;
+	stats st;
+} stage;
+
+static queue q_free, q_hash, q_verify;
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t batch_size = 1024;
+static int read_error = 0;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static void *
+xmalloc(size_t len)
+{
+	void *p;
+
+	p = malloc(len);
+	if (p == NULL) {
+		fprintf(stderr, "malloc() failed\n");
+		exit(2);
+	}
+	return p;
+}
+
+static void
+queue_init(queue *q, size_t cap, unsigned producers)
+{
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->not_empty, NULL);
+	pthread_cond_init(&q->not_full, NULL);
+	q->items = xmalloc(cap * sizeof *q->items);
+	q->cap = cap;
+	q->head = 0;
+	q->count = 0;
+	q->producers = producers;
+}
+
+static void
+queue_put(queue *q, batch *b, double *wait)
+{
+	double t0;
+
+	t0 = now();
+	pthread_mutex_lock(&q->lock);
+	while (q->count == q->cap) {
+		pthread_cond_wait(&q->not_full, &q->lock);
+	}
+	q->items[(q->head + q->count) % q->cap] = b;
+	q->count ++;
+	pthread_cond_signal(&q->not_empty);
+	pthread_mutex_unlock(&q->lock);
+	*wait += now() - t0;
+}
+
+static batch *
+queue_get(queue *q, double *wait)
+{
+	batch *b;
+	double t0;
+
+	t0 = now();
+	pthread_mutex_lock(&q->lock);
+	while (q->count == 0 && q->producers > 0) {
+		pthread_cond_wait(&q->not_empty, &q->lock);
+	}
+	if (q->count == 0) {
+		b = NULL;
+	} else {
+		b = q->items[q->head];
+		q->head = (q->head + 1) % q->cap;
+		q->count --;
+		pthread_cond_signal(&q->not_full);
+	}
+	pthread_mutex_unlock(&q->lock);
+	*wait += now() - t0;
+	return b;
+}
+
+static void
+queue_close(queue *q)
+{
+	pthread_mutex_lock(&q->lock);
+	q->producers --;
+	pthread_cond_broadcast(&q->not_empty);
+	pthread_mutex_unlock(&q->lock);
+}
+
+static uint32_t
+dec32le(const uint8_t *buf)
+{
+	return (uint32_t)buf[0]
+		| ((uint32_t)buf[1] << 8)
+		| ((uint32_t)buf[2] << 16)
+		| ((uint32_t)buf[3] << 24);
+}
+
+static void
+enc32le(uint8_t *buf, uint32_t x)
+{
+	buf[0] = (uint8_t)x;
+	buf[1] = (uint8_t)(x >> 8);
+	buf[2] = (uint8_t)(x >> 16);
+	buf[3] = (uint8_t)(x >> 24);
+}
+
+/* ==================================================================== */
+/*
+ * Reader stage.
+ */
+
+typedef struct {
+	stage *sg;
+	const uint8_t *map;
+	size_t map_len;
+	FILE *f;
+} reader_ctx;
+
+/*
+ * Streaming mode: read the next entry into the batch buffer. Returned
+ * value is 1 on success, 0 on end of log, -1 on error (truncated or
+ * invalid entry).
+ */
+static int
+read_entry(FILE *f, batch *b)
+{
+	uint8_t hd[ENTRY_HEADER];
+	size_t len, plen;
+
+	len = fread(hd, 1, sizeof hd, f);
+	if (len == 0 && feof(f)) {
+		return 0;
+	}
+	if (len != sizeof hd) {
+		return -1;
+	}
+	plen = dec32le(hd);
+	if (plen > MAX_PAYLOAD) {
+		return -1;
+	}
+	len = sizeof hd + plen;
+	if (b->buf_size - b->buf_len < len) {
+		size_t nsize;
+
+		nsize = b->buf_size * 2;
+		if (nsize < b->buf_len + len) {
+			nsize = b->buf_len + len;
+		}
+		b->buf = realloc(b->buf, nsize);
+		if (b->buf == NULL) {
+			fprintf(stderr, "realloc() failed\n");
+			exit(2);
+		}
+		b->buf_size = nsize;
+	}
+	memcpy(b->buf + b->buf_len, hd, sizeof hd);
+	if (fread(b->buf + b->buf_len + sizeof hd, 1, plen, f) != plen) {
+		return -1;
+	}
+	b->off[b->num] = b->buf_len;
+	b->buf_len += len;
+	return 1;
+}
+
+static void *
+reader_run(void *arg)
+{
+	reader_ctx *rc;
+	stats *st;
+	uint64_t pos, first;
+	int eof;
+
+	rc = arg;
+	st = &rc->sg->st;
+	pos = 0;
+	first = 0;
+	eof = 0;
+	while (!eof) {
+		batch *b;
+		double t0;
+
+		b = queue_get(&q_free, &st->wait_in);
+		t0 = now();
+		b->first = first;
+		b->num = 0;
+		b->buf_len = 0;
+		while (b->num < batch_size) {
+			if (rc->map != NULL) {
+				size_t plen;
+
+				if (pos == rc->map_len) {
+					eof = 1;
+					break;
+				}
+				if (rc->map_len - pos < ENTRY_HEADER) {
+					read_error = 1;
+					eof = 1;
+					break;
+				}
+				plen = dec32le(rc->map + pos);
+				if (plen > rc->map_len - pos - ENTRY_HEADER) {
+					read_error = 1;
+					eof = 1;
+					break;
+				}
+				b->off[b->num] = (size_t)pos;
+				b->pos[b->num] = pos;
+				pos += ENTRY_HEADER + plen;
+			} else {
+				int r;
+
+				r = read_entry(rc->f, b);
+				if (r <= 0) {
+					if (r < 0) {
+						read_error = 1;
+					}
+					eof = 1;
+					break;
+				}
+				b->pos[b->num] = pos;
+				pos += b->buf_len - b->off[b->num];
+			}
+			b->num ++;
+		}
+		b->data = rc->map != NULL ? rc->map : b->buf;
+		first += b->num;
+		st->entries += b->num;
+		st->busy += now() - t0;
+		if (b->num == 0) {
+			queue_put(&q_free, b, &st->wait_out);
+		} else {
+			queue_put(&q_hash, b, &st->wait_out);
+		}
+	}
+	st->bytes = pos;
+	queue_close(&q_hash);
+	return NULL;
+}
+
+/* ==================================================================== */
+/*
+ * Hashing stage.
+ */
+
+typedef struct {
+	stats st;
+	pthread_t th;
+} worker;
+
+static void *
+hash_run(void *arg)
+{
+	worker *wk;
+
+	wk = arg;
+	for (;;) {
+		batch *b;
+		double t0;
+		size_t u;
+
+		b = queue_get(&q_hash, &wk->st.wait_in);
+		if (b == NULL) {
+			break;
+		}
+		t0 = now();
+		for (u = 0; u < b->num; u ++) {
+			const uint8_t *e;
+			uint8_t *rec;
+			sha3_context sc;
+			size_t plen;
+
+			e = b->data + b->off[u];
+			rec = b->recs + u * REC_STRIDE;
+			plen = dec32le(e);
+			memcpy(rec, e + 4, 96);
+			sha3_init(&sc, 256);
+			sha3_update(&sc, e + ENTRY_HEADER, plen);
+			sha3_close(&sc, rec + 96);
+			wk->st.bytes += plen;
+		}
+		wk->st.entries += b->num;
+		wk->st.busy += now() - t0;
+		queue_put(&q_verify, b, &wk->st.wait_out);
+	}
+	queue_close(&q_verify);
+	return NULL;
+}
+
+/* ==================================================================== */
+/*
+ * Verification stage.
+ */
+
+static size_t work_len;
+
+static void *
+verify_run(void *arg)
+{
+	worker *wk;
+	void *work;
+
+	wk = arg;
+	work = xmalloc(work_len);
+	for (;;) {
+		batch *b;
+		double t0;
+		size_t u;
+
+		b = queue_get(&q_verify, &wk->st.wait_in);
+		if (b == NULL) {
+			break;
+		}
+		t0 = now();
+		if (!curve9767_sign_verify_strided(b->results, b->recs, b->num,
+			&rec_layout, CURVE9767_OID_SHA3_256, work, work_len))
+		{
+			pthread_mutex_lock(&out_lock);
+			for (u = 0; u < b->num; u ++) {
+				if (((b->results[u >> 3] >> (u & 7)) & 1) == 0) {
+					printf("invalid entry %llu (offset %llu)\n",
+						(unsigned long long)(b->first + u),
+						(unsigned long long)b->pos[u]);
+					wk->st.invalid ++;
+				}
+			}
+			pthread_mutex_unlock(&out_lock);
+		}
+		wk->st.entries += b->num;
+		wk->st.busy += now() - t0;
+		queue_put(&q_free, b, &wk->st.wait_out);
+	}
+	free(work);
+	return NULL;
+}
+
+/* ==================================================================== */
+/*
+ * Test log generation.
+ */
+
+#define GEN_KEYS   16
+
+static int
+generate(const char *fname, uint64_t num, uint64_t bad)
+{
+	curve9767_scalar s[GEN_KEYS];
+	curve9767_point Q[GEN_KEYS];
+	uint8_t t[GEN_KEYS][32];
+	shake_context rng;
+	FILE *f;
+	uint64_t u;
+	int i;
+
+	for (i = 0; i < GEN_KEYS; i ++) {
+		char seed[32];
+
+		snprintf(seed, sizeof seed, "c9logverify-key-%d", i);
+		curve9767_keygen(&s[i], t[i], &Q[i], seed, strlen(seed));
+	}
+	f = fopen(fname, "wb");
+	if (f == NULL) {
+		fprintf(stderr, "cannot open '%s': %s\n",
+			fname, strerror(errno));
+		return 2;
+	}
+	shake_init(&rng, 256);
+	shake_inject(&rng, "c9logverify", 11);
+	shake_flip(&rng);
+	for (u = 0; u < num; u ++) {
+		uint8_t e[ENTRY_HEADER + 300], hv[32];
+		sha3_context sc;
+		size_t plen;
+		int k;
+
+		shake_extract(&rng, e, 1);
+		plen = 16 + (size_t)e[0];
+		k = (int)(u % GEN_KEYS);
+		shake_extract(&rng, e + ENTRY_HEADER, plen);
+		enc32le(e, (uint32_t)plen);
+		sha3_init(&sc, 256);
+		sha3_update(&sc, e + ENTRY_HEADER, plen);
+		sha3_close(&sc, hv);
+		curve9767_sign_generate(e + 4, &s[k], t[k], &Q[k],
+			CURVE9767_OID_SHA3_256, hv, sizeof hv);
+		curve9767_point_encode(e + 68, &Q[k]);
+		if (bad != 0 && (u % bad) == bad - 1) {
+			e[ENTRY_HEADER] ^= 0x01;
+		}
+		if (fwrite(e, 1, ENTRY_HEADER + plen, f) != ENTRY_HEADER + plen) {
+			fprintf(stderr, "write error\n");
+			fclose(f);
+			return 2;
+		}
+	}
+	if (fclose(f) != 0) {
+		fprintf(stderr, "write error\n");
+		return 2;
+	}
+	return 0;
+}
+
+/* ==================================================================== */
+
+static void
+usage(void)
+{
+	fprintf(stderr,
+"usage: c9logverify [ -h num ] [ -v num ] [ -b num ] [ -q num ] [ -s ] logfile\n"
+"       c9logverify -g num [ -x k ] logfile\n");
+	exit(2);
+}
+
+static void
+print_stage(const stage *sg)
+{
+	printf("%-8s %3u %12llu %10.3f %10.3f %10.3f %12.0f\n",
+		sg->name, sg->num_threads,
+		(unsigned long long)sg->st.entries,
+		sg->st.busy, sg->st.wait_in, sg->st.wait_out,
+		sg->st.busy > 0.0
+			? (double)sg->st.entries * sg->num_threads
+				/ sg->st.busy
+			: 0.0);
+}
+
+static void
+add_stats(stats *d, const stats *s)
+{
+	d->entries += s->entries;
+	d->bytes += s->bytes;
+	d->invalid += s->invalid;
+	d->busy += s->busy;
+	d->wait_in += s->wait_in;
+	d->wait_out += s->wait_out;
+}
+
+int
+main(int argc, char *argv[])
+{
+	stage sg_read, sg_hash, sg_verify;
+	worker hw[MAX_THREADS], vw[MAX_THREADS];
+	reader_ctx rc;
+	pthread_t rth;
+	unsigned num_hash, num_verify, i;
+	size_t depth, num_batches, u;
+	uint64_t gen_num, gen_bad;
+	int streaming, opt;
+	const char *fname;
+	batch *batches;
+	double t0, wall;
+	long ncpu;
+	int fd;
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	num_hash = 1;
+	num_verify = ncpu > 3 ? (unsigned)(ncpu - 2) : 1;
+	depth = 4;
+	streaming = 0;
+	gen_num = 0;
+	gen_bad = 0;
+	while ((opt = getopt(argc, argv, "h:v:b:q:sg:x:")) != -1) {
+		switch (opt) {
+		case 'h':
+			num_hash = (unsigned)strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			num_verify = (unsigned)strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			batch_size = (size_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'q':
+			depth = (size_t)strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			streaming = 1;
+			break;
+		case 'g':
+			gen_num = strtoull(optarg, NULL, 0);
+			break;
+		case 'x':
+			gen_bad = strtoull(optarg, NULL, 0);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind + 1 != argc) {
+		usage();
+	}
+	fname = argv[optind];
+	if (gen_num != 0) {
+		return generate(fname, gen_num, gen_bad);
+	}
+	if (num_hash < 1 || num_hash > MAX_THREADS
+		|| num_verify < 1 || num_verify > MAX_THREADS
+		|| batch_size < 1 || batch_size > ((size_t)1 << 20)
+		|| depth < 1)
+	{
+		usage();
+	}
+
+	/*
+	 * Open the log.
+	 */
+	memset(&rc, 0, sizeof rc);
+	if (strcmp(fname, "-") == 0) {
+		rc.f = stdin;
+	} else if (streaming) {
+		rc.f = fopen(fname, "rb");
+		if (rc.f == NULL) {
+			fprintf(stderr, "cannot open '%s': %s\n",
+				fname, strerror(errno));
+			return 2;
+		}
+	} else {
+		struct stat sb;
+
+		fd = open(fname, O_RDONLY);
+		if (fd < 0 || fstat(fd, &sb) < 0) {
+			fprintf(stderr, "cannot open '%s': %s\n",
+				fname, strerror(errno));
+			return 2;
+		}
+		rc.map_len = (size_t)sb.st_size;
+		if (rc.map_len > 0) {
+			void *m;
+
+			m = mmap(NULL, rc.map_len, PROT_READ,
+				MAP_PRIVATE, fd, 0);
+			if (m == MAP_FAILED) {
+				fprintf(stderr, "mmap() failed: %s\n",
+					strerror(errno));
+				return 2;
+			}
+			madvise(m, rc.map_len, MADV_SEQUENTIAL);
+			rc.map = m;
+		} else {
+			/*
+			 * Empty log: a non-NULL map with zero length.
+			 */
+			rc.map = (const uint8_t *)"";
+		}
+		close(fd);
+	}
+
+	/*
+	 * Batch pool: enough for full queues, plus one batch per thread.
+	 */
+	num_batches = 2 * depth + num_hash + num_verify + 1;
+	batches = xmalloc(num_batches * sizeof *batches);
+	queue_init(&q_free, num_batches, 1);
+	queue_init(&q_hash, depth, 1);
+	queue_init(&q_verify, depth, num_hash);
+	for (u = 0; u < num_batches; u ++) {
+		batch *b;
+		double w;
+
+		b = &batches[u];
+		memset(b, 0, sizeof *b);
+		b->off = xmalloc(batch_size * sizeof *b->off);
+		b->pos = xmalloc(batch_size * sizeof *b->pos);
+		b->recs = xmalloc(batch_size * REC_STRIDE);
+		b->results = xmalloc((batch_size + 7) >> 3);
+		if (rc.map == NULL) {
+			b->buf_size = batch_size * (ENTRY_HEADER + 256);
+			b->buf = xmalloc(b->buf_size);
+		}
+		w = 0.0;
+		queue_put(&q_free, b, &w);
+	}
+	work_len = 2 * batch_size * CURVE9767_VERIFY_BATCH_RECORD_SIZE
+		+ curve9767_msm_scratch_size(12);
+
+	/*
+	 * Run the pipeline.
+	 */
+	memset(&sg_read, 0, sizeof sg_read);
+	memset(&sg_hash, 0, sizeof sg_hash);
+	memset(&sg_verify, 0, sizeof sg_verify);
+	sg_read.name = "read";
+	sg_read.num_threads = 1;
+	sg_hash.name = "hash";
+	sg_hash.num_threads = num_hash;
+	sg_verify.name = "verify";
+	sg_verify.num_threads = num_verify;
+	memset(hw, 0, sizeof hw);
+	memset(vw, 0, sizeof vw);
+	rc.sg = &sg_read;
+	t0 = now();
+	if (pthread_create(&rth, NULL, reader_run, &rc) != 0) {
+		fprintf(stderr, "pthread_create() failed\n");
+		return 2;
+	}
+	for (i = 0; i < num_hash; i ++) {
+		if (pthread_create(&hw[i].th, NULL, hash_run, &hw[i]) != 0) {
+			fprintf(stderr, "pthread_create() failed\n");
+			return 2;
+		}
+	}
+	for (i = 0; i < num_verify; i ++) {
+		if (pthread_create(&vw[i].th, NULL, verify_run, &vw[i]) != 0) {
+			fprintf(stderr, "pthread_create() failed\n");
+			return 2;
+		}
+	}
+	pthread_join(rth, NULL);
+	for (i = 0; i < num_hash; i ++) {
+		pthread_join(hw[i].th, NULL);
+		add_stats(&sg_hash.st, &hw[i].st);
+	}
+	for (i = 0; i < num_verify; i ++) {
+		pthread_join(vw[i].th, NULL);
+		add_stats(&sg_verify.st, &vw[i].st);
+	}
+	wall = now() - t0;
+
+	/*
+	 * Report. Rates are per stage, in entries per second of busy
+	 * time, scaled by the number of threads (i.e. the stage
+	 * throughput if its threads were never idle).
+	 */
+	fflush(stdout);
+	printf("%-8s %3s %12s %10s %10s %10s %12s\n",
+		"stage", "thr", "entries", "busy(s)", "wait-in", "wait-out",
+		"entries/s");
+	print_stage(&sg_read);
+	print_stage(&sg_hash);
+	print_stage(&sg_verify);
+	printf("log: %llu bytes, %llu entries, %llu invalid entries,"
+		" %.3f s, %.0f entries/s\n",
+		(unsigned long long)sg_read.st.bytes,
+		(unsigned long long)sg_verify.st.entries,
+		(unsigned long long)sg_verify.st.invalid, wall,
+		wall > 0.0 ? (double)sg_verify.st.entries / wall : 0.0);
+	if (read_error) {
+		fprintf(stderr, "truncated or invalid log (after entry %llu)\n",
+			(unsigned long long)sg_read.st.entries);
+		return 2;
+	}
+	return sg_verify.st.invalid != 0;
+}
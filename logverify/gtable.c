@@ -0,0 +1 @@
+../src/gtable.c
\ No newline at end of file
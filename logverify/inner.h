@@ -0,0 +1 @@
+../src/inner.h
\ No newline at end of file
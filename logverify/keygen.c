@@ -0,0 +1 @@
+../src/keygen.c
\ No newline at end of file
@@ -0,0 +1 @@
+../src/scalar_ref.c
\ No newline at end of file
@@ -0,0 +1 @@
+../src/sign.c
\ No newline at end of file
@@ -0,0 +1 @@
+../src/tune.c
\ No newline at end of file
@@ -0,0 +1,389 @@
+#include "inner.h"
+
+#define DOM_BATCH   CURVE9767_DOM("batch:")
+
+/*
+ * Batch verification of signed records.
+ *
+ * A signature (c, d) on hashed message hv, for public key Q, is valid if
+ * the encoding of d*G - e*Q is c (e is the challenge). With C the point
+ * decoded from c, this is equivalent to d*G - e*Q - C = 0. For records
+ * 0 to m-1, with random 128-bit coefficients z_i, we check that:
+ *   (sum z_i*d_i)*G + sum (-z_i*e_i)*Q_i + sum z_i*(-C_i) = 0
+ * The sum over the C_i and Q_i is computed with the MSM; the G term is
+ * computed separately (so that any sub-range of records can be checked
+ * with the same arrays, for the bisection). The points C_i are negated
+ * (rather than the coefficients z_i), so that half of the MSM scalars
+ * are only 128 bits long, and have zero digits in the upper windows.
+ *
+ * The coefficients are derived by hashing all records of the chunk: an
+ * attacker cannot choose invalid signatures that cancel each other out
+ * without predicting the coefficients.
+ *
+ * Work area layout, for a chunk of m records:
+ *   points    2*m points: -C_i at index 2*i, Q_i at index 2*i+1
+ *   scalars   2*m encoded scalars: z_i and -z_i*e_i
+ *   scratch   MSM scratch area (rest of the work area)
+ * Records which cannot be decoded (or whose signature point cannot be
+ * decoded) are handled individually in the decoding pass, and get zero
+ * coefficients.
+ */
+
+/*
+ * Minimum range size for a batch check; smaller ranges are verified
+ * individually.
+ */
+#define BATCH_MIN   4
+
+typedef struct {
+	const uint8_t *base;
+	const curve9767_record_layout *rl;
+	const char *hash_oid;
+	uint8_t *results;
+	curve9767_point *points;
+	uint8_t *scalars;
+	void *scratch;
+	size_t scratch_len;
+} batch_context;
+
+static const uint8_t *
+record(const batch_context *bc, size_t i)
+{
+	return bc->base + i * bc->rl->stride;
+}
+
+static size_t
+record_hv_len(const batch_context *bc, const uint8_t *rec)
+{
+	if (bc->rl->hv_len_off == CURVE9767_RECORD_FIXED_LEN) {
+		return bc->rl->hv_len;
+	}
+	return rec[bc->rl->hv_len_off];
+}
+
+static void
+set_result(const batch_context *bc, size_t i, uint32_t r)
+{
+	if (bc->results != NULL) {
+		bc->results[i >> 3] &= (uint8_t)~(1u << (i & 7));
+		bc->results[i >> 3] |= (uint8_t)(r << (i & 7));
+	}
+}
+
+static uint32_t
+get_result(const batch_context *bc, size_t i)
+{
+	return (bc->results[i >> 3] >> (i & 7)) & 1;
+}
+
+/*
+ * Verify record i individually, with its decoded public key Q. Returned
+ * value is 1 if the signature is valid, 0 otherwise.
+ */
+static uint32_t
+verify_one(const batch_context *bc, size_t i, const curve9767_point *Q)
+{
+	const uint8_t *rec, *sig;
+	curve9767_scalar d, e;
+	curve9767_point C;
+	uint8_t tmp[32];
+
+	rec = record(bc, i);
+	sig = rec + bc->rl->sig_off;
+	if (!curve9767_scalar_decode_strict(&d, sig + 32, 32)) {
+		return 0;
+	}
+	curve9767_inner_sign_challenge(&e, sig, rec + bc->rl->Q_off,
+		bc->hash_oid, rec + bc->rl->hv_off, record_hv_len(bc, rec));
+	curve9767_scalar_neg(&e, &e);
+	curve9767_point_mul_mulgen_add(&C, Q, &e, &d);
+	curve9767_point_encode(tmp, &C);
+	return memcmp(tmp, sig, 32) == 0;
+}
+
+/*
+ * Check records j0 to j1-1 (relative to the chunk start i0) with a
+ * single combined equation; records that already failed (or were
+ * handled individually) have zero coefficients.
+ */
+static int
+check_range(const batch_context *bc, size_t i0, size_t j0, size_t j1)
+{
+	curve9767_scalar sg, z[8], d[8];
+	curve9767_point R, T;
+	size_t j, k, num;
+
+	/*
+	 * The products z_j*d_j are computed by groups of eight, with the
+	 * batch scalar multiplication.
+	 */
+	sg = curve9767_scalar_zero;
+	num = 0;
+	for (j = j0; j < j1; j ++) {
+		const uint8_t *sig;
+
+		/*
+		 * The stored coefficient for -C_j is z_j; records with a
+		 * zero coefficient do not contribute.
+		 */
+		sig = record(bc, i0 + j) + bc->rl->sig_off;
+		curve9767_scalar_decode_strict(&z[num],
+			bc->scalars + (j << 6), 32);
+		if (curve9767_scalar_is_zero(&z[num])) {
+			continue;
+		}
+		curve9767_scalar_decode_strict(&d[num], sig + 32, 32);
+		if (++ num == 8) {
+			curve9767_scalar_mul_batch(d, d, z, num);
+			for (k = 0; k < num; k ++) {
+				curve9767_scalar_add(&sg, &sg, &d[k]);
+			}
+			num = 0;
+		}
+	}
+	if (num > 0) {
+		curve9767_scalar_mul_batch(d, d, z, num);
+		for (k = 0; k < num; k ++) {
+			curve9767_scalar_add(&sg, &sg, &d[k]);
+		}
+	}
+	curve9767_msm(&R, bc->points + (j0 << 1), bc->scalars + (j0 << 6),
+		(j1 - j0) << 1, bc->scratch, bc->scratch_len);
+	curve9767_point_mulgen(&T, &sg);
+	curve9767_point_add(&R, &R, &T);
+	return curve9767_point_is_neutral(&R);
+}
+
+/*
+ * Locate the invalid records among j0 to j1-1 (relative to the chunk
+ * start i0), knowing that the combined check failed for that range.
+ */
+static void
+bisect(const batch_context *bc, size_t i0, size_t j0, size_t j1)
+{
+	size_t j, jm;
+
+	if (j1 - j0 <= BATCH_MIN) {
+		for (j = j0; j < j1; j ++) {
+			const uint8_t *sc;
+			int k, nz;
+
+			/*
+			 * Only records with a non-zero coefficient are
+			 * still undecided.
+			 */
+			sc = bc->scalars + (j << 6);
+			nz = 0;
+			for (k = 0; k < 32; k ++) {
+				nz |= sc[k];
+			}
+			if (nz) {
+				set_result(bc, i0 + j, verify_one(bc, i0 + j,
+					&bc->points[(j << 1) + 1]));
+			}
+		}
+		return;
+	}
+	/*
+	 * If the first half passes, then the second half must contain
+	 * an invalid record, and does not need to be checked.
+	 */
+	jm = j0 + ((j1 - j0) >> 1);
+	if (check_range(bc, i0, j0, jm)) {
+		bisect(bc, i0, jm, j1);
+	} else {
+		bisect(bc, i0, j0, jm);
+		if (!check_range(bc, i0, jm, j1)) {
+			bisect(bc, i0, jm, j1);
+		}
+	}
+}
+
+/*
+ * Process records i0 to i0+m-1 as one chunk. Returned value is 1 if all
+ * records are valid, 0 otherwise.
+ */
+static int
+verify_chunk(const batch_context *bc, size_t i0, size_t m)
+{
+	shake_context sc;
+	size_t j;
+	uint32_t r;
+
+	/*
+	 * Derive the coefficients from the whole chunk.
+	 */
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_BATCH, strlen(DOM_BATCH));
+	shake_inject(&sc, bc->hash_oid, strlen(bc->hash_oid));
+	shake_inject(&sc, ":", 1);
+	for (j = 0; j < m; j ++) {
+		const uint8_t *rec;
+		size_t hv_len;
+		uint8_t hb[8];
+		int k;
+
+		rec = record(bc, i0 + j);
+		hv_len = record_hv_len(bc, rec);
+		for (k = 0; k < 8; k ++) {
+			hb[k] = (uint8_t)((uint64_t)hv_len >> (k << 3));
+		}
+		shake_inject(&sc, rec + bc->rl->sig_off, 64);
+		shake_inject(&sc, rec + bc->rl->Q_off, 32);
+		shake_inject(&sc, hb, sizeof hb);
+		shake_inject(&sc, rec + bc->rl->hv_off, hv_len);
+	}
+	shake_flip(&sc);
+
+	/*
+	 * Decode all points and compute all challenges and coefficients.
+	 */
+	r = 1;
+	for (j = 0; j < m; j ++) {
+		const uint8_t *rec, *sig;
+		curve9767_point *C, *Q;
+		uint8_t *sz, *se;
+		curve9767_scalar d, e, z;
+		uint8_t tmp[32];
+		uint32_t ok;
+
+		rec = record(bc, i0 + j);
+		sig = rec + bc->rl->sig_off;
+		C = &bc->points[j << 1];
+		Q = &bc->points[(j << 1) + 1];
+		sz = bc->scalars + (j << 6);
+		se = sz + 32;
+		memset(tmp, 0, sizeof tmp);
+		shake_extract(&sc, tmp, 16);
+		curve9767_scalar_decode_strict(&z, tmp, 32);
+
+		ok = curve9767_point_decode(Q, rec + bc->rl->Q_off);
+		ok &= curve9767_scalar_decode_strict(&d, sig + 32, 32);
+		if (!ok) {
+			/*
+			 * Invalid public key or second signature half.
+			 */
+			set_result(bc, i0 + j, 0);
+			r = 0;
+			memset(sz, 0, 64);
+			curve9767_point_set_neutral(C);
+			curve9767_point_set_neutral(Q);
+			continue;
+		}
+
+		/*
+		 * The signature point must decode, and re-encode into the
+		 * same bytes (for an exact match with the individual
+		 * verification, which compares encodings). Otherwise, the
+		 * record is verified individually (this includes the case
+		 * of an encoded point-at-infinity).
+		 */
+		ok = curve9767_point_decode(C, sig);
+		if (ok) {
+			curve9767_point_encode(tmp, C);
+			ok = memcmp(tmp, sig, 32) == 0;
+		}
+		if (!ok) {
+			ok = verify_one(bc, i0 + j, Q);
+			set_result(bc, i0 + j, ok);
+			r &= ok;
+			memset(sz, 0, 64);
+			curve9767_point_set_neutral(C);
+			continue;
+		}
+
+		curve9767_inner_sign_challenge(&e, sig, rec + bc->rl->Q_off,
+			bc->hash_oid, rec + bc->rl->hv_off,
+			record_hv_len(bc, rec));
+		curve9767_scalar_mul(&e, &e, &z);
+		curve9767_scalar_neg(&e, &e);
+		curve9767_point_neg(C, C);
+		curve9767_scalar_encode(sz, &z);
+		curve9767_scalar_encode(se, &e);
+		set_result(bc, i0 + j, 1);
+	}
+
+	if (check_range(bc, i0, 0, m)) {
+		return (int)r;
+	}
+	if (bc->results == NULL) {
+		return 0;
+	}
+	bisect(bc, i0, 0, m);
+	for (j = 0; j < m; j ++) {
+		r &= get_result(bc, i0 + j);
+	}
+	return (int)r;
+}
+
+/* see curve9767.h */
+int
+curve9767_sign_verify_strided(uint8_t *results,
+	const void *base, size_t n, const curve9767_record_layout *rl,
+	const char *hash_oid, void *tmp, size_t tmp_len)
+{
+	batch_context bc;
+	size_t m, i;
+	int r;
+
+	if (results != NULL) {
+		memset(results, 0, (n + 7) >> 3);
+	}
+	bc.base = base;
+	bc.rl = rl;
+	bc.hash_oid = hash_oid;
+	bc.results = results;
+
+	/*
+	 * Chunk size: half of the work area is used for the records,
+	 * the other half for the MSM scratch area.
+	 */
+	m = (tmp_len >> 1) / CURVE9767_VERIFY_BATCH_RECORD_SIZE;
+	if (m > n) {
+		m = n;
+	}
+	if (m < BATCH_MIN || (tmp_len - m * CURVE9767_VERIFY_BATCH_RECORD_SIZE)
+		< curve9767_msm_scratch_size(2))
+	{
+		/*
+		 * Not enough room for batch processing (or too few
+		 * records): verify individually.
+		 */
+		r = 1;
+		for (i = 0; i < n; i ++) {
+			curve9767_point Q;
+			uint32_t ok;
+
+			ok = curve9767_point_decode(&Q,
+				record(&bc, i) + rl->Q_off);
+			if (ok) {
+				ok = verify_one(&bc, i, &Q);
+			}
+			set_result(&bc, i, ok);
+			r &= (int)ok;
+			if (!r && results == NULL) {
+				return 0;
+			}
+		}
+		return r;
+	}
+	bc.points = tmp;
+	bc.scalars = (uint8_t *)tmp + m * 2 * sizeof(curve9767_point);
+	bc.scratch = bc.scalars + m * 64;
+	bc.scratch_len = tmp_len - m * CURVE9767_VERIFY_BATCH_RECORD_SIZE;
+
+	r = 1;
+	for (i = 0; i < n; i += m) {
+		size_t k;
+
+		k = n - i;
+		if (k > m) {
+			k = m;
+		}
+		r &= verify_chunk(&bc, i, k);
+		if (!r && results == NULL) {
+			return 0;
+		}
+	}
+	return r;
+}
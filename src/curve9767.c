@@ -142,10 +142,90 @@ do_lookup(curve9767_point *T, const window_point8 *win, uint32_t e)
 	curve9767_inner_gf_condneg(T->y, r);
 }
 
+/*
+ * Apply the window offset on a scalar, and encode it into bytes. This
+ * involves normalization to 0..n-1.
+ */
+static void
+encode_win4(uint8_t *sb, const curve9767_scalar *s)
+{
+	curve9767_scalar ss;
+
+	curve9767_scalar_decode_strict(&ss,
+		scalar_win4_off, sizeof scalar_win4_off);
+	curve9767_scalar_add(&ss, &ss, s);
+	curve9767_scalar_encode(sb, &ss);
+}
+
+/*
+ * Encode a scalar for a window-based multiplication with num_digits
+ * 4-bit digits; only the low nbits bits of the scalar are used. If
+ * num_digits is 63, the offset is applied modulo n (as in encode_win4());
+ * otherwise, the truncated scalar is lower than 2^(4*num_digits-2), and
+ * the offset (num_digits nibbles of value 8) is added as a plain
+ * integer, without overflowing num_digits nibbles.
+ */
+static void
+encode_win4_bits(uint8_t *sb, const curve9767_scalar *s,
+	unsigned nbits, unsigned num_digits)
+{
+	unsigned u, cc;
+
+	curve9767_scalar_encode(sb, s);
+	for (u = 0; u < 32; u ++) {
+		if ((u << 3) >= nbits) {
+			sb[u] = 0;
+		} else if (((u + 1) << 3) > nbits) {
+			sb[u] &= (uint8_t)((1u << (nbits & 7)) - 1);
+		}
+	}
+	if (num_digits >= 63) {
+		curve9767_scalar ss;
+
+		curve9767_scalar_decode_strict(&ss, sb, 32);
+		encode_win4(sb, &ss);
+		return;
+	}
+	cc = 0;
+	for (u = 0; u < 32; u ++) {
+		unsigned off;
+
+		if ((u << 1) + 1 < num_digits) {
+			off = 0x88;
+		} else if ((u << 1) < num_digits) {
+			off = 0x08;
+		} else {
+			off = 0;
+		}
+		cc += sb[u] + off;
+		sb[u] = (uint8_t)cc;
+		cc >>= 8;
+	}
+}
+
+/*
+ * Get the number of 4-bit digits for a multiplication with a scalar
+ * of nbits bits (nbits <= 252).
+ */
+static unsigned
+num_digits_bits(unsigned nbits)
+{
+	unsigned nd;
+
+	nd = (nbits + 5) >> 2;
+	return nd < 63 ? nd : 63;
+}
+
+/*
+ * Get the window from a step-wise multiplication context. The public
+ * structure declares it as an array of words, with the proper size.
+ */
+#define MC_WINDOW(mc)   ((window_point8 *)(void *)(mc)->window)
+
 /* see curve9767.h */
 void
-curve9767_point_mul(curve9767_point *Q3, const curve9767_point *Q1,
-	const curve9767_scalar *s)
+curve9767_point_mul_bits_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s, unsigned nbits)
 {
 	/*
 	 * Algorithm:
@@ -158,15 +238,15 @@ curve9767_point_mul(curve9767_point *Q3, const curve9767_point *Q1,
 	 *    these points. This "shifts" the window, and must be
 	 *    counterbalanced by a constant offset applied to the scalar.
 	 *
-	 * Therefore:
+	 * Therefore, with k = num_digits (63 for a full scalar):
 	 *
-	 *  1. Add 0x8888...888 to the scalar s, and normalize it to 0..n-1
-	 *     (we do this by encoding the scalar to bytes).
+	 *  1. Add 0x888...888 (k nibbles) to the scalar s, and normalize
+	 *     it (we do this by encoding the scalar to bytes).
 	 *  2. Compute the window: j*Q1 (for j = 1..8).
 	 *  3. Start with point Q3 = 0.
-	 *  4. For i in 0..62:
+	 *  4. For i in 0..k-1:
 	 *      - Compute Q3 <- 16*Q3
-	 *      - Let e = bits[(248-4*i)..(251-4*i)] of s
+	 *      - Let e = bits[(4*(k-1-i))..(4*(k-1-i)+3)] of s
 	 *      - Let: T = -(8-e)*Q1  if 0 <= e <= 7
 	 *             T = 0          if e == 8
 	 *             T = (e-8)*Q1   if 9 <= e <= 15
@@ -175,204 +255,417 @@ curve9767_point_mul(curve9767_point *Q3, const curve9767_point *Q1,
 	 * All lookups should be done in constant-time, as well as additions
 	 * and conditional negation of T.
 	 *
+	 * For a full scalar (252 bits), the offset is added modulo n, and
+	 * k = 63 digits are enough. For a short scalar, the offset is
+	 * added as an integer, and we need two extra bits of room so
+	 * that the sum does not overflow; this is still about half the
+	 * cost of a full multiplication for a 128-bit scalar. Only
+	 * nbits (which is public) impacts the execution time.
+	 *
 	 * For the first iteration (i == 0), since Q3 is still 0 at that
 	 * point, we can omit the multiplication by 16 and the addition,
 	 * and simply set Q3 to T.
+	 *
+	 * Step 1 is done here. Step 2 is split into seven steps (one
+	 * point addition each; 1*Q1 is stored right away); each
+	 * iteration of step 4 is one step. While the window is being
+	 * built, mc->Q3 contains the last computed multiple of Q1.
 	 */
-	curve9767_scalar ss;
-	uint8_t sb[32];
-	curve9767_point T;
-	window_point8 window;
-	int i;
-	uint32_t qz;
+	if (nbits > 252) {
+		nbits = 252;
+	}
+	mc->num_digits = num_digits_bits(nbits);
+	encode_win4_bits(mc->sb1, s, nbits, mc->num_digits);
+	mc->Q1 = *Q1;
+	mc->Q3 = *Q1;
+	curve9767_inner_window_put(MC_WINDOW(mc), Q1, 0);
+	mc->step = 0;
+	mc->mode = 0;
+	mc->jac = (curve9767_inner_tune.mul_jacobian
+		& CURVE9767_TUNE_JAC_MUL) != 0;
+}
 
-	/*
-	 * Apply offset on the scalar and encode it into bytes. This
-	 * involves normalization to 0..n-1.
-	 */
-	curve9767_scalar_decode_strict(&ss,
-		scalar_win4_off, sizeof scalar_win4_off);
-	curve9767_scalar_add(&ss, &ss, s);
-	curve9767_scalar_encode(sb, &ss);
+/* see curve9767.h */
+void
+curve9767_point_mul_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s)
+{
+	curve9767_point_mul_bits_start(mc, Q1, s, 252);
+}
 
+/* see curve9767.h */
+void
+curve9767_point_mul_mulgen_add_bits_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s1,
+	const curve9767_scalar *s2, unsigned nbits)
+{
 	/*
-	 * Create window contents.
+	 * This is the same process as curve9767_point_mul_bits_start();
+	 * each loop iteration additionally adds a point from the window
+	 * for G, using the bits of s2.
 	 */
-	T = *Q1;
-	for (i = 1; i <= 8; i ++) {
-		if (i != 1) {
-			curve9767_point_add(&T, &T, Q1);
-		}
-		curve9767_inner_window_put(&window, &T, i - 1);
-	}
+	curve9767_point_mul_bits_start(mc, Q1, s1, nbits);
+	encode_win4_bits(mc->sb2, s2, nbits > 252 ? 252 : nbits,
+		mc->num_digits);
+	mc->mode = 1;
+	mc->jac = (curve9767_inner_tune.mul_jacobian
+		& CURVE9767_TUNE_JAC_MUL_ADD) != 0;
+}
 
-	/*
-	 * Perform the chunk-by-chunk computation.
-	 */
-	qz = Q1->neutral;
-	for (i = 0; i < 63; i ++) {
+/* see curve9767.h */
+void
+curve9767_point_mul_mulgen_add_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s1,
+	const curve9767_scalar *s2)
+{
+	curve9767_point_mul_mulgen_add_bits_start(mc, Q1, s1, s2, 252);
+}
+
+/* see curve9767.h */
+unsigned
+curve9767_point_mul_step(curve9767_mul_context *mc, unsigned budget)
+{
+	while (budget -- > 0 && mc->step < 7 + mc->num_digits) {
+		curve9767_point T;
 		uint32_t e;
+		int i, top;
+
+		if (mc->step < 7) {
+			/*
+			 * Window construction: compute (step+2)*Q1. The
+			 * first step is a doubling. In the next steps,
+			 * j*Q1 (2 <= j <= 7) is neither Q1 nor -Q1, since
+			 * the curve order is prime and greater than 8
+			 * (or Q1 is the neutral): the incomplete addition
+			 * can be used.
+			 */
+			if (mc->step == 0) {
+				curve9767_point_add(&mc->Q3,
+					&mc->Q3, &mc->Q1);
+			} else {
+				curve9767_inner_point_add_distinct(&mc->Q3,
+					&mc->Q3, &mc->Q1);
+			}
+			curve9767_inner_window_put(MC_WINDOW(mc),
+				&mc->Q3, mc->step + 1);
+			mc->step ++;
+			continue;
+		}
 
 		/*
 		 * Extract exponent bits.
 		 */
-		e = (sb[(62 - i) >> 1] >> (((62 - i) & 1) << 2)) & 0x0F;
+		i = (int)mc->step - 7;
+		top = (int)mc->num_digits - 1;
+		e = (mc->sb1[(top - i) >> 1] >> (((top - i) & 1) << 2)) & 0x0F;
 
 		/*
 		 * Window lookup. Don't forget to adjust the neutral flag
 		 * to account for the case of Q1 = infinity.
 		 */
-		do_lookup(&T, &window, e);
-		T.neutral |= qz;
+		do_lookup(&T, MC_WINDOW(mc), e);
+		T.neutral |= mc->Q1.neutral;
 
 		/*
 		 * Q3 <- 16*Q3 + T.
 		 *
 		 * If i == 0, then we know that Q3 is (conceptually) 0,
 		 * and we can simply set Q3 to T.
+		 *
+		 * With the Jacobian accumulator (see curve9767_tune_set()),
+		 * the accumulator is J3 instead of Q3.
+		 *
+		 * For a single multiplication (mode 0), the incomplete
+		 * addition is used. Indeed, 16*Q3 = 16*a*Q1, where a is
+		 * the integer whose base-16 digits (in -8..+7) are the
+		 * first i digits, hence |a| <= 8*(16^i-1)/15, and T = d*Q1
+		 * with |d| <= 8. Since i <= 62, both |16*a-d| and |16*a+d|
+		 * are lower than 2^251.1, which is less than the curve
+		 * order n (about 2^251.82). If neither Q1, 16*Q3 nor T is
+		 * the neutral, then 16*Q3 = T or 16*Q3 = -T would imply
+		 * that n divides 16*a-d or 16*a+d, i.e. 16*a = d or
+		 * 16*a = -d over the integers, hence d = 0 (the only
+		 * multiple of 16 in -8..+8), and T = 0: contradiction.
+		 * For the combined multiplication (mode 1), Q3 also
+		 * contains multiples of G, and Q1 may be any multiple of
+		 * G: the complete addition is used.
 		 */
-		if (i == 0) {
-			*Q3 = T;
+		if (mc->jac) {
+			if (i == 0) {
+				curve9767_point_to_jacobian(&mc->J3, &T);
+			} else {
+				int k;
+
+				for (k = 0; k < 4; k ++) {
+					curve9767_inner_jpoint_double(&mc->J3);
+				}
+				if (mc->mode) {
+					curve9767_inner_jpoint_add_affine(
+						&mc->J3, &T);
+				} else {
+					curve9767_inner_jpoint_add_affine_distinct(
+						&mc->J3, &T);
+				}
+			}
 		} else {
-			curve9767_point_mul2k(Q3, Q3, 4);
-			curve9767_point_add(Q3, Q3, &T);
+			if (i == 0) {
+				mc->Q3 = T;
+			} else {
+				curve9767_point_mul2k(&mc->Q3, &mc->Q3, 4);
+				if (mc->mode) {
+					curve9767_point_add(&mc->Q3,
+						&mc->Q3, &T);
+				} else {
+					curve9767_inner_point_add_distinct(
+						&mc->Q3, &mc->Q3, &T);
+				}
+			}
+		}
+
+		/*
+		 * Lookup for G (combined multiplication only).
+		 */
+		if (mc->mode) {
+			e = (mc->sb2[(top - i) >> 1]
+				>> (((top - i) & 1) << 2)) & 0x0F;
+			do_lookup(&T, &curve9767_inner_window_G, e);
+			if (mc->jac) {
+				curve9767_inner_jpoint_add_affine(&mc->J3, &T);
+			} else {
+				curve9767_point_add(&mc->Q3, &mc->Q3, &T);
+			}
 		}
+
+		mc->step ++;
 	}
+	return 7 + mc->num_digits - mc->step;
 }
 
 /* see curve9767.h */
 void
-curve9767_point_mulgen(curve9767_point *Q3, const curve9767_scalar *s)
+curve9767_point_mul_finish(curve9767_point *Q3, curve9767_mul_context *mc)
 {
-	/*
-	 * We apply the same algorithm as curve9767_point_mul(), but
-	 * with four 64-bit scalars instead of one 252-bit scalar,
-	 * thus mutualizing the point doublings. This requires four
-	 * precomputed windows (each has size 640 bytes, hence these
-	 * tables account for 2560 bytes of ROM/Flash, which is
-	 * tolerable).
-	 */
-	curve9767_scalar ss;
-	uint8_t sb[32];
-	curve9767_point T;
-	int i;
+	curve9767_point_mul_step(mc, CURVE9767_MUL_STEPS);
+	if (mc->jac) {
+		curve9767_jpoint_normalize_batch(Q3, &mc->J3, 1);
+	} else {
+		*Q3 = mc->Q3;
+	}
+}
 
-	/*
-	 * Apply offset on the scalar and encode it into bytes. This
-	 * involves normalization to 0..n-1.
-	 */
-	curve9767_scalar_decode_strict(&ss,
-		scalar_win4_off, sizeof scalar_win4_off);
-	curve9767_scalar_add(&ss, &ss, s);
-	curve9767_scalar_encode(sb, &ss);
+/* see curve9767.h */
+void
+curve9767_point_mul(curve9767_point *Q3, const curve9767_point *Q1,
+	const curve9767_scalar *s)
+{
+	curve9767_mul_context mc;
+
+	curve9767_point_mul_start(&mc, Q1, s);
+	curve9767_point_mul_finish(Q3, &mc);
+}
+
+/* see curve9767.h */
+void
+curve9767_point_mul_bits(curve9767_point *Q3, const curve9767_point *Q1,
+	const curve9767_scalar *s, unsigned nbits)
+{
+	curve9767_mul_context mc;
+
+	curve9767_point_mul_bits_start(&mc, Q1, s, nbits);
+	curve9767_point_mul_finish(Q3, &mc);
+}
+
+/*
+ * Multiplication with precomputed windows: for j = 0..num-1, window
+ * win[4*j+k] contains the multiples of (2^(64*k))*B_j (k = 0..3), and
+ * sb[j] is the scalar for B_j, encoded with encode_win4(). Q3 is set to
+ * the sum of all s_j*B_j. The windows must not be for the neutral point.
+ *
+ * We apply the same algorithm as curve9767_point_mul(), but with four
+ * 64-bit scalars instead of one 252-bit scalar for each base point,
+ * thus mutualizing the point doublings. The Jacobian accumulator is
+ * used if the CURVE9767_TUNE_JAC_MULGEN bit is set in the tuning
+ * configuration (see curve9767_tune_set()).
+ */
+static void
+mul_windows(curve9767_point *Q3, const window_point8 *const *win,
+	const uint8_t *const *sb, int num)
+{
+	curve9767_point T;
+	curve9767_jpoint J3;
+	int i, j, jac;
 
 	/*
 	 * Perform the chunk-by-chunk computation. For each iteration,
-	 * we use 4 chunks of 4 bits from the scalar, to make 4 lookups
+	 * we use 4 chunks of 4 bits from each scalar, to make 4 lookups
 	 * in the relevant precomputed windows.
 	 *
-	 * Since the source scalar is 252 bits, not 256 bits, the first
-	 * loop iteration will not make a lookup in the highest window
+	 * Since the source scalars are 252 bits, not 256 bits, the first
+	 * loop iteration will not make a lookup in the highest windows
 	 * (the lookup bits are statically known to be 0). We specialize
 	 * that first iteration out of the loop.
 	 */
-	do_lookup(Q3, &curve9767_inner_window_G, sb[7] >> 4);
-	do_lookup(&T, &curve9767_inner_window_G64, sb[15] >> 4);
-	curve9767_point_add(Q3, Q3, &T);
-	do_lookup(&T, &curve9767_inner_window_G128, sb[23] >> 4);
-	curve9767_point_add(Q3, Q3, &T);
+	do_lookup(Q3, win[0], sb[0][7] >> 4);
+	for (j = 0; j < num; j ++) {
+		int k;
+
+		for (k = (j == 0); k < 3; k ++) {
+			do_lookup(&T, win[(j << 2) + k],
+				sb[j][(k << 3) + 7] >> 4);
+			curve9767_point_add(Q3, Q3, &T);
+		}
+	}
+
+	/*
+	 * With the Jacobian accumulator, the loop works on J3, and the
+	 * result is converted back at the end.
+	 */
+	jac = (curve9767_inner_tune.mul_jacobian
+		& CURVE9767_TUNE_JAC_MULGEN) != 0;
+	if (jac) {
+		curve9767_point_to_jacobian(&J3, Q3);
+	}
 
 	for (i = 1; i < 16; i ++) {
-		uint32_t e0, e1, e2, e3;
-		int j;
+		int k, sh;
 
 		/*
-		 * Extract exponent bits.
+		 * Point doublings.
 		 */
-		j = ((i + 1) & 1) << 2;
-		e0 = (sb[(15 - i) >> 1] >> j) & 0x0F;
-		e1 = (sb[(31 - i) >> 1] >> j) & 0x0F;
-		e2 = (sb[(47 - i) >> 1] >> j) & 0x0F;
-		e3 = (sb[(63 - i) >> 1] >> j) & 0x0F;
+		if (jac) {
+			for (k = 0; k < 4; k ++) {
+				curve9767_inner_jpoint_double(&J3);
+			}
+		} else {
+			curve9767_point_mul2k(Q3, Q3, 4);
+		}
 
 		/*
-		 * Window lookups and additions.
+		 * Extract exponent bits, window lookups and additions.
 		 */
-		curve9767_point_mul2k(Q3, Q3, 4);
-		do_lookup(&T, &curve9767_inner_window_G, e0);
-		curve9767_point_add(Q3, Q3, &T);
-		do_lookup(&T, &curve9767_inner_window_G64, e1);
-		curve9767_point_add(Q3, Q3, &T);
-		do_lookup(&T, &curve9767_inner_window_G128, e2);
-		curve9767_point_add(Q3, Q3, &T);
-		do_lookup(&T, &curve9767_inner_window_G192, e3);
-		curve9767_point_add(Q3, Q3, &T);
+		sh = ((i + 1) & 1) << 2;
+		for (j = 0; j < num; j ++) {
+			for (k = 0; k < 4; k ++) {
+				uint32_t e;
+
+				e = (sb[j][((k << 4) + 15 - i) >> 1] >> sh)
+					& 0x0F;
+				do_lookup(&T, win[(j << 2) + k], e);
+				if (jac) {
+					curve9767_inner_jpoint_add_affine(
+						&J3, &T);
+				} else {
+					curve9767_point_add(Q3, Q3, &T);
+				}
+			}
+		}
+	}
+	if (jac) {
+		curve9767_jpoint_normalize_batch(Q3, &J3, 1);
 	}
 }
 
+/*
+ * Precomputed windows for the generator (four windows for G, 2^64*G,
+ * 2^128*G and 2^192*G; each has size 640 bytes, hence these tables
+ * account for 2560 bytes of ROM/Flash, which is tolerable).
+ */
+static const window_point8 *const win_G[] = {
+	&curve9767_inner_window_G,
+	&curve9767_inner_window_G64,
+	&curve9767_inner_window_G128,
+	&curve9767_inner_window_G192
+};
+
 /* see curve9767.h */
 void
-curve9767_point_mul_mulgen_add(curve9767_point *Q3,
-	const curve9767_point *Q1, const curve9767_scalar *s1,
-	const curve9767_scalar *s2)
+curve9767_point_mulgen(curve9767_point *Q3, const curve9767_scalar *s)
 {
-	curve9767_scalar ss;
-	uint8_t sb1[32], sb2[32];
-	curve9767_point T;
-	window_point8 window;
-	int i;
-	uint32_t qz;
-
-	/*
-	 * Apply offset on both scalars and encode them into bytes. This
-	 * involves normalization to 0..n-1.
-	 */
-	curve9767_scalar_decode_strict(&ss,
-		scalar_win4_off, sizeof scalar_win4_off);
-	curve9767_scalar_add(&ss, &ss, s1);
-	curve9767_scalar_encode(sb1, &ss);
-	curve9767_scalar_decode_strict(&ss,
-		scalar_win4_off, sizeof scalar_win4_off);
-	curve9767_scalar_add(&ss, &ss, s2);
-	curve9767_scalar_encode(sb2, &ss);
+	uint8_t sb[32];
+	const uint8_t *sbp;
 
 	/*
-	 * Create window contents (for Q1).
+	 * Use the large table if it was published; otherwise, the
+	 * built-in windows are used.
 	 */
-	T = *Q1;
-	for (i = 1; i <= 8; i ++) {
-		if (i != 1) {
-			curve9767_point_add(&T, &T, Q1);
-		}
-		curve9767_inner_window_put(&window, &T, i - 1);
+	if (curve9767_inner_gtable_mulgen(Q3, s)) {
+		return;
 	}
 
 	/*
-	 * Perform the chunk-by-chunk computation.
+	 * Apply offset on the scalar and encode it into bytes.
 	 */
-	qz = Q1->neutral;
-	for (i = 0; i < 63; i ++) {
-		uint32_t e;
+	encode_win4(sb, s);
+	sbp = sb;
+	mul_windows(Q3, win_G, &sbp, 1);
+}
 
-		/*
-		 * Lookup for Q1. Don't forget to adjust the neutral flag
-		 * of T, in case Q1 = infinity.
-		 */
-		e = (sb1[(62 - i) >> 1] >> (((62 - i) & 1) << 2)) & 0x0F;
-		do_lookup(&T, &window, e);
-		T.neutral |= qz;
-		if (i == 0) {
-			*Q3 = T;
-		} else {
-			curve9767_point_mul2k(Q3, Q3, 4);
-			curve9767_point_add(Q3, Q3, &T);
-		}
+/*
+ * Get window k from a precomputed key object.
+ */
+#define PC_WINDOW(pc, k) \
+	((const window_point8 *)(const void *)(pc)->window[k])
 
-		/*
-		 * Lookup for G.
-		 */
-		e = (sb2[(62 - i) >> 1] >> (((62 - i) & 1) << 2)) & 0x0F;
-		do_lookup(&T, &curve9767_inner_window_G, e);
-		curve9767_point_add(Q3, Q3, &T);
+/* see curve9767.h */
+void
+curve9767_point_mul_precomp(curve9767_point *Q3,
+	const curve9767_precomp *pc, const curve9767_scalar *s)
+{
+	const window_point8 *win[4];
+	uint8_t sb[32];
+	const uint8_t *sbp;
+	int k;
+
+	for (k = 0; k < 4; k ++) {
+		win[k] = PC_WINDOW(pc, k);
 	}
+	encode_win4(sb, s);
+	sbp = sb;
+	mul_windows(Q3, win, &sbp, 1);
+}
+
+/* see curve9767.h */
+void
+curve9767_point_mul_precomp_mulgen_add(curve9767_point *Q3,
+	const curve9767_precomp *pc, const curve9767_scalar *s1,
+	const curve9767_scalar *s2)
+{
+	const window_point8 *win[8];
+	uint8_t sb1[32], sb2[32];
+	const uint8_t *sbp[2];
+	int k;
+
+	for (k = 0; k < 4; k ++) {
+		win[k] = PC_WINDOW(pc, k);
+		win[k + 4] = win_G[k];
+	}
+	encode_win4(sb1, s1);
+	encode_win4(sb2, s2);
+	sbp[0] = sb1;
+	sbp[1] = sb2;
+	mul_windows(Q3, win, sbp, 2);
+}
+
+/* see curve9767.h */
+void
+curve9767_point_mul_mulgen_add(curve9767_point *Q3,
+	const curve9767_point *Q1, const curve9767_scalar *s1,
+	const curve9767_scalar *s2)
+{
+	curve9767_mul_context mc;
+
+	curve9767_point_mul_mulgen_add_start(&mc, Q1, s1, s2);
+	curve9767_point_mul_finish(Q3, &mc);
+}
+
+/* see curve9767.h */
+void
+curve9767_point_mul_mulgen_add_bits(curve9767_point *Q3,
+	const curve9767_point *Q1, const curve9767_scalar *s1,
+	const curve9767_scalar *s2, unsigned nbits)
+{
+	curve9767_mul_context mc;
+
+	curve9767_point_mul_mulgen_add_bits_start(&mc, Q1, s1, s2, nbits);
+	curve9767_point_mul_finish(Q3, &mc);
 }
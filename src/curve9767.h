@@ -105,6 +105,28 @@ void curve9767_scalar_neg(curve9767_scalar *c, const curve9767_scalar *a);
 void curve9767_scalar_mul(curve9767_scalar *c,
 	const curve9767_scalar *a, const curve9767_scalar *b);
 
+/*
+ * Invert scalar a, result in c. If a is zero, then c is set to zero.
+ * The c structure may be the same as structure a. This is constant-time,
+ * but about 300 times as expensive as a multiplication.
+ */
+void curve9767_scalar_inv(curve9767_scalar *c, const curve9767_scalar *a);
+
+/*
+ * Batch operations on n scalars: c[i] = a[i] + b[i], c[i] = a[i] * b[i],
+ * and decoding with reduction of n consecutive sources of len bytes each
+ * (source i starts at offset i*len). Results are the same as with the
+ * one-scalar functions. On platforms with SIMD support (SSE2, AVX2,
+ * NEON), four scalars are processed in parallel. Array c[] may be the
+ * same as a[] or b[], but must not otherwise overlap with them.
+ */
+void curve9767_scalar_add_batch(curve9767_scalar *c,
+	const curve9767_scalar *a, const curve9767_scalar *b, size_t n);
+void curve9767_scalar_mul_batch(curve9767_scalar *c,
+	const curve9767_scalar *a, const curve9767_scalar *b, size_t n);
+void curve9767_scalar_decode_reduce_batch(curve9767_scalar *s,
+	const void *src, size_t len, size_t n);
+
 /*
  * Conditional copy of a scalar (constant-time). If ctl is 0, then d 
  * is unmodified; if ctl is 1, then d is set to the value of s.
@@ -197,6 +219,65 @@ int curve9767_point_encode(void *dst, const curve9767_point *Q);
  */
 int curve9767_point_encode_X(void *dst, const curve9767_point *Q);
 
+/*
+ * Curve point in Jacobian coordinates (X:Y:Z), for affine coordinates
+ * x = X/Z^2 and y = Y/Z^3. The point-at-infinity is marked with the
+ * neutral flag (other fields are then ignored). As with curve9767_point,
+ * contents are opaque.
+ *
+ * Converting a point from Jacobian to affine coordinates requires an
+ * inversion in the field, which is expensive. When many points must be
+ * converted (or encoded), curve9767_jpoint_normalize_batch() and
+ * curve9767_jpoint_encode_batch() share a single inversion for all of
+ * them (Montgomery's trick), at the cost of three extra multiplications
+ * per point.
+ */
+typedef struct {
+	uint32_t neutral;
+	uint16_t x[19];
+	uint16_t dummy1;  /* for alignment */
+	uint16_t y[19];
+	uint16_t dummy2;  /* for alignment */
+	uint16_t z[19];
+	uint16_t dummy3;  /* for alignment */
+} curve9767_jpoint;
+
+/*
+ * Convert a point from affine to Jacobian coordinates (with Z = 1).
+ * This is constant-time.
+ */
+void curve9767_point_to_jacobian(curve9767_jpoint *P,
+	const curve9767_point *Q);
+
+/*
+ * Convert num points P[0..num-1] from Jacobian to affine coordinates,
+ * into Q[0..num-1]. Only one field inversion is computed. Neutral points
+ * yield the point-at-infinity, as set by curve9767_point_set_neutral().
+ * Non-neutral points MUST have a non-zero Z coordinate.
+ *
+ * This is constant-time (the neutral status of the points may be
+ * secret); execution time depends only on num. The Q[] and P[] arrays
+ * must not overlap.
+ */
+void curve9767_jpoint_normalize_batch(curve9767_point *Q,
+	const curve9767_jpoint *P, size_t num);
+
+/*
+ * Encode num points P[0..num-1] (in Jacobian coordinates) into dst
+ * (32*num bytes); each encoding is the same as with
+ * curve9767_point_encode() on the affine point (in particular, neutral
+ * points yield the same invalid encoding). Points are processed by
+ * groups of CURVE9767_JPOINT_ENCODE_CHUNK, with one field inversion per
+ * group. Returned value is 1 if none of the points is the
+ * point-at-infinity, 0 otherwise.
+ *
+ * This is constant-time (the neutral status of the points may be
+ * secret); execution time depends only on num.
+ */
+#define CURVE9767_JPOINT_ENCODE_CHUNK   16
+int curve9767_jpoint_encode_batch(void *dst,
+	const curve9767_jpoint *P, size_t num);
+
 /*
  * Decode a curve point. The source array (src[]) must have length
  * exactly 32 bytes. Returned value is 1 on success, 0 on error. An
@@ -263,10 +344,26 @@ void curve9767_point_mul2k(curve9767_point *Q3,
 void curve9767_point_mul(curve9767_point *Q3, const curve9767_point *Q1,
 	const curve9767_scalar *s);
 
+/*
+ * Short-scalar point multiplication: multiply point Q1 by the low nbits
+ * bits of scalar s (i.e. by s mod 2^nbits), result in Q3. If s is lower
+ * than 2^nbits, then this is s*Q1. The cost is roughly proportional to
+ * nbits; for nbits = 128, it is about half the cost of
+ * curve9767_point_mul(). Values of nbits above 252 are treated as 252.
+ *
+ * This is constant-time with regard to Q1 and s, but not nbits (which
+ * is meant to be a public, fixed parameter, e.g. for 128-bit
+ * coefficients in batch verification).
+ */
+void curve9767_point_mul_bits(curve9767_point *Q3, const curve9767_point *Q1,
+	const curve9767_scalar *s, unsigned nbits);
+
 /*
  * Generator multiplication: this is a special case of point
  * multiplication, in which the point to multiply is the conventional
- * generator. This is more efficient than curve9767_point_mul().
+ * generator. This is more efficient than curve9767_point_mul(). If a
+ * large table was published (see curve9767_gtable_init()), then it is
+ * used, for a faster computation.
  */
 void curve9767_point_mulgen(curve9767_point *Q3, const curve9767_scalar *s);
 
@@ -286,9 +383,124 @@ void curve9767_point_mul_mulgen_add(curve9767_point *Q3,
 	const curve9767_point *Q1, const curve9767_scalar *s1,
 	const curve9767_scalar *s2);
 
+/*
+ * Short-scalar combined multiplications: this sets Q3 to s1*Q1+s2*G,
+ * using only the low nbits bits of s1 and of s2 (see
+ * curve9767_point_mul_bits()).
+ */
+void curve9767_point_mul_mulgen_add_bits(curve9767_point *Q3,
+	const curve9767_point *Q1, const curve9767_scalar *s1,
+	const curve9767_scalar *s2, unsigned nbits);
+
+/*
+ * Step-wise point multiplication.
+ *
+ * curve9767_point_mul() and curve9767_point_mul_mulgen_add() perform
+ * a fixed sequence of CURVE9767_MUL_STEPS elementary steps: seven steps
+ * for computing the window of multiples of Q1, then 63 steps, each
+ * processing four bits of the scalar(s) (four doublings and one or two
+ * point additions). The functions below expose that sequence, so that
+ * a caller (e.g. a cooperative scheduler on a microcontroller) may
+ * perform the computation in several slices, interleaving it with
+ * other tasks:
+ *
+ *  - curve9767_point_mul_start() or curve9767_point_mul_mulgen_add_start()
+ *    initializes a context with the operands (operands are copied;
+ *    they need not be kept by the caller afterwards);
+ *
+ *  - curve9767_point_mul_step() performs up to 'budget' steps, and
+ *    returns the number of steps that remain to be performed;
+ *
+ *  - when curve9767_point_mul_step() has returned 0, the result is
+ *    obtained with curve9767_point_mul_finish().
+ *
+ * The short-scalar variants (curve9767_point_mul_bits_start() and
+ * curve9767_point_mul_mulgen_add_bits_start()) use fewer steps: seven
+ * steps for the window, then min(63, ceil((nbits+2)/4)) steps for the
+ * scalar bits. CURVE9767_MUL_STEPS is the maximum.
+ *
+ * The total cost is the same as that of the monolithic functions (which
+ * are themselves implemented with these functions). Each step costs at
+ * most one loop iteration (no step is more expensive than four point
+ * doublings and two point additions). The number of steps does not
+ * depend on the operand values, and each step is constant-time.
+ *
+ * The context does not reference any external resource; it can be
+ * released at any time, and copied.
+ */
+
+#define CURVE9767_MUL_STEPS   70
+
+/*
+ * Context for a step-wise point multiplication. Contents are opaque.
+ * The window[] array has room for eight precomputed points; it is
+ * large (640 bytes) so contexts should be allocated with care on
+ * small systems.
+ */
+typedef struct {
+	curve9767_point Q1, Q3;
+	curve9767_jpoint J3;
+	uint32_t window[160];
+	uint8_t sb1[32], sb2[32];
+	unsigned step, mode, num_digits, jac;
+} curve9767_mul_context;
+
+/*
+ * Start a step-wise computation of s*Q1.
+ */
+void curve9767_point_mul_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s);
+
+/*
+ * Start a step-wise computation of s1*Q1+s2*G.
+ */
+void curve9767_point_mul_mulgen_add_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s1,
+	const curve9767_scalar *s2);
+
+/*
+ * Start a step-wise computation of (s mod 2^nbits)*Q1.
+ */
+void curve9767_point_mul_bits_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s, unsigned nbits);
+
+/*
+ * Start a step-wise computation of (s1 mod 2^nbits)*Q1
+ * + (s2 mod 2^nbits)*G.
+ */
+void curve9767_point_mul_mulgen_add_bits_start(curve9767_mul_context *mc,
+	const curve9767_point *Q1, const curve9767_scalar *s1,
+	const curve9767_scalar *s2, unsigned nbits);
+
+/*
+ * Perform up to 'budget' steps of a step-wise point multiplication.
+ * Returned value is the number of remaining steps (0 when the
+ * computation is complete). Calling this function on a complete
+ * computation does nothing (and returns 0).
+ */
+unsigned curve9767_point_mul_step(curve9767_mul_context *mc, unsigned budget);
+
+/*
+ * Get the result of a complete step-wise point multiplication. If the
+ * computation is not complete, then the remaining steps are performed
+ * first.
+ */
+void curve9767_point_mul_finish(curve9767_point *Q3,
+	curve9767_mul_context *mc);
+
 /* ===================================================================== */
 /*
  * High-level operations.
+ *
+ * The derivations described below (key pair generation, signature
+ * nonces and challenges, ECDH key derivation) use SHAKE256 and the
+ * documented domain separation strings. If the library is compiled
+ * with the CURVE9767_TURBOSHAKE macro set to a non-zero value, an
+ * alternate, non-interoperable profile is used instead: SHAKE256 is
+ * replaced with TurboSHAKE256 (domain separation byte 0x1F), and
+ * each domain separation string "curve9767-xxx:" is replaced with
+ * "curve9767-ts-xxx:". This profile is faster (TurboSHAKE uses 12
+ * Keccak rounds instead of 24) but all parties must use it.
  */
 
 /*
@@ -296,7 +508,8 @@ void curve9767_point_mul_mulgen_add(curve9767_point *Q3,
  * fed with the message to hash (including any relevant domain
  * separation string), and flipped (i.e. made ready for generating
  * output). Normally, SHAKE256 is used, but this function also works
- * with SHAKE128 and other SHAKE variants.
+ * with SHAKE128 and other SHAKE variants, including TurboSHAKE (see
+ * turboshake_init() in sha3.h).
  *
  * Exactly 96 bytes are extracted from the SHAKE context.
  *
@@ -584,4 +797,951 @@ int curve9767_sign_verify(const void *sig,
 	const curve9767_point *Q,
 	const char *hash_oid, const void *hv, size_t hv_len);
 
+/*
+ * Step-wise signature verification. This splits curve9767_sign_verify()
+ * into slices of bounded duration, similar to the step-wise point
+ * multiplication (see curve9767_point_mul_step()):
+ *
+ *  - curve9767_sign_verify_start() decodes the signature and computes
+ *    the challenge (this includes hashing hv, but no curve operation);
+ *
+ *  - curve9767_sign_verify_step() performs up to 'budget' elementary
+ *    steps and returns the number of remaining steps (the total is
+ *    CURVE9767_MUL_STEPS);
+ *
+ *  - curve9767_sign_verify_finish() returns the verification result
+ *    (1 if the signature is valid, 0 otherwise), after performing any
+ *    remaining step.
+ *
+ * The signature, public key and hashed message are not referenced after
+ * curve9767_sign_verify_start() returns.
+ */
+
+/*
+ * Context for a step-wise signature verification. Contents are opaque.
+ */
+typedef struct {
+	curve9767_mul_context mc;
+	uint8_t c[32];
+	uint32_t r;
+} curve9767_verify_context;
+
+/*
+ * Start a step-wise signature verification.
+ */
+void curve9767_sign_verify_start(curve9767_verify_context *vc,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+/*
+ * Perform up to 'budget' steps of a step-wise signature verification;
+ * returned value is the number of remaining steps.
+ */
+unsigned curve9767_sign_verify_step(curve9767_verify_context *vc,
+	unsigned budget);
+
+/*
+ * Finish a step-wise signature verification. Returned value is 1 if
+ * the signature is valid, 0 otherwise.
+ */
+int curve9767_sign_verify_finish(curve9767_verify_context *vc);
+
+/* ===================================================================== */
+/*
+ * Verification cache.
+ *
+ * Some applications verify the same signatures many times (e.g. a
+ * gateway that checks a signed token on each request). A verification
+ * cache remembers successful verifications: a 128-bit digest of the
+ * signature, encoded public key, hash function identifier and hashed
+ * message is stored, along with an expiry time. A subsequent
+ * verification of the same tuple, before expiry, is then a table
+ * lookup instead of a double scalar multiplication. Only positive
+ * results are stored; failed verifications are always recomputed.
+ *
+ * The cache uses a caller-provided memory area, split into entries
+ * (24 bytes each); the number of entries is the largest power of two
+ * that fits. Entries are grouped into buckets of 8 consecutive
+ * entries; a given tuple may be stored only in the bucket selected by
+ * its digest, so lookups and insertions are bounded. When a bucket is
+ * full, the entry with the earliest expiry time is evicted.
+ *
+ * Time is provided by the caller as an arbitrary 64-bit counter
+ * ("now"), e.g. seconds since the Epoch; the cache never reads a clock.
+ * An entry inserted at time "now" is valid until (excluded) time
+ * now + ttl.
+ *
+ * Digests are keyed with a caller-provided secret salt, so that
+ * outsiders cannot craft inputs that all map to the same bucket.
+ *
+ * This library does not use threads. If the cache is shared between
+ * several threads, the caller must provide locking callbacks with
+ * curve9767_vcache_set_locking(): the table is then split into a number
+ * of "stripes" (each stripe is a set of buckets), and accesses to a
+ * bucket are performed with its stripe lock held. Digest computation
+ * and signature verification are done without any lock held.
+ *
+ * Cache operations are not constant-time; this is fine since
+ * signatures, public keys and messages are normally public data.
+ */
+
+/*
+ * A cache entry. Contents are opaque.
+ */
+typedef struct {
+	uint64_t key[2];
+	uint64_t expiry;
+} curve9767_vcache_entry;
+
+/*
+ * Verification cache context. Contents are opaque; it is initialized
+ * with curve9767_vcache_init(). The context references the memory area
+ * provided at initialization.
+ */
+typedef struct {
+	curve9767_vcache_entry *entries;
+	size_t num_buckets;
+	uint64_t ttl;
+	uint8_t salt[32];
+	unsigned num_stripes;
+	void (*lock)(void *lock_ctx, unsigned stripe);
+	void (*unlock)(void *lock_ctx, unsigned stripe);
+	void *lock_ctx;
+} curve9767_vcache;
+
+/*
+ * Initialize a verification cache over the provided memory area (mem,
+ * of size mem_len bytes; it should be suitably aligned for uint64_t).
+ * The area must be large enough for at least one bucket (8 entries,
+ * 192 bytes); otherwise, 0 is returned. Entries are valid for ttl time
+ * units after insertion (ttl must be non-zero).
+ *
+ * The salt should be a secret random value (e.g. 32 bytes obtained from
+ * the OS random source). It may be empty (salt_len = 0), but then
+ * attackers may be able to force evictions of cached entries.
+ *
+ * The cache is initially empty, and uses no locking. Returned value is
+ * 1 on success.
+ */
+int curve9767_vcache_init(curve9767_vcache *vc, void *mem, size_t mem_len,
+	uint64_t ttl, const void *salt, size_t salt_len);
+
+/*
+ * Set the locking callbacks. num_stripes must be a power of two, and
+ * lock(lock_ctx, i) and unlock(lock_ctx, i) are called with stripe
+ * indices i in the 0 to num_stripes-1 range. If num_stripes is larger
+ * than the number of buckets, then it is internally reduced to that
+ * number. Setting lock and unlock to NULL disables locking.
+ *
+ * This function must be called before the cache is shared between
+ * threads.
+ */
+void curve9767_vcache_set_locking(curve9767_vcache *vc, unsigned num_stripes,
+	void (*lock)(void *lock_ctx, unsigned stripe),
+	void (*unlock)(void *lock_ctx, unsigned stripe),
+	void *lock_ctx);
+
+/*
+ * Remove all entries from the cache.
+ */
+void curve9767_vcache_clear(curve9767_vcache *vc);
+
+/*
+ * Look up a signature in the cache. This returns 1 if the tuple
+ * (signature, public key, hash function identifier, hashed message) is
+ * currently recorded as valid (i.e. it was inserted at a time t such
+ * that t + ttl > now), 0 otherwise. No signature verification is
+ * performed.
+ */
+int curve9767_vcache_lookup(curve9767_vcache *vc, uint64_t now,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+/*
+ * Record the tuple (signature, public key, hash function identifier,
+ * hashed message) as valid, with expiry time now + ttl. No signature
+ * verification is performed: this is meant for signatures which were
+ * verified by other means (e.g. curve9767_sign_verify_strided()).
+ */
+void curve9767_vcache_insert(curve9767_vcache *vc, uint64_t now,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+/*
+ * Signature verification with a cache. This function has the same
+ * semantics as curve9767_sign_verify(), but a cache lookup is first
+ * performed; upon a cache miss, the signature is verified, and, if it
+ * is valid, it is recorded into the cache with expiry time now + ttl.
+ *
+ * If vc is NULL, then this function simply calls curve9767_sign_verify().
+ */
+int curve9767_sign_verify_cached(curve9767_vcache *vc, uint64_t now,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+
+/* ===================================================================== */
+/*
+ * Multi-scalar multiplication.
+ *
+ * Given points P_1..P_n and scalars k_1..k_n, the functions below
+ * compute k_1*P_1 + ... + k_n*P_n with Pippenger's bucket method. For
+ * large n, this is much faster than n separate point multiplications:
+ * the cost per point is close to one point addition per window of c
+ * bits, with c growing as log(n).
+ *
+ * The scalars are split into num_windows windows (num_windows =
+ * ceil(253/c)), and each window is processed independently, with its
+ * own bucket storage (scratch area). The computation can thus be split
+ * between several threads, without any locking:
+ *
+ *  - curve9767_msm_init() prepares a context;
+ *
+ *  - curve9767_msm_window() processes window w (0 <= w < num_windows);
+ *    it writes only in the slot for window w in the context, and in
+ *    the provided scratch area. Distinct windows may be processed
+ *    concurrently (with distinct scratch areas), in any order;
+ *
+ *  - when all windows have been processed, curve9767_msm_merge()
+ *    combines the per-window results into the final sum.
+ *
+ * This library does not create threads; curve9767_msm() is a
+ * convenience function that processes all windows sequentially.
+ *
+ * Scalars are provided in encoded format (32 bytes each, as produced
+ * by curve9767_scalar_encode(); they must be fully reduced). Points
+ * are in affine coordinates; the neutral may be used.
+ *
+ * MSM is NOT constant-time: it is meant for public data (e.g. batch
+ * verification of signatures).
+ */
+
+/*
+ * Maximum window size (in bits). The scratch area for a window size of
+ * c bits has size curve9767_msm_scratch_size(c).
+ */
+#define CURVE9767_MSM_MAX_BITS   20
+
+/*
+ * MSM context. Contents are opaque, except num_windows (the number of
+ * windows to process, after initialization). The context references the
+ * points and scalars provided at initialization, which must not be
+ * modified until curve9767_msm_merge() has been called.
+ */
+typedef struct {
+	const curve9767_point *points;
+	const uint8_t *scalars;
+	size_t num;
+	unsigned c, num_windows;
+	curve9767_jpoint win[127];
+} curve9767_msm_context;
+
+/*
+ * Get the recommended window size (in bits) for an MSM with n points,
+ * for the active tuning configuration (see curve9767_tune_set()). The
+ * returned value is between 2 and 16.
+ */
+unsigned curve9767_msm_window_bits(size_t n);
+
+/*
+ * Get the size (in bytes) of the scratch area needed to process one
+ * window of c bits (2 <= c <= CURVE9767_MSM_MAX_BITS).
+ */
+size_t curve9767_msm_scratch_size(unsigned c);
+
+/*
+ * Initialize an MSM context for n points (points[]) and n scalars
+ * (scalars[], 32*n bytes), with windows of c bits. Returned value is 1
+ * on success, 0 if c is out of range.
+ */
+int curve9767_msm_init(curve9767_msm_context *mc,
+	const curve9767_point *points, const uint8_t *scalars, size_t n,
+	unsigned c);
+
+/*
+ * Process window w. The scratch area must have size at least
+ * curve9767_msm_scratch_size(c) bytes, and be suitably aligned for
+ * uint32_t.
+ */
+void curve9767_msm_window(curve9767_msm_context *mc, unsigned w,
+	void *scratch);
+
+/*
+ * Combine the per-window results (all windows must have been
+ * processed) into the final sum Q.
+ */
+void curve9767_msm_merge(curve9767_point *Q, const curve9767_msm_context *mc);
+
+/*
+ * Compute an MSM in the calling thread. The window size is chosen with
+ * curve9767_msm_window_bits(), reduced if necessary so that the scratch
+ * area (scratch, of size scratch_len bytes) is large enough. Returned
+ * value is 1 on success, 0 if the scratch area is too small even for
+ * 2-bit windows.
+ */
+int curve9767_msm(curve9767_point *Q,
+	const curve9767_point *points, const uint8_t *scalars, size_t n,
+	void *scratch, size_t scratch_len);
+
+/*
+ * Streaming MSM accumulator.
+ *
+ * The accumulator ingests (scalar, point) pairs one at a time, and
+ * computes their MSM on demand. The points need not be kept by the
+ * caller: each point is added immediately to one bucket per window
+ * (in Jacobian coordinates), so the cost per point is about
+ * ceil(253/c) mixed additions, and the memory is fixed by the window
+ * size c (curve9767_msm_accumulator_size(c) bytes, provided by the
+ * caller), regardless of the number of ingested pairs.
+ *
+ * curve9767_msm_accumulator_finalize() returns the current sum; its
+ * cost is that of the per-bucket work of all windows, independent of
+ * the number of pairs. The accumulated sum is not modified (more pairs
+ * may be added afterwards); curve9767_msm_accumulator_reset() clears
+ * it (e.g. at the start of a new window of a stream). A window size
+ * of curve9767_msm_window_bits(n), for the expected number n of pairs
+ * between two finalizations, is a good choice.
+ *
+ * This can be used for incremental batch verification of signatures:
+ * for each signature, add the signature point and the public key
+ * with a random coefficient (and the challenge times that
+ * coefficient), and keep a running sum of the scalar parts; the
+ * finalized sum is then compared with that sum times the generator.
+ *
+ * As with the other MSM functions, this is NOT constant-time.
+ */
+typedef struct {
+	void *mem;
+	unsigned c, num_windows;
+	uint64_t count;
+} curve9767_msm_accumulator;
+
+/*
+ * Get the size (in bytes) of the memory needed by an accumulator with
+ * windows of c bits. Returned value is 0 if c is out of range (2 to
+ * CURVE9767_MSM_MAX_BITS).
+ */
+size_t curve9767_msm_accumulator_size(unsigned c);
+
+/*
+ * Initialize an accumulator with windows of c bits, using the provided
+ * memory (mem, of size mem_len bytes, suitably aligned for uint32_t),
+ * which must remain available as long as the accumulator is in use.
+ * The accumulator is initially empty. Returned value is 1 on success,
+ * 0 if c is out of range or the memory is too small.
+ */
+int curve9767_msm_accumulator_init(curve9767_msm_accumulator *acc,
+	unsigned c, void *mem, size_t mem_len);
+
+/*
+ * Clear an accumulator (its sum becomes the neutral).
+ */
+void curve9767_msm_accumulator_reset(curve9767_msm_accumulator *acc);
+
+/*
+ * Add scalar*P to the accumulator. The scalar is in encoded format
+ * (32 bytes, fully reduced); P may be the neutral. The count field is
+ * incremented.
+ */
+void curve9767_msm_accumulator_add(curve9767_msm_accumulator *acc,
+	const curve9767_point *P, const uint8_t *scalar);
+
+/*
+ * Get the sum of all pairs added since the last reset (or the
+ * initialization) into Q.
+ */
+void curve9767_msm_accumulator_finalize(curve9767_point *Q,
+	curve9767_msm_accumulator *acc);
+
+/* ===================================================================== */
+/*
+ * Batch verification of signed records.
+ *
+ * curve9767_sign_verify_strided() verifies n signed records stored in
+ * place in a caller buffer, without marshalling: record i starts at
+ * base + i*stride, and the signature (64 bytes), encoded public key (32
+ * bytes) and hashed message are read at fixed offsets within each
+ * record. The hashed message length is either fixed, or read from a
+ * length byte in each record.
+ *
+ * Records are processed in chunks (as large as the provided work area
+ * allows): all public keys and signature points in the chunk are
+ * decoded and all challenges are computed, then the chunk is checked
+ * with a single multi-scalar multiplication, over a random linear
+ * combination of the verification equations (with 128-bit coefficients
+ * derived by hashing the whole chunk). If the combined check fails,
+ * the chunk is split in halves, recursively, to locate the invalid
+ * records. The per-record results are the same as with
+ * curve9767_sign_verify() (except with negligible probability).
+ *
+ * Batch verification is NOT constant-time (it uses the MSM); it is
+ * meant for public data.
+ */
+
+/*
+ * Layout of a signed record. All offsets are in bytes, from the start
+ * of the record. If hv_len_off is CURVE9767_RECORD_FIXED_LEN, then all
+ * hashed messages have length hv_len; otherwise, the length of each
+ * hashed message is the byte at offset hv_len_off (and hv_len is
+ * ignored).
+ */
+typedef struct {
+	size_t stride;
+	size_t sig_off;
+	size_t Q_off;
+	size_t hv_off;
+	size_t hv_len_off;
+	size_t hv_len;
+} curve9767_record_layout;
+
+#define CURVE9767_RECORD_FIXED_LEN   ((size_t)-1)
+
+/*
+ * Work area size per record (in bytes). The work area should have
+ * room for the records of a chunk, and about as much for the MSM
+ * scratch area; larger chunks are more efficient (up to a few
+ * thousand records).
+ */
+#define CURVE9767_VERIFY_BATCH_RECORD_SIZE   232
+
+/*
+ * Verify n signed records, starting at base, with the provided layout
+ * and hash function identifier (common to all records). If results is
+ * not NULL, then bit i of the bitmap (bit i&7 of results[i>>3]) is
+ * set to 1 if record i is valid, 0 otherwise; results must have room
+ * for (n+7)/8 bytes, and unused bits of the last byte are cleared.
+ * If results is NULL, processing stops at the first invalid chunk.
+ *
+ * The work area tmp (of size tmp_len bytes) must be suitably aligned
+ * for uint32_t. If it is too small for batch processing, then records
+ * are verified individually.
+ *
+ * Returned value is 1 if all records are valid, 0 otherwise.
+ */
+int curve9767_sign_verify_strided(uint8_t *results,
+	const void *base, size_t n, const curve9767_record_layout *rl,
+	const char *hash_oid, void *tmp, size_t tmp_len);
+
+/* ===================================================================== */
+/*
+ * Autotuning.
+ *
+ * Some algorithm choices depend on the relative costs of field
+ * operations (multiplication M, squaring S, inversion I), which vary
+ * between platforms: with the reference code on x86, an inversion costs
+ * about 8 multiplications, while the Cortex-M0+ assembly routines bring
+ * it down to about 6. The active configuration (a global, process-wide
+ * setting) drives these choices:
+ *
+ *  - Accumulator for point multiplications: in affine coordinates
+ *    (each multi-doubling and each point addition costs an inversion)
+ *    or in Jacobian coordinates (no inversion, but more multiplications,
+ *    and one inversion at the end). The choice is made separately for
+ *    curve9767_point_mul() (one addition per 4-bit digit),
+ *    curve9767_point_mul_mulgen_add() (two additions per digit), and
+ *    curve9767_point_mulgen() (four additions per four doublings); the
+ *    step-wise and short-scalar variants follow the same choices.
+ *
+ *  - MSM window size: curve9767_msm_window_bits() uses the cost of the
+ *    per-bucket work, relative to the cost of adding a point into a
+ *    bucket.
+ *
+ * Field multiplication, squaring and inversion kernels, and the
+ * generator tables, are fixed at compile-time; they are not affected.
+ * Configuration changes only impact performance: all results are
+ * identical for all configurations, and all functions that are
+ * constant-time remain so.
+ *
+ * A configuration is obtained either from the built-in defaults
+ * (curve9767_tune_default()), from measured costs
+ * (curve9767_tune_measure(), using a caller-provided clock), or from
+ * costs obtained offline (curve9767_tune_from_costs()). It can be
+ * exported to bytes and imported back, so that a configuration can be
+ * persisted and pinned. The active configuration is set with
+ * curve9767_tune_set(); this is not thread-safe, and should be done at
+ * startup, before other threads use the library.
+ */
+
+/*
+ * Tuning configuration. Costs are relative (in arbitrary units, e.g.
+ * clock cycles). mul_jacobian is a bit mask that selects the Jacobian
+ * accumulator (instead of the affine accumulator) for
+ * curve9767_point_mul() (bit 0, CURVE9767_TUNE_JAC_MUL),
+ * curve9767_point_mul_mulgen_add() (bit 1, CURVE9767_TUNE_JAC_MUL_ADD)
+ * and curve9767_point_mulgen() (bit 2, CURVE9767_TUNE_JAC_MULGEN).
+ * msm_bucket_cost is the cost of the per-bucket work in an MSM window,
+ * in units of 1/16 of a bucket addition.
+ */
+typedef struct {
+	uint32_t cost_mul, cost_sqr, cost_inv;
+	uint32_t mul_jacobian;
+	uint32_t msm_bucket_cost;
+} curve9767_tune_config;
+
+#define CURVE9767_TUNE_JAC_MUL       0x01
+#define CURVE9767_TUNE_JAC_MUL_ADD   0x02
+#define CURVE9767_TUNE_JAC_MULGEN    0x04
+
+/*
+ * Size (in bytes) of an exported configuration.
+ */
+#define CURVE9767_TUNE_ENCODED_SIZE   24
+
+/*
+ * Get the built-in default configuration.
+ */
+void curve9767_tune_default(curve9767_tune_config *tc);
+
+/*
+ * Compute a configuration from the relative costs of field operations
+ * (multiplication, squaring, inversion). Costs must be non-zero.
+ */
+void curve9767_tune_from_costs(curve9767_tune_config *tc,
+	uint32_t cost_mul, uint32_t cost_sqr, uint32_t cost_inv);
+
+/*
+ * Measure the costs of field operations, and compute the corresponding
+ * configuration; the accumulator choices are made by measuring the
+ * point doublings and additions of both accumulators (this takes about
+ * as long as one point multiplication). The clock_fn() callback must
+ * return a monotonic counter (e.g. a cycle counter, or a time in
+ * nanoseconds); it is called with the clock_ctx parameter. Returned
+ * value is 1 on success, 0 if the clock resolution is too coarse (tc is
+ * then set to the defaults).
+ */
+int curve9767_tune_measure(curve9767_tune_config *tc,
+	uint64_t (*clock_fn)(void *clock_ctx), void *clock_ctx);
+
+/*
+ * Set the active configuration.
+ */
+void curve9767_tune_set(const curve9767_tune_config *tc);
+
+/*
+ * Get the active configuration.
+ */
+void curve9767_tune_get(curve9767_tune_config *tc);
+
+/*
+ * Export a configuration into exactly CURVE9767_TUNE_ENCODED_SIZE
+ * bytes.
+ */
+void curve9767_tune_export(void *dst, const curve9767_tune_config *tc);
+
+/*
+ * Import a configuration. Returned value is 1 on success, 0 on error
+ * (invalid length or contents; tc is then unmodified).
+ */
+int curve9767_tune_import(curve9767_tune_config *tc,
+	const void *src, size_t len);
+
+/* ===================================================================== */
+/*
+ * Precomputed keys.
+ *
+ * A precomputed key object contains a public point Q (a verification
+ * key, or the static public key of an ECDH peer), its cached encoding,
+ * and four windows of multiples of Q, 2^64*Q, 2^128*Q and 2^192*Q.
+ * With these windows, multiplications by Q use the same algorithm as
+ * curve9767_point_mulgen(), which is more than twice as fast as
+ * curve9767_point_mul(). Optionally, the object also contains the
+ * secret scalar s and the additional secret t, for signing.
+ *
+ * Building the windows costs 192 point doublings and 28 point
+ * additions. The structure is also its own serialized format: it
+ * can be written as is to a file, and later used in place (e.g. from
+ * a memory-mapped file) after validation with curve9767_precomp_load(),
+ * which does not copy anything. The object starts with a header
+ * (magic, format version, and an identifier for the internal
+ * representation, which depends on the implementation and on the
+ * byte order), and contains a 32-byte integrity tag (SHAKE256 over the
+ * rest of the object). The tag detects corruption and truncation; it
+ * is not a MAC, and does not protect against an attacker who can
+ * modify the stored objects.
+ *
+ * The structure size (CURVE9767_PRECOMP_SIZE) is a multiple of 64
+ * bytes, so that objects can be concatenated in a file; if the file is
+ * mapped at a page boundary, then each object is aligned on a cache
+ * line. Objects containing the secret part MUST be stored with the
+ * same care as any other secret key.
+ */
+
+typedef struct {
+	uint8_t magic[4];
+	uint32_t version;
+	uint32_t format;
+	uint32_t flags;
+	uint8_t tag[32];
+	uint8_t encoded_Q[32];
+	uint8_t encoded_s[32];
+	uint8_t t[32];
+	curve9767_point Q;
+	uint8_t reserved[28];
+	uint32_t window[4][160];
+} curve9767_precomp;
+
+#define CURVE9767_PRECOMP_SIZE      2816
+#define CURVE9767_PRECOMP_VERSION   1
+
+/*
+ * Flag: the object contains a secret scalar and additional secret.
+ */
+#define CURVE9767_PRECOMP_SECRET    0x01
+
+/*
+ * Initialize a precomputed key object for point Q. If s is not NULL,
+ * then s and t are stored as well (t MUST then be non-NULL), and Q
+ * MUST be s*G (this is not verified). Returned value is 1 on success,
+ * 0 if Q is the point-at-infinity.
+ */
+int curve9767_precomp_init(curve9767_precomp *pc, const curve9767_point *Q,
+	const curve9767_scalar *s, const uint8_t t[32]);
+
+/*
+ * Validate a serialized precomputed key object of len bytes (len may
+ * be larger than CURVE9767_PRECOMP_SIZE; extra bytes are ignored).
+ * The source MUST be aligned on a 32-bit boundary (64-byte alignment
+ * is recommended). On success, a pointer to the object (equal to src)
+ * is returned; on error (misaligned or too short source, unknown
+ * format or version, wrong tag), NULL is returned.
+ *
+ * Successfully validated objects must not be modified afterwards.
+ */
+const curve9767_precomp *curve9767_precomp_load(const void *src, size_t len);
+
+/*
+ * Multiply the precomputed point by scalar s, result in Q3.
+ */
+void curve9767_point_mul_precomp(curve9767_point *Q3,
+	const curve9767_precomp *pc, const curve9767_scalar *s);
+
+/*
+ * Compute s1*Q+s2*G, with Q the precomputed point. Point doublings are
+ * shared between both multiplications.
+ */
+void curve9767_point_mul_precomp_mulgen_add(curve9767_point *Q3,
+	const curve9767_precomp *pc, const curve9767_scalar *s1,
+	const curve9767_scalar *s2);
+
+/*
+ * Signature generation with a precomputed key object (which must
+ * contain the secret part). The signature is the same as with
+ * curve9767_sign_generate(). Returned value is 1 on success, 0 if the
+ * object does not contain the secret part (no signature is produced).
+ */
+int curve9767_sign_generate_precomp(void *sig, const curve9767_precomp *pc,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+/*
+ * Signature verification with a precomputed public key. The result is
+ * the same as with curve9767_sign_verify().
+ */
+int curve9767_sign_verify_precomp(const void *sig,
+	const curve9767_precomp *pc,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+/*
+ * ECDH with a precomputed peer public key (e.g. a static key). The
+ * shared secret is the same as with curve9767_ecdh_recv() with the
+ * encoded peer key; since the precomputed point is valid, this function
+ * always returns 1.
+ */
+int curve9767_ecdh_recv_precomp(void *shared_secret,
+	size_t shared_secret_len, const curve9767_scalar *s,
+	const curve9767_precomp *pc2);
+
+/* ===================================================================== */
+/*
+ * Threshold signatures (FROST).
+ *
+ * A signing key s is split into shares with Shamir's secret sharing, so
+ * that any 'threshold' of the 'num' participants can jointly produce a
+ * signature, without ever reconstructing s. Signatures are standard
+ * curve9767 signatures (curve9767_sign_verify() accepts them, for the
+ * unchanged public key Q = s*G), but they are not deterministic.
+ *
+ * Participants are identified by an integer between 1 and
+ * CURVE9767_FROST_MAX_PARTICIPANTS; the share of participant i is s_i,
+ * and its verification share is Y_i = s_i*G (which can be published).
+ *
+ * Signing follows FROST (Komlo-Goldberg), with one commitment pair per
+ * signer and per-signer binding factors:
+ *
+ *  - Offline: each participant generates a pool of nonce pairs (d, e)
+ *    with curve9767_frost_nonce_generate(), and publishes the matching
+ *    commitments (D = d*G, E = e*G). This is where all generator
+ *    multiplications are performed.
+ *
+ *  - Online: a coordinator picks the signers and one unused commitment
+ *    per signer, and sends the commitment list and the message to the
+ *    signers. Each signer computes the session parameters with
+ *    curve9767_frost_session_init() (binding factors, group commitment
+ *    R = sum (D_j + rho_j*E_j), and challenge), then its signature share
+ *    with curve9767_frost_sign_share(), which is only scalar arithmetic
+ *    and one hash. Signers MUST compute the session themselves (they
+ *    must not accept R from the coordinator).
+ *
+ *  - The coordinator checks the shares with
+ *    curve9767_frost_verify_shares() (a single MSM for all shares;
+ *    culprits are identified if the check fails), and assembles the
+ *    signature with curve9767_frost_aggregate().
+ *
+ * A nonce MUST NOT be used twice; curve9767_frost_sign_share() erases
+ * the nonce it uses (and refuses erased nonces), but nonce pools must
+ * not be copied or restored from backups.
+ */
+
+/*
+ * Maximum participant identifier, and maximum number of signers in a
+ * signing session.
+ */
+#define CURVE9767_FROST_MAX_PARTICIPANTS   255
+#define CURVE9767_FROST_MAX_SIGNERS         16
+
+/*
+ * Public commitment for a nonce pair: participant identifier, and
+ * encoded points D and E.
+ */
+typedef struct {
+	uint32_t id;
+	uint8_t D[32];
+	uint8_t E[32];
+} curve9767_frost_commitment;
+
+/*
+ * Secret nonce pair (d, e), with its commitment. This structure must be
+ * kept secret.
+ */
+typedef struct {
+	curve9767_frost_commitment comm;
+	curve9767_scalar d, e;
+} curve9767_frost_nonce;
+
+/*
+ * Signing session parameters. Contents are opaque.
+ */
+typedef struct {
+	uint8_t c[32];
+	uint8_t encoded_Q[32];
+	uint8_t rho_key[32];
+	curve9767_scalar e;
+	size_t num;
+	curve9767_frost_commitment comm[CURVE9767_FROST_MAX_SIGNERS];
+} curve9767_frost_session;
+
+/*
+ * Split secret scalar s into num shares (shares[i] is the share of
+ * participant i+1), such that any threshold of them allow signing. The
+ * random polynomial is derived from the seed (which must have enough
+ * entropy, e.g. 32 bytes from a cryptographically secure RNG) and s.
+ * Returned value is 1 on success, 0 if the parameters are invalid (it is
+ * required that 1 <= threshold <= num <= CURVE9767_FROST_MAX_PARTICIPANTS
+ * and threshold <= CURVE9767_FROST_MAX_SIGNERS).
+ */
+int curve9767_frost_split(curve9767_scalar *shares,
+	const curve9767_scalar *s, unsigned threshold, unsigned num,
+	const void *seed, size_t seed_len);
+
+/*
+ * Generate num nonce pairs for participant id, with the participant's
+ * share s_i. The nonces are derived from the seed (which must be fresh
+ * and have enough entropy; it is mixed with the share, so that a weak
+ * seed does not leak the share by itself). The public commitments are
+ * also written in comm[] (if not NULL). Returned value is 1 on success,
+ * 0 if the identifier is invalid.
+ */
+int curve9767_frost_nonce_generate(curve9767_frost_nonce *nonces,
+	curve9767_frost_commitment *comm, size_t num, unsigned id,
+	const curve9767_scalar *s_i, const void *seed, size_t seed_len);
+
+/*
+ * Get the size (in bytes) of the work area for which
+ * curve9767_frost_session_init() and curve9767_frost_verify_shares()
+ * use a single MSM, for num signers. With a smaller work area (or NULL),
+ * these functions use individual point multiplications instead.
+ */
+size_t curve9767_frost_tmp_size(size_t num);
+
+/*
+ * Initialize a signing session, for public key Q, with the commitments
+ * of the num signers (comm[], sorted by increasing identifier), and the
+ * hashed message (hash_oid, hv, hv_len, as in curve9767_sign_generate()).
+ * The work area tmp (of size tmp_len bytes) must be suitably aligned
+ * for uint32_t. Returned value is 1 on success, 0 if the parameters are
+ * invalid (too many signers, identifiers not sorted or out of range, or
+ * invalid commitment points).
+ */
+int curve9767_frost_session_init(curve9767_frost_session *fs,
+	const curve9767_point *Q,
+	const curve9767_frost_commitment *comm, size_t num,
+	const char *hash_oid, const void *hv, size_t hv_len,
+	void *tmp, size_t tmp_len);
+
+/*
+ * Compute the signature share (32 bytes) of participant id, with its
+ * share s_i and the nonce whose commitment was used in the session. The
+ * nonce is erased. Returned value is 1 on success, 0 if the nonce was
+ * already used, or if its commitment does not match the one used in
+ * the session for that participant (nothing is written in that case).
+ */
+int curve9767_frost_sign_share(void *sig_share,
+	const curve9767_frost_session *fs, unsigned id,
+	const curve9767_scalar *s_i, curve9767_frost_nonce *nonce);
+
+/*
+ * Verify the signature shares of all signers of the session: sig_shares
+ * contains the 32-byte shares, and Y[] the verification shares, both in
+ * the order of the session commitments. If results is not NULL, then
+ * bit i of results[i >> 3] is set to 1 if share i is valid, 0 otherwise.
+ * Returned value is 1 if all shares are valid, 0 otherwise.
+ */
+int curve9767_frost_verify_shares(uint8_t *results,
+	const curve9767_frost_session *fs, const void *sig_shares,
+	const curve9767_point *Y, void *tmp, size_t tmp_len);
+
+/*
+ * Assemble the signature (64 bytes) from the signature shares of all
+ * signers of the session (in the order of the session commitments).
+ */
+void curve9767_frost_aggregate(void *sig,
+	const curve9767_frost_session *fs, const void *sig_shares);
+
+/* ===================================================================== */
+/*
+ * Large precomputed table for the generator.
+ *
+ * curve9767_point_mulgen() normally uses four built-in windows (2560
+ * bytes of ROM). When enough RAM is available, a much larger table can
+ * be provided: it contains 32 windows of 128 points (multiples of
+ * 2^(8*i)*G, for i = 0..31), so that generator multiplications use
+ * 8-bit signed digits, with no point doubling and half the point
+ * additions. This table (CURVE9767_GTABLE_SIZE bytes) is computed at
+ * runtime; it is never needed for correctness.
+ *
+ * The table is built in CURVE9767_GTABLE_PARTS independent parts (one
+ * window each, with one field inversion per batch of points). Until all
+ * parts are done, curve9767_point_mulgen() (and thus key pair generation
+ * and signature generation) uses the built-in windows; once the last
+ * part is done, the table is published and all subsequent calls use it.
+ * Results are identical either way.
+ *
+ * A single table can be used per process: the first table passed to
+ * curve9767_gtable_build_step() or curve9767_gtable_init() is retained,
+ * and calls with another table have no effect. That table must stay
+ * valid (and unmodified) for the rest of the process lifetime.
+ *
+ * These functions are thread-safe if CURVE9767_ATOMIC is non-zero (this
+ * is the default when the compiler supports C11 atomics, except on ARM
+ * Cortex-M0/M0+); each part is built exactly once, and the publication
+ * of the table is an atomic pointer store with release semantics.
+ * Otherwise, they must not be called concurrently with each other or
+ * with curve9767_point_mulgen().
+ *
+ * Typical usage is to start one or several background threads that call
+ * curve9767_gtable_init() (eager parallel build), or to call it from the
+ * first request that finds curve9767_gtable_ready() to be 0 (lazy build;
+ * concurrent requests are not blocked, they only use the slower path).
+ */
+
+typedef struct {
+	uint32_t window[32][16][160];
+} curve9767_gtable;
+
+#define CURVE9767_GTABLE_SIZE    327680
+#define CURVE9767_GTABLE_PARTS   32
+
+/*
+ * Build one part of the table: the next part that no other thread has
+ * claimed is computed. If it was the last part to complete, then the
+ * table is published. Returned value is 1 if a part was built, 0 if all
+ * parts were already claimed (or if gt is not the retained table).
+ */
+int curve9767_gtable_build_step(curve9767_gtable *gt);
+
+/*
+ * Build all parts of the table that are not yet claimed by other
+ * threads (i.e. call curve9767_gtable_build_step() until it returns 0).
+ * When this function returns, the table may still be incomplete if
+ * other threads are building parts concurrently. Returned value is 1 if
+ * the table is published, 0 otherwise.
+ */
+int curve9767_gtable_init(curve9767_gtable *gt);
+
+/*
+ * Returned value is 1 if the large table is published (and thus used by
+ * curve9767_point_mulgen()), 0 otherwise.
+ */
+int curve9767_gtable_ready(void);
+
+/* ===================================================================== */
+/*
+ * Merkle-batched signatures.
+ *
+ * When many messages must be signed at once, a single signature can be
+ * shared by all of them: the hashed messages are the leaves of a Merkle
+ * tree (with SHA3-256), and the tree root is signed once. Each message
+ * then gets a proof, which contains the root signature and the
+ * sibling nodes on the path from the leaf to the root (72 bytes, plus
+ * 32 bytes per tree level, i.e. about 72 + 32*log2(n) bytes).
+ *
+ * Verification of a proof recomputes the root, then verifies the root
+ * signature. With a verification cache (see curve9767_vcache_init()),
+ * the root signature is verified only once per batch: subsequent
+ * messages of the same batch only cost a few SHA3 computations.
+ *
+ * The tree is built four nodes at a time with the four-way SHA3
+ * implementation (sha3_x4_*(), see sha3.h), which is faster when the
+ * compiler targets AVX2.
+ *
+ * A proof is valid only for the messages it was produced for; it is
+ * not interchangeable with a plain signature (curve9767_sign_verify()
+ * rejects the root signature for any single message).
+ */
+
+/*
+ * Maximum size (in bytes) of a proof.
+ */
+#define CURVE9767_MERKLE_PROOF_MAX   (72 + 32 * 32)
+
+/*
+ * Get the size (in bytes) of the tree buffer for n messages. Returned
+ * value is 0 if n is not in the 1 to 2^32-1 range.
+ */
+size_t curve9767_merkle_tree_size(size_t n);
+
+/*
+ * Sign n hashed messages (all of hv_len bytes, for the same hash
+ * function identifier, and stored consecutively in hv[]). The secret
+ * scalar s, additional secret t and public key Q are as for
+ * curve9767_sign_generate(). The root signature (64 bytes) is written
+ * in sig[], and the tree in tree[] (of size
+ * curve9767_merkle_tree_size(n) bytes), for use with
+ * curve9767_merkle_proof(). Returned value is 1 on success, 0 if n is
+ * out of range.
+ */
+int curve9767_merkle_sign(void *sig, void *tree,
+	const curve9767_scalar *s, const uint8_t t[32],
+	const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len, size_t n);
+
+/*
+ * Get the proof for message index (0 to n-1) into dst[] (at most
+ * CURVE9767_MERKLE_PROOF_MAX bytes), from the root signature and the
+ * tree produced by curve9767_merkle_sign() for n messages. Returned
+ * value is the proof length, or 0 on error (index or n out of range).
+ */
+size_t curve9767_merkle_proof(void *dst, const void *sig, const void *tree,
+	size_t n, size_t index);
+
+/*
+ * Verify a proof (of size proof_len bytes) for a hashed message hv (of
+ * size hv_len bytes), with public key Q. The root signature is verified
+ * with curve9767_sign_verify_cached() (vc may be NULL, in which case no
+ * cache is used). Returned value is 1 if the proof is valid, 0
+ * otherwise.
+ */
+int curve9767_merkle_verify(curve9767_vcache *vc, uint64_t now,
+	const void *proof, size_t proof_len, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
 #endif
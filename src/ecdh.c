@@ -1,7 +1,7 @@
 #include "inner.h"
 
-#define DOM_ECDH        "curve9767-ecdh:"
-#define DOM_ECDH_FAIL   "curve9767-ecdh-failed:"
+#define DOM_ECDH        CURVE9767_DOM("ecdh:")
+#define DOM_ECDH_FAIL   CURVE9767_DOM("ecdh-failed:")
 
 /* see curve9767.h */
 void
@@ -18,6 +18,22 @@ curve9767_ecdh_keygen(curve9767_scalar *s, uint8_t encoded_Q[32],
 	}
 }
 
+/*
+ * Compute the shared secret from the pre-master secret.
+ */
+static void
+make_secret(void *shared_secret, size_t shared_secret_len,
+	const uint8_t *pm)
+{
+	shake_context sc;
+
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_ECDH, strlen(DOM_ECDH));
+	shake_inject(&sc, pm, 32);
+	shake_flip(&sc);
+	shake_extract(&sc, shared_secret, shared_secret_len);
+}
+
 /* see curve9767.h */
 int
 curve9767_ecdh_recv(void *shared_secret, size_t shared_secret_len,
@@ -42,7 +58,7 @@ curve9767_ecdh_recv(void *shared_secret, size_t shared_secret_len,
 	 * of failure (r == 0).
 	 */
 	curve9767_scalar_encode(tmp, s);
-	shake_init(&sc, 256);
+	curve9767_inner_kdf_init(&sc);
 	shake_inject(&sc, DOM_ECDH_FAIL, strlen(DOM_ECDH_FAIL));
 	shake_inject(&sc, tmp, 32);
 	shake_inject(&sc, encoded_Q2, 32);
@@ -57,14 +73,25 @@ curve9767_ecdh_recv(void *shared_secret, size_t shared_secret_len,
 		pm[i] ^= (uint8_t)((r - 1) & (pm[i] ^ tmp[i]));
 	}
 
+	make_secret(shared_secret, shared_secret_len, pm);
+	return (int)r;
+}
+
+/* see curve9767.h */
+int
+curve9767_ecdh_recv_precomp(void *shared_secret,
+	size_t shared_secret_len, const curve9767_scalar *s,
+	const curve9767_precomp *pc2)
+{
+	curve9767_point Q2;
+	uint8_t pm[32];
+
 	/*
-	 * Compute the shared secret.
+	 * The precomputed point was decoded or computed when the object
+	 * was built, so there is no failure case here.
 	 */
-	shake_init(&sc, 256);
-	shake_inject(&sc, DOM_ECDH, strlen(DOM_ECDH));
-	shake_inject(&sc, pm, 32);
-	shake_flip(&sc);
-	shake_extract(&sc, shared_secret, shared_secret_len);
-
-	return (int)r;
+	curve9767_point_mul_precomp(&Q2, pc2, s);
+	curve9767_point_encode_X(pm, &Q2);
+	make_secret(shared_secret, shared_secret_len, pm);
+	return 1;
 }
@@ -0,0 +1,511 @@
+#include "inner.h"
+
+#define DOM_FROST_SPLIT    CURVE9767_DOM("frost-split:")
+#define DOM_FROST_NONCE    CURVE9767_DOM("frost-nonce:")
+#define DOM_FROST_RHO      CURVE9767_DOM("frost-rho:")
+#define DOM_FROST_BIND     CURVE9767_DOM("frost-bind:")
+#define DOM_FROST_VERIFY   CURVE9767_DOM("frost-verify:")
+
+/*
+ * FROST threshold signatures.
+ *
+ * With the signer set S (identifiers x_j), the commitments (D_j, E_j)
+ * and the binding factors rho_j, the group commitment is:
+ *   R = sum (D_j + rho_j*E_j)
+ * The signature is (c, z) with c the encoding of R, e the usual
+ * challenge (computed from c, Q and the hashed message), and:
+ *   z = sum z_j
+ *   z_j = d_j + rho_j*e_j + lambda_j*e*s_j
+ * where lambda_j is the Lagrange coefficient of x_j in S. Since
+ * sum lambda_j*s_j = s, we get z*G = R + e*Q, i.e. R = z*G - e*Q, which
+ * is what curve9767_sign_verify() checks.
+ *
+ * A share is valid if z_j*G = D_j + rho_j*E_j + lambda_j*e*Y_j. All
+ * shares are checked at once with random 128-bit coefficients r_j:
+ *   (sum r_j*z_j)*G + sum (-r_j)*D_j + sum (-r_j*rho_j)*E_j
+ *                   + sum (-r_j*lambda_j*e)*Y_j = 0
+ * The coefficients are derived by hashing the session and all shares.
+ */
+
+static void
+enc32le(uint8_t *buf, uint32_t x)
+{
+	buf[0] = (uint8_t)x;
+	buf[1] = (uint8_t)(x >> 8);
+	buf[2] = (uint8_t)(x >> 16);
+	buf[3] = (uint8_t)(x >> 24);
+}
+
+/*
+ * Get participant identifier x as a scalar.
+ */
+static void
+scalar_from_id(curve9767_scalar *x, unsigned id)
+{
+	uint8_t tmp[4];
+
+	enc32le(tmp, id);
+	curve9767_scalar_decode_strict(x, tmp, sizeof tmp);
+}
+
+/*
+ * Extract a non-zero scalar from a SHAKE context (in output mode).
+ */
+static void
+extract_scalar(curve9767_scalar *x, shake_context *sc)
+{
+	uint8_t tmp[64];
+
+	shake_extract(sc, tmp, sizeof tmp);
+	curve9767_scalar_decode_reduce(x, tmp, sizeof tmp);
+	curve9767_scalar_condcopy(x, &curve9767_scalar_one,
+		curve9767_scalar_is_zero(x));
+}
+
+/*
+ * Compute the binding factor for participant id.
+ */
+static void
+binding_factor(curve9767_scalar *rho,
+	const curve9767_frost_session *fs, unsigned id)
+{
+	shake_context sc;
+	uint8_t tmp[4];
+
+	enc32le(tmp, id);
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_FROST_BIND, strlen(DOM_FROST_BIND));
+	shake_inject(&sc, fs->rho_key, sizeof fs->rho_key);
+	shake_inject(&sc, tmp, sizeof tmp);
+	shake_flip(&sc);
+	extract_scalar(rho, &sc);
+}
+
+/*
+ * Compute the Lagrange coefficient (at 0) of signer k of the session:
+ *   lambda_k = prod_{j != k} x_j / (x_j - x_k)
+ */
+static void
+lagrange(curve9767_scalar *lambda, const curve9767_frost_session *fs,
+	size_t k)
+{
+	curve9767_scalar num, den, xk, xj, t;
+	size_t j;
+
+	num = curve9767_scalar_one;
+	den = curve9767_scalar_one;
+	scalar_from_id(&xk, fs->comm[k].id);
+	for (j = 0; j < fs->num; j ++) {
+		if (j == k) {
+			continue;
+		}
+		scalar_from_id(&xj, fs->comm[j].id);
+		curve9767_scalar_mul(&num, &num, &xj);
+		curve9767_scalar_sub(&t, &xj, &xk);
+		curve9767_scalar_mul(&den, &den, &t);
+	}
+	curve9767_scalar_inv(&den, &den);
+	curve9767_scalar_mul(lambda, &num, &den);
+}
+
+/* see curve9767.h */
+int
+curve9767_frost_split(curve9767_scalar *shares,
+	const curve9767_scalar *s, unsigned threshold, unsigned num,
+	const void *seed, size_t seed_len)
+{
+	curve9767_scalar coeff[CURVE9767_FROST_MAX_SIGNERS];
+	shake_context sc;
+	uint8_t tmp[32];
+	unsigned i, k;
+
+	if (threshold < 1 || threshold > num
+		|| num > CURVE9767_FROST_MAX_PARTICIPANTS
+		|| threshold > CURVE9767_FROST_MAX_SIGNERS)
+	{
+		return 0;
+	}
+
+	/*
+	 * f(x) = s + coeff[1]*x + ... + coeff[threshold-1]*x^(threshold-1)
+	 */
+	curve9767_scalar_encode(tmp, s);
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_FROST_SPLIT, strlen(DOM_FROST_SPLIT));
+	shake_inject(&sc, tmp, sizeof tmp);
+	shake_inject(&sc, seed, seed_len);
+	shake_flip(&sc);
+	coeff[0] = *s;
+	for (k = 1; k < threshold; k ++) {
+		extract_scalar(&coeff[k], &sc);
+	}
+
+	/*
+	 * Share of participant i+1 is f(i+1) (Horner's rule).
+	 */
+	for (i = 0; i < num; i ++) {
+		curve9767_scalar x, y;
+
+		scalar_from_id(&x, i + 1);
+		y = coeff[threshold - 1];
+		for (k = threshold - 1; k > 0; k --) {
+			curve9767_scalar_mul(&y, &y, &x);
+			curve9767_scalar_add(&y, &y, &coeff[k - 1]);
+		}
+		shares[i] = y;
+	}
+	return 1;
+}
+
+/* see curve9767.h */
+int
+curve9767_frost_nonce_generate(curve9767_frost_nonce *nonces,
+	curve9767_frost_commitment *comm, size_t num, unsigned id,
+	const curve9767_scalar *s_i, const void *seed, size_t seed_len)
+{
+	shake_context sc;
+	uint8_t tmp[32];
+	size_t u;
+
+	if (id < 1 || id > CURVE9767_FROST_MAX_PARTICIPANTS) {
+		return 0;
+	}
+	curve9767_scalar_encode(tmp, s_i);
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_FROST_NONCE, strlen(DOM_FROST_NONCE));
+	shake_inject(&sc, tmp, sizeof tmp);
+	enc32le(tmp, id);
+	shake_inject(&sc, tmp, 4);
+	shake_inject(&sc, seed, seed_len);
+	shake_flip(&sc);
+	for (u = 0; u < num; u ++) {
+		curve9767_frost_nonce *fn;
+		curve9767_point T;
+
+		fn = &nonces[u];
+		extract_scalar(&fn->d, &sc);
+		extract_scalar(&fn->e, &sc);
+		fn->comm.id = id;
+		curve9767_point_mulgen(&T, &fn->d);
+		curve9767_point_encode(fn->comm.D, &T);
+		curve9767_point_mulgen(&T, &fn->e);
+		curve9767_point_encode(fn->comm.E, &T);
+		if (comm != NULL) {
+			comm[u] = fn->comm;
+		}
+	}
+	return 1;
+}
+
+/* see curve9767.h */
+size_t
+curve9767_frost_tmp_size(size_t num)
+{
+	return 3 * num * (sizeof(curve9767_point) + 32)
+		+ curve9767_msm_scratch_size(curve9767_msm_window_bits(3 * num));
+}
+
+/*
+ * Check whether the work area can hold n points, n scalars, and the MSM
+ * scratch area.
+ */
+static int
+msm_fits(size_t n, size_t tmp_len)
+{
+	size_t len;
+
+	len = n * (sizeof(curve9767_point) + 32);
+	return tmp_len >= len
+		&& tmp_len - len >= curve9767_msm_scratch_size(2);
+}
+
+/* see curve9767.h */
+int
+curve9767_frost_session_init(curve9767_frost_session *fs,
+	const curve9767_point *Q,
+	const curve9767_frost_commitment *comm, size_t num,
+	const char *hash_oid, const void *hv, size_t hv_len,
+	void *tmp, size_t tmp_len)
+{
+	shake_context sc;
+	curve9767_point R, D, E;
+	curve9767_point *points;
+	uint8_t *scalars;
+	uint8_t buf[4];
+	size_t j;
+	int use_msm;
+
+	if (num < 1 || num > CURVE9767_FROST_MAX_SIGNERS || Q->neutral) {
+		return 0;
+	}
+	for (j = 0; j < num; j ++) {
+		if (comm[j].id < 1
+			|| comm[j].id > CURVE9767_FROST_MAX_PARTICIPANTS
+			|| (j > 0 && comm[j].id <= comm[j - 1].id))
+		{
+			return 0;
+		}
+	}
+	fs->num = num;
+	memcpy(fs->comm, comm, num * sizeof *comm);
+	curve9767_point_encode(fs->encoded_Q, Q);
+
+	/*
+	 * The binding factors depend on the public key, all commitments,
+	 * and the message.
+	 */
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_FROST_RHO, strlen(DOM_FROST_RHO));
+	shake_inject(&sc, fs->encoded_Q, 32);
+	enc32le(buf, (uint32_t)num);
+	shake_inject(&sc, buf, sizeof buf);
+	for (j = 0; j < num; j ++) {
+		enc32le(buf, comm[j].id);
+		shake_inject(&sc, buf, sizeof buf);
+		shake_inject(&sc, comm[j].D, 32);
+		shake_inject(&sc, comm[j].E, 32);
+	}
+	shake_inject(&sc, hash_oid, strlen(hash_oid));
+	shake_inject(&sc, ":", 1);
+	shake_inject(&sc, hv, hv_len);
+	shake_flip(&sc);
+	shake_extract(&sc, fs->rho_key, sizeof fs->rho_key);
+
+	/*
+	 * R = sum (D_j + rho_j*E_j), with a single MSM if the work area
+	 * is large enough (D_j at index 2*j, with scalar 1).
+	 */
+	use_msm = tmp != NULL && msm_fits(num << 1, tmp_len);
+	points = tmp;
+	scalars = (uint8_t *)tmp + (num << 1) * sizeof(curve9767_point);
+	curve9767_point_set_neutral(&R);
+	for (j = 0; j < num; j ++) {
+		curve9767_scalar rho;
+
+		if (!curve9767_point_decode(&D, comm[j].D)
+			|| !curve9767_point_decode(&E, comm[j].E))
+		{
+			return 0;
+		}
+		binding_factor(&rho, fs, comm[j].id);
+		if (use_msm) {
+			points[j << 1] = D;
+			points[(j << 1) + 1] = E;
+			curve9767_scalar_encode(scalars + (j << 6),
+				&curve9767_scalar_one);
+			curve9767_scalar_encode(scalars + (j << 6) + 32, &rho);
+		} else {
+			curve9767_point_mul(&E, &E, &rho);
+			curve9767_point_add(&R, &R, &D);
+			curve9767_point_add(&R, &R, &E);
+		}
+	}
+	if (use_msm) {
+		curve9767_msm(&R, points, scalars, num << 1,
+			scalars + (num << 6),
+			tmp_len - (num << 1) * (sizeof(curve9767_point) + 32));
+	}
+
+	curve9767_point_encode(fs->c, &R);
+	curve9767_inner_sign_challenge(&fs->e, fs->c, fs->encoded_Q,
+		hash_oid, hv, hv_len);
+	return 1;
+}
+
+/* see curve9767.h */
+int
+curve9767_frost_sign_share(void *sig_share,
+	const curve9767_frost_session *fs, unsigned id,
+	const curve9767_scalar *s_i, curve9767_frost_nonce *nonce)
+{
+	curve9767_scalar rho, lambda, z, t;
+	size_t k;
+
+	for (k = 0; k < fs->num; k ++) {
+		if (fs->comm[k].id == id) {
+			break;
+		}
+	}
+	if (k == fs->num
+		|| memcmp(&nonce->comm, &fs->comm[k], sizeof nonce->comm) != 0
+		|| curve9767_scalar_is_zero(&nonce->d))
+	{
+		return 0;
+	}
+
+	/*
+	 * z_i = d_i + rho_i*e_i + lambda_i*e*s_i
+	 */
+	binding_factor(&rho, fs, id);
+	lagrange(&lambda, fs, k);
+	curve9767_scalar_mul(&z, &rho, &nonce->e);
+	curve9767_scalar_add(&z, &z, &nonce->d);
+	curve9767_scalar_mul(&t, &lambda, &fs->e);
+	curve9767_scalar_mul(&t, &t, s_i);
+	curve9767_scalar_add(&z, &z, &t);
+	curve9767_scalar_encode(sig_share, &z);
+
+	/*
+	 * Erase the nonce; an erased nonce has d = 0, and cannot be used
+	 * again.
+	 */
+	memset(nonce, 0, sizeof *nonce);
+	return 1;
+}
+
+/*
+ * Verify share j individually: z_j*G - lambda_j*e*Y_j must be equal to
+ * D_j + rho_j*E_j.
+ */
+static uint32_t
+verify_share(const curve9767_frost_session *fs, size_t j,
+	const curve9767_scalar *z, const curve9767_point *Y)
+{
+	curve9767_scalar rho, lambda;
+	curve9767_point A, D, E;
+
+	binding_factor(&rho, fs, fs->comm[j].id);
+	lagrange(&lambda, fs, j);
+	curve9767_scalar_mul(&lambda, &lambda, &fs->e);
+	curve9767_scalar_neg(&lambda, &lambda);
+	curve9767_point_mul_mulgen_add(&A, Y, &lambda, z);
+	curve9767_point_decode(&D, fs->comm[j].D);
+	curve9767_point_decode(&E, fs->comm[j].E);
+	curve9767_point_mul(&E, &E, &rho);
+	curve9767_point_add(&E, &E, &D);
+	curve9767_point_sub(&A, &A, &E);
+	return (uint32_t)curve9767_point_is_neutral(&A);
+}
+
+static void
+set_result(uint8_t *results, size_t i, uint32_t r)
+{
+	if (results != NULL) {
+		results[i >> 3] &= (uint8_t)~(1u << (i & 7));
+		results[i >> 3] |= (uint8_t)(r << (i & 7));
+	}
+}
+
+/* see curve9767.h */
+int
+curve9767_frost_verify_shares(uint8_t *results,
+	const curve9767_frost_session *fs, const void *sig_shares,
+	const curve9767_point *Y, void *tmp, size_t tmp_len)
+{
+	const uint8_t *zbuf;
+	curve9767_scalar z[CURVE9767_FROST_MAX_SIGNERS];
+	uint32_t ok[CURVE9767_FROST_MAX_SIGNERS];
+	size_t num, j;
+	int r;
+
+	zbuf = sig_shares;
+	num = fs->num;
+	if (results != NULL) {
+		memset(results, 0, (num + 7) >> 3);
+	}
+	r = 1;
+	for (j = 0; j < num; j ++) {
+		ok[j] = curve9767_scalar_decode_strict(&z[j], zbuf + (j << 5), 32);
+		r &= (int)ok[j];
+	}
+
+	/*
+	 * Combined check with a single MSM (D_j, E_j and Y_j at indices
+	 * 3*j, 3*j+1 and 3*j+2). Shares that could not be decoded are
+	 * excluded.
+	 */
+	if (num >= 2 && tmp != NULL && msm_fits(3 * num, tmp_len)) {
+		curve9767_point *points;
+		uint8_t *scalars;
+		curve9767_scalar sz, rj, t, lambda, rho;
+		curve9767_point T;
+		shake_context sc;
+		uint8_t rb[32];
+
+		points = tmp;
+		scalars = (uint8_t *)tmp + 3 * num * sizeof(curve9767_point);
+		curve9767_inner_kdf_init(&sc);
+		shake_inject(&sc, DOM_FROST_VERIFY, strlen(DOM_FROST_VERIFY));
+		shake_inject(&sc, fs->c, sizeof fs->c);
+		shake_inject(&sc, fs->rho_key, sizeof fs->rho_key);
+		shake_inject(&sc, zbuf, num << 5);
+		shake_flip(&sc);
+		sz = curve9767_scalar_zero;
+		memset(rb, 0, sizeof rb);
+		for (j = 0; j < num; j ++) {
+			uint8_t *sj;
+
+			shake_extract(&sc, rb, 16);
+			curve9767_scalar_decode_strict(&rj, rb, sizeof rb);
+			curve9767_scalar_condcopy(&rj, &curve9767_scalar_zero,
+				1 - ok[j]);
+			curve9767_scalar_mul(&t, &rj, &z[j]);
+			curve9767_scalar_add(&sz, &sz, &t);
+
+			curve9767_point_decode(&points[3 * j], fs->comm[j].D);
+			curve9767_point_decode(&points[3 * j + 1],
+				fs->comm[j].E);
+			points[3 * j + 2] = Y[j];
+			binding_factor(&rho, fs, fs->comm[j].id);
+			lagrange(&lambda, fs, j);
+			curve9767_scalar_neg(&rj, &rj);
+			sj = scalars + 96 * j;
+			curve9767_scalar_encode(sj, &rj);
+			curve9767_scalar_mul(&t, &rj, &rho);
+			curve9767_scalar_encode(sj + 32, &t);
+			curve9767_scalar_mul(&t, &rj, &lambda);
+			curve9767_scalar_mul(&t, &t, &fs->e);
+			curve9767_scalar_encode(sj + 64, &t);
+		}
+		curve9767_msm(&T, points, scalars, 3 * num,
+			scalars + 96 * num,
+			tmp_len - 3 * num * (sizeof(curve9767_point) + 32));
+		curve9767_point_mulgen(&points[0], &sz);
+		curve9767_point_add(&T, &T, &points[0]);
+		if (curve9767_point_is_neutral(&T)) {
+			for (j = 0; j < num; j ++) {
+				set_result(results, j, ok[j]);
+			}
+			return r;
+		}
+		if (results == NULL) {
+			return 0;
+		}
+	}
+
+	/*
+	 * Individual checks.
+	 */
+	for (j = 0; j < num; j ++) {
+		if (ok[j]) {
+			ok[j] = verify_share(fs, j, &z[j], &Y[j]);
+		}
+		set_result(results, j, ok[j]);
+		r &= (int)ok[j];
+		if (!r && results == NULL) {
+			return 0;
+		}
+	}
+	return r;
+}
+
+/* see curve9767.h */
+void
+curve9767_frost_aggregate(void *sig,
+	const curve9767_frost_session *fs, const void *sig_shares)
+{
+	const uint8_t *zbuf;
+	curve9767_scalar z, t;
+	uint8_t *buf;
+	size_t j;
+
+	zbuf = sig_shares;
+	z = curve9767_scalar_zero;
+	for (j = 0; j < fs->num; j ++) {
+		curve9767_scalar_decode_reduce(&t, zbuf + (j << 5), 32);
+		curve9767_scalar_add(&z, &z, &t);
+	}
+	buf = sig;
+	memcpy(buf, fs->c, 32);
+	curve9767_scalar_encode(buf + 32, &z);
+}
@@ -0,0 +1,251 @@
+#include "inner.h"
+
+/*
+ * Large precomputed table for the generator.
+ *
+ * Window i (0 <= i < 32) contains j*(2^(8*i))*G for j = 1..128, split
+ * into 16 consecutive window_point8 structures (sub-window k holds the
+ * multiples 8*k+1 to 8*k+8). For a scalar s, we compute t = s + o mod n,
+ * with o = sum_{i=0..31} 128*2^(8*i) mod n; t < 2^252 and:
+ *   s = sum_{i=0..31} (t_i - 128)*2^(8*i) mod n
+ * where t_i is byte i of t. Each digit t_i - 128 is in the -128..+127
+ * range; a lookup in window i yields the point (or its opposite) with
+ * a constant-time scan of all 128 points. The 32 points are then added
+ * together (31 additions, no doubling).
+ *
+ * Each window is built independently: 2^(8*i)*G is obtained with
+ * curve9767_point_mul2k(), then the multiples are computed in Jacobian
+ * coordinates (successive mixed additions), and normalized by batches
+ * of GT_BATCH points with a single inversion each.
+ *
+ * The build state is global: a pointer to the retained table, a counter
+ * of claimed parts, a counter of completed parts, and a pointer to the
+ * published table (read by curve9767_point_mulgen()). With C11 atomics,
+ * the completion counter uses acquire-release semantics, so that the
+ * thread that completes the last part "sees" the contents written by
+ * all other threads before it publishes the table (release store);
+ * curve9767_point_mulgen() reads the published pointer with an acquire
+ * load.
+ */
+
+#ifndef CURVE9767_ATOMIC
+#if defined __STDC_VERSION__ && __STDC_VERSION__ >= 201112L \
+	&& !defined __STDC_NO_ATOMICS__ && !defined __ARM_ARCH_6M__
+#define CURVE9767_ATOMIC   1
+#else
+#define CURVE9767_ATOMIC   0
+#endif
+#endif
+
+#if CURVE9767_ATOMIC
+#include <stdatomic.h>
+#define GT_VAR(t)          _Atomic(t)
+#define GT_LOAD(v)         atomic_load_explicit(&(v), memory_order_acquire)
+#define GT_STORE(v, x)     atomic_store_explicit(&(v), (x), \
+                                   memory_order_release)
+#define GT_INCR(v)         atomic_fetch_add_explicit(&(v), 1, \
+                                   memory_order_acq_rel)
+#define GT_CAS(v, e, x)    atomic_compare_exchange_strong(&(v), &(e), (x))
+#else
+#define GT_VAR(t)          t
+#define GT_LOAD(v)         (v)
+#define GT_STORE(v, x)     ((v) = (x))
+#define GT_INCR(v)         ((v) ++)
+#define GT_CAS(v, e, x)    ((v) == (e) ? ((v) = (x), 1) : ((e) = (v), 0))
+#endif
+
+static GT_VAR(curve9767_gtable *) gt_retained;
+static GT_VAR(unsigned) gt_claimed;
+static GT_VAR(unsigned) gt_completed;
+static GT_VAR(const curve9767_gtable *) gt_published;
+
+/*
+ * Number of points normalized with a single inversion (multiple of 8).
+ */
+#define GT_BATCH   32
+
+/*
+ * Get sub-window k of window i.
+ */
+#define GT_WINDOW(gt, i, k) \
+	((const window_point8 *)(const void *)(gt)->window[i][k])
+
+/*
+ * Build window i of the table.
+ */
+static void
+build_window(curve9767_gtable *gt, unsigned i)
+{
+	curve9767_point B, P[GT_BATCH];
+	curve9767_jpoint J, JP[GT_BATCH];
+	unsigned j, k;
+
+	curve9767_point_mul2k(&B, &curve9767_generator, i << 3);
+	curve9767_point_to_jacobian(&J, &B);
+	for (j = 0; j < 128; j += GT_BATCH) {
+		for (k = 0; k < GT_BATCH; k ++) {
+			/*
+			 * J = (j+k)*B; the first addition is a doubling,
+			 * the next ones cannot be (2 <= j+k <= 127, and the
+			 * curve order is a prime greater than 128).
+			 */
+			if (j + k == 1) {
+				curve9767_inner_jpoint_add_affine(&J, &B);
+			} else if (j + k > 1) {
+				curve9767_inner_jpoint_add_affine_distinct(
+					&J, &B);
+			}
+			JP[k] = J;
+		}
+		curve9767_jpoint_normalize_batch(P, JP, GT_BATCH);
+		for (k = 0; k < GT_BATCH; k ++) {
+			curve9767_inner_window_put(
+				(window_point8 *)(void *)
+				gt->window[i][(j + k) >> 3],
+				&P[k], (j + k) & 7);
+		}
+	}
+}
+
+/*
+ * Perform a lookup in window i, based on byte e (digit e - 128). T is
+ * set to (e-128)*(2^(8*i))*G (including the neutral flag).
+ */
+static void
+gt_lookup(curve9767_point *T, const curve9767_gtable *gt,
+	unsigned i, uint32_t e)
+{
+	curve9767_point U;
+	uint32_t e128, index, r, k;
+	int j;
+
+	/*
+	 * Same processing as do_lookup() in curve9767.c: index is
+	 * e - 129 for e >= 129, 127 - e for e <= 127 (negation needed),
+	 * and 0 for e == 128 (neutral).
+	 */
+	e128 = (e & -e) >> 7;
+	index = e - 129;
+	r = index >> 31;
+	index = (index ^ -r) - r;
+	index &= (e128 - 1);
+
+	/*
+	 * Scan all sub-windows; only the one that contains the point
+	 * is kept (masked copy).
+	 */
+	curve9767_inner_window_lookup(T, GT_WINDOW(gt, i, 0), index & 7);
+	for (k = 1; k < 16; k ++) {
+		uint16_t m;
+
+		curve9767_inner_window_lookup(&U,
+			GT_WINDOW(gt, i, k), index & 7);
+		m = (uint16_t)(((k ^ (index >> 3)) - 1) >> 31);
+		m = -m;
+		for (j = 0; j < 19; j ++) {
+			T->x[j] ^= m & (T->x[j] ^ U.x[j]);
+			T->y[j] ^= m & (T->y[j] ^ U.y[j]);
+		}
+	}
+	T->neutral = e128;
+	curve9767_inner_gf_condneg(T->y, r);
+}
+
+/* see inner.h */
+int
+curve9767_inner_gtable_mulgen(curve9767_point *Q3, const curve9767_scalar *s)
+{
+	static const uint8_t gt_off[32] = {
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+	};
+	const curve9767_gtable *gt;
+	curve9767_scalar t;
+	curve9767_point T;
+	curve9767_jpoint J3;
+	uint8_t tb[32];
+	int i, jac;
+
+	gt = GT_LOAD(gt_published);
+	if (gt == NULL) {
+		return 0;
+	}
+	curve9767_scalar_decode_reduce(&t, gt_off, sizeof gt_off);
+	curve9767_scalar_add(&t, &t, s);
+	curve9767_scalar_encode(tb, &t);
+
+	/*
+	 * As in the window-based generator multiplication, the Jacobian
+	 * accumulator is used if CURVE9767_TUNE_JAC_MULGEN is set.
+	 */
+	jac = (curve9767_inner_tune.mul_jacobian
+		& CURVE9767_TUNE_JAC_MULGEN) != 0;
+	gt_lookup(Q3, gt, 31, tb[31]);
+	if (jac) {
+		curve9767_point_to_jacobian(&J3, Q3);
+	}
+	for (i = 30; i >= 0; i --) {
+		gt_lookup(&T, gt, (unsigned)i, tb[i]);
+		if (jac) {
+			curve9767_inner_jpoint_add_affine(&J3, &T);
+		} else {
+			curve9767_point_add(Q3, Q3, &T);
+		}
+	}
+	if (jac) {
+		curve9767_jpoint_normalize_batch(Q3, &J3, 1);
+	}
+	return 1;
+}
+
+/* see curve9767.h */
+int
+curve9767_gtable_build_step(curve9767_gtable *gt)
+{
+	curve9767_gtable *cur;
+	unsigned part;
+
+	/*
+	 * Once-guard: the first table is retained.
+	 */
+	cur = NULL;
+	if (!GT_CAS(gt_retained, cur, gt) && cur != gt) {
+		return 0;
+	}
+
+	/*
+	 * Claim the next part. The counter is checked first, so that
+	 * it does not keep increasing after the build.
+	 */
+	if (GT_LOAD(gt_claimed) >= CURVE9767_GTABLE_PARTS) {
+		return 0;
+	}
+	part = GT_INCR(gt_claimed);
+	if (part >= CURVE9767_GTABLE_PARTS) {
+		return 0;
+	}
+	build_window(gt, part);
+	if (GT_INCR(gt_completed) == CURVE9767_GTABLE_PARTS - 1) {
+		GT_STORE(gt_published, gt);
+	}
+	return 1;
+}
+
+/* see curve9767.h */
+int
+curve9767_gtable_init(curve9767_gtable *gt)
+{
+	while (curve9767_gtable_build_step(gt)) {
+		continue;
+	}
+	return curve9767_gtable_ready();
+}
+
+/* see curve9767.h */
+int
+curve9767_gtable_ready(void)
+{
+	return GT_LOAD(gt_published) != NULL;
+}
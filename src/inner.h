@@ -18,6 +18,12 @@
  *    type. The type field_element below can be used to that effect,
  *    especially for local variables.
  *
+ *  - Arrays must also have room for a 20th uint16_t value (padding),
+ *    which an implementation may read and overwrite with unspecified
+ *    contents (e.g. when processing values with SIMD registers). This
+ *    is the case of field_element and of the coordinates in a
+ *    curve9767_point (followed by a dummy field).
+ *
  *  - For functions that receive field elements as parameters and return
  *    field elements, the destination array may be the same as any of
  *    the source arrays; but partial overlap is not supported.
@@ -159,6 +165,15 @@ uint32_t curve9767_inner_gf_decode(uint16_t *c, const void *src);
  */
 void curve9767_inner_gf_map_to_base(uint16_t *c, const void *src);
 
+/*
+ * Batch version of curve9767_inner_gf_map_to_base(): num sequences of
+ * 48 bytes each (consecutive in src) are mapped to the field elements
+ * c[0] to c[num-1]. The output is the same as with num individual calls,
+ * but implementations may process several inputs in parallel.
+ */
+void curve9767_inner_gf_map_to_base_batch(field_element *c,
+	const void *src, size_t num);
+
 /* ==================================================================== */
 /*
  * Curve9767 functions.
@@ -215,6 +230,22 @@ extern const window_point8 curve9767_inner_window_G64;
 extern const window_point8 curve9767_inner_window_G128;
 extern const window_point8 curve9767_inner_window_G192;
 
+/*
+ * Generator multiplication with the large table (see curve9767_gtable_init()).
+ * If the table is published, Q3 is set to s*G and 1 is returned;
+ * otherwise, Q3 is unmodified and 0 is returned.
+ */
+int curve9767_inner_gtable_mulgen(curve9767_point *Q3,
+	const curve9767_scalar *s);
+
+/*
+ * Identifier for the implementation-specific representation of points
+ * and windows (each implementation uses a distinct value). It is stored
+ * in precomputed key objects (see curve9767_precomp_load()), so that
+ * objects serialized by another implementation are rejected.
+ */
+extern const uint32_t curve9767_inner_repr_id;
+
 /*
  * Apply Icart's map on an input field element u. Map is described in
  * section 2 of: https://eprint.iacr.org/2009/226
@@ -231,6 +262,117 @@ extern const window_point8 curve9767_inner_window_G192;
  */
 void curve9767_inner_Icart_map(curve9767_point *Q, const uint16_t *u);
 
+/*
+ * Apply Icart's map on two input field elements u1 and u2, and add the
+ * two resulting points together into Q. The result is the same as with
+ * two calls to curve9767_inner_Icart_map() followed by
+ * curve9767_point_add(), but both maps share a single field inversion,
+ * and their computations are interleaved.
+ *
+ * Arrays u1[] and u2[] MUST be disjoint from Q.
+ */
+void curve9767_inner_Icart_map2(curve9767_point *Q,
+	const uint16_t *u1, const uint16_t *u2);
+
+/*
+ * Incomplete point addition: this is the same as curve9767_point_add(),
+ * except that Q1 and Q2 MUST NOT have the same X coordinate, unless at
+ * least one of them is the neutral (i.e. if neither is the neutral, then
+ * Q1 != Q2 and Q1 != -Q2). This saves the computation of the tangent
+ * slope, and the comparisons. Neutral operands are handled (in
+ * constant time). Each call site must document why the condition holds.
+ */
+void curve9767_inner_point_add_distinct(curve9767_point *Q3,
+	const curve9767_point *Q1, const curve9767_point *Q2);
+
+/*
+ * Point doubling in Jacobian coordinates (constant-time). The neutral
+ * flag is kept unchanged.
+ */
+void curve9767_inner_jpoint_double(curve9767_jpoint *P);
+
+/*
+ * Add point Q (affine coordinates) to point P (Jacobian coordinates).
+ * This is constant-time and handles all cases (P == Q, P == -Q, either
+ * point being the neutral).
+ */
+void curve9767_inner_jpoint_add_affine(curve9767_jpoint *P,
+	const curve9767_point *Q);
+
+/*
+ * Incomplete version of curve9767_inner_jpoint_add_affine(): P and Q
+ * MUST NOT be equal or opposite, unless at least one of them is the
+ * neutral (same condition as curve9767_inner_point_add_distinct()).
+ * This avoids the computation of 2*P. Neutral operands are handled
+ * (in constant time).
+ */
+void curve9767_inner_jpoint_add_affine_distinct(curve9767_jpoint *P,
+	const curve9767_point *Q);
+
+/*
+ * Variable-time versions of the Jacobian point additions, for public
+ * data (MSM): curve9767_inner_jpoint_add_affine_vartime() computes the
+ * same result as curve9767_inner_jpoint_add_affine(), with early exits
+ * for the special cases; curve9767_inner_jpoint_add_vartime() adds
+ * two points in Jacobian coordinates (P <- P + Q, all cases handled).
+ * The neutral is recognized by its flag only (other fields are then
+ * ignored).
+ */
+void curve9767_inner_jpoint_add_affine_vartime(curve9767_jpoint *P,
+	const curve9767_point *Q);
+void curve9767_inner_jpoint_add_vartime(curve9767_jpoint *P,
+	const curve9767_jpoint *Q);
+
+/*
+ * Compute the signature challenge e from the first half of a signature
+ * (c, 32 bytes), the encoded public key (32 bytes), and the hashed
+ * message (see curve9767_sign_generate()).
+ */
+void curve9767_inner_sign_challenge(curve9767_scalar *e,
+	const uint8_t *c, const uint8_t *encoded_Q,
+	const char *hash_oid, const void *hv, size_t hv_len);
+
+/* ==================================================================== */
+/*
+ * Active tuning configuration (see curve9767_tune_set()).
+ */
+extern curve9767_tune_config curve9767_inner_tune;
+
+/* ==================================================================== */
+/*
+ * Hashing profile for internal derivations.
+ *
+ * Key pair generation, deterministic signature nonces, signature
+ * challenges and the ECDH key derivation all use SHAKE256 with a
+ * domain separation string that starts with "curve9767-". If the
+ * CURVE9767_TURBOSHAKE macro is defined to a non-zero value at
+ * compile-time, then these derivations instead use TurboSHAKE256
+ * (12 rounds instead of 24, domain separation byte 0x1F), and the
+ * domain separation strings start with "curve9767-ts-" (e.g. the
+ * keygen string becomes "curve9767-ts-keygen:").
+ *
+ * The TurboSHAKE profile is NOT interoperable with the default
+ * profile: keys, signatures and ECDH shared secrets differ. It is
+ * meant for closed systems where all parties use this code with the
+ * same compile-time profile. It roughly halves the hashing cost,
+ * which is significant on small microcontrollers.
+ *
+ * Hash-to-curve is not affected, since the caller provides the
+ * SHAKE context (which may be initialized with turboshake_init()).
+ */
+
+#ifndef CURVE9767_TURBOSHAKE
+#define CURVE9767_TURBOSHAKE   0
+#endif
+
+#if CURVE9767_TURBOSHAKE
+#define CURVE9767_DOM(name)            "curve9767-ts-" name
+#define curve9767_inner_kdf_init(sc)   turboshake_init((sc), 256, 0x1F)
+#else
+#define CURVE9767_DOM(name)            "curve9767-" name
+#define curve9767_inner_kdf_init(sc)   shake_init((sc), 256)
+#endif
+
 /* ==================================================================== */
 
 #endif
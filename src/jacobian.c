@@ -0,0 +1,394 @@
+#include "inner.h"
+
+/*
+ * Conversions between affine and Jacobian coordinates.
+ *
+ * Batch normalization uses Montgomery's trick: with Z_0..Z_(n-1) the
+ * Z coordinates, we compute the prefix products
+ *   pp_i = Z_0*Z_1*...*Z_i
+ * then invert pp_(n-1); walking back the points, 1/Z_i = (1/pp_i)*pp_(i-1)
+ * and 1/pp_(i-1) = (1/pp_i)*Z_i. Neutral points use Z = 1 in the
+ * products, so that they do not alter the result for the other points
+ * (this is done with constant-time selection, since the neutral status
+ * may be secret).
+ *
+ * The prefix products are stored in the x[] arrays of the destination
+ * points, so that no extra storage is needed: pp_(i-1) is still
+ * available when point i is converted, since points are converted
+ * from last to first.
+ */
+
+/*
+ * Get the Z coordinate of P into z, replaced with 1 if P is neutral.
+ */
+static void
+get_z(field_element *z, const curve9767_jpoint *P)
+{
+	uint32_t m;
+	int i;
+
+	m = -P->neutral;
+	for (i = 0; i < 19; i ++) {
+		z->v[i] = P->z[i] ^ (uint16_t)(m
+			& (P->z[i] ^ curve9767_inner_gf_one.v[i]));
+	}
+	z->v[19] = 0;
+}
+
+/* see curve9767.h */
+void
+curve9767_point_to_jacobian(curve9767_jpoint *P, const curve9767_point *Q)
+{
+	P->neutral = Q->neutral;
+	memcpy(P->x, Q->x, sizeof P->x);
+	memcpy(P->y, Q->y, sizeof P->y);
+	memcpy(P->z, curve9767_inner_gf_one.v, sizeof P->z);
+}
+
+/* see curve9767.h */
+void
+curve9767_jpoint_normalize_batch(curve9767_point *Q,
+	const curve9767_jpoint *P, size_t num)
+{
+	field_element t, z, iz, iz2;
+	size_t u;
+
+	if (num == 0) {
+		return;
+	}
+
+	/*
+	 * Prefix products, in Q[u].x.
+	 */
+	get_z(&z, &P[0]);
+	memcpy(Q[0].x, z.v, sizeof Q[0].x);
+	for (u = 1; u < num; u ++) {
+		get_z(&z, &P[u]);
+		curve9767_inner_gf_mul(Q[u].x, Q[u - 1].x, z.v);
+	}
+
+	/*
+	 * Invert the product of all Z, and walk back the points.
+	 */
+	curve9767_inner_gf_inv(t.v, Q[num - 1].x);
+	for (u = num; u -- > 0;) {
+		uint32_t m;
+		int i;
+
+		if (u > 0) {
+			curve9767_inner_gf_mul(iz.v, t.v, Q[u - 1].x);
+			get_z(&z, &P[u]);
+			curve9767_inner_gf_mul(t.v, t.v, z.v);
+		} else {
+			iz = t;
+		}
+		curve9767_inner_gf_sqr(iz2.v, iz.v);
+		curve9767_inner_gf_mul(Q[u].x, P[u].x, iz2.v);
+		curve9767_inner_gf_mul(iz2.v, iz2.v, iz.v);
+		curve9767_inner_gf_mul(Q[u].y, P[u].y, iz2.v);
+
+		/*
+		 * Coordinates of neutral points are cleared, as in
+		 * curve9767_point_set_neutral().
+		 */
+		m = P[u].neutral - 1;
+		for (i = 0; i < 19; i ++) {
+			Q[u].x[i] &= (uint16_t)m;
+			Q[u].y[i] &= (uint16_t)m;
+		}
+		Q[u].neutral = P[u].neutral;
+	}
+}
+
+/* see curve9767.h */
+int
+curve9767_jpoint_encode_batch(void *dst,
+	const curve9767_jpoint *P, size_t num)
+{
+	curve9767_point Q[CURVE9767_JPOINT_ENCODE_CHUNK];
+	uint8_t *buf;
+	int r;
+
+	buf = dst;
+	r = 1;
+	while (num > 0) {
+		size_t n, u;
+
+		n = num < CURVE9767_JPOINT_ENCODE_CHUNK
+			? num : CURVE9767_JPOINT_ENCODE_CHUNK;
+		curve9767_jpoint_normalize_batch(Q, P, n);
+		for (u = 0; u < n; u ++) {
+			r &= curve9767_point_encode(buf + (u << 5), &Q[u]);
+		}
+		buf += n << 5;
+		P += n;
+		num -= n;
+	}
+	return r;
+}
+
+/*
+ * Constant-time copy of the coordinates and flag of s into d, if
+ * ctl == 1; if ctl == 0, d is unmodified.
+ */
+static void
+jpoint_condcopy(curve9767_jpoint *d, const curve9767_jpoint *s, uint32_t ctl)
+{
+	uint32_t m;
+	int i;
+
+	m = -ctl;
+	d->neutral ^= m & (d->neutral ^ s->neutral);
+	for (i = 0; i < 19; i ++) {
+		d->x[i] ^= (uint16_t)(m & (d->x[i] ^ s->x[i]));
+		d->y[i] ^= (uint16_t)(m & (d->y[i] ^ s->y[i]));
+		d->z[i] ^= (uint16_t)(m & (d->z[i] ^ s->z[i]));
+	}
+}
+
+/* see inner.h */
+void
+curve9767_inner_jpoint_double(curve9767_jpoint *P)
+{
+	field_element delta, gamma, beta, alpha, t;
+
+	/*
+	 * Formulas: dbl-2001-b (a = -3), 3M+5S. There is no point of
+	 * order 2 on the curve, hence no special case besides the
+	 * neutral (whose flag is kept unchanged).
+	 */
+	curve9767_inner_gf_sqr(delta.v, P->z);
+	curve9767_inner_gf_sqr(gamma.v, P->y);
+	curve9767_inner_gf_mul(beta.v, P->x, gamma.v);
+	curve9767_inner_gf_sub(t.v, P->x, delta.v);
+	curve9767_inner_gf_add(alpha.v, P->x, delta.v);
+	curve9767_inner_gf_mul(alpha.v, alpha.v, t.v);
+	curve9767_inner_gf_add(t.v, alpha.v, alpha.v);
+	curve9767_inner_gf_add(alpha.v, alpha.v, t.v);
+
+	/* Z3 = (Y1+Z1)^2 - gamma - delta */
+	curve9767_inner_gf_add(t.v, P->y, P->z);
+	curve9767_inner_gf_sqr(t.v, t.v);
+	curve9767_inner_gf_sub(t.v, t.v, gamma.v);
+	curve9767_inner_gf_sub(P->z, t.v, delta.v);
+
+	/* X3 = alpha^2 - 8*beta */
+	curve9767_inner_gf_add(beta.v, beta.v, beta.v);
+	curve9767_inner_gf_add(beta.v, beta.v, beta.v);
+	curve9767_inner_gf_sqr(t.v, alpha.v);
+	curve9767_inner_gf_sub(t.v, t.v, beta.v);
+	curve9767_inner_gf_sub(P->x, t.v, beta.v);
+
+	/* Y3 = alpha*(4*beta - X3) - 8*gamma^2 */
+	curve9767_inner_gf_sub(t.v, beta.v, P->x);
+	curve9767_inner_gf_mul(t.v, t.v, alpha.v);
+	curve9767_inner_gf_sqr(gamma.v, gamma.v);
+	curve9767_inner_gf_add(gamma.v, gamma.v, gamma.v);
+	curve9767_inner_gf_add(gamma.v, gamma.v, gamma.v);
+	curve9767_inner_gf_add(gamma.v, gamma.v, gamma.v);
+	curve9767_inner_gf_sub(P->y, t.v, gamma.v);
+}
+
+/*
+ * Generic mixed addition (madd-2007-bl, 7M+4S): T is set to P + Q,
+ * assuming that neither point is the neutral, and that P != Q and
+ * P != -Q (the neutral flag of T is not set). With H = U2 - X1 and
+ * r = S2 - Y1 (in the notations of the formulas), *eh is set to 1 if
+ * H == 0 (0 otherwise), and *er to 1 if r == 0 (0 otherwise); when
+ * neither point is the neutral, H == 0 means that P = Q or P = -Q.
+ * If eh is NULL, then these flags are not computed.
+ */
+static void
+jpoint_madd(curve9767_jpoint *T, uint32_t *eh, uint32_t *er,
+	const curve9767_jpoint *P, const curve9767_point *Q)
+{
+	field_element z1z1, u2, s2, h, hh, i, j, r, v, t;
+
+	curve9767_inner_gf_sqr(z1z1.v, P->z);
+	curve9767_inner_gf_mul(u2.v, Q->x, z1z1.v);
+	curve9767_inner_gf_mul(s2.v, P->z, z1z1.v);
+	curve9767_inner_gf_mul(s2.v, s2.v, Q->y);
+	curve9767_inner_gf_sub(h.v, u2.v, P->x);
+	curve9767_inner_gf_sub(r.v, s2.v, P->y);
+	if (eh != NULL) {
+		*eh = curve9767_inner_gf_eq(h.v, curve9767_inner_gf_zero.v);
+		*er = curve9767_inner_gf_eq(r.v, curve9767_inner_gf_zero.v);
+	}
+	curve9767_inner_gf_sqr(hh.v, h.v);
+	curve9767_inner_gf_add(i.v, hh.v, hh.v);
+	curve9767_inner_gf_add(i.v, i.v, i.v);
+	curve9767_inner_gf_mul(j.v, h.v, i.v);
+	curve9767_inner_gf_add(r.v, r.v, r.v);
+	curve9767_inner_gf_mul(v.v, P->x, i.v);
+
+	/* Z3 = (Z1+H)^2 - Z1Z1 - HH */
+	curve9767_inner_gf_add(t.v, P->z, h.v);
+	curve9767_inner_gf_sqr(t.v, t.v);
+	curve9767_inner_gf_sub(t.v, t.v, z1z1.v);
+	curve9767_inner_gf_sub(T->z, t.v, hh.v);
+
+	/* X3 = r^2 - J - 2*V */
+	curve9767_inner_gf_sqr(t.v, r.v);
+	curve9767_inner_gf_sub(t.v, t.v, j.v);
+	curve9767_inner_gf_sub(t.v, t.v, v.v);
+	curve9767_inner_gf_sub(T->x, t.v, v.v);
+
+	/* Y3 = r*(V - X3) - 2*Y1*J */
+	curve9767_inner_gf_mul(j.v, j.v, P->y);
+	curve9767_inner_gf_add(j.v, j.v, j.v);
+	curve9767_inner_gf_sub(t.v, v.v, T->x);
+	curve9767_inner_gf_mul(t.v, t.v, r.v);
+	curve9767_inner_gf_sub(T->y, t.v, j.v);
+}
+
+/* see inner.h */
+void
+curve9767_inner_jpoint_add_affine(curve9767_jpoint *P,
+	const curve9767_point *Q)
+{
+	curve9767_jpoint D, T;
+	uint32_t eh, er;
+
+	/*
+	 * The generic formulas do not work when P = Q or P = -Q, or when
+	 * one of the points is the neutral; we also compute 2*P, and
+	 * select the correct result in constant time:
+	 *   P neutral            (Q.x : Q.y : 1), flag from Q
+	 *   Q neutral            P
+	 *   P = Q                2*P
+	 *   P = -Q               neutral
+	 *   otherwise            P + Q (generic formulas)
+	 */
+	D = *P;
+	curve9767_inner_jpoint_double(&D);
+	jpoint_madd(&T, &eh, &er, P, Q);
+
+	/*
+	 * Generic result is valid (and not neutral) if H != 0. If H == 0
+	 * and r == 0, then P = Q and we use the double. Otherwise, the
+	 * result is the neutral.
+	 */
+	T.neutral = eh & (1 - er);
+	jpoint_condcopy(&T, &D, eh & er);
+
+	/*
+	 * Neutral operands.
+	 */
+	jpoint_condcopy(&T, P, Q->neutral);
+	curve9767_point_to_jacobian(&D, Q);
+	jpoint_condcopy(&T, &D, P->neutral);
+	*P = T;
+}
+
+/* see inner.h */
+void
+curve9767_inner_jpoint_add_affine_distinct(curve9767_jpoint *P,
+	const curve9767_point *Q)
+{
+	curve9767_jpoint D, T;
+
+	/*
+	 * Since P != Q and P != -Q, the generic result is valid unless
+	 * one of the points is the neutral.
+	 */
+	jpoint_madd(&T, NULL, NULL, P, Q);
+	T.neutral = 0;
+	jpoint_condcopy(&T, P, Q->neutral);
+	curve9767_point_to_jacobian(&D, Q);
+	jpoint_condcopy(&T, &D, P->neutral);
+	*P = T;
+}
+
+/* see inner.h */
+void
+curve9767_inner_jpoint_add_affine_vartime(curve9767_jpoint *P,
+	const curve9767_point *Q)
+{
+	curve9767_jpoint T;
+	uint32_t eh, er;
+
+	/*
+	 * Same cases as curve9767_inner_jpoint_add_affine(), handled
+	 * with early exits (the doubling is computed only if needed).
+	 */
+	if (Q->neutral) {
+		return;
+	}
+	if (P->neutral) {
+		curve9767_point_to_jacobian(P, Q);
+		return;
+	}
+	jpoint_madd(&T, &eh, &er, P, Q);
+	if (eh) {
+		if (er) {
+			curve9767_inner_jpoint_double(P);
+		} else {
+			P->neutral = 1;
+		}
+		return;
+	}
+	T.neutral = 0;
+	*P = T;
+}
+
+/* see inner.h */
+void
+curve9767_inner_jpoint_add_vartime(curve9767_jpoint *P,
+	const curve9767_jpoint *Q)
+{
+	field_element z1z1, z2z2, u1, u2, s1, s2, h, i, j, r, v, t;
+
+	/*
+	 * Formulas: add-2007-bl, 11M+5S.
+	 */
+	if (Q->neutral) {
+		return;
+	}
+	if (P->neutral) {
+		*P = *Q;
+		return;
+	}
+	curve9767_inner_gf_sqr(z1z1.v, P->z);
+	curve9767_inner_gf_sqr(z2z2.v, Q->z);
+	curve9767_inner_gf_mul(u1.v, P->x, z2z2.v);
+	curve9767_inner_gf_mul(u2.v, Q->x, z1z1.v);
+	curve9767_inner_gf_mul(s1.v, P->y, Q->z);
+	curve9767_inner_gf_mul(s1.v, s1.v, z2z2.v);
+	curve9767_inner_gf_mul(s2.v, Q->y, P->z);
+	curve9767_inner_gf_mul(s2.v, s2.v, z1z1.v);
+	curve9767_inner_gf_sub(h.v, u2.v, u1.v);
+	curve9767_inner_gf_sub(r.v, s2.v, s1.v);
+	if (curve9767_inner_gf_eq(h.v, curve9767_inner_gf_zero.v)) {
+		if (curve9767_inner_gf_eq(r.v, curve9767_inner_gf_zero.v)) {
+			curve9767_inner_jpoint_double(P);
+		} else {
+			P->neutral = 1;
+		}
+		return;
+	}
+	curve9767_inner_gf_add(i.v, h.v, h.v);
+	curve9767_inner_gf_sqr(i.v, i.v);
+	curve9767_inner_gf_mul(j.v, h.v, i.v);
+	curve9767_inner_gf_add(r.v, r.v, r.v);
+	curve9767_inner_gf_mul(v.v, u1.v, i.v);
+
+	/* Z3 = ((Z1+Z2)^2 - Z1Z1 - Z2Z2)*H */
+	curve9767_inner_gf_add(t.v, P->z, Q->z);
+	curve9767_inner_gf_sqr(t.v, t.v);
+	curve9767_inner_gf_sub(t.v, t.v, z1z1.v);
+	curve9767_inner_gf_sub(t.v, t.v, z2z2.v);
+	curve9767_inner_gf_mul(P->z, t.v, h.v);
+
+	/* X3 = r^2 - J - 2*V */
+	curve9767_inner_gf_sqr(t.v, r.v);
+	curve9767_inner_gf_sub(t.v, t.v, j.v);
+	curve9767_inner_gf_sub(t.v, t.v, v.v);
+	curve9767_inner_gf_sub(P->x, t.v, v.v);
+
+	/* Y3 = r*(V - X3) - 2*S1*J */
+	curve9767_inner_gf_mul(j.v, j.v, s1.v);
+	curve9767_inner_gf_add(j.v, j.v, j.v);
+	curve9767_inner_gf_sub(t.v, v.v, P->x);
+	curve9767_inner_gf_mul(t.v, t.v, r.v);
+	curve9767_inner_gf_sub(P->y, t.v, j.v);
+}
@@ -1,6 +1,6 @@
 #include "inner.h"
 
-#define DOM_KEYGEN   "curve9767-keygen:"
+#define DOM_KEYGEN   CURVE9767_DOM("keygen:")
 
 /* see curve9767.h */
 void
@@ -11,7 +11,7 @@ curve9767_keygen(curve9767_scalar *s, uint8_t t[32], curve9767_point *Q,
 	uint8_t tmp[64];
 	curve9767_scalar s2;
 
-	shake_init(&sc, 256);
+	curve9767_inner_kdf_init(&sc);
 	shake_inject(&sc, DOM_KEYGEN, strlen(DOM_KEYGEN));
 	shake_inject(&sc, seed, seed_len);
 	shake_flip(&sc);
@@ -0,0 +1,249 @@
+#include "inner.h"
+
+/*
+ * Merkle-batched signatures.
+ *
+ * Tree nodes are SHA3-256 outputs (32 bytes):
+ *   leaf i:       SHA3-256(0x00 || hv_i)
+ *   inner node:   SHA3-256(0x01 || left || right)
+ * Each level is obtained from the previous one by hashing consecutive
+ * pairs of nodes; if a level has an odd number of nodes, the last one
+ * is promoted unchanged to the next level. The levels are stored one
+ * after the other in the tree buffer (leaves first); the last level
+ * contains only the root.
+ *
+ * The signed value is SHA3-256(0x02 || n || root || hash_oid), with n
+ * over 4 bytes (little-endian); it is signed as a hashed message with
+ * the DOM_MERKLE identifier, so that a root signature cannot be
+ * mistaken for a signature over a single message.
+ *
+ * Leaves and inner nodes are computed four at a time, with the
+ * four-way SHA3 implementation (sha3_x4_*()).
+ *
+ * Proof format:
+ *   signature over the root (64 bytes)
+ *   n (4 bytes, little-endian)
+ *   message index i (4 bytes, little-endian)
+ *   sibling nodes from the leaf level up (32 bytes each)
+ */
+
+#define DOM_MERKLE   CURVE9767_DOM("merkle")
+
+static void
+enc32le(uint8_t *buf, uint32_t x)
+{
+	buf[0] = (uint8_t)x;
+	buf[1] = (uint8_t)(x >> 8);
+	buf[2] = (uint8_t)(x >> 16);
+	buf[3] = (uint8_t)(x >> 24);
+}
+
+static uint32_t
+dec32le(const uint8_t *buf)
+{
+	return (uint32_t)buf[0]
+		| ((uint32_t)buf[1] << 8)
+		| ((uint32_t)buf[2] << 16)
+		| ((uint32_t)buf[3] << 24);
+}
+
+/*
+ * Hash num values of in_len bytes each (value j at src + j*in_len),
+ * with a one-byte prefix; output j is written at dst + 32*j.
+ */
+static void
+hash_nodes(uint8_t *dst, const uint8_t *src, size_t num, size_t in_len,
+	uint8_t prefix)
+{
+	const uint8_t pp[4] = { prefix, prefix, prefix, prefix };
+	size_t j;
+
+	for (j = 0; j + 4 <= num; j += 4) {
+		sha3_x4_context sx;
+		const void *in[4];
+		void *out[4];
+		unsigned i;
+
+		for (i = 0; i < 4; i ++) {
+			in[i] = &pp[i];
+			out[i] = dst + ((j + i) << 5);
+		}
+		sha3_x4_init(&sx, 256);
+		sha3_x4_update(&sx, in, 1);
+		for (i = 0; i < 4; i ++) {
+			in[i] = src + (j + i) * in_len;
+		}
+		sha3_x4_update(&sx, in, in_len);
+		sha3_x4_close(&sx, out);
+	}
+	for (; j < num; j ++) {
+		sha3_context sc;
+
+		sha3_init(&sc, 256);
+		sha3_update(&sc, &prefix, 1);
+		sha3_update(&sc, src + j * in_len, in_len);
+		sha3_close(&sc, dst + (j << 5));
+	}
+}
+
+/*
+ * Compute the signed value for a root and a number of messages.
+ */
+static void
+make_signed_value(uint8_t *rv, const uint8_t *root, uint32_t n,
+	const char *hash_oid)
+{
+	sha3_context sc;
+	uint8_t tmp[5];
+
+	tmp[0] = 0x02;
+	enc32le(tmp + 1, n);
+	sha3_init(&sc, 256);
+	sha3_update(&sc, tmp, sizeof tmp);
+	sha3_update(&sc, root, 32);
+	sha3_update(&sc, hash_oid, strlen(hash_oid));
+	sha3_close(&sc, rv);
+}
+
+/* see curve9767.h */
+size_t
+curve9767_merkle_tree_size(size_t n)
+{
+	size_t m, total;
+
+	if (n == 0 || n > 0xFFFFFFFF) {
+		return 0;
+	}
+	total = n;
+	for (m = n; m > 1; m = (m + 1) >> 1) {
+		total += (m + 1) >> 1;
+	}
+	return total << 5;
+}
+
+/* see curve9767.h */
+int
+curve9767_merkle_sign(void *sig, void *tree,
+	const curve9767_scalar *s, const uint8_t t[32],
+	const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len, size_t n)
+{
+	uint8_t *buf, rv[32];
+	size_t m;
+
+	if (curve9767_merkle_tree_size(n) == 0) {
+		return 0;
+	}
+	buf = tree;
+	hash_nodes(buf, hv, n, hv_len, 0x00);
+	for (m = n; m > 1; m = (m + 1) >> 1) {
+		uint8_t *next;
+
+		next = buf + (m << 5);
+		hash_nodes(next, buf, m >> 1, 64, 0x01);
+		if ((m & 1) != 0) {
+			memcpy(next + ((m >> 1) << 5), buf + ((m - 1) << 5), 32);
+		}
+		buf = next;
+	}
+	make_signed_value(rv, buf, (uint32_t)n, hash_oid);
+	curve9767_sign_generate(sig, s, t, Q, DOM_MERKLE, rv, sizeof rv);
+	return 1;
+}
+
+/* see curve9767.h */
+size_t
+curve9767_merkle_proof(void *dst, const void *sig, const void *tree,
+	size_t n, size_t index)
+{
+	const uint8_t *buf;
+	uint8_t *out;
+	size_t m, len;
+
+	if (curve9767_merkle_tree_size(n) == 0 || index >= n) {
+		return 0;
+	}
+	out = dst;
+	memcpy(out, sig, 64);
+	enc32le(out + 64, (uint32_t)n);
+	enc32le(out + 68, (uint32_t)index);
+	len = 72;
+	buf = tree;
+	for (m = n; m > 1; m = (m + 1) >> 1) {
+		size_t sib;
+
+		sib = index ^ 1;
+		if (sib < m) {
+			memcpy(out + len, buf + (sib << 5), 32);
+			len += 32;
+		}
+		buf += m << 5;
+		index >>= 1;
+	}
+	return len;
+}
+
+/* see curve9767.h */
+int
+curve9767_merkle_verify(curve9767_vcache *vc, uint64_t now,
+	const void *proof, size_t proof_len, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	const uint8_t *buf;
+	uint8_t node[32], rv[32];
+	size_t m, n, index, off;
+	sha3_context sc;
+	uint8_t prefix;
+
+	if (proof_len < 72) {
+		return 0;
+	}
+	buf = proof;
+	n = dec32le(buf + 64);
+	index = dec32le(buf + 68);
+	if (n == 0 || index >= n) {
+		return 0;
+	}
+
+	/*
+	 * Recompute the root from the leaf and the sibling nodes; the
+	 * proof length must match exactly.
+	 */
+	prefix = 0x00;
+	sha3_init(&sc, 256);
+	sha3_update(&sc, &prefix, 1);
+	sha3_update(&sc, hv, hv_len);
+	sha3_close(&sc, node);
+	off = 72;
+	prefix = 0x01;
+	for (m = n; m > 1; m = (m + 1) >> 1) {
+		if ((index ^ 1) < m) {
+			if (off + 32 > proof_len) {
+				return 0;
+			}
+			sha3_init(&sc, 256);
+			sha3_update(&sc, &prefix, 1);
+			if ((index & 1) == 0) {
+				sha3_update(&sc, node, 32);
+				sha3_update(&sc, buf + off, 32);
+			} else {
+				sha3_update(&sc, buf + off, 32);
+				sha3_update(&sc, node, 32);
+			}
+			sha3_close(&sc, node);
+			off += 32;
+		}
+		index >>= 1;
+	}
+	if (off != proof_len) {
+		return 0;
+	}
+
+	/*
+	 * Verify the root signature. With a cache, it is verified only
+	 * once for all messages of the batch.
+	 */
+	make_signed_value(rv, node, (uint32_t)n, hash_oid);
+	return curve9767_sign_verify_cached(vc, now, buf, Q,
+		DOM_MERKLE, rv, sizeof rv);
+}
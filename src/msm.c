@@ -0,0 +1,326 @@
+#include "inner.h"
+
+/*
+ * Multi-scalar multiplication (Pippenger's algorithm).
+ *
+ * Scalars are split into windows of c bits, with a signed recoding:
+ * for window w, the digit is:
+ *   d_w = b[c*w..c*w+c-1] + b[c*w-1] - 2^c*b[c*w+c-1]
+ * where b[i] is bit i of the scalar (b[-1] = 0). These digits are in
+ * the -2^(c-1)..+2^(c-1) range, and the sum of d_w*2^(c*w) telescopes
+ * to the scalar value, provided that the top bit of the last window is
+ * zero (hence the number of windows is ceil(253/c), since scalars are
+ * lower than 2^252). Each digit depends only on c+1 scalar bits, so
+ * windows can be processed independently (and in parallel).
+ *
+ * For a window, each point P_i is added to bucket |d_i| (or subtracted,
+ * if d_i < 0). Buckets are kept in Jacobian coordinates, with mixed
+ * (Jacobian + affine) additions. When all points have been added, the
+ * window sum sum_j j*B_j is obtained with the usual running sum, with
+ * two Jacobian additions per bucket. Converting the buckets to affine
+ * coordinates first (with a single inversion) would allow mixed
+ * additions for the running sum, but the conversion costs 6M+S per
+ * bucket while a mixed addition saves only 4M+S, so it is not done.
+ *
+ * The streaming accumulator (curve9767_msm_accumulator_*()) keeps the
+ * buckets of all windows at once: each ingested point is added to one
+ * bucket per window, and the window sums are computed (and combined)
+ * only on finalization. Finalization does not modify the buckets, so
+ * that the accumulator remains usable afterwards.
+ *
+ * All of this is variable-time: MSM is meant for public data.
+ */
+
+/*
+ * Add (d > 0) or subtract (d < 0) point P (not the neutral) to bucket
+ * B[|d|-1].
+ */
+static void
+bucket_add(curve9767_jpoint *B, int32_t d, const curve9767_point *P)
+{
+	if (d > 0) {
+		curve9767_inner_jpoint_add_affine_vartime(&B[d - 1], P);
+	} else if (d < 0) {
+		curve9767_point N;
+
+		curve9767_point_neg(&N, P);
+		curve9767_inner_jpoint_add_affine_vartime(&B[-d - 1], &N);
+	}
+}
+
+/*
+ * Get the signed digit for window w (c bits) from an encoded scalar.
+ */
+static int32_t
+get_digit(const uint8_t *s, unsigned c, unsigned w)
+{
+	unsigned start, k;
+	uint32_t bits;
+	int32_t d;
+
+	/*
+	 * c <= 20, hence the window fits in the four bytes starting at
+	 * the one that contains its first bit. Bits beyond 255 are zero.
+	 */
+	start = c * w;
+	bits = 0;
+	for (k = 0; k < 4; k ++) {
+		unsigned j;
+
+		j = (start >> 3) + k;
+		if (j < 32) {
+			bits |= (uint32_t)s[j] << (k << 3);
+		}
+	}
+	bits = (bits >> (start & 7)) & (((uint32_t)1 << c) - 1);
+	d = (int32_t)bits - (int32_t)((bits >> (c - 1)) << c);
+	if (w > 0) {
+		d += (s[(start - 1) >> 3] >> ((start - 1) & 7)) & 1;
+	}
+	return d;
+}
+
+/*
+ * Compute sum_j (j+1)*B[j] for num_buckets buckets B[] (in Jacobian
+ * coordinates).
+ */
+static void
+bucket_sum(curve9767_jpoint *sum, const curve9767_jpoint *B,
+	size_t num_buckets)
+{
+	curve9767_jpoint run;
+	long j;
+
+	/*
+	 * Running sum: sum_j (j+1)*B[j] = sum_j (B[j] + B[j+1] + ...).
+	 */
+	run.neutral = 1;
+	sum->neutral = 1;
+	for (j = (long)num_buckets - 1; j >= 0; j --) {
+		curve9767_inner_jpoint_add_vartime(&run, &B[j]);
+		curve9767_inner_jpoint_add_vartime(sum, &run);
+	}
+}
+
+/* see curve9767.h */
+unsigned
+curve9767_msm_window_bits(size_t n)
+{
+	unsigned c, best_c;
+	uint64_t best_cost;
+
+	/*
+	 * Cost model (in units of 1/16 of a mixed addition): each window
+	 * costs one bucket addition per point, and a per-bucket cost for
+	 * the running sums, taken from the active tuning configuration
+	 * (48, i.e. 3 mixed additions, by default).
+	 * We also keep the scratch size reasonable (c <= 16).
+	 */
+	best_c = 2;
+	best_cost = (uint64_t)-1;
+	for (c = 2; c <= 16; c ++) {
+		uint64_t w, cost;
+
+		w = (253 + c - 1) / c;
+		cost = w * (16 * (uint64_t)n
+			+ curve9767_inner_tune.msm_bucket_cost
+			* ((uint64_t)1 << (c - 1)));
+		if (cost < best_cost) {
+			best_cost = cost;
+			best_c = c;
+		}
+	}
+	return best_c;
+}
+
+/* see curve9767.h */
+size_t
+curve9767_msm_scratch_size(unsigned c)
+{
+	return ((size_t)1 << (c - 1)) * sizeof(curve9767_jpoint);
+}
+
+/* see curve9767.h */
+int
+curve9767_msm_init(curve9767_msm_context *mc,
+	const curve9767_point *points, const uint8_t *scalars, size_t n,
+	unsigned c)
+{
+	if (c < 2 || c > CURVE9767_MSM_MAX_BITS) {
+		return 0;
+	}
+	mc->points = points;
+	mc->scalars = scalars;
+	mc->num = n;
+	mc->c = c;
+	mc->num_windows = (253 + c - 1) / c;
+	return 1;
+}
+
+/* see curve9767.h */
+void
+curve9767_msm_window(curve9767_msm_context *mc, unsigned w, void *scratch)
+{
+	curve9767_jpoint *B;
+	size_t num_buckets, u;
+	unsigned c;
+
+	c = mc->c;
+	num_buckets = (size_t)1 << (c - 1);
+	B = scratch;
+
+	/*
+	 * Bucket accumulation. Bucket B[j] corresponds to digit j+1.
+	 */
+	for (u = 0; u < num_buckets; u ++) {
+		B[u].neutral = 1;
+	}
+	for (u = 0; u < mc->num; u ++) {
+		if (mc->points[u].neutral) {
+			continue;
+		}
+		bucket_add(B, get_digit(mc->scalars + (u << 5), c, w),
+			&mc->points[u]);
+	}
+
+	bucket_sum(&mc->win[w], B, num_buckets);
+}
+
+/* see curve9767.h */
+void
+curve9767_msm_merge(curve9767_point *Q, const curve9767_msm_context *mc)
+{
+	curve9767_jpoint S;
+	unsigned w, i;
+
+	/*
+	 * Horner evaluation over the windows, in Jacobian coordinates;
+	 * the result is normalized with a single inversion.
+	 */
+	S = mc->win[mc->num_windows - 1];
+	for (w = mc->num_windows - 1; w -- > 0;) {
+		for (i = 0; i < mc->c && !S.neutral; i ++) {
+			curve9767_inner_jpoint_double(&S);
+		}
+		curve9767_inner_jpoint_add_vartime(&S, &mc->win[w]);
+	}
+	curve9767_jpoint_normalize_batch(Q, &S, 1);
+}
+
+/* see curve9767.h */
+int
+curve9767_msm(curve9767_point *Q,
+	const curve9767_point *points, const uint8_t *scalars, size_t n,
+	void *scratch, size_t scratch_len)
+{
+	curve9767_msm_context mc;
+	unsigned c, w;
+
+	c = curve9767_msm_window_bits(n);
+	while (c >= 2 && curve9767_msm_scratch_size(c) > scratch_len) {
+		c --;
+	}
+	if (!curve9767_msm_init(&mc, points, scalars, n, c)) {
+		return 0;
+	}
+	for (w = 0; w < mc.num_windows; w ++) {
+		curve9767_msm_window(&mc, w, scratch);
+	}
+	curve9767_msm_merge(Q, &mc);
+	return 1;
+}
+
+/*
+ * Get the buckets of window w in an accumulator.
+ */
+#define ACC_BUCKETS(acc, w) \
+	((curve9767_jpoint *)(acc)->mem + ((size_t)(w) << ((acc)->c - 1)))
+
+/* see curve9767.h */
+size_t
+curve9767_msm_accumulator_size(unsigned c)
+{
+	size_t num_buckets;
+
+	if (c < 2 || c > CURVE9767_MSM_MAX_BITS) {
+		return 0;
+	}
+	num_buckets = (size_t)1 << (c - 1);
+	return num_buckets * ((253 + c - 1) / c) * sizeof(curve9767_jpoint);
+}
+
+/* see curve9767.h */
+int
+curve9767_msm_accumulator_init(curve9767_msm_accumulator *acc,
+	unsigned c, void *mem, size_t mem_len)
+{
+	size_t len;
+
+	len = curve9767_msm_accumulator_size(c);
+	if (len == 0 || len > mem_len) {
+		return 0;
+	}
+	acc->mem = mem;
+	acc->c = c;
+	acc->num_windows = (253 + c - 1) / c;
+	curve9767_msm_accumulator_reset(acc);
+	return 1;
+}
+
+/* see curve9767.h */
+void
+curve9767_msm_accumulator_reset(curve9767_msm_accumulator *acc)
+{
+	curve9767_jpoint *B;
+	size_t u, n;
+
+	B = acc->mem;
+	n = (size_t)acc->num_windows << (acc->c - 1);
+	for (u = 0; u < n; u ++) {
+		B[u].neutral = 1;
+	}
+	acc->count = 0;
+}
+
+/* see curve9767.h */
+void
+curve9767_msm_accumulator_add(curve9767_msm_accumulator *acc,
+	const curve9767_point *P, const uint8_t *scalar)
+{
+	unsigned w;
+
+	acc->count ++;
+	if (P->neutral) {
+		return;
+	}
+	for (w = 0; w < acc->num_windows; w ++) {
+		bucket_add(ACC_BUCKETS(acc, w),
+			get_digit(scalar, acc->c, w), P);
+	}
+}
+
+/* see curve9767.h */
+void
+curve9767_msm_accumulator_finalize(curve9767_point *Q,
+	curve9767_msm_accumulator *acc)
+{
+	curve9767_jpoint S, T;
+	size_t num_buckets;
+	unsigned w, i;
+
+	/*
+	 * Horner evaluation over the windows, as in
+	 * curve9767_msm_merge(), with each window sum computed from its
+	 * buckets just before being added.
+	 */
+	num_buckets = (size_t)1 << (acc->c - 1);
+	S.neutral = 1;
+	for (w = acc->num_windows; w -- > 0;) {
+		for (i = 0; i < acc->c && !S.neutral; i ++) {
+			curve9767_inner_jpoint_double(&S);
+		}
+		bucket_sum(&T, ACC_BUCKETS(acc, w), num_buckets);
+		curve9767_inner_jpoint_add_vartime(&S, &T);
+	}
+	curve9767_jpoint_normalize_batch(Q, &S, 1);
+}
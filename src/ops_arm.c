@@ -492,6 +492,20 @@ curve9767_inner_gf_map_to_base(uint16_t *c, const void *src)
 	}
 }
 
+/* see inner.h */
+void
+curve9767_inner_gf_map_to_base_batch(field_element *c,
+	const void *src, size_t num)
+{
+	const uint8_t *buf;
+	size_t u;
+
+	buf = src;
+	for (u = 0; u < num; u ++) {
+		curve9767_inner_gf_map_to_base(c[u].v, buf + 48 * u);
+	}
+}
+
 /* ====================================================================== */
 /*
  * Curve9767 Functions
@@ -543,6 +557,9 @@ const curve9767_point curve9767_generator = {
 	0   /* dummy2 */
 };
 
+/* see inner.h */
+const uint32_t curve9767_inner_repr_id = 2;  /* interleaved window layout */
+
 /* see inner.h */
 uint32_t
 curve9767_inner_make_y(uint16_t *y, const uint16_t *x, uint32_t neg)
@@ -667,3 +684,114 @@ curve9767_inner_Icart_map(curve9767_point *Q, const uint16_t *u)
 	/* Set Q to the point-at-infinity if and only if u is zero. */
 	Q->neutral = gf_eq(u, curve9767_inner_gf_zero.v);
 }
+
+/* see inner.h */
+void
+curve9767_inner_Icart_map2(curve9767_point *Q,
+	const uint16_t *u1, const uint16_t *u2)
+{
+	/*
+	 * Both maps follow curve9767_inner_Icart_map(), with their
+	 * steps interleaved, so that the two (independent) dependency
+	 * chains overlap. The two inversions of 6*u are replaced with
+	 * a single one (Montgomery's trick):
+	 *   1/(6*u1) = (6*u2)/((6*u1)*(6*u2))
+	 *   1/(6*u2) = (6*u1)/((6*u1)*(6*u2))
+	 * If u1 or u2 is zero, then 6*u is replaced with 1, so that the
+	 * inversion of the other value is still correct; the resulting
+	 * point is then marked as neutral, and the addition ignores its
+	 * coordinates.
+	 *
+	 * The final addition keeps its own inversion: expressing both
+	 * points as fractions, so that it could share the inversion,
+	 * costs more multiplications than the inversion (Itoh-Tsujii)
+	 * that it would save.
+	 */
+	curve9767_point T[2];
+	field_element t1[2], t2[2], t3[2], t4[2], t5, t6;
+	const uint16_t *u[2];
+	uint32_t nz[2], m;
+	int i, j;
+
+	u[0] = u1;
+	u[1] = u2;
+
+	for (j = 0; j < 2; j ++) {
+		nz[j] = gf_eq(u[j], curve9767_inner_gf_zero.v);
+
+		/* u^2 -> t1 */
+		gf_sqr(t1[j].v, u[j]);
+
+		/* u^4 -> t2 */
+		gf_sqr(t2[j].v, t1[j].v);
+
+		/* u^6 -> t3 */
+		gf_mul(t3[j].v, t1[j].v, t2[j].v);
+
+		/* 3*a - u^4 -> t2, 6*u (or 1, if u == 0) -> t4 */
+		gf_neg(t2[j].v, t2[j].v);
+		t2[j].v[0] = (uint16_t)mp_add(t2[j].v[0], MNINEm);
+		m = -nz[j];
+		for (i = 0; i < 19; i ++) {
+			uint32_t w;
+
+			w = mp_montymul(u[j][i], SIXm);
+			w ^= m & (w ^ curve9767_inner_gf_one.v[i]);
+			t4[j].v[i] = (uint16_t)w;
+		}
+	}
+
+	/* 1/(6*u1) and 1/(6*u2) -> t4 */
+	gf_mul(t5.v, t4[0].v, t4[1].v);
+	gf_inv(t5.v, t5.v);
+	gf_mul(t6.v, t4[1].v, t5.v);
+	gf_mul(t4[1].v, t4[0].v, t5.v);
+	t4[0] = t6;
+
+	for (j = 0; j < 2; j ++) {
+		/* (3*a - u^4)/(6*u) -> t2   (value 'v' from the map) */
+		gf_mul(t2[j].v, t2[j].v, t4[j].v);
+
+		/* v^2 - b - (u^6)/27 -> t3 */
+		for (i = 0; i < 19; i ++) {
+			t3[j].v[i] = (uint16_t)mp_montymul(
+				t3[j].v[i], IMTWENTYSEVENm);
+		}
+		gf_sqr(t4[j].v, t2[j].v);
+		gf_add(t3[j].v, t3[j].v, t4[j].v);
+		t3[j].v[Bi] = (uint16_t)mp_sub(t3[j].v[Bi], Bm);
+	}
+
+	/* (v^2 - b - (u^6)/27)^(1/3) -> t3 */
+	gf_cubert(t3[0].v, t3[0].v);
+	gf_cubert(t3[1].v, t3[1].v);
+
+	for (j = 0; j < 2; j ++) {
+		/* (v^2 - b - (u^6)/27)^(1/3) + (u^2)/3 -> x */
+		for (i = 0; i < 19; i ++) {
+			t1[j].v[i] = (uint16_t)mp_montymul(
+				t1[j].v[i], ITHREEm);
+		}
+		gf_add(T[j].x, t3[j].v, t1[j].v);
+
+		/* u*x + v -> y */
+		gf_mul(t1[j].v, T[j].x, u[j]);
+		gf_add(T[j].y, t1[j].v, t2[j].v);
+
+		T[j].neutral = nz[j];
+	}
+
+	curve9767_point_add(Q, &T[0], &T[1]);
+}
+
+/* see inner.h */
+void
+curve9767_inner_point_add_distinct(curve9767_point *Q3,
+	const curve9767_point *Q1, const curve9767_point *Q2)
+{
+	/*
+	 * The complete addition is implemented in assembly (ops_cm0.s);
+	 * it is used as is.
+	 */
+	curve9767_point_add(Q3, Q1, Q2);
+}
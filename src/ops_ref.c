@@ -3,10 +3,78 @@
  *
  * All operations are implemented in plain C code. Multiplication operations
  * are over 32 bits (with only 32-bit results).
+ *
+ * If CURVE9767_SIMD is non-zero, the linear operations on field elements
+ * (addition, subtraction, negation, conditional moves, comparisons, and
+ * multiplications by small constants) use SIMD intrinsics instead. This
+ * is the default when the compiler targets AVX2, SSE2 or NEON.
+ *
+ * If CURVE9767_FMA is non-zero, multiplications and squarings in the
+ * field are computed with AVX2 FMA operations on floating-point values
+ * (experimental; this requires AVX2 and FMA support at compile time).
+ *
+ * If CURVE9767_GF_KERNEL is non-zero, multiplications and squarings in
+ * the field use the kernels gfk_mul() and gfk_sqr() from gf_kernel.h,
+ * which is generated by extra/mkgfkernels.py (with the --select option;
+ * bench-host/bench_gfk finds the fastest kernels for the current
+ * platform and compiler). This is ignored if CURVE9767_FMA is non-zero.
+ *
+ * If CURVE9767_GF32 is non-zero, the sequence of doublings in
+ * curve9767_point_mul2k() uses an unpacked internal representation
+ * (32-bit coefficients, lazily reduced, with 64-bit accumulators in
+ * multiplications); this is meant for 64-bit hosts.
  */
 
 #include "inner.h"
 
+#ifndef CURVE9767_SIMD
+#if defined __AVX2__ || defined __SSE2__ || defined __ARM_NEON
+#define CURVE9767_SIMD   1
+#else
+#define CURVE9767_SIMD   0
+#endif
+#endif
+
+#if CURVE9767_SIMD
+#if defined __ARM_NEON
+#include <arm_neon.h>
+#define CURVE9767_SIMD_NEON   1
+#define CURVE9767_SIMD_AVX2   0
+#define CURVE9767_SIMD_SSE2   0
+#elif defined __AVX2__
+#include <immintrin.h>
+#define CURVE9767_SIMD_NEON   0
+#define CURVE9767_SIMD_AVX2   1
+#define CURVE9767_SIMD_SSE2   0
+#elif defined __SSE2__
+#include <emmintrin.h>
+#define CURVE9767_SIMD_NEON   0
+#define CURVE9767_SIMD_AVX2   0
+#define CURVE9767_SIMD_SSE2   1
+#else
+#error CURVE9767_SIMD requires AVX2, SSE2 or NEON
+#endif
+#endif
+
+#ifndef CURVE9767_FMA
+#define CURVE9767_FMA   0
+#endif
+
+#ifndef CURVE9767_GF_KERNEL
+#define CURVE9767_GF_KERNEL   0
+#endif
+
+#ifndef CURVE9767_GF32
+#define CURVE9767_GF32   0
+#endif
+
+#if CURVE9767_FMA
+#if !defined __AVX2__ || !defined __FMA__
+#error CURVE9767_FMA requires AVX2 and FMA
+#endif
+#include <immintrin.h>
+#endif
+
 /* ====================================================================== */
 /*
  * Base Field Functions (GF(9767))
@@ -316,43 +384,494 @@ const field_element curve9767_inner_gf_one = {
 	{ R, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P }
 };
 
+#if CURVE9767_SIMD
+
+/*
+ * SIMD implementation of the linear operations (addition, subtraction,
+ * negation, conditional moves, comparison, and multiplication by a
+ * small constant). Values are processed as 20 lanes of 16 bits; the
+ * 20th lane is the padding slot (see inner.h), and its contents are
+ * ignored.
+ *
+ * Since coefficients are in the 1..p range and 2*p < 2^15, sums and
+ * differences fit in a signed 16-bit lane, and each reduction is a
+ * comparison and a masked correction. Multiplication of a coefficient
+ * a by a Montgomery constant k (lower than p) computes
+ * mp_frommonty(a*k) in 16-bit lanes: with kp = k*p1i mod 2^32 =
+ * kl + kh*2^16, the value y1 of mp_frommonty() (high half of
+ * a*k*p1i mod 2^32) is:
+ *
+ *   y1 = floor(a*kl / 2^16) + a*kh  mod 2^16
+ *
+ * and the result is 1 + floor(y1*p / 2^16). These are one mulhi, one
+ * mullo and another mulhi per lane.
+ *
+ * Three variants are provided: AVX2 (lanes 0..15 in one 256-bit
+ * register), SSE2 and NEON (lanes 0..15 in two 128-bit registers); the
+ * last four lanes use a 64-bit register (or the low half of a 128-bit
+ * register).
+ */
+
+#if CURVE9767_SIMD_NEON
+
+typedef struct {
+	uint16x8_t v0, v1;
+	uint16x4_t v2;
+} gfv;
+
+static inline gfv
+gfv_load(const uint16_t *a)
+{
+	gfv r;
+
+	r.v0 = vld1q_u16(a);
+	r.v1 = vld1q_u16(a + 8);
+	r.v2 = vld1_u16(a + 16);
+	return r;
+}
+
+static inline void
+gfv_store(uint16_t *c, gfv r)
+{
+	vst1q_u16(c, r.v0);
+	vst1q_u16(c + 8, r.v1);
+	vst1_u16(c + 16, r.v2);
+}
+
+static inline uint16x8_t
+vq_add_mod(uint16x8_t a, uint16x8_t b)
+{
+	uint16x8_t p, s;
+
+	p = vdupq_n_u16(P);
+	s = vaddq_u16(a, b);
+	return vsubq_u16(s, vandq_u16(vcgtq_u16(s, p), p));
+}
+
+static inline uint16x4_t
+vd_add_mod(uint16x4_t a, uint16x4_t b)
+{
+	uint16x4_t p, s;
+
+	p = vdup_n_u16(P);
+	s = vadd_u16(a, b);
+	return vsub_u16(s, vand_u16(vcgt_u16(s, p), p));
+}
+
+static inline uint16x8_t
+vq_sub_mod(uint16x8_t a, uint16x8_t b)
+{
+	/* a - b is negative or zero exactly when a <= b. */
+	return vaddq_u16(vsubq_u16(a, b),
+		vandq_u16(vcleq_u16(a, b), vdupq_n_u16(P)));
+}
+
+static inline uint16x4_t
+vd_sub_mod(uint16x4_t a, uint16x4_t b)
+{
+	return vadd_u16(vsub_u16(a, b),
+		vand_u16(vcle_u16(a, b), vdup_n_u16(P)));
+}
+
+static inline uint16x8_t
+vq_mulhi(uint16x8_t a, uint16x8_t b)
+{
+	uint32x4_t lo, hi;
+
+	lo = vmull_u16(vget_low_u16(a), vget_low_u16(b));
+	hi = vmull_u16(vget_high_u16(a), vget_high_u16(b));
+	return vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+}
+
+static inline uint16x4_t
+vd_mulhi(uint16x4_t a, uint16x4_t b)
+{
+	return vshrn_n_u32(vmull_u16(a, b), 16);
+}
+
+static inline uint16x8_t
+vq_mulc(uint16x8_t a, uint32_t kl, uint32_t kh)
+{
+	uint16x8_t y;
+
+	y = vaddq_u16(vq_mulhi(a, vdupq_n_u16((uint16_t)kl)),
+		vmulq_n_u16(a, (uint16_t)kh));
+	return vaddq_u16(vq_mulhi(y, vdupq_n_u16(P)), vdupq_n_u16(1));
+}
+
+static inline uint16x4_t
+vd_mulc(uint16x4_t a, uint32_t kl, uint32_t kh)
+{
+	uint16x4_t y;
+
+	y = vadd_u16(vd_mulhi(a, vdup_n_u16((uint16_t)kl)),
+		vmul_n_u16(a, (uint16_t)kh));
+	return vadd_u16(vd_mulhi(y, vdup_n_u16(P)), vdup_n_u16(1));
+}
+
+static inline gfv
+gfv_add(gfv a, gfv b)
+{
+	gfv r;
+
+	r.v0 = vq_add_mod(a.v0, b.v0);
+	r.v1 = vq_add_mod(a.v1, b.v1);
+	r.v2 = vd_add_mod(a.v2, b.v2);
+	return r;
+}
+
+static inline gfv
+gfv_sub(gfv a, gfv b)
+{
+	gfv r;
+
+	r.v0 = vq_sub_mod(a.v0, b.v0);
+	r.v1 = vq_sub_mod(a.v1, b.v1);
+	r.v2 = vd_sub_mod(a.v2, b.v2);
+	return r;
+}
+
+static inline gfv
+gfv_mulc(gfv a, uint32_t kl, uint32_t kh)
+{
+	gfv r;
+
+	r.v0 = vq_mulc(a.v0, kl, kh);
+	r.v1 = vq_mulc(a.v1, kl, kh);
+	r.v2 = vd_mulc(a.v2, kl, kh);
+	return r;
+}
+
+/*
+ * Return a if ctl == 1, b if ctl == 0.
+ */
+static inline gfv
+gfv_select(gfv a, gfv b, uint32_t ctl)
+{
+	uint16x8_t mq;
+	uint16x4_t md;
+	gfv r;
+
+	mq = vdupq_n_u16((uint16_t)-ctl);
+	md = vdup_n_u16((uint16_t)-ctl);
+	r.v0 = vbslq_u16(mq, a.v0, b.v0);
+	r.v1 = vbslq_u16(mq, a.v1, b.v1);
+	r.v2 = vbsl_u16(md, a.v2, b.v2);
+	return r;
+}
+
+/*
+ * Return 1 if lanes 0..18 of a and b are equal, 0 otherwise.
+ */
+static inline uint32_t
+gfv_eq(gfv a, gfv b)
+{
+	uint16x8_t x;
+	uint16x4_t y;
+	uint64_t w;
+
+	x = vorrq_u16(veorq_u16(a.v0, b.v0), veorq_u16(a.v1, b.v1));
+	y = vorr_u16(vorr_u16(vget_low_u16(x), vget_high_u16(x)),
+		vand_u16(veor_u16(a.v2, b.v2),
+		vcreate_u16((uint64_t)0x0000FFFFFFFFFFFF)));
+	w = vget_lane_u64(vreinterpret_u64_u16(y), 0);
+	w |= w >> 32;
+	w &= 0xFFFFFFFF;
+	return (uint32_t)((w - 1) >> 63);
+}
+
+#elif CURVE9767_SIMD_AVX2
+
+typedef struct {
+	__m256i h;
+	__m128i t;
+} gfv;
+
+static inline gfv
+gfv_load(const uint16_t *a)
+{
+	gfv r;
+
+	r.h = _mm256_loadu_si256((const __m256i *)(const void *)a);
+	r.t = _mm_loadl_epi64((const __m128i *)(const void *)(a + 16));
+	return r;
+}
+
+static inline void
+gfv_store(uint16_t *c, gfv r)
+{
+	_mm256_storeu_si256((__m256i *)(void *)c, r.h);
+	_mm_storel_epi64((__m128i *)(void *)(c + 16), r.t);
+}
+
+static inline gfv
+gfv_add(gfv a, gfv b)
+{
+	__m256i ph, sh;
+	__m128i pt, st;
+	gfv r;
+
+	ph = _mm256_set1_epi16(P);
+	pt = _mm_set1_epi16(P);
+	sh = _mm256_add_epi16(a.h, b.h);
+	st = _mm_add_epi16(a.t, b.t);
+	r.h = _mm256_sub_epi16(sh,
+		_mm256_and_si256(_mm256_cmpgt_epi16(sh, ph), ph));
+	r.t = _mm_sub_epi16(st, _mm_and_si128(_mm_cmpgt_epi16(st, pt), pt));
+	return r;
+}
+
+static inline gfv
+gfv_sub(gfv a, gfv b)
+{
+	__m256i dh;
+	__m128i dt;
+	gfv r;
+
+	dh = _mm256_sub_epi16(a.h, b.h);
+	dt = _mm_sub_epi16(a.t, b.t);
+	r.h = _mm256_add_epi16(dh, _mm256_andnot_si256(
+		_mm256_cmpgt_epi16(dh, _mm256_setzero_si256()),
+		_mm256_set1_epi16(P)));
+	r.t = _mm_add_epi16(dt, _mm_andnot_si128(
+		_mm_cmpgt_epi16(dt, _mm_setzero_si128()), _mm_set1_epi16(P)));
+	return r;
+}
+
+static inline gfv
+gfv_mulc(gfv a, uint32_t kl, uint32_t kh)
+{
+	__m256i yh;
+	__m128i yt;
+	gfv r;
+
+	yh = _mm256_add_epi16(
+		_mm256_mulhi_epu16(a.h, _mm256_set1_epi16((short)kl)),
+		_mm256_mullo_epi16(a.h, _mm256_set1_epi16((short)kh)));
+	yt = _mm_add_epi16(
+		_mm_mulhi_epu16(a.t, _mm_set1_epi16((short)kl)),
+		_mm_mullo_epi16(a.t, _mm_set1_epi16((short)kh)));
+	r.h = _mm256_add_epi16(
+		_mm256_mulhi_epu16(yh, _mm256_set1_epi16(P)),
+		_mm256_set1_epi16(1));
+	r.t = _mm_add_epi16(
+		_mm_mulhi_epu16(yt, _mm_set1_epi16(P)), _mm_set1_epi16(1));
+	return r;
+}
+
+/*
+ * Return a if ctl == 1, b if ctl == 0.
+ */
+static inline gfv
+gfv_select(gfv a, gfv b, uint32_t ctl)
+{
+	__m256i mh;
+	__m128i mt;
+	gfv r;
+
+	mh = _mm256_set1_epi16((short)-ctl);
+	mt = _mm_set1_epi16((short)-ctl);
+	r.h = _mm256_blendv_epi8(b.h, a.h, mh);
+	r.t = _mm_blendv_epi8(b.t, a.t, mt);
+	return r;
+}
+
+/*
+ * Return 1 if lanes 0..18 of a and b are equal, 0 otherwise.
+ */
+static inline uint32_t
+gfv_eq(gfv a, gfv b)
+{
+	uint32_t mh, mt, d;
+
+	mh = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(a.h, b.h));
+	mt = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(a.t, b.t));
+	d = (mh ^ 0xFFFFFFFF) | ((mt & 0x3F) ^ 0x3F);
+	return 1 - ((d | -d) >> 31);
+}
+
+#elif CURVE9767_SIMD_SSE2
+
+typedef struct {
+	__m128i v0, v1, v2;
+} gfv;
+
+static inline gfv
+gfv_load(const uint16_t *a)
+{
+	gfv r;
+
+	r.v0 = _mm_loadu_si128((const __m128i *)(const void *)a);
+	r.v1 = _mm_loadu_si128((const __m128i *)(const void *)(a + 8));
+	r.v2 = _mm_loadl_epi64((const __m128i *)(const void *)(a + 16));
+	return r;
+}
+
+static inline void
+gfv_store(uint16_t *c, gfv r)
+{
+	_mm_storeu_si128((__m128i *)(void *)c, r.v0);
+	_mm_storeu_si128((__m128i *)(void *)(c + 8), r.v1);
+	_mm_storel_epi64((__m128i *)(void *)(c + 16), r.v2);
+}
+
+static inline __m128i
+vx_add_mod(__m128i a, __m128i b)
+{
+	__m128i p, s;
+
+	p = _mm_set1_epi16(P);
+	s = _mm_add_epi16(a, b);
+	return _mm_sub_epi16(s, _mm_and_si128(_mm_cmpgt_epi16(s, p), p));
+}
+
+static inline __m128i
+vx_sub_mod(__m128i a, __m128i b)
+{
+	__m128i d;
+
+	d = _mm_sub_epi16(a, b);
+	return _mm_add_epi16(d, _mm_andnot_si128(
+		_mm_cmpgt_epi16(d, _mm_setzero_si128()), _mm_set1_epi16(P)));
+}
+
+static inline __m128i
+vx_mulc(__m128i a, uint32_t kl, uint32_t kh)
+{
+	__m128i y;
+
+	y = _mm_add_epi16(
+		_mm_mulhi_epu16(a, _mm_set1_epi16((short)kl)),
+		_mm_mullo_epi16(a, _mm_set1_epi16((short)kh)));
+	return _mm_add_epi16(
+		_mm_mulhi_epu16(y, _mm_set1_epi16(P)), _mm_set1_epi16(1));
+}
+
+static inline gfv
+gfv_add(gfv a, gfv b)
+{
+	gfv r;
+
+	r.v0 = vx_add_mod(a.v0, b.v0);
+	r.v1 = vx_add_mod(a.v1, b.v1);
+	r.v2 = vx_add_mod(a.v2, b.v2);
+	return r;
+}
+
+static inline gfv
+gfv_sub(gfv a, gfv b)
+{
+	gfv r;
+
+	r.v0 = vx_sub_mod(a.v0, b.v0);
+	r.v1 = vx_sub_mod(a.v1, b.v1);
+	r.v2 = vx_sub_mod(a.v2, b.v2);
+	return r;
+}
+
+static inline gfv
+gfv_mulc(gfv a, uint32_t kl, uint32_t kh)
+{
+	gfv r;
+
+	r.v0 = vx_mulc(a.v0, kl, kh);
+	r.v1 = vx_mulc(a.v1, kl, kh);
+	r.v2 = vx_mulc(a.v2, kl, kh);
+	return r;
+}
+
+/*
+ * Return a if ctl == 1, b if ctl == 0.
+ */
+static inline gfv
+gfv_select(gfv a, gfv b, uint32_t ctl)
+{
+	__m128i m;
+	gfv r;
+
+	m = _mm_set1_epi16((short)-ctl);
+	r.v0 = _mm_xor_si128(b.v0, _mm_and_si128(m, _mm_xor_si128(a.v0, b.v0)));
+	r.v1 = _mm_xor_si128(b.v1, _mm_and_si128(m, _mm_xor_si128(a.v1, b.v1)));
+	r.v2 = _mm_xor_si128(b.v2, _mm_and_si128(m, _mm_xor_si128(a.v2, b.v2)));
+	return r;
+}
+
+/*
+ * Return 1 if lanes 0..18 of a and b are equal, 0 otherwise.
+ */
+static inline uint32_t
+gfv_eq(gfv a, gfv b)
+{
+	uint32_t m, d;
+
+	m = (uint32_t)_mm_movemask_epi8(_mm_and_si128(
+		_mm_cmpeq_epi16(a.v0, b.v0), _mm_cmpeq_epi16(a.v1, b.v1)));
+	d = m ^ 0xFFFF;
+	m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(a.v2, b.v2));
+	d |= (m & 0x3F) ^ 0x3F;
+	return 1 - ((d | -d) >> 31);
+}
+
+#endif
+
+#endif
+
 /* see inner.h */
 void
 curve9767_inner_gf_add(uint16_t *c, const uint16_t *a, const uint16_t *b)
 {
+#if CURVE9767_SIMD
+	gfv_store(c, gfv_add(gfv_load(a), gfv_load(b)));
+#else
 	int i;
 
 	for (i = 0; i < 19; i ++) {
 		c[i] = (uint16_t)mp_add(a[i], b[i]);
 	}
+#endif
 }
 
 /* see inner.h */
 void
 curve9767_inner_gf_sub(uint16_t *c, const uint16_t *a, const uint16_t *b)
 {
+#if CURVE9767_SIMD
+	gfv_store(c, gfv_sub(gfv_load(a), gfv_load(b)));
+#else
 	int i;
 
 	for (i = 0; i < 19; i ++) {
 		c[i] = (uint16_t)mp_sub(a[i], b[i]);
 	}
+#endif
 }
 
 /* see inner.h */
 void
 curve9767_inner_gf_neg(uint16_t *c, const uint16_t *a)
 {
+#if CURVE9767_SIMD
+	gfv_store(c, gfv_sub(gfv_load(curve9767_inner_gf_zero.v), gfv_load(a)));
+#else
 	int i;
 
 	for (i = 0; i < 19; i ++) {
 		c[i] = (uint16_t)mp_sub(P, a[i]);
 	}
+#endif
 }
 
 /* see inner.h */
 void
 curve9767_inner_gf_condneg(uint16_t *c, uint32_t ctl)
 {
+#if CURVE9767_SIMD
+	gfv x;
+
+	x = gfv_load(c);
+	gfv_store(c, gfv_select(
+		gfv_sub(gfv_load(curve9767_inner_gf_zero.v), x), x, ctl));
+#else
 	int i;
 	uint32_t m;
 
@@ -364,6 +883,28 @@ curve9767_inner_gf_condneg(uint16_t *c, uint32_t ctl)
 		wc ^= m & (wc ^ mp_sub(P, wc));
 		c[i] = (uint16_t)wc;
 	}
+#endif
+}
+
+/*
+ * Compute c = k*a, for a constant k in the base field (in Montgomery
+ * representation).
+ */
+static void
+gf_mulconst(uint16_t *c, const uint16_t *a, uint32_t k)
+{
+#if CURVE9767_SIMD
+	uint32_t kp;
+
+	kp = k * (uint32_t)P1I;
+	gfv_store(c, gfv_mulc(gfv_load(a), kp & 0xFFFF, kp >> 16));
+#else
+	int i;
+
+	for (i = 0; i < 19; i ++) {
+		c[i] = (uint16_t)mp_montymul(a[i], k);
+	}
+#endif
 }
 
 /*
@@ -492,10 +1033,95 @@ curve9767_inner_gf_condneg(uint16_t *c, uint32_t ctl)
 		(void)r3; \
 	} while (0)
 
+#if CURVE9767_FMA
+
+/*
+ * Field multiplication with floating-point FMA operations.
+ *
+ * All coefficients are at most p, and each coefficient of the product
+ * (before reduction) is at most 37*p^2 < 2^32; all partial sums are
+ * thus integers that are exactly representable in a double (53-bit
+ * mantissa), and FMA operations compute them without any rounding.
+ *
+ * The product is computed as a convolution: c[k] is the sum of a[i]
+ * times bb(k-i), where bb(j) = b[j] for 0 <= j <= 18, and
+ * bb(j) = 2*b[j+19] for j < 0 (since z^19 = 2). The bb() values are
+ * stored in ext[], so that four consecutive outputs c[k..k+3] are one
+ * 4-lane FMA for each a[i] (95 FMA in total, for 20 output lanes; the
+ * 20th lane is the padding slot).
+ *
+ * The Montgomery reduction of each coefficient is then performed with
+ * 32-bit integer lanes. Since AVX2 converts doubles to signed 32-bit
+ * integers only, 2^31 is subtracted before conversion and added back
+ * afterwards (with a XOR).
+ */
+static void
+gf_mul_fma(uint16_t *c, const uint16_t *a, const uint16_t *b)
+{
+	double ext[38];
+	__m256d acc[5], off;
+	__m128i x[5], p, p1i, one, sgn;
+	int i, g;
+
+	for (i = 0; i < 18; i ++) {
+		ext[i] = 2.0 * (double)b[i + 1];
+	}
+	for (i = 0; i < 19; i ++) {
+		ext[i + 18] = (double)b[i];
+	}
+	ext[37] = 0.0;
+
+	for (g = 0; g < 5; g ++) {
+		acc[g] = _mm256_setzero_pd();
+	}
+	for (i = 0; i < 19; i ++) {
+		__m256d ai;
+
+		ai = _mm256_set1_pd((double)a[i]);
+		for (g = 0; g < 5; g ++) {
+			acc[g] = _mm256_fmadd_pd(ai,
+				_mm256_loadu_pd(ext + (g << 2) - i + 18), acc[g]);
+		}
+	}
+
+	off = _mm256_set1_pd(2147483648.0);
+	sgn = _mm_set1_epi32((int)0x80000000);
+	p = _mm_set1_epi32(P);
+	p1i = _mm_set1_epi32((int)P1I);
+	one = _mm_set1_epi32(1);
+	for (g = 0; g < 5; g ++) {
+		__m128i y;
+
+		y = _mm_xor_si128(_mm256_cvtpd_epi32(
+			_mm256_sub_pd(acc[g], off)), sgn);
+
+		/* See mp_frommonty(). */
+		y = _mm_srli_epi32(_mm_mullo_epi32(y, p1i), 16);
+		y = _mm_srli_epi32(_mm_mullo_epi32(y, p), 16);
+		x[g] = _mm_add_epi32(y, one);
+	}
+	_mm_storeu_si128((__m128i *)(void *)c, _mm_packus_epi32(x[0], x[1]));
+	_mm_storeu_si128((__m128i *)(void *)(c + 8),
+		_mm_packus_epi32(x[2], x[3]));
+	_mm_storel_epi64((__m128i *)(void *)(c + 16),
+		_mm_packus_epi32(x[4], x[4]));
+}
+
+#elif CURVE9767_GF_KERNEL
+
+#include "gf_kernel.h"
+
+#endif
+
 /* see inner.h */
 void
 curve9767_inner_gf_mul(uint16_t *c, const uint16_t *a, const uint16_t *b)
 {
+#if CURVE9767_FMA
+	gf_mul_fma(c, a, b);
+#elif CURVE9767_GF_KERNEL
+	gfk_mul(c, a, b);
+#else
 	/*
 	 * We use one step of Karatsuba multiplication. Depending
 	 * on the architecture and compiler, nested Karatsuba steps
@@ -644,12 +1270,18 @@ curve9767_inner_gf_mul(uint16_t *c, const uint16_t *a, const uint16_t *b)
 	 * Karatsuba fix-up and Montgomery reductions.
 	 */
 	KFIX;
+#endif
 }
 
 /* see inner.h */
 void
 curve9767_inner_gf_sqr(uint16_t *c, const uint16_t *a)
 {
+#if CURVE9767_FMA
+	gf_mul_fma(c, a, a);
+#elif CURVE9767_GF_KERNEL
+	gfk_sqr(c, a);
+#else
 	/*
 	 * If we split a into low part and high part, we have:
 	 *
@@ -766,6 +1398,7 @@ curve9767_inner_gf_sqr(uint16_t *c, const uint16_t *a)
 	 * Karatsuba fix-up and Montgomery reductions.
 	 */
 	KFIX;
+#endif
 }
 
 /*
@@ -1179,6 +1812,9 @@ curve9767_inner_gf_is_neg(const uint16_t *a)
 uint32_t
 curve9767_inner_gf_eq(const uint16_t *a, const uint16_t *b)
 {
+#if CURVE9767_SIMD
+	return gfv_eq(gfv_load(a), gfv_load(b));
+#else
 	int i;
 	uint32_t r;
 
@@ -1187,6 +1823,7 @@ curve9767_inner_gf_eq(const uint16_t *a, const uint16_t *b)
 		r |= -(a[i] ^ b[i]);
 	}
 	return 1 - (r >> 31);
+#endif
 }
 
 /* see inner.h */
@@ -1328,6 +1965,9 @@ curve9767_inner_gf_decode(uint16_t *c, const void *src)
 static void
 gf_condcopy(uint16_t *c, const uint16_t *a, uint32_t ctl)
 {
+#if CURVE9767_SIMD
+	gfv_store(c, gfv_select(gfv_load(a), gfv_load(c), ctl));
+#else
 	int i;
 	uint32_t m;
 
@@ -1339,15 +1979,105 @@ gf_condcopy(uint16_t *c, const uint16_t *a, uint32_t ctl)
 		wc = c[i];
 		c[i] = (uint16_t)(wc ^ (m & (wa ^ wc)));
 	}
+#endif
 }
 
+/*
+ * Divide x[j] by p, with an incoming remainder r (0 <= r < p); x[j] is
+ * replaced with the quotient, and the new remainder is returned. This
+ * is one step of a word-by-word division of a big integer (16-bit
+ * limbs, most significant first) by p.
+ */
+static inline uint32_t
+mp_divstep(uint32_t *xj, uint32_t r)
+{
+	uint32_t d;
+
+	/*
+	 * Each limb is up to 65535, to which is added the current
+	 * remainder, scaled up, for a maximum dividend:
+	 *   65535 + (9766 << 16) = 640090111
+	 *
+	 * We obtain a constant-time division of the dividend d
+	 * with these two facts:
+	 *
+	 *   - Montgomery reduction of d yields (d/(2^32)) mod p;
+	 *     with an extra Montgomery multiplication by 2^64 mod p,
+	 *     we get d mod p.
+	 *
+	 *   - Let e = d - (d mod p). This is a multiple of p;
+	 *     then: e * (1/p mod 2^32) = e/p mod 2^32
+	 */
+	d = (r << 16) + *xj;
+
+	/*
+	 * We must add P to d, because mp_frommonty() cannot tolerate an
+	 * input of value 0.
+	 */
+	r = mp_frommonty(d + P);
+
+	/*
+	 * Now r = (d/(2^32)) mod p, in the 1..p range. We need d mod p,
+	 * in the 0..p-1 range. We first add R1I = (1/(2^32)) mod p, which
+	 * yields (d+1)/(2^32) mod p. Then, we do a Montgomery
+	 * multiplication with R2 = 2^64 mod p, yielding (d+1) mod p in
+	 * the 1..p range. Finally, we subtract 1, and get d mod p in the
+	 * 0..p-1 range.
+	 */
+	r = mp_montymul(r + R1I, R2) - 1;
+
+	/*
+	 * Divide e = (d-r) by p. This is an exact division, which can be
+	 * done by mutiplying (modulo 2^32) with 1/p mod 2^32 (see section
+	 * 9 of: T. Grandlund and P. Montgomery, "Division by Invariant
+	 * Integers using Multiplication", SIGPLAN'94; section 9).
+	 */
+	*xj = (d - r) * P0I;
+	return r;
+}
+
+/*
+ * map_max_xw[i] = min { j | floor(2^384 / (p^i)) < 2^(16*j) }
+ * This is the maximum size, in 16-bit words, of floor(x / p^i) for a
+ * 384-bit integer x.
+ */
+static const uint8_t map_max_xw[] = {
+	24, 24, 23, 22, 21, 20, 20, 19, 18, 17,
+	16, 15, 15, 14, 13, 12, 11, 10, 10
+};
+
+/*
+ * p^10, in 16-bit limbs (little-endian order).
+ */
+static const uint16_t map_P10[] = {
+	60337, 16725, 58062, 7423, 55827, 1592, 23377, 14103, 23
+};
+
+/*
+ * floor(2^384 / p^10), in 16-bit limbs (little-endian order).
+ */
+static const uint16_t map_MU[] = {
+	52644, 41870, 50859, 43888, 44867, 58696, 18356, 21311,
+	 2978, 59659,  3728, 62301,  8068, 16683, 64096,  2822
+};
+
+/*
+ * map_low_xw[i] = min { j | p^(10-i) <= 2^(16*j) }
+ * This is the maximum size, in 16-bit words, of floor(y / p^i) for an
+ * integer y < p^10.
+ */
+static const uint8_t map_low_xw[] = {
+	9, 8, 7, 6, 5, 5, 4, 3, 2, 1
+};
+
 /* see inner.h */
 void
 curve9767_inner_gf_map_to_base(uint16_t *c, const void *src)
 {
 	const uint8_t *buf;
-	uint32_t x[24];
-	int i;
+	uint32_t x[24], q[16], xl[10];
+	uint64_t w;
+	int i, j;
 
 	/*
 	 * Decode the 48 bytes into a big integer x[] (16-bit limbs).
@@ -1359,77 +2089,174 @@ curve9767_inner_gf_map_to_base(uint16_t *c, const void *src)
 	}
 
 	/*
-	 * Get coefficients one by one. As the loop advances, the value
-	 * x[] shrinks, allowing us to skip the last words.
+	 * Coefficients 0 to 9 depend only on xl = x mod p^10, and
+	 * coefficients 10 to 18 only on q = floor(x / p^10). We first
+	 * split x into q and xl, then the two conversions are performed
+	 * together (each division step on q is followed by an
+	 * independent step on xl, which gives the CPU two dependency
+	 * chains to interleave); this saves about half of the division
+	 * steps of a direct conversion, which must divide the whole x
+	 * for each of the first ten coefficients.
+	 *
+	 * The split uses Barrett reduction: with q1 = floor(x / 2^128)
+	 * and mu = floor(2^384 / p^10), the estimate
+	 * q3 = floor(q1*mu / 2^256) is such that q3 <= q <= q3 + 2
+	 * (since 2^128 <= p^10 and q1 < 2^256). Two conditional
+	 * corrections then yield the exact q and xl.
 	 */
-	for (i = 0; i < 19; i ++) {
-		uint32_t r;
-		int j;
+	w = 0;
+	for (i = 0; i < 32; i ++) {
+		int k;
 
-		/*
-		 * max_xw[i] = min { j | floor(x / (p^i)) < 2^(16*j) }
-		 * This is the maximum size, in 16-bit words, of the value
-		 * x[] when starting iteration number i.
-		 */
-		static const uint8_t max_xw[] = {
-			24, 24, 23, 22, 21, 20, 20, 19, 18, 17,
-			16, 15, 15, 14, 13, 12, 11, 10, 10
-		};
+		for (k = (i < 16) ? 0 : i - 15; k <= i && k < 16; k ++) {
+			w += x[8 + k] * (uint32_t)map_MU[i - k];
+		}
+		if (i >= 16) {
+			q[i - 16] = (uint32_t)w & 0xFFFF;
+		}
+		w >>= 16;
+	}
 
-		/*
-		 * Divide x by p, word by word.
-		 * Each limb is up to 65535, to which is added the current
-		 * remainder, scaled up, for a maximum dividend:
-		 *   65535 + (9766 << 16) = 640090111
-		 *
-		 * We obtain a constant-time division of the dividend d
-		 * with these two facts:
-		 *
-		 *   - Montgomery reduction of d yields (d/(2^32)) mod p;
-		 *     with an extra Montgomery multiplication by 2^64 mod p,
-		 *     we get d mod p.
-		 *
-		 *   - Let e = d - (d mod p). This is a multiple of p;
-		 *     then: e * (1/p mod 2^32) = e/p mod 2^32
-		 */
-		r = 0;
-		for (j = max_xw[i] - 1; j >= 0; j --) {
-			uint32_t d;
-
-			d = (r << 16) + x[j];
-
-			/*
-			 * We must add P to d, because mp_frommonty()
-			 * cannot tolerate an input of value 0.
-			 */
-			r = mp_frommonty(d + P);
-
-			/*
-			 * Now r = (d/(2^32)) mod p, in the 1..p range.
-			 * We need d mod p, in the 0..p-1 range. We first
-			 * add R1I = (1/(2^32)) mod p, which yields
-			 * (d+1)/(2^32) mod p. Then, we do a Montgomery
-			 * multiplication with R2 = 2^64 mod p, yielding
-			 * (d+1) mod p in the 1..p range. Finally, we
-			 * subtract 1, and get d mod p in the 0..p-1 range.
-			 */
-			r = mp_montymul(r + R1I, R2) - 1;
-
-			/*
-			 * Divide e = (d-r) by p. This is an exact division,
-			 * which can be done by mutiplying (modulo 2^32)
-			 * with 1/p mod 2^32 (see section 9 of: T. Grandlund
-			 * and P. Montgomery, "Division by Invariant Integers
-			 * using Multiplication", SIGPLAN'94; section 9).
-			 */
-			x[j] = (d - r) * P0I;
+	/*
+	 * xl = x - q3*p^10; the result is lower than 3*p^10 < 2^160,
+	 * hence it can be computed modulo 2^160 (ten limbs).
+	 */
+	w = 0;
+	for (i = 0; i < 10; i ++) {
+		int k;
+
+		for (k = (i < 9) ? 0 : i - 8; k <= i; k ++) {
+			w += q[k] * (uint32_t)map_P10[i - k];
+		}
+		xl[i] = (uint32_t)w & 0xFFFF;
+		w >>= 16;
+	}
+	w = 0;
+	for (i = 0; i < 10; i ++) {
+		uint32_t v;
+
+		v = x[i] - xl[i] - (uint32_t)w;
+		xl[i] = v & 0xFFFF;
+		w = v >> 31;
+	}
+
+	/*
+	 * Corrections: if xl >= p^10, subtract p^10 and increment q.
+	 */
+	for (j = 0; j < 2; j ++) {
+		uint32_t t[10], b, m, cc;
+
+		b = 0;
+		for (i = 0; i < 10; i ++) {
+			uint32_t v;
+
+			v = xl[i] - (i < 9 ? (uint32_t)map_P10[i] : 0) - b;
+			t[i] = v & 0xFFFF;
+			b = v >> 31;
+		}
+		m = b - 1;
+		for (i = 0; i < 10; i ++) {
+			xl[i] ^= m & (xl[i] ^ t[i]);
+		}
+		cc = m & 1;
+		for (i = 0; i < 16; i ++) {
+			uint32_t v;
+
+			v = q[i] + cc;
+			q[i] = v & 0xFFFF;
+			cc = v >> 16;
+		}
+	}
+
+	/*
+	 * Get coefficients by pairs (i and i+10). As the loop advances,
+	 * the values q[] and xl[] shrink, allowing us to skip the last
+	 * words.
+	 */
+	for (i = 0; i < 10; i ++) {
+		uint32_t rl, rh;
+		int len;
+
+		len = (i < 9) ? map_max_xw[i + 10] : map_low_xw[i];
+		rl = 0;
+		rh = 0;
+		for (j = len - 1; j >= 0; j --) {
+			if (i < 9) {
+				rh = mp_divstep(&q[j], rh);
+			}
+			if (j < map_low_xw[i]) {
+				rl = mp_divstep(&xl[j], rl);
+			}
 		}
 
 		/*
-		 * Last remainder is x mod p; this is our next coefficients.
-		 * We want it in Montgomery representation.
+		 * Last remainders are our next coefficients. We want them
+		 * in Montgomery representation.
 		 */
-		c[i] = (uint16_t)mp_tomonty(r);
+		c[i] = (uint16_t)mp_tomonty(rl);
+		if (i < 9) {
+			c[i + 10] = (uint16_t)mp_tomonty(rh);
+		}
+	}
+}
+
+/*
+ * Number of inputs processed in parallel by
+ * curve9767_inner_gf_map_to_base_batch().
+ */
+#define MAP_LANES   8
+
+/* see inner.h */
+void
+curve9767_inner_gf_map_to_base_batch(field_element *c,
+	const void *src, size_t num)
+{
+	const uint8_t *buf;
+
+	/*
+	 * Inputs are processed by groups of MAP_LANES, with a direct
+	 * conversion (one word-by-word division of the whole value for
+	 * each coefficient). All lanes perform the same sequence of
+	 * operations, with the lane index in the innermost loops, so
+	 * that the compiler may map lanes to SIMD registers. The last
+	 * group is padded with zeros.
+	 */
+	buf = src;
+	while (num > 0) {
+		uint32_t x[24][MAP_LANES], r[MAP_LANES];
+		size_t n, l;
+		int i, j;
+
+		n = num < MAP_LANES ? num : MAP_LANES;
+		for (l = 0; l < MAP_LANES; l ++) {
+			for (i = 0; i < 24; i ++) {
+				if (l < n) {
+					const uint8_t *b;
+
+					b = buf + 48 * l + (i << 1);
+					x[i][l] = (uint32_t)b[0]
+						| ((uint32_t)b[1] << 8);
+				} else {
+					x[i][l] = 0;
+				}
+			}
+		}
+		for (i = 0; i < 19; i ++) {
+			for (l = 0; l < MAP_LANES; l ++) {
+				r[l] = 0;
+			}
+			for (j = map_max_xw[i] - 1; j >= 0; j --) {
+				for (l = 0; l < MAP_LANES; l ++) {
+					r[l] = mp_divstep(&x[j][l], r[l]);
+				}
+			}
+			for (l = 0; l < n; l ++) {
+				c[l].v[i] = (uint16_t)mp_tomonty(r[l]);
+			}
+		}
+		c += n;
+		buf += 48 * n;
+		num -= n;
 	}
 }
 
@@ -1484,6 +2311,9 @@ const curve9767_point curve9767_generator = {
 	0   /* dummy2 */
 };
 
+/* see inner.h */
+const uint32_t curve9767_inner_repr_id = 1;  /* plain window layout */
+
 /* see inner.h */
 uint32_t
 curve9767_inner_make_y(uint16_t *y, const uint16_t *x, uint32_t neg)
@@ -1555,9 +2385,7 @@ curve9767_point_add(curve9767_point *Q3,
 	gf_condcopy(t1.v, t3.v, ex);
 	gf_sub(t2.v, Q2->y, Q1->y);
 	gf_sqr(t3.v, Q1->x);
-	for (i = 0; i < 19; i ++) {
-		t3.v[i] = (uint16_t)mp_montymul(t3.v[i], THREEm);
-	}
+	gf_mulconst(t3.v, t3.v, THREEm);
 	t3.v[0] = (uint16_t)mp_add(t3.v[0], Am);
 	gf_condcopy(t2.v, t3.v, ex);
 	gf_inv(t1.v, t1.v);
@@ -1616,12 +2444,212 @@ curve9767_point_add(curve9767_point *Q3,
 		| ((1 - Q1->neutral) & (1 - Q2->neutral) & ex & (1 - ey));
 }
 
+/* see inner.h */
+void
+curve9767_inner_point_add_distinct(curve9767_point *Q3,
+	const curve9767_point *Q1, const curve9767_point *Q2)
+{
+	uint32_t n0, n1, n2;
+	field_element t1, t2, t3;
+	int i;
+
+	/*
+	 * Same as curve9767_point_add(), without the doubling case:
+	 *   lambda = (y2-y1)/(x2-x1)
+	 * (if either point is the neutral, then x2-x1 may be zero, but
+	 * the computed values are then discarded).
+	 */
+	gf_sub(t1.v, Q2->x, Q1->x);
+	gf_sub(t2.v, Q2->y, Q1->y);
+	gf_inv(t1.v, t1.v);
+	gf_mul(t1.v, t1.v, t2.v);
+
+	/*
+	 * x3 = lambda^2 - x1 - x2  (in t2)
+	 * y3 = lambda*(x1 - x3) - y1  (in t3)
+	 */
+	gf_sqr(t2.v, t1.v);
+	gf_sub(t2.v, t2.v, Q1->x);
+	gf_sub(t2.v, t2.v, Q2->x);
+	gf_sub(t3.v, Q1->x, t2.v);
+	gf_mul(t3.v, t3.v, t1.v);
+	gf_sub(t3.v, t3.v, Q1->y);
+
+	/*
+	 * If either Q1 or Q2 is zero, then we use the coordinates from
+	 * the other one. The result can be zero only if both are zero.
+	 */
+	n1 = -(Q1->neutral);
+	n2 = -(Q2->neutral);
+	n0 = ~(n1 | n2);
+	for (i = 0; i < 19; i ++) {
+		uint32_t w;
+
+		w = (uint32_t)t2.v[i] & n0;
+		w |= n2 & (uint32_t)Q1->x[i];
+		w |= n1 & (uint32_t)Q2->x[i];
+		Q3->x[i] = (uint16_t)w;
+
+		w = (uint32_t)t3.v[i] & n0;
+		w |= n2 & (uint32_t)Q1->y[i];
+		w |= n1 & (uint32_t)Q2->y[i];
+		Q3->y[i] = (uint16_t)w;
+	}
+	Q3->neutral = Q1->neutral & Q2->neutral;
+}
+
+#if CURVE9767_GF32
+
+/*
+ * Unpacked field elements: 19 coefficients (and a padding slot) of 32
+ * bits each. Each coefficient is a non-negative integer congruent
+ * (modulo p) to the Montgomery representation of the corresponding
+ * coefficient, but not necessarily reduced: additions and
+ * subtractions are performed without any normalization, and the caller
+ * is responsible for keeping track of bounds. Multiplications accept
+ * coefficients up to 2^19 (i.e. more than 53*p), and return
+ * coefficients lower than p (zero included).
+ *
+ * Since the representation of a value is in Montgomery form, it can
+ * be multiplied by a small integer constant directly (the result
+ * represents the product of the value by that integer).
+ */
+typedef struct {
+	uint32_t v[20];
+} gf32;
+
+static inline void
+gf32_load(gf32 *d, const uint16_t *a)
+{
+	int i;
+
+	for (i = 0; i < 19; i ++) {
+		d->v[i] = a[i];
+	}
+}
+
+/*
+ * Normalize and store a value; coefficients must be at most 2^18.
+ */
+static inline void
+gf32_store(uint16_t *c, const gf32 *a)
+{
+	int i;
+
+	for (i = 0; i < 19; i ++) {
+		/*
+		 * p is added so that the mp_montymul() input is not zero;
+		 * (2^18+p)*R < 3654952486.
+		 */
+		c[i] = (uint16_t)mp_montymul(a->v[i] + P, R);
+	}
+}
+
+/*
+ * d <- a + b
+ */
+static inline void
+gf32_add(gf32 *d, const gf32 *a, const gf32 *b)
+{
+	int i;
+
+	for (i = 0; i < 19; i ++) {
+		d->v[i] = a->v[i] + b->v[i];
+	}
+}
+
+/*
+ * d <- a + k*p - b (coefficients of b must be at most k*p)
+ */
+static inline void
+gf32_sub(gf32 *d, const gf32 *a, const gf32 *b, uint32_t k)
+{
+	int i;
+
+	for (i = 0; i < 19; i ++) {
+		d->v[i] = a->v[i] + k * P - b->v[i];
+	}
+}
+
+/*
+ * d <- k*a (k is a small integer, not in Montgomery representation)
+ */
+static inline void
+gf32_muli(gf32 *d, const gf32 *a, uint32_t k)
+{
+	int i;
+
+	for (i = 0; i < 19; i ++) {
+		d->v[i] = k * a->v[i];
+	}
+}
+
+/*
+ * Montgomery reduction of 19 coefficients of less than 2^44: each
+ * (x + m*p)/2^32 is lower than 2^12 + p, and a single conditional
+ * subtraction makes it lower than p.
+ */
+static inline void
+gf32_reduce(gf32 *d, const uint64_t *t)
+{
+	int k;
+
+	for (k = 0; k < 19; k ++) {
+		uint32_t m, r;
+
+		m = (uint32_t)t[k] * (uint32_t)P1I;
+		r = (uint32_t)((t[k] + (uint64_t)m * P) >> 32);
+		r -= P & -((uint32_t)(P - 1 - r) >> 31);
+		d->v[k] = r;
+	}
+}
+
+/*
+ * d <- a*b (Montgomery multiplication)
+ *
+ * Coefficients of a and b are at most 2^19. With bb[] the coefficients
+ * of b with the wrapped ones doubled (z^19 = 2), each product
+ * coefficient is the sum of 19 products of at most 2^19*2^20 = 2^39,
+ * i.e. less than 2^44.
+ */
+static void
+gf32_mul(gf32 *d, const gf32 *a, const gf32 *b)
+{
+	uint32_t ext[37];
+	uint64_t t[19];
+	int i, k;
+
+	for (i = 0; i < 18; i ++) {
+		ext[i] = b->v[i + 1] << 1;
+	}
+	for (i = 0; i < 19; i ++) {
+		ext[i + 18] = b->v[i];
+	}
+	for (k = 0; k < 19; k ++) {
+		t[k] = 0;
+	}
+	for (i = 0; i < 19; i ++) {
+		uint32_t ai;
+
+		ai = a->v[i];
+		for (k = 0; k < 19; k ++) {
+			t[k] += (uint64_t)ai * ext[k - i + 18];
+		}
+	}
+	gf32_reduce(d, t);
+}
+
+#endif
+
 /* see curve9767.h */
 void
 curve9767_point_mul2k(curve9767_point *Q3,
 	const curve9767_point *Q1, unsigned k)
 {
-	field_element X, Y, Z, XX, YY, YYYY, ZZ, S, M;
+	field_element X, Y, Z, XX, YY, YYYY, ZZ, S;
+#if !CURVE9767_GF32
+	field_element M;
+#endif
 	int i;
 	unsigned cc;
 
@@ -1701,18 +2729,81 @@ curve9767_point_mul2k(curve9767_point *Q3,
 	 * squarings already computed above, since Z1 = 2*y; this saves
 	 * two squarings in that iteration.
 	 */
+#if CURVE9767_GF32
+	/*
+	 * With the unpacked representation, the bounds on coefficients
+	 * (as multiples of p) are indicated in comments. At the start of
+	 * each iteration, X <= 13*p, Y <= 9*p and Z <= 6*p; all
+	 * multiplication operands are at most 19*p (at most 51*p in the
+	 * first iteration), within the 2^19 limit.
+	 */
+	{
+		gf32 X32, Y32, Z32, XX32, YY32, YYYY32, ZZ32, S32, M32;
+
+		gf32_load(&X32, X.v);
+		gf32_load(&Y32, Y.v);
+		gf32_load(&Z32, Z.v);
+		for (cc = 1; cc < k; cc ++) {
+			/* ZZ = Z1^2  (4*p)
+			   ZZZZ = ZZ^2 (in S, 16*p) */
+			if (cc == 1) {
+				gf32_load(&YY32, YY.v);
+				gf32_load(&YYYY32, YYYY.v);
+				gf32_muli(&ZZ32, &YY32, 4);
+				gf32_muli(&S32, &YYYY32, 16);
+			} else {
+				gf32_mul(&ZZ32, &Z32, &Z32);
+				gf32_mul(&S32, &ZZ32, &ZZ32);
+			}
+
+			/* XX = X1^2  (p) */
+			gf32_mul(&XX32, &X32, &X32);
+
+			/* M = 3*XX+a*ZZZZ  (51*p) */
+			gf32_sub(&M32, &XX32, &S32, 16);
+			gf32_muli(&M32, &M32, 3);
+
+			/* YY = Y1^2, YYYY = YY^2  (p) */
+			gf32_mul(&YY32, &Y32, &Y32);
+			gf32_mul(&YYYY32, &YY32, &YY32);
+
+			/* S = 2*((X1+YY)^2-XX-YYYY)  (6*p) */
+			gf32_add(&S32, &X32, &YY32);
+			gf32_mul(&S32, &S32, &S32);
+			gf32_sub(&S32, &S32, &XX32, 1);
+			gf32_sub(&S32, &S32, &YYYY32, 1);
+			gf32_muli(&S32, &S32, 2);
+
+			/* store Y1+Z1 into XX  (15*p) */
+			gf32_add(&XX32, &Y32, &Z32);
+
+			/* X2 = M^2-2*S  (13*p) */
+			gf32_mul(&X32, &M32, &M32);
+			gf32_sub(&X32, &X32, &S32, 6);
+			gf32_sub(&X32, &X32, &S32, 6);
+
+			/* Y2 = M*(S-X2)-8*YYYY  (9*p) */
+			gf32_sub(&S32, &S32, &X32, 13);
+			gf32_mul(&S32, &S32, &M32);
+			gf32_muli(&YYYY32, &YYYY32, 8);
+			gf32_sub(&Y32, &S32, &YYYY32, 8);
+
+			/* Z2 = (Y1+Z1)^2-YY-ZZ  (6*p) */
+			gf32_mul(&XX32, &XX32, &XX32);
+			gf32_sub(&XX32, &XX32, &YY32, 1);
+			gf32_sub(&Z32, &XX32, &ZZ32, 4);
+		}
+		gf32_store(X.v, &X32);
+		gf32_store(Y.v, &Y32);
+		gf32_store(Z.v, &Z32);
+	}
+#else
 	for (cc = 1; cc < k; cc ++) {
 		/* ZZ = Z1^2
 		   ZZZZ = ZZ^2 (in S) */
 		if (cc == 1) {
-			int j;
-
-			for (j = 0; j < 19; j ++) {
-				ZZ.v[j] = (uint16_t)mp_montymul(
-					YY.v[j], FOURm);
-				S.v[j] = (uint16_t)mp_montymul(
-					YYYY.v[j], SIXTEENm);
-			}
+			gf_mulconst(ZZ.v, YY.v, FOURm);
+			gf_mulconst(S.v, YYYY.v, SIXTEENm);
 		} else {
 			gf_sqr(ZZ.v, Z.v);
 			gf_sqr(S.v, ZZ.v);
@@ -1724,9 +2815,7 @@ curve9767_point_mul2k(curve9767_point *Q3,
 		/* M = 3*XX+a*ZZZZ
 		   (this releases S) */
 		gf_sub(M.v, XX.v, S.v);
-		for (i = 0; i < 19; i ++) {
-			M.v[i] = (uint16_t)mp_montymul(M.v[i], THREEm);
-		}
+		gf_mulconst(M.v, M.v, THREEm);
 
 		/* YY = Y1^2 */
 		gf_sqr(YY.v, Y.v);
@@ -1752,16 +2841,15 @@ curve9767_point_mul2k(curve9767_point *Q3,
 		/* Y2 = M*(S-X2)-8*YYYY */
 		gf_sub(S.v, S.v, X.v);
 		gf_mul(S.v, S.v, M.v);
-		for (i = 0; i < 19; i ++) {
-			Y.v[i] = (uint16_t)mp_sub(S.v[i],
-				mp_montymul(YYYY.v[i], EIGHTm));
-		}
+		gf_mulconst(YYYY.v, YYYY.v, EIGHTm);
+		gf_sub(Y.v, S.v, YYYY.v);
 
 		/* Z2 = (Y1+Z1)^2-YY-ZZ */
 		gf_sqr(XX.v, XX.v);
 		gf_sub(XX.v, XX.v, YY.v);
 		gf_sub(Z.v, XX.v, ZZ.v);
 	}
+#endif
 
 	/*
 	 * Convert back to affine coordinates.
@@ -2008,7 +3096,6 @@ void
 curve9767_inner_Icart_map(curve9767_point *Q, const uint16_t *u)
 {
 	field_element t1, t2, t3, t4;
-	int i;
 
 	/* u^2 -> t1 */
 	gf_sqr(t1.v, u);
@@ -2022,25 +3109,19 @@ curve9767_inner_Icart_map(curve9767_point *Q, const uint16_t *u)
 	/* (3*a - u^4)/(6*u) -> t2   (value 'v' from the map) */
 	gf_neg(t2.v, t2.v);
 	t2.v[0] = (uint16_t)mp_add(t2.v[0], MNINEm);
-	for (i = 0; i < 19; i ++) {
-		t4.v[i] = (uint16_t)mp_montymul(u[i], SIXm);
-	}
+	gf_mulconst(t4.v, u, SIXm);
 	gf_inv(t4.v, t4.v);
 	gf_mul(t2.v, t2.v, t4.v);
 
 	/* v^2 - b - (u^6)/27 -> t3 */
-	for (i = 0; i < 19; i ++) {
-		t3.v[i] = (uint16_t)mp_montymul(t3.v[i], IMTWENTYSEVENm);
-	}
+	gf_mulconst(t3.v, t3.v, IMTWENTYSEVENm);
 	gf_sqr(t4.v, t2.v);
 	gf_add(t3.v, t3.v, t4.v);
 	t3.v[Bi] = (uint16_t)mp_sub(t3.v[Bi], Bm);
 
 	/* (v^2 - b - (u^6)/27)^(1/3) + (u^2)/3 -> x */
 	gf_cubert(t3.v, t3.v);
-	for (i = 0; i < 19; i ++) {
-		t1.v[i] = (uint16_t)mp_montymul(t1.v[i], ITHREEm);
-	}
+	gf_mulconst(t1.v, t1.v, ITHREEm);
 	gf_add(Q->x, t3.v, t1.v);
 
 	/* u*x + v -> y */
@@ -2050,3 +3131,90 @@ curve9767_inner_Icart_map(curve9767_point *Q, const uint16_t *u)
 	/* Set Q to the point-at-infinity if and only if u is zero. */
 	Q->neutral = gf_eq(u, curve9767_inner_gf_zero.v);
 }
+
+/* see inner.h */
+void
+curve9767_inner_Icart_map2(curve9767_point *Q,
+	const uint16_t *u1, const uint16_t *u2)
+{
+	/*
+	 * Both maps follow curve9767_inner_Icart_map(), with their
+	 * steps interleaved, so that the two (independent) dependency
+	 * chains overlap. The two inversions of 6*u are replaced with
+	 * a single one (Montgomery's trick):
+	 *   1/(6*u1) = (6*u2)/((6*u1)*(6*u2))
+	 *   1/(6*u2) = (6*u1)/((6*u1)*(6*u2))
+	 * If u1 or u2 is zero, then 6*u is replaced with 1, so that the
+	 * inversion of the other value is still correct; the resulting
+	 * point is then marked as neutral, and the addition ignores its
+	 * coordinates.
+	 *
+	 * The final addition keeps its own inversion: expressing both
+	 * points as fractions, so that it could share the inversion,
+	 * costs more multiplications than the inversion (Itoh-Tsujii)
+	 * that it would save.
+	 */
+	curve9767_point T[2];
+	field_element t1[2], t2[2], t3[2], t4[2], t5, t6;
+	const uint16_t *u[2];
+	uint32_t nz[2];
+	int j;
+
+	u[0] = u1;
+	u[1] = u2;
+
+	for (j = 0; j < 2; j ++) {
+		nz[j] = gf_eq(u[j], curve9767_inner_gf_zero.v);
+
+		/* u^2 -> t1 */
+		gf_sqr(t1[j].v, u[j]);
+
+		/* u^4 -> t2 */
+		gf_sqr(t2[j].v, t1[j].v);
+
+		/* u^6 -> t3 */
+		gf_mul(t3[j].v, t1[j].v, t2[j].v);
+
+		/* 3*a - u^4 -> t2, 6*u (or 1, if u == 0) -> t4 */
+		gf_neg(t2[j].v, t2[j].v);
+		t2[j].v[0] = (uint16_t)mp_add(t2[j].v[0], MNINEm);
+		gf_mulconst(t4[j].v, u[j], SIXm);
+		gf_condcopy(t4[j].v, curve9767_inner_gf_one.v, nz[j]);
+	}
+
+	/* 1/(6*u1) and 1/(6*u2) -> t4 */
+	gf_mul(t5.v, t4[0].v, t4[1].v);
+	gf_inv(t5.v, t5.v);
+	gf_mul(t6.v, t4[1].v, t5.v);
+	gf_mul(t4[1].v, t4[0].v, t5.v);
+	t4[0] = t6;
+
+	for (j = 0; j < 2; j ++) {
+		/* (3*a - u^4)/(6*u) -> t2   (value 'v' from the map) */
+		gf_mul(t2[j].v, t2[j].v, t4[j].v);
+
+		/* v^2 - b - (u^6)/27 -> t3 */
+		gf_mulconst(t3[j].v, t3[j].v, IMTWENTYSEVENm);
+		gf_sqr(t4[j].v, t2[j].v);
+		gf_add(t3[j].v, t3[j].v, t4[j].v);
+		t3[j].v[Bi] = (uint16_t)mp_sub(t3[j].v[Bi], Bm);
+	}
+
+	/* (v^2 - b - (u^6)/27)^(1/3) -> t3 */
+	gf_cubert(t3[0].v, t3[0].v);
+	gf_cubert(t3[1].v, t3[1].v);
+
+	for (j = 0; j < 2; j ++) {
+		/* (v^2 - b - (u^6)/27)^(1/3) + (u^2)/3 -> x */
+		gf_mulconst(t1[j].v, t1[j].v, ITHREEm);
+		gf_add(T[j].x, t3[j].v, t1[j].v);
+
+		/* u*x + v -> y */
+		gf_mul(t1[j].v, T[j].x, u[j]);
+		gf_add(T[j].y, t1[j].v, t2[j].v);
+
+		T[j].neutral = nz[j];
+	}
+
+	curve9767_point_add(Q, &T[0], &T[1]);
+}
@@ -0,0 +1,124 @@
+#include "inner.h"
+
+#define DOM_PRECOMP   CURVE9767_DOM("precomp:")
+
+static const uint8_t precomp_magic[] = { 'C', '9', 'P', 'K' };
+
+/*
+ * Compute the integrity tag of a precomputed key object: SHAKE256 over
+ * the header fields (magic to flags) and all bytes after the tag.
+ */
+static void
+make_tag(uint8_t *tag, const curve9767_precomp *pc)
+{
+	shake_context sc;
+	const uint8_t *buf;
+	size_t off;
+
+	buf = (const uint8_t *)pc;
+	off = offsetof(curve9767_precomp, tag);
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_PRECOMP, strlen(DOM_PRECOMP));
+	shake_inject(&sc, buf, off);
+	off += sizeof pc->tag;
+	shake_inject(&sc, buf + off, sizeof *pc - off);
+	shake_flip(&sc);
+	shake_extract(&sc, tag, sizeof pc->tag);
+}
+
+/* see curve9767.h */
+int
+curve9767_precomp_init(curve9767_precomp *pc, const curve9767_point *Q,
+	const curve9767_scalar *s, const uint8_t t[32])
+{
+	curve9767_point B, T;
+	int k;
+
+	if (Q->neutral) {
+		return 0;
+	}
+
+	/*
+	 * All unused fields (including the secret part, if not provided,
+	 * and the padding slots of the point, which field operations may
+	 * leave with arbitrary contents) are set to zero, so that the
+	 * serialized object is deterministic.
+	 */
+	memset(pc, 0, sizeof *pc);
+	memcpy(pc->magic, precomp_magic, sizeof precomp_magic);
+	pc->version = CURVE9767_PRECOMP_VERSION;
+	pc->format = curve9767_inner_repr_id;
+	curve9767_point_encode(pc->encoded_Q, Q);
+	if (s != NULL) {
+		pc->flags = CURVE9767_PRECOMP_SECRET;
+		curve9767_scalar_encode(pc->encoded_s, s);
+		memcpy(pc->t, t, 32);
+	}
+	pc->Q.neutral = Q->neutral;
+	memcpy(pc->Q.x, Q->x, sizeof Q->x);
+	memcpy(pc->Q.y, Q->y, sizeof Q->y);
+
+	/*
+	 * Window k contains j*(2^(64*k))*Q for j = 1..8. Since the curve
+	 * order is prime, none of these points is the neutral.
+	 */
+	B = *Q;
+	for (k = 0; k < 4; k ++) {
+		window_point8 *win;
+		uint32_t j;
+
+		win = (window_point8 *)(void *)pc->window[k];
+		if (k > 0) {
+			curve9767_point_mul2k(&B, &B, 64);
+		}
+		T = B;
+		curve9767_inner_window_put(win, &T, 0);
+		for (j = 1; j < 8; j ++) {
+			/*
+			 * The first addition is a doubling; then, j*B is
+			 * neither B nor -B (2 <= j <= 7).
+			 */
+			if (j == 1) {
+				curve9767_point_add(&T, &T, &B);
+			} else {
+				curve9767_inner_point_add_distinct(&T, &T, &B);
+			}
+			curve9767_inner_window_put(win, &T, j);
+		}
+	}
+
+	make_tag(pc->tag, pc);
+	return 1;
+}
+
+/* see curve9767.h */
+const curve9767_precomp *
+curve9767_precomp_load(const void *src, size_t len)
+{
+	const curve9767_precomp *pc;
+	uint8_t tag[32];
+	uint32_t w;
+	int i;
+
+	if (((uintptr_t)src & 3) != 0 || len < sizeof *pc) {
+		return NULL;
+	}
+	pc = src;
+	if (memcmp(pc->magic, precomp_magic, sizeof precomp_magic) != 0
+		|| pc->version != CURVE9767_PRECOMP_VERSION
+		|| pc->format != curve9767_inner_repr_id
+		|| (pc->flags & ~(uint32_t)CURVE9767_PRECOMP_SECRET) != 0)
+	{
+		return NULL;
+	}
+
+	make_tag(tag, pc);
+	w = 0;
+	for (i = 0; i < 32; i ++) {
+		w |= tag[i] ^ pc->tag[i];
+	}
+	if (w != 0) {
+		return NULL;
+	}
+	return pc;
+}
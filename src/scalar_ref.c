@@ -18,8 +18,77 @@
  * Each function has its own acceptable ranges for input values, and a
  * guaranteed output range. In general, we require scalar values at the
  * API level to be lower than 1.27*n.
+ *
+ * Batch operations (curve9767_scalar_*_batch()) process four scalars in
+ * parallel, one per 32-bit lane, with SIMD intrinsics if CURVE9767_SIMD
+ * is non-zero (this is the default when the compiler targets SSE2 or
+ * NEON; SSE4.1 provides a native 32-bit lane multiplication, which SSE2
+ * emulates). The limbs are the same 15-bit words, and all intermediate
+ * values fit in 32 bits, so the lane computations mirror the
+ * one-scalar functions.
  */
 
+#ifndef CURVE9767_SIMD
+#if defined __SSE2__ || defined __ARM_NEON
+#define CURVE9767_SIMD   1
+#else
+#define CURVE9767_SIMD   0
+#endif
+#endif
+
+#if CURVE9767_SIMD
+#if defined __ARM_NEON
+#include <arm_neon.h>
+typedef uint32x4_t sv4;
+#define V_SET1(x)     vdupq_n_u32(x)
+#define V_ADD(a, b)   vaddq_u32(a, b)
+#define V_SUB(a, b)   vsubq_u32(a, b)
+#define V_MUL(a, b)   vmulq_u32(a, b)
+#define V_AND(a, b)   vandq_u32(a, b)
+#define V_XOR(a, b)   veorq_u32(a, b)
+#define V_SHR(a, n)   vshrq_n_u32(a, n)
+#define V_LOAD(p)     vld1q_u32(p)
+#define V_STORE(p, a) vst1q_u32(p, a)
+#elif defined __SSE2__
+#if defined __SSE4_1__
+#include <smmintrin.h>
+#define V_MUL(a, b)   _mm_mullo_epi32(a, b)
+#else
+#include <emmintrin.h>
+#define V_MUL(a, b)   sv4_mul_sse2(a, b)
+#endif
+typedef __m128i sv4;
+#define V_SET1(x)     _mm_set1_epi32((int)(x))
+#define V_ADD(a, b)   _mm_add_epi32(a, b)
+#define V_SUB(a, b)   _mm_sub_epi32(a, b)
+#define V_AND(a, b)   _mm_and_si128(a, b)
+#define V_XOR(a, b)   _mm_xor_si128(a, b)
+#define V_SHR(a, n)   _mm_srli_epi32(a, n)
+#define V_LOAD(p)     _mm_loadu_si128((const __m128i *)(const void *)(p))
+#define V_STORE(p, a) _mm_storeu_si128((__m128i *)(void *)(p), a)
+#if !defined __SSE4_1__
+/*
+ * Low 32 bits of the products of 32-bit lanes: SSE2 only multiplies
+ * the even lanes (into 64-bit results), so the odd lanes are shifted
+ * down and multiplied separately.
+ */
+static inline __m128i
+sv4_mul_sse2(__m128i a, __m128i b)
+{
+	__m128i e, o;
+
+	e = _mm_mul_epu32(a, b);
+	o = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(
+		_mm_shuffle_epi32(e, _MM_SHUFFLE(0, 0, 2, 0)),
+		_mm_shuffle_epi32(o, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+#else
+#error CURVE9767_SIMD requires SSE2 or NEON
+#endif
+#endif
+
 /*
  * Curve order, in base 2^15 (little-endian order).
  */
@@ -521,6 +590,54 @@ curve9767_scalar_mul(curve9767_scalar *c,
 	scalar_mmul(c->v.w16, t, b->v.w16);
 }
 
+/* see curve9767.h */
+void
+curve9767_scalar_inv(curve9767_scalar *c, const curve9767_scalar *a)
+{
+	/*
+	 * We raise a to the power n-2 (Fermat's little theorem), with
+	 * a fixed 4-bit window (the exponent is not secret, hence the
+	 * window values can be accessed directly). All values are in
+	 * Montgomery representation; win[0] is 1 (i.e. sR).
+	 */
+	static const uint16_t one[17] = { 1 };
+	uint16_t win[16][17], x[17], e[17];
+	int i, j;
+
+	memcpy(e, order, sizeof e);
+	e[0] -= 2;
+	scalar_mmul(win[0], one, sR2);
+	scalar_mmul(win[1], a->v.w16, sR2);
+	for (j = 2; j < 16; j ++) {
+		scalar_mmul(win[j], win[j - 1], win[1]);
+	}
+
+	/*
+	 * n < 2^252, so the exponent has 63 4-bit digits. A digit may
+	 * straddle two 15-bit words.
+	 */
+	memcpy(x, win[0], sizeof x);
+	for (i = 248; i >= 0; i -= 4) {
+		unsigned k;
+
+		for (j = 0; j < 4; j ++) {
+			scalar_mmul(x, x, x);
+		}
+		k = e[i / 15] >> (i % 15);
+		if ((i % 15) > 11) {
+			k |= (unsigned)e[i / 15 + 1] << (15 - (i % 15));
+		}
+		scalar_mmul(x, x, win[k & 15]);
+	}
+
+	/*
+	 * Set dummy alignment word (to appease some sanitizing tools).
+	 */
+	c->v.w16[17] = 0;
+
+	scalar_mmul(c->v.w16, x, one);
+}
+
 /* see curve9767.h */
 void
 curve9767_scalar_condcopy(curve9767_scalar *d,
@@ -533,3 +650,245 @@ curve9767_scalar_condcopy(curve9767_scalar *d,
 		d->v.w32[i] ^= ctl & (d->v.w32[i] ^ s->v.w32[i]);
 	}
 }
+
+#if CURVE9767_SIMD
+
+/*
+ * Four-lane versions of scalar_add() and scalar_mmul(). Each sv4[17]
+ * array holds four scalars (lane k of word i is word i of scalar k);
+ * same input and output ranges as the one-scalar functions.
+ */
+
+static void
+scalar_add_x4(sv4 *c, const sv4 *a, const sv4 *b)
+{
+	sv4 d[17], cc, z, m15;
+	int i, j;
+
+	z = V_SET1(0);
+	m15 = V_SET1(0x7FFF);
+	cc = z;
+	for (i = 0; i < 17; i ++) {
+		sv4 w;
+
+		w = V_ADD(V_ADD(a[i], b[i]), cc);
+		d[i] = V_AND(w, m15);
+		cc = V_SHR(w, 15);
+	}
+	for (j = 0; j < 2; j ++) {
+		sv4 m;
+
+		/* m = -1 if d >= 2^252, 0 otherwise (see scalar_add()) */
+		m = V_SHR(d[16], 12);
+		m = V_SUB(z, V_SHR(V_SUB(z, m), 31));
+		cc = z;
+		for (i = 0; i < 17; i ++) {
+			sv4 wd;
+
+			wd = V_SUB(V_SUB(d[i], V_AND(m, V_SET1(order[i]))), cc);
+			d[i] = V_AND(wd, m15);
+			cc = V_SHR(wd, 31);
+		}
+	}
+	memcpy(c, d, sizeof d);
+}
+
+static void
+scalar_mmul_x4(sv4 *c, const sv4 *a, const sv4 *b)
+{
+	sv4 d[17], dh, m15, vn0, vn0i;
+	int i, j;
+
+	m15 = V_SET1(0x7FFF);
+	vn0 = V_SET1(N0);
+	vn0i = V_SET1(N0I);
+	for (i = 0; i < 17; i ++) {
+		d[i] = V_SET1(0);
+	}
+	dh = V_SET1(0);
+	for (i = 0; i < 17; i ++) {
+		sv4 f, g, t, cc;
+
+		f = a[i];
+		t = V_ADD(d[0], V_MUL(f, b[0]));
+		g = V_AND(V_MUL(t, vn0i), m15);
+		cc = V_SHR(V_ADD(t, V_MUL(g, vn0)), 15);
+		for (j = 1; j < 17; j ++) {
+			sv4 h;
+
+			h = V_ADD(V_ADD(d[j], V_MUL(f, b[j])),
+				V_ADD(V_MUL(g, V_SET1(order[j])), cc));
+			d[j - 1] = V_AND(h, m15);
+			cc = V_SHR(h, 15);
+		}
+		dh = V_ADD(dh, cc);
+		d[16] = V_AND(dh, m15);
+		dh = V_SHR(dh, 15);
+	}
+	memcpy(c, d, sizeof d);
+}
+
+/*
+ * Load up to four scalars (num, 1 to 4) into lanes; missing lanes are
+ * set to zero.
+ */
+static void
+load_x4(sv4 *v, const curve9767_scalar *a, size_t num)
+{
+	uint32_t tmp[4];
+	size_t k;
+	int i;
+
+	for (i = 0; i < 17; i ++) {
+		for (k = 0; k < 4; k ++) {
+			tmp[k] = k < num ? a[k].v.w16[i] : 0;
+		}
+		v[i] = V_LOAD(tmp);
+	}
+}
+
+static void
+store_x4(curve9767_scalar *c, const sv4 *v, size_t num)
+{
+	uint32_t tmp[4];
+	size_t k;
+	int i;
+
+	for (k = 0; k < num; k ++) {
+		c[k].v.w16[17] = 0;
+	}
+	for (i = 0; i < 17; i ++) {
+		V_STORE(tmp, v[i]);
+		for (k = 0; k < num; k ++) {
+			c[k].v.w16[i] = (uint16_t)tmp[k];
+		}
+	}
+}
+
+static void
+const_x4(sv4 *v, const uint16_t *a)
+{
+	int i;
+
+	for (i = 0; i < 17; i ++) {
+		v[i] = V_SET1(a[i]);
+	}
+}
+
+#endif
+
+/* see curve9767.h */
+void
+curve9767_scalar_add_batch(curve9767_scalar *c,
+	const curve9767_scalar *a, const curve9767_scalar *b, size_t n)
+{
+#if CURVE9767_SIMD
+	size_t u;
+
+	for (u = 0; u < n; u += 4) {
+		sv4 va[17], vb[17];
+		size_t num;
+
+		num = n - u < 4 ? n - u : 4;
+		load_x4(va, a + u, num);
+		load_x4(vb, b + u, num);
+		scalar_add_x4(va, va, vb);
+		store_x4(c + u, va, num);
+	}
+#else
+	size_t u;
+
+	for (u = 0; u < n; u ++) {
+		curve9767_scalar_add(&c[u], &a[u], &b[u]);
+	}
+#endif
+}
+
+/* see curve9767.h */
+void
+curve9767_scalar_mul_batch(curve9767_scalar *c,
+	const curve9767_scalar *a, const curve9767_scalar *b, size_t n)
+{
+#if CURVE9767_SIMD
+	sv4 r2[17];
+	size_t u;
+
+	const_x4(r2, sR2);
+	for (u = 0; u < n; u += 4) {
+		sv4 va[17], vb[17];
+		size_t num;
+
+		num = n - u < 4 ? n - u : 4;
+		load_x4(va, a + u, num);
+		load_x4(vb, b + u, num);
+		scalar_mmul_x4(va, va, r2);
+		scalar_mmul_x4(va, va, vb);
+		store_x4(c + u, va, num);
+	}
+#else
+	size_t u;
+
+	for (u = 0; u < n; u ++) {
+		curve9767_scalar_mul(&c[u], &a[u], &b[u]);
+	}
+#endif
+}
+
+/* see curve9767.h */
+void
+curve9767_scalar_decode_reduce_batch(curve9767_scalar *s,
+	const void *src, size_t len, size_t n)
+{
+#if CURVE9767_SIMD
+	const uint8_t *buf;
+	sv4 vd[17];
+	size_t u;
+
+	/*
+	 * Same algorithm as curve9767_scalar_decode_reduce(); the chunk
+	 * decoding is done per scalar, the multiplications and additions
+	 * on four lanes.
+	 */
+	buf = src;
+	if (len <= 31) {
+		for (u = 0; u < n; u ++) {
+			s[u].v.w16[17] = 0;
+			scalar_decode_trunc(s[u].v.w16, buf + u * len, len);
+		}
+		return;
+	}
+	const_x4(vd, sD);
+	for (u = 0; u < n; u += 4) {
+		curve9767_scalar t[4];
+		sv4 x[17], y[17];
+		size_t num, k, off;
+
+		num = n - u < 4 ? n - u : 4;
+		for (off = 0; off + 31 < len; off += 31);
+		for (k = 0; k < num; k ++) {
+			scalar_decode_trunc(t[k].v.w16,
+				buf + (u + k) * len + off, len - off);
+		}
+		load_x4(x, t, num);
+		while (off > 0) {
+			off -= 31;
+			scalar_mmul_x4(x, x, vd);
+			for (k = 0; k < num; k ++) {
+				scalar_decode_trunc(t[k].v.w16,
+					buf + (u + k) * len + off, 31);
+			}
+			load_x4(y, t, num);
+			scalar_add_x4(x, x, y);
+		}
+		store_x4(s + u, x, num);
+	}
+#else
+	const uint8_t *buf;
+	size_t u;
+
+	buf = src;
+	for (u = 0; u < n; u ++) {
+		curve9767_scalar_decode_reduce(&s[u], buf + u * len, len);
+	}
+#endif
+}
@@ -35,6 +35,49 @@
 
 #include "sha3.h"
 
+/*
+ * On 32-bit targets, Keccak lanes are stored in bit-interleaved form
+ * (SHA3_BI32): each 64-bit lane is split into two 32-bit words, one
+ * with the even-indexed bits and one with the odd-indexed bits, so that
+ * 64-bit rotations become two 32-bit rotations. The lane is still held
+ * in a uint64_t (even bits in the low word, odd bits in the high word),
+ * so the context layout does not change; conversion happens when
+ * bytes are injected or extracted. On ARM Cortex-M0/M0+, the
+ * permutation is implemented in assembly (sha3_cm0.s, SHA3_BI32_CM0).
+ */
+#ifndef SHA3_BI32
+#if UINTPTR_MAX <= 0xFFFFFFFF
+#define SHA3_BI32   1
+#else
+#define SHA3_BI32   0
+#endif
+#endif
+
+#ifndef SHA3_BI32_CM0
+#if SHA3_BI32 && defined __ARM_ARCH_6M__
+#define SHA3_BI32_CM0   1
+#else
+#define SHA3_BI32_CM0   0
+#endif
+#endif
+
+/*
+ * The four-way SHA3 uses AVX2 when available (on 64-bit lanes only).
+ */
+#ifndef SHA3_AVX2
+#if defined __AVX2__ && !SHA3_BI32
+#define SHA3_AVX2   1
+#else
+#define SHA3_AVX2   0
+#endif
+#endif
+
+#if SHA3_AVX2 && SHA3_BI32
+#error SHA3_AVX2 requires 64-bit lanes (SHA3_BI32 = 0)
+#endif
+
+#if !SHA3_BI32
+
 /*
  * Round constants.
  */
@@ -53,11 +96,44 @@ static const uint64_t RC[] = {
 	0x0000000080000001, 0x8000000080008008
 };
 
+#endif
+
+/*
+ * Little-endian decoding and encoding of 64-bit values.
+ */
+static inline uint64_t
+dec64le(const uint8_t *buf)
+{
+	return (uint64_t)buf[0]
+		| ((uint64_t)buf[1] << 8)
+		| ((uint64_t)buf[2] << 16)
+		| ((uint64_t)buf[3] << 24)
+		| ((uint64_t)buf[4] << 32)
+		| ((uint64_t)buf[5] << 40)
+		| ((uint64_t)buf[6] << 48)
+		| ((uint64_t)buf[7] << 56);
+}
+
+static inline void
+enc64le(uint8_t *buf, uint64_t x)
+{
+	int i;
+
+	for (i = 0; i < 8; i ++) {
+		buf[i] = (uint8_t)(x >> (i << 3));
+	}
+}
+
+#if !SHA3_BI32
+
 /*
- * Process the provided state.
+ * Process the provided state. The number of rounds (nr) is 24 for the
+ * full Keccak-f permutation, 12 for TurboSHAKE; it must be even. When
+ * fewer than 24 rounds are used, these are the last rounds of the
+ * permutation (i.e. with the last round constants).
  */
 static void
-process_block(uint64_t *A)
+process_block(uint64_t *A, unsigned nr)
 {
 	uint64_t t0, t1, t2, t3, t4;
 	uint64_t tt0, tt1, tt2, tt3;
@@ -77,10 +153,10 @@ process_block(uint64_t *A)
 	A[20] = ~A[20];
 
 	/*
-	 * Compute the 24 rounds. This loop is partially unrolled (each
+	 * Compute the rounds. This loop is partially unrolled (each
 	 * iteration computes two rounds).
 	 */
-	for (j = 0; j < 24; j += 2) {
+	for (j = 24 - (int)nr; j < 24; j += 2) {
 
 		tt0 = A[ 1] ^ A[ 6];
 		tt1 = A[11] ^ A[16];
@@ -484,15 +560,588 @@ process_block(uint64_t *A)
 	A[20] = ~A[20];
 }
 
+/*
+ * Lane access: XOR a 64-bit value into lane j, or get lane j, in
+ * normal (little-endian) bit order.
+ */
+static inline void
+lane_xor(uint64_t *A, size_t j, uint64_t x)
+{
+	A[j] ^= x;
+}
+
+static inline uint64_t
+lane_get(const uint64_t *A, size_t j)
+{
+	return A[j];
+}
+
+/*
+ * Byte access: XOR byte b into state byte v, or get state byte v.
+ */
+static inline void
+lane_xor_byte(uint64_t *A, size_t v, unsigned b)
+{
+	A[v >> 3] ^= (uint64_t)b << ((v & 7) << 3);
+}
+
+static inline unsigned
+lane_get_byte(const uint64_t *A, size_t v)
+{
+	return (uint8_t)(A[v >> 3] >> ((v & 7) << 3));
+}
+
+#else
+
+/*
+ * Gather the even-indexed bits of x into the low 16 bits (other bits
+ * are cleared).
+ */
+static inline uint32_t
+squeeze_even(uint32_t x)
+{
+	x &= 0x55555555;
+	x = (x | (x >> 1)) & 0x33333333;
+	x = (x | (x >> 2)) & 0x0F0F0F0F;
+	x = (x | (x >> 4)) & 0x00FF00FF;
+	x = (x | (x >> 8)) & 0x0000FFFF;
+	return x;
+}
+
+/*
+ * Spread the low 16 bits of x into the even-indexed bits (inverse of
+ * squeeze_even()); x must be lower than 2^16.
+ */
+static inline uint32_t
+spread_even(uint32_t x)
+{
+	x = (x | (x << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	return x;
+}
+
+static inline void
+lane_xor(uint64_t *A, size_t j, uint64_t x)
+{
+	uint32_t lo, hi, e, o;
+
+	lo = (uint32_t)x;
+	hi = (uint32_t)(x >> 32);
+	e = squeeze_even(lo) | (squeeze_even(hi) << 16);
+	o = squeeze_even(lo >> 1) | (squeeze_even(hi >> 1) << 16);
+	A[j] ^= ((uint64_t)o << 32) | (uint64_t)e;
+}
+
+static inline uint64_t
+lane_get(const uint64_t *A, size_t j)
+{
+	uint32_t e, o, lo, hi;
+
+	e = (uint32_t)A[j];
+	o = (uint32_t)(A[j] >> 32);
+	lo = spread_even(e & 0xFFFF) | (spread_even(o & 0xFFFF) << 1);
+	hi = spread_even(e >> 16) | (spread_even(o >> 16) << 1);
+	return ((uint64_t)hi << 32) | (uint64_t)lo;
+}
+
+/*
+ * Byte k of a lane has its even bits in bits 4*k to 4*k+3 of the even
+ * word, and its odd bits at the same place in the odd word.
+ */
+static inline void
+lane_xor_byte(uint64_t *A, size_t v, unsigned b)
+{
+	unsigned k;
+
+	k = (unsigned)(v & 7) << 2;
+	A[v >> 3] ^= ((uint64_t)squeeze_even(b >> 1) << (32 + k))
+		| ((uint64_t)squeeze_even(b) << k);
+}
+
+static inline unsigned
+lane_get_byte(const uint64_t *A, size_t v)
+{
+	uint32_t e, o;
+	unsigned k;
+
+	k = (unsigned)(v & 7) << 2;
+	e = (uint32_t)(A[v >> 3] >> k) & 0x0F;
+	o = (uint32_t)(A[v >> 3] >> (32 + k)) & 0x0F;
+	return spread_even(e) | (spread_even(o) << 1);
+}
+
+#if SHA3_BI32_CM0
+
+/*
+ * Keccak-p permutation on the bit-interleaved state (in sha3_cm0.s):
+ * 32-bit words 2*j and 2*j+1 are the even and odd words of lane j.
+ */
+void sha3_process_block_cm0(uint64_t *A, unsigned nr);
+
+static void
+process_block(uint64_t *A, unsigned nr)
+{
+	sha3_process_block_cm0(A, nr);
+}
+
+#else
+
+/*
+ * Round constants, bit-interleaved (even word, odd word).
+ */
+static const uint32_t RC_BI[] = {
+	0x00000001, 0x00000000,
+	0x00000000, 0x00000089,
+	0x00000000, 0x8000008B,
+	0x00000000, 0x80008080,
+	0x00000001, 0x0000008B,
+	0x00000001, 0x00008000,
+	0x00000001, 0x80008088,
+	0x00000001, 0x80000082,
+	0x00000000, 0x0000000B,
+	0x00000000, 0x0000000A,
+	0x00000001, 0x00008082,
+	0x00000000, 0x00008003,
+	0x00000001, 0x0000808B,
+	0x00000001, 0x8000000B,
+	0x00000001, 0x8000008A,
+	0x00000001, 0x80000081,
+	0x00000000, 0x80000081,
+	0x00000000, 0x80000008,
+	0x00000000, 0x00000083,
+	0x00000000, 0x80008003,
+	0x00000001, 0x80008088,
+	0x00000000, 0x80000088,
+	0x00000001, 0x00008000,
+	0x00000000, 0x80008082
+};
+
+#define ROTL32(x, n)   (((x) << (n)) | ((x) >> (32 - (n))))
+
+/*
+ * Process the provided state (bit-interleaved lanes), with the last nr
+ * rounds of Keccak-f; nr must be even. Word 2*k (2*k+1) of the state is
+ * the even (odd) word of lane k. Each round reads the state from one
+ * array and writes it into the other (the loop computes two rounds per
+ * iteration, from S to E and back). Theta is applied to the words as
+ * they are read by rho and pi; then the ten words of a row are
+ * combined by chi.
+ *
+ * In rho, a rotation of a lane by 2*n bits rotates both words by n bits;
+ * a rotation by 2*n+1 bits also swaps the two words (and rotates the new
+ * even word by n+1 bits, the new odd word by n bits).
+ */
+static void
+process_block(uint64_t *A, unsigned nr)
+{
+	uint32_t S[50], E[50];
+	uint32_t c0, c1, c2, c3, c4, c5, c6, c7, c8, c9;
+	uint32_t d0, d1, d2, d3, d4, d5, d6, d7, d8, d9;
+	uint32_t b0, b1, b2, b3, b4, b5, b6, b7, b8, b9;
+	unsigned r, j;
+
+	for (j = 0; j < 25; j ++) {
+		S[2 * j] = (uint32_t)A[j];
+		S[2 * j + 1] = (uint32_t)(A[j] >> 32);
+	}
+	for (r = 24 - nr; r < 24; r += 2) {
+		/* theta */
+		c0 = S[ 0] ^ S[10] ^ S[20] ^ S[30] ^ S[40];
+		c1 = S[ 1] ^ S[11] ^ S[21] ^ S[31] ^ S[41];
+		c2 = S[ 2] ^ S[12] ^ S[22] ^ S[32] ^ S[42];
+		c3 = S[ 3] ^ S[13] ^ S[23] ^ S[33] ^ S[43];
+		c4 = S[ 4] ^ S[14] ^ S[24] ^ S[34] ^ S[44];
+		c5 = S[ 5] ^ S[15] ^ S[25] ^ S[35] ^ S[45];
+		c6 = S[ 6] ^ S[16] ^ S[26] ^ S[36] ^ S[46];
+		c7 = S[ 7] ^ S[17] ^ S[27] ^ S[37] ^ S[47];
+		c8 = S[ 8] ^ S[18] ^ S[28] ^ S[38] ^ S[48];
+		c9 = S[ 9] ^ S[19] ^ S[29] ^ S[39] ^ S[49];
+		d0 = c8 ^ ROTL32(c3, 1);
+		d1 = c9 ^ c2;
+		d2 = c0 ^ ROTL32(c5, 1);
+		d3 = c1 ^ c4;
+		d4 = c2 ^ ROTL32(c7, 1);
+		d5 = c3 ^ c6;
+		d6 = c4 ^ ROTL32(c9, 1);
+		d7 = c5 ^ c8;
+		d8 = c6 ^ ROTL32(c1, 1);
+		d9 = c7 ^ c0;
+
+		/* rho, pi and chi: words 0 to 9 */
+		b0 = S[ 0] ^ d0;
+		b1 = S[ 1] ^ d1;
+		b2 = S[12] ^ d2;
+		b2 = ROTL32(b2, 22);
+		b3 = S[13] ^ d3;
+		b3 = ROTL32(b3, 22);
+		b4 = S[25] ^ d5;
+		b4 = ROTL32(b4, 22);
+		b5 = S[24] ^ d4;
+		b5 = ROTL32(b5, 21);
+		b6 = S[37] ^ d7;
+		b6 = ROTL32(b6, 11);
+		b7 = S[36] ^ d6;
+		b7 = ROTL32(b7, 10);
+		b8 = S[48] ^ d8;
+		b8 = ROTL32(b8, 7);
+		b9 = S[49] ^ d9;
+		b9 = ROTL32(b9, 7);
+		E[ 0] = b0 ^ (~b2 & b4);
+		E[ 1] = b1 ^ (~b3 & b5);
+		E[ 2] = b2 ^ (~b4 & b6);
+		E[ 3] = b3 ^ (~b5 & b7);
+		E[ 4] = b4 ^ (~b6 & b8);
+		E[ 5] = b5 ^ (~b7 & b9);
+		E[ 6] = b6 ^ (~b8 & b0);
+		E[ 7] = b7 ^ (~b9 & b1);
+		E[ 8] = b8 ^ (~b0 & b2);
+		E[ 9] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 10 to 19 */
+		b0 = S[ 6] ^ d6;
+		b0 = ROTL32(b0, 14);
+		b1 = S[ 7] ^ d7;
+		b1 = ROTL32(b1, 14);
+		b2 = S[18] ^ d8;
+		b2 = ROTL32(b2, 10);
+		b3 = S[19] ^ d9;
+		b3 = ROTL32(b3, 10);
+		b4 = S[21] ^ d1;
+		b4 = ROTL32(b4, 2);
+		b5 = S[20] ^ d0;
+		b5 = ROTL32(b5, 1);
+		b6 = S[33] ^ d3;
+		b6 = ROTL32(b6, 23);
+		b7 = S[32] ^ d2;
+		b7 = ROTL32(b7, 22);
+		b8 = S[45] ^ d5;
+		b8 = ROTL32(b8, 31);
+		b9 = S[44] ^ d4;
+		b9 = ROTL32(b9, 30);
+		E[10] = b0 ^ (~b2 & b4);
+		E[11] = b1 ^ (~b3 & b5);
+		E[12] = b2 ^ (~b4 & b6);
+		E[13] = b3 ^ (~b5 & b7);
+		E[14] = b4 ^ (~b6 & b8);
+		E[15] = b5 ^ (~b7 & b9);
+		E[16] = b6 ^ (~b8 & b0);
+		E[17] = b7 ^ (~b9 & b1);
+		E[18] = b8 ^ (~b0 & b2);
+		E[19] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 20 to 29 */
+		b0 = S[ 3] ^ d3;
+		b0 = ROTL32(b0, 1);
+		b1 = S[ 2] ^ d2;
+		b2 = S[14] ^ d4;
+		b2 = ROTL32(b2, 3);
+		b3 = S[15] ^ d5;
+		b3 = ROTL32(b3, 3);
+		b4 = S[27] ^ d7;
+		b4 = ROTL32(b4, 13);
+		b5 = S[26] ^ d6;
+		b5 = ROTL32(b5, 12);
+		b6 = S[38] ^ d8;
+		b6 = ROTL32(b6, 4);
+		b7 = S[39] ^ d9;
+		b7 = ROTL32(b7, 4);
+		b8 = S[40] ^ d0;
+		b8 = ROTL32(b8, 9);
+		b9 = S[41] ^ d1;
+		b9 = ROTL32(b9, 9);
+		E[20] = b0 ^ (~b2 & b4);
+		E[21] = b1 ^ (~b3 & b5);
+		E[22] = b2 ^ (~b4 & b6);
+		E[23] = b3 ^ (~b5 & b7);
+		E[24] = b4 ^ (~b6 & b8);
+		E[25] = b5 ^ (~b7 & b9);
+		E[26] = b6 ^ (~b8 & b0);
+		E[27] = b7 ^ (~b9 & b1);
+		E[28] = b8 ^ (~b0 & b2);
+		E[29] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 30 to 39 */
+		b0 = S[ 9] ^ d9;
+		b0 = ROTL32(b0, 14);
+		b1 = S[ 8] ^ d8;
+		b1 = ROTL32(b1, 13);
+		b2 = S[10] ^ d0;
+		b2 = ROTL32(b2, 18);
+		b3 = S[11] ^ d1;
+		b3 = ROTL32(b3, 18);
+		b4 = S[22] ^ d2;
+		b4 = ROTL32(b4, 5);
+		b5 = S[23] ^ d3;
+		b5 = ROTL32(b5, 5);
+		b6 = S[35] ^ d5;
+		b6 = ROTL32(b6, 8);
+		b7 = S[34] ^ d4;
+		b7 = ROTL32(b7, 7);
+		b8 = S[46] ^ d6;
+		b8 = ROTL32(b8, 28);
+		b9 = S[47] ^ d7;
+		b9 = ROTL32(b9, 28);
+		E[30] = b0 ^ (~b2 & b4);
+		E[31] = b1 ^ (~b3 & b5);
+		E[32] = b2 ^ (~b4 & b6);
+		E[33] = b3 ^ (~b5 & b7);
+		E[34] = b4 ^ (~b6 & b8);
+		E[35] = b5 ^ (~b7 & b9);
+		E[36] = b6 ^ (~b8 & b0);
+		E[37] = b7 ^ (~b9 & b1);
+		E[38] = b8 ^ (~b0 & b2);
+		E[39] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 40 to 49 */
+		b0 = S[ 4] ^ d4;
+		b0 = ROTL32(b0, 31);
+		b1 = S[ 5] ^ d5;
+		b1 = ROTL32(b1, 31);
+		b2 = S[17] ^ d7;
+		b2 = ROTL32(b2, 28);
+		b3 = S[16] ^ d6;
+		b3 = ROTL32(b3, 27);
+		b4 = S[29] ^ d9;
+		b4 = ROTL32(b4, 20);
+		b5 = S[28] ^ d8;
+		b5 = ROTL32(b5, 19);
+		b6 = S[31] ^ d1;
+		b6 = ROTL32(b6, 21);
+		b7 = S[30] ^ d0;
+		b7 = ROTL32(b7, 20);
+		b8 = S[42] ^ d2;
+		b8 = ROTL32(b8, 1);
+		b9 = S[43] ^ d3;
+		b9 = ROTL32(b9, 1);
+		E[40] = b0 ^ (~b2 & b4);
+		E[41] = b1 ^ (~b3 & b5);
+		E[42] = b2 ^ (~b4 & b6);
+		E[43] = b3 ^ (~b5 & b7);
+		E[44] = b4 ^ (~b6 & b8);
+		E[45] = b5 ^ (~b7 & b9);
+		E[46] = b6 ^ (~b8 & b0);
+		E[47] = b7 ^ (~b9 & b1);
+		E[48] = b8 ^ (~b0 & b2);
+		E[49] = b9 ^ (~b1 & b3);
+
+		/* iota */
+		E[ 0] ^= RC_BI[2 * r + 0];
+		E[ 1] ^= RC_BI[2 * r + 1];
+
+		/* theta */
+		c0 = E[ 0] ^ E[10] ^ E[20] ^ E[30] ^ E[40];
+		c1 = E[ 1] ^ E[11] ^ E[21] ^ E[31] ^ E[41];
+		c2 = E[ 2] ^ E[12] ^ E[22] ^ E[32] ^ E[42];
+		c3 = E[ 3] ^ E[13] ^ E[23] ^ E[33] ^ E[43];
+		c4 = E[ 4] ^ E[14] ^ E[24] ^ E[34] ^ E[44];
+		c5 = E[ 5] ^ E[15] ^ E[25] ^ E[35] ^ E[45];
+		c6 = E[ 6] ^ E[16] ^ E[26] ^ E[36] ^ E[46];
+		c7 = E[ 7] ^ E[17] ^ E[27] ^ E[37] ^ E[47];
+		c8 = E[ 8] ^ E[18] ^ E[28] ^ E[38] ^ E[48];
+		c9 = E[ 9] ^ E[19] ^ E[29] ^ E[39] ^ E[49];
+		d0 = c8 ^ ROTL32(c3, 1);
+		d1 = c9 ^ c2;
+		d2 = c0 ^ ROTL32(c5, 1);
+		d3 = c1 ^ c4;
+		d4 = c2 ^ ROTL32(c7, 1);
+		d5 = c3 ^ c6;
+		d6 = c4 ^ ROTL32(c9, 1);
+		d7 = c5 ^ c8;
+		d8 = c6 ^ ROTL32(c1, 1);
+		d9 = c7 ^ c0;
+
+		/* rho, pi and chi: words 0 to 9 */
+		b0 = E[ 0] ^ d0;
+		b1 = E[ 1] ^ d1;
+		b2 = E[12] ^ d2;
+		b2 = ROTL32(b2, 22);
+		b3 = E[13] ^ d3;
+		b3 = ROTL32(b3, 22);
+		b4 = E[25] ^ d5;
+		b4 = ROTL32(b4, 22);
+		b5 = E[24] ^ d4;
+		b5 = ROTL32(b5, 21);
+		b6 = E[37] ^ d7;
+		b6 = ROTL32(b6, 11);
+		b7 = E[36] ^ d6;
+		b7 = ROTL32(b7, 10);
+		b8 = E[48] ^ d8;
+		b8 = ROTL32(b8, 7);
+		b9 = E[49] ^ d9;
+		b9 = ROTL32(b9, 7);
+		S[ 0] = b0 ^ (~b2 & b4);
+		S[ 1] = b1 ^ (~b3 & b5);
+		S[ 2] = b2 ^ (~b4 & b6);
+		S[ 3] = b3 ^ (~b5 & b7);
+		S[ 4] = b4 ^ (~b6 & b8);
+		S[ 5] = b5 ^ (~b7 & b9);
+		S[ 6] = b6 ^ (~b8 & b0);
+		S[ 7] = b7 ^ (~b9 & b1);
+		S[ 8] = b8 ^ (~b0 & b2);
+		S[ 9] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 10 to 19 */
+		b0 = E[ 6] ^ d6;
+		b0 = ROTL32(b0, 14);
+		b1 = E[ 7] ^ d7;
+		b1 = ROTL32(b1, 14);
+		b2 = E[18] ^ d8;
+		b2 = ROTL32(b2, 10);
+		b3 = E[19] ^ d9;
+		b3 = ROTL32(b3, 10);
+		b4 = E[21] ^ d1;
+		b4 = ROTL32(b4, 2);
+		b5 = E[20] ^ d0;
+		b5 = ROTL32(b5, 1);
+		b6 = E[33] ^ d3;
+		b6 = ROTL32(b6, 23);
+		b7 = E[32] ^ d2;
+		b7 = ROTL32(b7, 22);
+		b8 = E[45] ^ d5;
+		b8 = ROTL32(b8, 31);
+		b9 = E[44] ^ d4;
+		b9 = ROTL32(b9, 30);
+		S[10] = b0 ^ (~b2 & b4);
+		S[11] = b1 ^ (~b3 & b5);
+		S[12] = b2 ^ (~b4 & b6);
+		S[13] = b3 ^ (~b5 & b7);
+		S[14] = b4 ^ (~b6 & b8);
+		S[15] = b5 ^ (~b7 & b9);
+		S[16] = b6 ^ (~b8 & b0);
+		S[17] = b7 ^ (~b9 & b1);
+		S[18] = b8 ^ (~b0 & b2);
+		S[19] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 20 to 29 */
+		b0 = E[ 3] ^ d3;
+		b0 = ROTL32(b0, 1);
+		b1 = E[ 2] ^ d2;
+		b2 = E[14] ^ d4;
+		b2 = ROTL32(b2, 3);
+		b3 = E[15] ^ d5;
+		b3 = ROTL32(b3, 3);
+		b4 = E[27] ^ d7;
+		b4 = ROTL32(b4, 13);
+		b5 = E[26] ^ d6;
+		b5 = ROTL32(b5, 12);
+		b6 = E[38] ^ d8;
+		b6 = ROTL32(b6, 4);
+		b7 = E[39] ^ d9;
+		b7 = ROTL32(b7, 4);
+		b8 = E[40] ^ d0;
+		b8 = ROTL32(b8, 9);
+		b9 = E[41] ^ d1;
+		b9 = ROTL32(b9, 9);
+		S[20] = b0 ^ (~b2 & b4);
+		S[21] = b1 ^ (~b3 & b5);
+		S[22] = b2 ^ (~b4 & b6);
+		S[23] = b3 ^ (~b5 & b7);
+		S[24] = b4 ^ (~b6 & b8);
+		S[25] = b5 ^ (~b7 & b9);
+		S[26] = b6 ^ (~b8 & b0);
+		S[27] = b7 ^ (~b9 & b1);
+		S[28] = b8 ^ (~b0 & b2);
+		S[29] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 30 to 39 */
+		b0 = E[ 9] ^ d9;
+		b0 = ROTL32(b0, 14);
+		b1 = E[ 8] ^ d8;
+		b1 = ROTL32(b1, 13);
+		b2 = E[10] ^ d0;
+		b2 = ROTL32(b2, 18);
+		b3 = E[11] ^ d1;
+		b3 = ROTL32(b3, 18);
+		b4 = E[22] ^ d2;
+		b4 = ROTL32(b4, 5);
+		b5 = E[23] ^ d3;
+		b5 = ROTL32(b5, 5);
+		b6 = E[35] ^ d5;
+		b6 = ROTL32(b6, 8);
+		b7 = E[34] ^ d4;
+		b7 = ROTL32(b7, 7);
+		b8 = E[46] ^ d6;
+		b8 = ROTL32(b8, 28);
+		b9 = E[47] ^ d7;
+		b9 = ROTL32(b9, 28);
+		S[30] = b0 ^ (~b2 & b4);
+		S[31] = b1 ^ (~b3 & b5);
+		S[32] = b2 ^ (~b4 & b6);
+		S[33] = b3 ^ (~b5 & b7);
+		S[34] = b4 ^ (~b6 & b8);
+		S[35] = b5 ^ (~b7 & b9);
+		S[36] = b6 ^ (~b8 & b0);
+		S[37] = b7 ^ (~b9 & b1);
+		S[38] = b8 ^ (~b0 & b2);
+		S[39] = b9 ^ (~b1 & b3);
+
+		/* rho, pi and chi: words 40 to 49 */
+		b0 = E[ 4] ^ d4;
+		b0 = ROTL32(b0, 31);
+		b1 = E[ 5] ^ d5;
+		b1 = ROTL32(b1, 31);
+		b2 = E[17] ^ d7;
+		b2 = ROTL32(b2, 28);
+		b3 = E[16] ^ d6;
+		b3 = ROTL32(b3, 27);
+		b4 = E[29] ^ d9;
+		b4 = ROTL32(b4, 20);
+		b5 = E[28] ^ d8;
+		b5 = ROTL32(b5, 19);
+		b6 = E[31] ^ d1;
+		b6 = ROTL32(b6, 21);
+		b7 = E[30] ^ d0;
+		b7 = ROTL32(b7, 20);
+		b8 = E[42] ^ d2;
+		b8 = ROTL32(b8, 1);
+		b9 = E[43] ^ d3;
+		b9 = ROTL32(b9, 1);
+		S[40] = b0 ^ (~b2 & b4);
+		S[41] = b1 ^ (~b3 & b5);
+		S[42] = b2 ^ (~b4 & b6);
+		S[43] = b3 ^ (~b5 & b7);
+		S[44] = b4 ^ (~b6 & b8);
+		S[45] = b5 ^ (~b7 & b9);
+		S[46] = b6 ^ (~b8 & b0);
+		S[47] = b7 ^ (~b9 & b1);
+		S[48] = b8 ^ (~b0 & b2);
+		S[49] = b9 ^ (~b1 & b3);
+
+		/* iota */
+		S[ 0] ^= RC_BI[2 * r + 2];
+		S[ 1] ^= RC_BI[2 * r + 3];
+	}
+	for (j = 0; j < 25; j ++) {
+		A[j] = ((uint64_t)S[2 * j + 1] << 32) | (uint64_t)S[2 * j];
+	}
+}
+
+#endif
+
+#endif
+
 /* see sha3.h */
 void
 shake_init(shake_context *sc, unsigned size)
 {
 	sc->rate = 200 - (size_t)(size >> 2);
 	sc->dptr = 0;
+	sc->rounds = 24;
+	sc->dsbyte = 0x1F;
 	memset(sc->A, 0, sizeof sc->A);
 }
 
+/* see sha3.h */
+void
+turboshake_init(shake_context *sc, unsigned size, unsigned dsbyte)
+{
+	shake_init(sc, size);
+	sc->rounds = 12;
+	sc->dsbyte = dsbyte;
+}
+
 /* see sha3.h */
 void
 shake_inject(shake_context *sc, const void *in, size_t len)
@@ -510,17 +1159,28 @@ shake_inject(shake_context *sc, const void *in, size_t len)
 		if (clen > len) {
 			clen = len;
 		}
-		for (u = 0; u < clen; u ++) {
+		u = 0;
+		while (u < clen) {
 			size_t v;
 
+			/*
+			 * Whole aligned lanes are injected with a single
+			 * conversion (for the bit-interleaved format).
+			 */
 			v = u + dptr;
-			sc->A[v >> 3] ^= (uint64_t)buf[u] << ((v & 7) << 3);
+			if ((v & 7) == 0 && (clen - u) >= 8) {
+				lane_xor(sc->A, v >> 3, dec64le(buf + u));
+				u += 8;
+			} else {
+				lane_xor_byte(sc->A, v, buf[u]);
+				u ++;
+			}
 		}
 		dptr += clen;
 		buf += clen;
 		len -= clen;
 		if (dptr == rate) {
-			process_block(sc->A);
+			process_block(sc->A, sc->rounds);
 			dptr = 0;
 		}
 	}
@@ -532,16 +1192,18 @@ void
 shake_flip(shake_context *sc)
 {
 	/*
-	 * We apply padding and pre-XOR the value into the state. We
-	 * set dptr to the end of the buffer, so that first call to
-	 * shake_extract() will process the block.
+	 * We apply padding and pre-XOR the value into the state. The
+	 * first padding byte is the domain separation byte (0x1F for
+	 * SHAKE, caller-provided for TurboSHAKE). We set dptr to the
+	 * end of the buffer, so that first call to shake_extract() will
+	 * process the block.
 	 */
 	unsigned v;
 
 	v = sc->dptr;
-	sc->A[v >> 3] ^= (uint64_t)0x1F << ((v & 7) << 3);
+	lane_xor_byte(sc->A, v, sc->dsbyte);
 	v = sc->rate - 1;
-	sc->A[v >> 3] ^= (uint64_t)0x80 << ((v & 7) << 3);
+	lane_xor_byte(sc->A, v, 0x80);
 	sc->dptr = sc->rate;
 }
 
@@ -559,7 +1221,7 @@ shake_extract(shake_context *sc, void *out, size_t len)
 		size_t clen;
 
 		if (dptr == rate) {
-			process_block(sc->A);
+			process_block(sc->A, sc->rounds);
 			dptr = 0;
 		}
 		clen = rate - dptr;
@@ -567,9 +1229,17 @@ shake_extract(shake_context *sc, void *out, size_t len)
 			clen = len;
 		}
 		len -= clen;
-		while (clen -- > 0) {
-			*buf ++ = sc->A[dptr >> 3] >> ((dptr & 7) << 3);
-			dptr ++;
+		while (clen > 0) {
+			if ((dptr & 7) == 0 && clen >= 8) {
+				enc64le(buf, lane_get(sc->A, dptr >> 3));
+				buf += 8;
+				dptr += 8;
+				clen -= 8;
+			} else {
+				*buf ++ = lane_get_byte(sc->A, dptr);
+				dptr ++;
+				clen --;
+			}
 		}
 	}
 	sc->dptr = dptr;
@@ -602,21 +1272,256 @@ sha3_close(sha3_context *sc, void *out)
 	 * we append '01', not '1111'.
 	 */
 	v = sc->dptr;
-	sc->A[v >> 3] ^= (uint64_t)0x06 << ((v & 7) << 3);
+	lane_xor_byte(sc->A, v, 0x06);
 	v = sc->rate - 1;
-	sc->A[v >> 3] ^= (uint64_t)0x80 << ((v & 7) << 3);
+	lane_xor_byte(sc->A, v, 0x80);
 
 	/*
 	 * Process the padded block.
 	 */
-	process_block(sc->A);
+	process_block(sc->A, sc->rounds);
 
 	/*
 	 * Write output. Output length (in bytes) is obtained from the rate.
 	 */
 	buf = out;
 	len = (200 - sc->rate) >> 1;
-	for (u = 0; u < len; u ++) {
-		buf[u] = sc->A[u >> 3] >> ((u & 7) << 3);
+	for (u = 0; u + 8 <= len; u += 8) {
+		enc64le(buf + u, lane_get(sc->A, u >> 3));
+	}
+	for (; u < len; u ++) {
+		buf[u] = lane_get_byte(sc->A, u);
+	}
+}
+
+/*
+ * Four-way SHA3. With AVX2, the four states are interleaved (lane j of
+ * state i is A[4*j+i]) and processed together, one 256-bit register
+ * per lane index. Otherwise, the states are stored one after the other
+ * (lane j of state i is A[25*i+j]) and processed with process_block().
+ */
+#if SHA3_AVX2
+
+#include <immintrin.h>
+
+#define X4(j, i)   (((j) << 2) + (i))
+#define X4_XOR_BYTE(A, v, i, b) \
+	((A)[X4((v) >> 3, i)] ^= (uint64_t)(b) << (((v) & 7) << 3))
+#define X4_GET_BYTE(A, v, i) \
+	((uint8_t)((A)[X4((v) >> 3, i)] >> (((v) & 7) << 3)))
+
+#define XOR256(x, y)   _mm256_xor_si256(x, y)
+#define ROL256(x, n)   _mm256_or_si256( \
+	_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - (n)))
+
+static void
+process_block_x4(uint64_t *st)
+{
+	__m256i A[25], B[25];
+	__m256i C0, C1, C2, C3, C4, D0, D1, D2, D3, D4;
+	int j, r;
+
+	for (j = 0; j < 25; j ++) {
+		A[j] = _mm256_loadu_si256(
+			(const __m256i *)(void *)(st + 4 * j));
+	}
+	for (r = 0; r < 24; r ++) {
+		/* theta */
+		C0 = XOR256(XOR256(A[0], A[5]),
+			XOR256(XOR256(A[10], A[15]), A[20]));
+		C1 = XOR256(XOR256(A[1], A[6]),
+			XOR256(XOR256(A[11], A[16]), A[21]));
+		C2 = XOR256(XOR256(A[2], A[7]),
+			XOR256(XOR256(A[12], A[17]), A[22]));
+		C3 = XOR256(XOR256(A[3], A[8]),
+			XOR256(XOR256(A[13], A[18]), A[23]));
+		C4 = XOR256(XOR256(A[4], A[9]),
+			XOR256(XOR256(A[14], A[19]), A[24]));
+		D0 = XOR256(C4, ROL256(C1, 1));
+		D1 = XOR256(C0, ROL256(C2, 1));
+		D2 = XOR256(C1, ROL256(C3, 1));
+		D3 = XOR256(C2, ROL256(C4, 1));
+		D4 = XOR256(C3, ROL256(C0, 1));
+
+		/* rho and pi */
+		B[ 0] = XOR256(A[ 0], D0);
+		B[10] = ROL256(XOR256(A[ 1], D1), 1);
+		B[20] = ROL256(XOR256(A[ 2], D2), 62);
+		B[ 5] = ROL256(XOR256(A[ 3], D3), 28);
+		B[15] = ROL256(XOR256(A[ 4], D4), 27);
+		B[16] = ROL256(XOR256(A[ 5], D0), 36);
+		B[ 1] = ROL256(XOR256(A[ 6], D1), 44);
+		B[11] = ROL256(XOR256(A[ 7], D2), 6);
+		B[21] = ROL256(XOR256(A[ 8], D3), 55);
+		B[ 6] = ROL256(XOR256(A[ 9], D4), 20);
+		B[ 7] = ROL256(XOR256(A[10], D0), 3);
+		B[17] = ROL256(XOR256(A[11], D1), 10);
+		B[ 2] = ROL256(XOR256(A[12], D2), 43);
+		B[12] = ROL256(XOR256(A[13], D3), 25);
+		B[22] = ROL256(XOR256(A[14], D4), 39);
+		B[23] = ROL256(XOR256(A[15], D0), 41);
+		B[ 8] = ROL256(XOR256(A[16], D1), 45);
+		B[18] = ROL256(XOR256(A[17], D2), 15);
+		B[ 3] = ROL256(XOR256(A[18], D3), 21);
+		B[13] = ROL256(XOR256(A[19], D4), 8);
+		B[14] = ROL256(XOR256(A[20], D0), 18);
+		B[24] = ROL256(XOR256(A[21], D1), 2);
+		B[ 9] = ROL256(XOR256(A[22], D2), 61);
+		B[19] = ROL256(XOR256(A[23], D3), 56);
+		B[ 4] = ROL256(XOR256(A[24], D4), 14);
+
+		/* chi */
+		A[ 0] = XOR256(B[ 0],
+			_mm256_andnot_si256(B[ 1], B[ 2]));
+		A[ 1] = XOR256(B[ 1],
+			_mm256_andnot_si256(B[ 2], B[ 3]));
+		A[ 2] = XOR256(B[ 2],
+			_mm256_andnot_si256(B[ 3], B[ 4]));
+		A[ 3] = XOR256(B[ 3],
+			_mm256_andnot_si256(B[ 4], B[ 0]));
+		A[ 4] = XOR256(B[ 4],
+			_mm256_andnot_si256(B[ 0], B[ 1]));
+		A[ 5] = XOR256(B[ 5],
+			_mm256_andnot_si256(B[ 6], B[ 7]));
+		A[ 6] = XOR256(B[ 6],
+			_mm256_andnot_si256(B[ 7], B[ 8]));
+		A[ 7] = XOR256(B[ 7],
+			_mm256_andnot_si256(B[ 8], B[ 9]));
+		A[ 8] = XOR256(B[ 8],
+			_mm256_andnot_si256(B[ 9], B[ 5]));
+		A[ 9] = XOR256(B[ 9],
+			_mm256_andnot_si256(B[ 5], B[ 6]));
+		A[10] = XOR256(B[10],
+			_mm256_andnot_si256(B[11], B[12]));
+		A[11] = XOR256(B[11],
+			_mm256_andnot_si256(B[12], B[13]));
+		A[12] = XOR256(B[12],
+			_mm256_andnot_si256(B[13], B[14]));
+		A[13] = XOR256(B[13],
+			_mm256_andnot_si256(B[14], B[10]));
+		A[14] = XOR256(B[14],
+			_mm256_andnot_si256(B[10], B[11]));
+		A[15] = XOR256(B[15],
+			_mm256_andnot_si256(B[16], B[17]));
+		A[16] = XOR256(B[16],
+			_mm256_andnot_si256(B[17], B[18]));
+		A[17] = XOR256(B[17],
+			_mm256_andnot_si256(B[18], B[19]));
+		A[18] = XOR256(B[18],
+			_mm256_andnot_si256(B[19], B[15]));
+		A[19] = XOR256(B[19],
+			_mm256_andnot_si256(B[15], B[16]));
+		A[20] = XOR256(B[20],
+			_mm256_andnot_si256(B[21], B[22]));
+		A[21] = XOR256(B[21],
+			_mm256_andnot_si256(B[22], B[23]));
+		A[22] = XOR256(B[22],
+			_mm256_andnot_si256(B[23], B[24]));
+		A[23] = XOR256(B[23],
+			_mm256_andnot_si256(B[24], B[20]));
+		A[24] = XOR256(B[24],
+			_mm256_andnot_si256(B[20], B[21]));
+
+		/* iota */
+		A[0] = XOR256(A[0],
+			_mm256_set1_epi64x((long long)RC[r]));
+	}
+	for (j = 0; j < 25; j ++) {
+		_mm256_storeu_si256((__m256i *)(void *)(st + 4 * j), A[j]);
+	}
+}
+
+#else
+
+#define X4_XOR_BYTE(A, v, i, b)   lane_xor_byte((A) + 25 * (i), v, b)
+#define X4_GET_BYTE(A, v, i)      lane_get_byte((A) + 25 * (i), v)
+
+static void
+process_block_x4(uint64_t *st)
+{
+	int i;
+
+	for (i = 0; i < 4; i ++) {
+		process_block(st + 25 * i, 24);
+	}
+}
+
+#endif
+
+/* see sha3.h */
+void
+sha3_x4_init(sha3_x4_context *sc, unsigned size)
+{
+	sc->rate = 200 - (size_t)(size >> 2);
+	sc->dptr = 0;
+	memset(sc->A, 0, sizeof sc->A);
+}
+
+/* see sha3.h */
+void
+sha3_x4_update(sha3_x4_context *sc, const void *const in[4], size_t len)
+{
+	const uint8_t *buf[4];
+	size_t dptr, rate;
+	unsigned i;
+
+	for (i = 0; i < 4; i ++) {
+		buf[i] = in[i];
+	}
+	dptr = sc->dptr;
+	rate = sc->rate;
+	while (len > 0) {
+		size_t clen, u;
+
+		clen = rate - dptr;
+		if (clen > len) {
+			clen = len;
+		}
+		for (u = 0; u < clen; u ++) {
+			size_t v;
+
+			v = u + dptr;
+			for (i = 0; i < 4; i ++) {
+				X4_XOR_BYTE(sc->A, v, i, buf[i][u]);
+			}
+		}
+		for (i = 0; i < 4; i ++) {
+			buf[i] += clen;
+		}
+		dptr += clen;
+		len -= clen;
+		if (dptr == rate) {
+			process_block_x4(sc->A);
+			dptr = 0;
+		}
+	}
+	sc->dptr = dptr;
+}
+
+/* see sha3.h */
+void
+sha3_x4_close(sha3_x4_context *sc, void *const out[4])
+{
+	size_t u, v, w, len;
+	unsigned i;
+
+	/*
+	 * Same padding as sha3_close(), for all four states.
+	 */
+	v = sc->dptr;
+	w = sc->rate - 1;
+	for (i = 0; i < 4; i ++) {
+		X4_XOR_BYTE(sc->A, v, i, 0x06);
+		X4_XOR_BYTE(sc->A, w, i, 0x80);
+	}
+	process_block_x4(sc->A);
+	len = (200 - sc->rate) >> 1;
+	for (i = 0; i < 4; i ++) {
+		uint8_t *buf;
+
+		buf = out[i];
+		for (u = 0; u < len; u ++) {
+			buf[u] = X4_GET_BYTE(sc->A, u, i);
+		}
 	}
 }
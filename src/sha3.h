@@ -18,6 +18,7 @@ extern "C" {
 typedef struct {
 	uint64_t A[25];
 	size_t dptr, rate;
+	unsigned rounds, dsbyte;
 } shake_context;
 
 /*
@@ -31,6 +32,22 @@ typedef struct {
  */
 void shake_init(shake_context *sc, unsigned size);
 
+/*
+ * Initialize a context for TurboSHAKE (RFC 9861). TurboSHAKE uses the
+ * same sponge construction as SHAKE, but with the Keccak-p[1600,n_r=12]
+ * permutation (the last 12 rounds of the 24-round Keccak-f), which
+ * makes it about twice as fast. The "size" parameter is 128 for
+ * TurboSHAKE128, 256 for TurboSHAKE256.
+ *
+ * The "dsbyte" parameter is the domain separation byte, which must be
+ * in the 0x01 to 0x7F range; 0x1F is the default value defined by
+ * RFC 9861.
+ *
+ * The context is then used with shake_inject(), shake_flip() and
+ * shake_extract(), as for SHAKE.
+ */
+void turboshake_init(shake_context *sc, unsigned size, unsigned dsbyte);
+
 /*
  * Inject some data bytes into the SHAKE context ("absorb" operation).
  * This function can be called several times, to inject several chunks
@@ -86,6 +103,41 @@ void sha3_update(sha3_context *sc, const void *in, size_t len);
  */
 void sha3_close(sha3_context *sc, void *out);
 
+/*
+ * Context for four SHA3 computations over inputs of identical length
+ * (all four inputs receive the same number of bytes); this is meant
+ * for hashing many values of identical length (e.g. Merkle tree
+ * nodes). When sha3.c is compiled with SHA3_AVX2 (the default if AVX2
+ * is available), the four Keccak states are interleaved and the
+ * permutation is computed on all of them at once. Otherwise, the states
+ * are stored one after the other and permuted one at a time, which is
+ * no faster than four separate sha3_context computations. Contents are
+ * opaque.
+ */
+typedef struct {
+	uint64_t A[100];
+	size_t dptr, rate;
+} sha3_x4_context;
+
+/*
+ * Initialize a four-way SHA3 context, for a given output size (in bits),
+ * as with sha3_init().
+ */
+void sha3_x4_init(sha3_x4_context *sc, unsigned size);
+
+/*
+ * Update a four-way SHA3 context: len bytes from in[i] are injected
+ * into state i, for i = 0 to 3.
+ */
+void sha3_x4_update(sha3_x4_context *sc, const void *const in[4], size_t len);
+
+/*
+ * Finalize a four-way SHA3 computation: hash output i is written in
+ * out[i]. As with sha3_close(), the context must be reinitialized
+ * before computing new hashes.
+ */
+void sha3_x4_close(sha3_x4_context *sc, void *const out[4]);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,269 @@
+@ =======================================================================
+@ Keccak-p[1600] permutation for ARM Cortex-M0/M0+, with bit-interleaved
+@ lanes (see sha3.c).
+@ =======================================================================
+
+	.syntax	unified
+	.cpu	cortex-m0
+	.file	"sha3_cm0.s"
+	.text
+
+@ =======================================================================
+
+@ One half (even words if off = 0, odd words if off = 4) of the chi step
+@ on a row: the five words are read from B (r1) and written in the
+@ state (r0), at offsets off, off+8, ..., off+32.
+@   out[k] = b[k] ^ (~b[k+1] & b[k+2])
+@ r2..r7 are scratch.
+@ Cost: 30
+.macro CHI_HALF  off
+	ldr	r2, [r1, #(\off)]
+	ldr	r3, [r1, #((\off) + 8)]
+	ldr	r4, [r1, #((\off) + 16)]
+	ldr	r5, [r1, #((\off) + 24)]
+	ldr	r6, [r1, #((\off) + 32)]
+	movs	r7, r4
+	bics	r7, r3
+	eors	r7, r2
+	str	r7, [r0, #(\off)]
+	movs	r7, r5
+	bics	r7, r4
+	eors	r7, r3
+	str	r7, [r0, #((\off) + 8)]
+	movs	r7, r6
+	bics	r7, r5
+	eors	r7, r4
+	str	r7, [r0, #((\off) + 16)]
+	movs	r7, r2
+	bics	r7, r6
+	eors	r7, r5
+	str	r7, [r0, #((\off) + 24)]
+	movs	r7, r3
+	bics	r7, r2
+	eors	r7, r6
+	str	r7, [r0, #((\off) + 32)]
+.endm
+
+@ Compute the theta value D[x] (even and odd words) from the column
+@ parities C (on the stack at offset 200) and store it on the stack
+@ at offset 240. r6 must contain 31 (rotation count).
+@   D_e[x] = C_e[x-1] ^ rotl(C_o[x+1], 1)
+@   D_o[x] = C_o[x-1] ^ C_e[x+1]
+@ Cost: 14
+.macro THETA_D  x, xm, xp
+	ldr	r2, [sp, #(200 + 8 * (\xm))]
+	ldr	r3, [sp, #(204 + 8 * (\xp))]
+	rors	r3, r6
+	eors	r2, r3
+	str	r2, [sp, #(240 + 8 * (\x))]
+	ldr	r2, [sp, #(204 + 8 * (\xm))]
+	ldr	r3, [sp, #(200 + 8 * (\xp))]
+	eors	r2, r3
+	str	r2, [sp, #(244 + 8 * (\x))]
+.endm
+
+@ =======================================================================
+@ void sha3_process_block_cm0(uint64_t *A, unsigned nr)
+@
+@ Apply the last nr rounds (1 <= nr <= 24) of Keccak-f[1600] on the
+@ state A. Each lane is bit-interleaved: 32-bit word 2*j contains the
+@ even-indexed bits of lane j, and word 2*j+1 contains the odd-indexed
+@ bits.
+@
+@ Stack layout (280 bytes):
+@   0     B[50]   output of rho and pi
+@   200   C[10]   column parities
+@   240   D[10]   theta values
+@ The state address is kept in r8, the round index (24-nr to 23) in r9,
+@ and the chi row counter in r10.
+@ =======================================================================
+
+	.align	1
+	.global	sha3_process_block_cm0
+	.thumb
+	.thumb_func
+	.type	sha3_process_block_cm0, %function
+sha3_process_block_cm0:
+	push	{ r4, r5, r6, r7, lr }
+	mov	r4, r8
+	mov	r5, r9
+	mov	r6, r10
+	push	{ r4, r5, r6 }
+	sub	sp, #280
+	mov	r8, r0
+	movs	r2, #24
+	subs	r2, r1
+	mov	r9, r2
+
+.Lsha3_round:
+	@ Theta: column parities C[j] = S[j] ^ S[j+10] ^ ... ^ S[j+40].
+	mov	r0, r8
+	add	r1, sp, #200
+	movs	r7, #10
+.Lsha3_theta1:
+	ldr	r2, [r0, #0]
+	ldr	r3, [r0, #40]
+	eors	r2, r3
+	ldr	r3, [r0, #80]
+	eors	r2, r3
+	ldr	r3, [r0, #120]
+	eors	r2, r3
+	adds	r0, #160
+	ldr	r3, [r0, #0]
+	eors	r2, r3
+	subs	r0, #156
+	stm	r1!, { r2 }
+	subs	r7, #1
+	bne	.Lsha3_theta1
+
+	@ Theta: D values.
+	movs	r6, #31
+	THETA_D  0, 4, 1
+	THETA_D  1, 0, 2
+	THETA_D  2, 1, 3
+	THETA_D  3, 2, 4
+	THETA_D  4, 3, 0
+
+	@ Theta: S[j + 10*y] ^= D[j].
+	mov	r0, r8
+	add	r1, sp, #240
+	movs	r7, #10
+.Lsha3_theta2:
+	ldm	r1!, { r2 }
+	ldr	r3, [r0, #0]
+	eors	r3, r2
+	str	r3, [r0, #0]
+	ldr	r3, [r0, #40]
+	eors	r3, r2
+	str	r3, [r0, #40]
+	ldr	r3, [r0, #80]
+	eors	r3, r2
+	str	r3, [r0, #80]
+	ldr	r3, [r0, #120]
+	eors	r3, r2
+	str	r3, [r0, #120]
+	adds	r0, #160
+	ldr	r3, [r0, #0]
+	eors	r3, r2
+	str	r3, [r0, #0]
+	subs	r0, #156
+	subs	r7, #1
+	bne	.Lsha3_theta2
+
+	@ Rho and pi: B[d] = ror(S[src], rot), from the table.
+	mov	r0, r8
+	mov	r1, sp
+	adr	r2, .Lsha3_rhopi
+	movs	r7, #50
+.Lsha3_rhopi_loop:
+	ldrb	r3, [r2, #0]
+	ldrb	r4, [r2, #1]
+	adds	r2, #2
+	ldr	r3, [r0, r3]
+	rors	r3, r4
+	stm	r1!, { r3 }
+	subs	r7, #1
+	bne	.Lsha3_rhopi_loop
+
+	@ Chi: five rows, both halves of each row.
+	mov	r0, r8
+	mov	r1, sp
+	movs	r7, #5
+	mov	r10, r7
+.Lsha3_chi:
+	CHI_HALF  0
+	CHI_HALF  4
+	adds	r0, #40
+	adds	r1, #40
+	mov	r7, r10
+	subs	r7, #1
+	mov	r10, r7
+	bne	.Lsha3_chi
+
+	@ Iota: XOR the round constant into lane 0.
+	adr	r2, .Lsha3_rc
+	mov	r3, r9
+	lsls	r3, r3, #3
+	adds	r2, r3
+	ldr	r3, [r2, #0]
+	ldr	r4, [r2, #4]
+	mov	r0, r8
+	ldr	r5, [r0, #0]
+	eors	r5, r3
+	str	r5, [r0, #0]
+	ldr	r5, [r0, #4]
+	eors	r5, r4
+	str	r5, [r0, #4]
+
+	@ Next round (the loop is too large for a conditional branch).
+	mov	r3, r9
+	adds	r3, #1
+	mov	r9, r3
+	cmp	r3, #24
+	beq	.Lsha3_done
+	b	.Lsha3_round
+.Lsha3_done:
+
+	add	sp, #280
+	pop	{ r4, r5, r6 }
+	mov	r8, r4
+	mov	r9, r5
+	mov	r10, r6
+	pop	{ r4, r5, r6, r7, pc }
+
+	.align	2
+.Lsha3_rc:
+	@ Round constants (even word, odd word).
+	.long	0x00000001, 0x00000000
+	.long	0x00000000, 0x00000089
+	.long	0x00000000, 0x8000008B
+	.long	0x00000000, 0x80008080
+	.long	0x00000001, 0x0000008B
+	.long	0x00000001, 0x00008000
+	.long	0x00000001, 0x80008088
+	.long	0x00000001, 0x80000082
+	.long	0x00000000, 0x0000000B
+	.long	0x00000000, 0x0000000A
+	.long	0x00000001, 0x00008082
+	.long	0x00000000, 0x00008003
+	.long	0x00000001, 0x0000808B
+	.long	0x00000001, 0x8000000B
+	.long	0x00000001, 0x8000008A
+	.long	0x00000001, 0x80000081
+	.long	0x00000000, 0x80000081
+	.long	0x00000000, 0x80000008
+	.long	0x00000000, 0x00000083
+	.long	0x00000000, 0x80008003
+	.long	0x00000001, 0x80008088
+	.long	0x00000000, 0x80000088
+	.long	0x00000001, 0x00008000
+	.long	0x00000000, 0x80008082
+.Lsha3_rhopi:
+	@ Rho and pi: for each output word, source offset (bytes) and right
+	@ rotation count.
+	.byte	  0,  0,   4,  0   @ lane 0
+	.byte	 48, 10,  52, 10   @ lane 1
+	.byte	100, 10,  96, 11   @ lane 2
+	.byte	148, 21, 144, 22   @ lane 3
+	.byte	192, 25, 196, 25   @ lane 4
+	.byte	 24, 18,  28, 18   @ lane 5
+	.byte	 72, 22,  76, 22   @ lane 6
+	.byte	 84, 30,  80, 31   @ lane 7
+	.byte	132,  9, 128, 10   @ lane 8
+	.byte	180,  1, 176,  2   @ lane 9
+	.byte	 12, 31,   8,  0   @ lane 10
+	.byte	 56, 29,  60, 29   @ lane 11
+	.byte	108, 19, 104, 20   @ lane 12
+	.byte	152, 28, 156, 28   @ lane 13
+	.byte	160, 23, 164, 23   @ lane 14
+	.byte	 36, 18,  32, 19   @ lane 15
+	.byte	 40, 14,  44, 14   @ lane 16
+	.byte	 88, 27,  92, 27   @ lane 17
+	.byte	140, 24, 136, 25   @ lane 18
+	.byte	184,  4, 188,  4   @ lane 19
+	.byte	 16,  1,  20,  1   @ lane 20
+	.byte	 68,  4,  64,  5   @ lane 21
+	.byte	116, 12, 112, 13   @ lane 22
+	.byte	124, 11, 120, 12   @ lane 23
+	.byte	168, 31, 172, 31   @ lane 24
+	.size	sha3_process_block_cm0, .-sha3_process_block_cm0
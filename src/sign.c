@@ -1,7 +1,7 @@
 #include "inner.h"
 
-#define DOM_SIGN_K   "curve9767-sign-k:"
-#define DOM_SIGN_E   "curve9767-sign-e:"
+#define DOM_SIGN_K   CURVE9767_DOM("sign-k:")
+#define DOM_SIGN_E   CURVE9767_DOM("sign-e:")
 
 static void
 make_k(curve9767_scalar *k, const uint8_t t[32],
@@ -10,7 +10,7 @@ make_k(curve9767_scalar *k, const uint8_t t[32],
 	shake_context sc;
 	uint8_t tmp[64];
 
-	shake_init(&sc, 256);
+	curve9767_inner_kdf_init(&sc);
 	shake_inject(&sc, DOM_SIGN_K, strlen(DOM_SIGN_K));
 	shake_inject(&sc, t, 32);
 	shake_inject(&sc, hash_oid, strlen(hash_oid));
@@ -23,18 +23,19 @@ make_k(curve9767_scalar *k, const uint8_t t[32],
 		curve9767_scalar_is_zero(k));
 }
 
-static void
-make_e(curve9767_scalar *e, const uint8_t c[32], const curve9767_point *Q,
+/* see inner.h */
+void
+curve9767_inner_sign_challenge(curve9767_scalar *e,
+	const uint8_t *c, const uint8_t *encoded_Q,
 	const char *hash_oid, const void *hv, size_t hv_len)
 {
 	shake_context sc;
 	uint8_t tmp[64];
 
-	shake_init(&sc, 256);
+	curve9767_inner_kdf_init(&sc);
 	shake_inject(&sc, DOM_SIGN_E, strlen(DOM_SIGN_E));
 	shake_inject(&sc, c, 32);
-	curve9767_point_encode(tmp, Q);
-	shake_inject(&sc, tmp, 32);
+	shake_inject(&sc, encoded_Q, 32);
 	shake_inject(&sc, hash_oid, strlen(hash_oid));
 	shake_inject(&sc, ":", 1);
 	shake_inject(&sc, hv, hv_len);
@@ -43,11 +44,12 @@ make_e(curve9767_scalar *e, const uint8_t c[32], const curve9767_point *Q,
 	curve9767_scalar_decode_reduce(e, tmp, 64);
 }
 
-/* see curve9767.h */
-void
-curve9767_sign_generate(void *sig,
-	const curve9767_scalar *s, const uint8_t t[32],
-	const curve9767_point *Q,
+/*
+ * Signature generation, with the encoded public key.
+ */
+static void
+do_sign(void *sig, const curve9767_scalar *s, const uint8_t t[32],
+	const uint8_t *encoded_Q,
 	const char *hash_oid, const void *hv, size_t hv_len)
 {
 	curve9767_scalar k, e;
@@ -57,7 +59,7 @@ curve9767_sign_generate(void *sig,
 	make_k(&k, t, hash_oid, hv, hv_len);
 	curve9767_point_mulgen(&C, &k);
 	curve9767_point_encode(tmp, &C);
-	make_e(&e, tmp, Q, hash_oid, hv, hv_len);
+	curve9767_inner_sign_challenge(&e, tmp, encoded_Q, hash_oid, hv, hv_len);
 	curve9767_scalar_mul(&e, &e, s);
 	curve9767_scalar_add(&e, &e, &k);
 	curve9767_scalar_encode(tmp + 32, &e);
@@ -65,27 +67,123 @@ curve9767_sign_generate(void *sig,
 }
 
 /* see curve9767.h */
-int
-curve9767_sign_verify(const void *sig,
+void
+curve9767_sign_generate(void *sig,
+	const curve9767_scalar *s, const uint8_t t[32],
 	const curve9767_point *Q,
 	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	uint8_t eQ[32];
+
+	curve9767_point_encode(eQ, Q);
+	do_sign(sig, s, t, eQ, hash_oid, hv, hv_len);
+}
+
+/* see curve9767.h */
+void
+curve9767_sign_verify_start(curve9767_verify_context *vc,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len)
 {
 	curve9767_scalar d, e;
-	curve9767_point C;
-	uint32_t r, w;
 	const uint8_t *buf;
-	uint8_t tmp[32];
-	int i;
+	uint8_t eQ[32];
 
+	/*
+	 * The verification computes C = d*G - e*Q, and compares its
+	 * encoding with the first half of the signature.
+	 */
 	buf = sig;
-	r = curve9767_scalar_decode_strict(&d, buf + 32, 32);
-	make_e(&e, buf, Q, hash_oid, hv, hv_len);
+	vc->r = curve9767_scalar_decode_strict(&d, buf + 32, 32);
+	memcpy(vc->c, buf, 32);
+	curve9767_point_encode(eQ, Q);
+	curve9767_inner_sign_challenge(&e, buf, eQ, hash_oid, hv, hv_len);
 	curve9767_scalar_neg(&e, &e);
-	curve9767_point_mul_mulgen_add(&C, Q, &e, &d);
-	curve9767_point_encode(tmp, &C);
+	curve9767_point_mul_mulgen_add_start(&vc->mc, Q, &e, &d);
+}
+
+/* see curve9767.h */
+unsigned
+curve9767_sign_verify_step(curve9767_verify_context *vc, unsigned budget)
+{
+	return curve9767_point_mul_step(&vc->mc, budget);
+}
+
+/*
+ * Compare the encoding of C with the first half of the signature (c);
+ * r is 1 if the second half was successfully decoded, 0 otherwise.
+ */
+static int
+check_c(const curve9767_point *C, const uint8_t *c, uint32_t r)
+{
+	uint32_t w;
+	uint8_t tmp[32];
+	int i;
+
+	curve9767_point_encode(tmp, C);
 	w = 0;
 	for (i = 0; i < 32; i ++) {
-		w |= tmp[i] ^ buf[i];
+		w |= tmp[i] ^ c[i];
 	}
 	return r & ((w - 1) >> 31);
 }
+
+/* see curve9767.h */
+int
+curve9767_sign_verify_finish(curve9767_verify_context *vc)
+{
+	curve9767_point C;
+
+	curve9767_point_mul_finish(&C, &vc->mc);
+	return check_c(&C, vc->c, vc->r);
+}
+
+/* see curve9767.h */
+int
+curve9767_sign_verify(const void *sig,
+	const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	curve9767_verify_context vc;
+
+	curve9767_sign_verify_start(&vc, sig, Q, hash_oid, hv, hv_len);
+	return curve9767_sign_verify_finish(&vc);
+}
+
+/* see curve9767.h */
+int
+curve9767_sign_generate_precomp(void *sig, const curve9767_precomp *pc,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	curve9767_scalar s;
+
+	if (!(pc->flags & CURVE9767_PRECOMP_SECRET)) {
+		return 0;
+	}
+	curve9767_scalar_decode_strict(&s, pc->encoded_s, 32);
+	do_sign(sig, &s, pc->t, pc->encoded_Q, hash_oid, hv, hv_len);
+	return 1;
+}
+
+/* see curve9767.h */
+int
+curve9767_sign_verify_precomp(const void *sig,
+	const curve9767_precomp *pc,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	curve9767_scalar d, e;
+	curve9767_point C;
+	const uint8_t *buf;
+	uint32_t r;
+
+	/*
+	 * Same computation as curve9767_sign_verify_start(), but the
+	 * multiplication uses the precomputed windows for Q.
+	 */
+	buf = sig;
+	r = curve9767_scalar_decode_strict(&d, buf + 32, 32);
+	curve9767_inner_sign_challenge(&e, buf, pc->encoded_Q, hash_oid, hv, hv_len);
+	curve9767_scalar_neg(&e, &e);
+	curve9767_point_mul_precomp_mulgen_add(&C, pc, &e, &d);
+	return check_c(&C, buf, r);
+}
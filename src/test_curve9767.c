@@ -151,6 +151,68 @@ test_SHAKE(void)
 	fflush(stdout);
 }
 
+static void
+test_TurboSHAKE_KAT(unsigned size, unsigned dsbyte,
+	const uint8_t *src, size_t ilen, const char *hexout)
+{
+	uint8_t ref[300], tmp[300];
+	size_t olen, u;
+	shake_context sc;
+
+	olen = hextobin(ref, sizeof ref, hexout);
+	turboshake_init(&sc, size, dsbyte);
+	shake_inject(&sc, src, ilen);
+	shake_flip(&sc);
+	shake_extract(&sc, tmp, olen);
+	check_equals(ref, tmp, olen, "TurboSHAKE KAT 1");
+
+	memset(tmp, 0, sizeof tmp);
+	turboshake_init(&sc, size, dsbyte);
+	for (u = 0; u < ilen; u ++) {
+		shake_inject(&sc, src + u, 1);
+	}
+	shake_flip(&sc);
+	for (u = 0; u < olen; u ++) {
+		shake_extract(&sc, tmp + u, 1);
+	}
+	check_equals(ref, tmp, olen, "TurboSHAKE KAT 2");
+
+	printf(".");
+	fflush(stdout);
+}
+
+/*
+ * TurboSHAKE test vectors from RFC 9861. Input messages are
+ * ptn(n) (repetition of the bytes 0x00 to 0xFA, truncated to n bytes),
+ * except for the last one (three bytes of value 0xFF).
+ */
+static void
+test_TurboSHAKE(void)
+{
+	static uint8_t ptn[4913];
+	static const uint8_t ff3[] = { 0xFF, 0xFF, 0xFF };
+	size_t u;
+
+	printf("Test TurboSHAKE: ");
+	fflush(stdout);
+
+	for (u = 0; u < sizeof ptn; u ++) {
+		ptn[u] = (uint8_t)(u % 251);
+	}
+
+	test_TurboSHAKE_KAT(128, 0x1F, ptn, 0, "1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c");
+	test_TurboSHAKE_KAT(128, 0x1F, ptn, 17, "9c97d036a3bac819db70ede0ca554ec6e4c2a1a4ffbfd9ec269ca6a111161233");
+	test_TurboSHAKE_KAT(128, 0x1F, ptn, 4913, "d4976eb56bcf118520582b709f73e1d6853e001fdaf80e1b13e0d0599d5fb372");
+	test_TurboSHAKE_KAT(128, 0x01, ff3, sizeof ff3, "bf323f940494e88ee1c540fe660be8a0c93f43d15ec006998462fa994eed5dab");
+
+	test_TurboSHAKE_KAT(256, 0x1F, ptn, 0, "367a329dafea871c7802ec67f905ae13c57695dc2c6663c61035f59a18f8e7db11edc0e12e91ea60eb6b32df06dd7f002fbafabb6e13ec1cc20d995547600db0");
+	test_TurboSHAKE_KAT(256, 0x1F, ptn, 17, "b3bab0300e6a191fbe6137939835923578794ea54843f5011090fa2f3780a9e5cb22c59d78b40a0fbff9e672c0fbe0970bd2c845091c6044d687054da5d8e9c7");
+	test_TurboSHAKE_KAT(256, 0x1F, ptn, 4913, "c74ebc919a5b3b0dd1228185ba02d29ef442d69d3d4276a93efe0bf9a16a7dc0cd4eabadab8cd7a5edd96695f5d360abe09e2c6511a3ec397da3b76b9e1674fb");
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
 /*
  * SHA3 test vectors from:
  *    https://csrc.nist.gov/Projects/cryptographic-algorithm-validation-program/Secure-Hashing
@@ -1573,7 +1635,7 @@ static void
 test_SHA3(void)
 {
 	const char *const *s;
-	size_t old_len;
+	size_t old_len, len;
 
 	printf("Test SHA3: ");
 	fflush(stdout);
@@ -1622,6 +1684,50 @@ test_SHA3(void)
 		fflush(stdout);
 	}
 
+	/*
+	 * Four-way SHA3 must match SHA3 on each input (inputs are
+	 * injected in two chunks).
+	 */
+	printf(" ");
+	fflush(stdout);
+	for (len = 0; len < 300; len += 13) {
+		static const unsigned sizes[] = { 224, 256, 384, 512 };
+		uint8_t in[4][300], out[4][64], tmp[64];
+		const void *ip[4];
+		void *op[4];
+		sha3_x4_context sx;
+		unsigned size;
+		size_t u, h;
+		int i;
+
+		size = sizes[(len / 13) & 3];
+		for (i = 0; i < 4; i ++) {
+			for (u = 0; u < len; u ++) {
+				in[i][u] = (uint8_t)(i * 101 + u * 7);
+			}
+			ip[i] = in[i];
+			op[i] = out[i];
+		}
+		h = len >> 1;
+		sha3_x4_init(&sx, size);
+		sha3_x4_update(&sx, ip, h);
+		for (i = 0; i < 4; i ++) {
+			ip[i] = in[i] + h;
+		}
+		sha3_x4_update(&sx, ip, len - h);
+		sha3_x4_close(&sx, op);
+		for (i = 0; i < 4; i ++) {
+			sha3_context sc;
+
+			sha3_init(&sc, size);
+			sha3_update(&sc, in[i], len);
+			sha3_close(&sc, tmp);
+			check_equals(tmp, out[i], size >> 3, "SHA3 x4");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
 	printf(" done.\n");
 	fflush(stdout);
 }
@@ -2454,11 +2560,69 @@ test_scalar(void)
 		curve9767_scalar_mul(&a3, &a1, &a2);
 		curve9767_scalar_encode(tmp, &a3);
 		check_equals(tmp, b1t2, 32, "Sub");
+		curve9767_scalar_inv(&a3, &a1);
+		curve9767_scalar_mul(&a3, &a3, &a1);
+		if (!curve9767_scalar_eq(&a3, &curve9767_scalar_one)) {
+			fprintf(stderr, "Inv\n");
+			exit(EXIT_FAILURE);
+		}
 
 		printf(".");
 		fflush(stdout);
 	}
 
+	curve9767_scalar_inv(&a3, &curve9767_scalar_zero);
+	if (!curve9767_scalar_is_zero(&a3)) {
+		fprintf(stderr, "Inv (zero)\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_scalar_inv(&a3, &curve9767_scalar_one);
+	if (!curve9767_scalar_eq(&a3, &curve9767_scalar_one)) {
+		fprintf(stderr, "Inv (one)\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Batch operations must match the one-scalar functions, for all
+	 * counts modulo 4 (including in-place operation).
+	 */
+	for (u = 0; u <= 9; u ++) {
+		curve9767_scalar ba[9], bb[9], bc[9], bd[9];
+		uint8_t src[9 * 96];
+		size_t v, len;
+
+		for (v = 0; v < sizeof src; v ++) {
+			src[v] = (uint8_t)(v * 29 + u * 7 + (v >> 5));
+		}
+		for (len = 20; len <= 96; len += 76) {
+			curve9767_scalar_decode_reduce_batch(ba, src, len, u);
+			for (v = 0; v < u; v ++) {
+				curve9767_scalar_decode_reduce(&a1,
+					src + v * len, len);
+				if (!curve9767_scalar_eq(&a1, &ba[v])) {
+					fprintf(stderr, "Decode (batch)\n");
+					exit(EXIT_FAILURE);
+				}
+			}
+		}
+		curve9767_scalar_decode_reduce_batch(bb, src + 5, 64, u);
+		curve9767_scalar_mul_batch(bc, ba, bb, u);
+		memcpy(bd, ba, sizeof ba);
+		curve9767_scalar_add_batch(bd, bd, bb, u);
+		for (v = 0; v < u; v ++) {
+			curve9767_scalar_mul(&a3, &ba[v], &bb[v]);
+			if (!curve9767_scalar_eq(&a3, &bc[v])) {
+				fprintf(stderr, "Mul (batch)\n");
+				exit(EXIT_FAILURE);
+			}
+			curve9767_scalar_add(&a3, &ba[v], &bb[v]);
+			if (!curve9767_scalar_eq(&a3, &bd[v])) {
+				fprintf(stderr, "Add (batch)\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
 	printf(" done.\n");
 	fflush(stdout);
 }
@@ -2741,6 +2905,7 @@ static void
 test_map_to_base(void)
 {
 	const char *const *s;
+	int i;
 
 	printf("Test map_to_base: ");
 	fflush(stdout);
@@ -2762,6 +2927,67 @@ test_map_to_base(void)
 		fflush(stdout);
 	}
 
+	/*
+	 * The batch function must match the single-input function, for
+	 * all batch sizes (including partial groups). Inputs include
+	 * edge values: 0, 2^384-1, and k*p^10 + d for small k and d
+	 * (single-input implementations may split at p^10).
+	 */
+	for (i = 0; i < 4; i ++) {
+		static const size_t nums[] = { 1, 7, 9, 20 };
+		uint8_t buf[20 * 48];
+		field_element cb[20], c;
+		shake_context sc;
+		size_t num, u;
+
+		num = nums[i];
+		shake_init(&sc, 256);
+		shake_inject(&sc, "map_to_base", 11);
+		shake_inject(&sc, &num, 1);
+		shake_flip(&sc);
+		shake_extract(&sc, buf, num * 48);
+		if (num == 20) {
+			memset(buf, 0x00, 48);
+			memset(buf + 48, 0xFF, 48);
+			for (u = 2; u < num; u ++) {
+				uint32_t t[24], cc;
+				int j, k;
+
+				/*
+				 * t = p^10 * (u/3) + ((u%3) - 1) (mod 2^384)
+				 */
+				memset(t, 0, sizeof t);
+				t[0] = (uint32_t)(u / 3);
+				for (k = 0; k < 10; k ++) {
+					cc = 0;
+					for (j = 0; j < 24; j ++) {
+						cc += t[j] * 9767;
+						t[j] = cc & 0xFFFF;
+						cc >>= 16;
+					}
+				}
+				cc = (uint32_t)(u % 3) + 0xFFFF;
+				for (j = 0; j < 24; j ++) {
+					cc += t[j];
+					t[j] = cc & 0xFFFF;
+					cc = (cc >> 16) + 0xFFFF;
+				}
+				for (j = 0; j < 24; j ++) {
+					buf[48 * u + 2 * j] = (uint8_t)t[j];
+					buf[48 * u + 2 * j + 1] =
+						(uint8_t)(t[j] >> 8);
+				}
+			}
+		}
+		curve9767_inner_gf_map_to_base_batch(cb, buf, num);
+		for (u = 0; u < num; u ++) {
+			curve9767_inner_gf_map_to_base(c.v, buf + 48 * u);
+			check_equals(cb[u].v, c.v, 38, "map batch");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
 	printf(" done.\n");
 	fflush(stdout);
 }
@@ -3098,6 +3324,71 @@ test_Icart_map(void)
 		fflush(stdout);
 	}
 
+	/*
+	 * Two maps and addition: compare with the separate computation,
+	 * including the special cases (neutral inputs, doubling, and
+	 * opposite points, since -u maps to the opposite of the image
+	 * of u).
+	 */
+	s = KAT_ICART_MAP;
+	while (*s != NULL) {
+		uint8_t bu[32], bb1[32], bb2[32];
+		curve9767_point Q1, Q2, Q3;
+		field_element u[2], v;
+		int i;
+
+		HEXTOBIN(bu, s[0]);
+		curve9767_inner_gf_decode(u[0].v, bu);
+		if (s[2] != NULL) {
+			HEXTOBIN(bu, s[2]);
+			curve9767_inner_gf_decode(u[1].v, bu);
+		} else {
+			u[1] = u[0];
+		}
+		s += 2;
+		for (i = 0; i < 6; i ++) {
+			const uint16_t *a1, *a2;
+
+			a1 = u[0].v;
+			switch (i) {
+			case 0:
+				a2 = u[1].v;
+				break;
+			case 1:
+				a2 = u[0].v;
+				break;
+			case 2:
+				curve9767_inner_gf_neg(v.v, u[0].v);
+				a2 = v.v;
+				break;
+			case 3:
+				a2 = curve9767_inner_gf_zero.v;
+				break;
+			case 4:
+				a1 = curve9767_inner_gf_zero.v;
+				a2 = u[0].v;
+				break;
+			default:
+				a1 = curve9767_inner_gf_zero.v;
+				a2 = curve9767_inner_gf_zero.v;
+				break;
+			}
+			curve9767_inner_Icart_map(&Q1, a1);
+			curve9767_inner_Icart_map(&Q2, a2);
+			curve9767_point_add(&Q1, &Q1, &Q2);
+			curve9767_inner_Icart_map2(&Q3, a1, a2);
+			if (curve9767_point_encode(bb1, &Q1)
+				!= curve9767_point_encode(bb2, &Q3))
+			{
+				fprintf(stderr, "Icart_map2: wrong neutral\n");
+				exit(EXIT_FAILURE);
+			}
+			check_equals(bb1, bb2, 32, "Icart_map2");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
 	printf(" done.\n");
 	fflush(stdout);
 }
@@ -3524,6 +3815,54 @@ test_combined(void)
 	fflush(stdout);
 }
 
+#if CURVE9767_TURBOSHAKE
+
+static const char *const KAT_ECDH[] = {
+	/*
+	 * ECDH tests, TurboSHAKE profile (CURVE9767_TURBOSHAKE).
+	 *
+	 * Same format as the default profile tests below (the seeds,
+	 * peer points and invalid points are the same as the first
+	 * four default profile tests).
+	 */
+
+	"43afb574385a2d2ecf77bd922bc38f61da62aea07dfc7e4bc8cce6fec12b5624",
+	"6b2c7aa822240398147304b4427536ece79282a7a13464f218c0d76936b2fd09",
+	"986277c0d2f75550be695df095a26bbb344958c64f1c7a32dbe6dbb6d616fd0d",
+	"f81e3e6214db544e0b7f05120bf238b1898e67ade16b174ca73b7c229d890b18",
+	"77d7234c811964b7e56f212e0a3058b92de92a6db70b59a766c1233d863f97cb",
+	"003a5a1e43417de4575365aeec7aae1c73ab950653936f1dd019b99fae762f59",
+	"e42eb785b7270baa61d7c28f38a98411b326187d034de911fc6d1855b4c3ea1b",
+
+	"bba83405f9dbe29e10859354c7c503ee5a7a05bb41397dd5e7cc8d490dc4cdbd",
+	"1f653793d1a631ca6d666ea55b17bec61fc8c3294af011190be56977bc665009",
+	"a0bc5385dfde4ebb4099b744252403cb129ac79b6b73db097e2213907732c80c",
+	"90bedcddc8431e0471c3d466ef2982acf0192fb7f725a8a4a582c77fd1b91a62",
+	"a7164a7f3cb77556a75a633cb1fc712f292f1385c1b07eae27409697e003a84b",
+	"93e81711d5add6eb457a06068bedaadea160463afc78e74f81213ad88b942713",
+	"7cd05cfed5846ee304eac03593da3309184bdeaf2d420f57d96beeaad252d201",
+
+	"550ed8c961f036b9ab67545f61b5c7471ab53e9eae0816e1cbe8110a1f430e2d",
+	"935ebee8426dbc1884bca73f26d03012ae45b1ae2efa3b7994828951e6fb6b02",
+	"3e2bc419a19f98da2b9b63473d5c375d3556158fe212ecbe0917c0cc26becb1b",
+	"414a8ce61f61d188b7a767edcd77788c513f0c65d3408ae85009100f7aa9a540",
+	"f712e45068de075a260d6724a13a57367dc22b506a32bff220f7795d7c2cf8df",
+	"3a1c5448c66a5942801815c0c7361d94fd4c3b3648a1f72a3ba54f4388adab61",
+	"e3e4233a1d5010141808a53a3a0355bc480d447a303ca9745e48ce858fdd4d74",
+
+	"42f5d965e5d2d48d9bb77caa61534885f1da3e70c109e8cb4f5fb5090c05299e",
+	"4f38abb72d3d4bc8fe391af6691184aee1872c6c80c7d4250745318c1f154907",
+	"ac4506fd5ef3040520d4e39c82295d5c64823aa3c3f459bb9214794f4804331c",
+	"8fc756f5930e51415952e67d65fbf2d314d4196f477b14826c0eca9975b3ed12",
+	"650fbb84fa6973af2e8f9872dad244c90c3924b3bb33109c801d0c00337ba3c4",
+	"6679bf0e0288768e138616b0285bb20680483fb2af32e005621b353217659262",
+	"07ccd786429ca8755d77aa58a9868422bbeb21f99267d53fbd8ce9d4f53f6497",
+
+	NULL
+};
+
+#else
+
 static const char *const KAT_ECDH[] = {
 	/*
 	 * ECDH tests.
@@ -3698,6 +4037,8 @@ static const char *const KAT_ECDH[] = {
 	NULL
 };
 
+#endif
+
 static void
 test_ECDH(void)
 {
@@ -3747,6 +4088,50 @@ test_ECDH(void)
 	fflush(stdout);
 }
 
+#if CURVE9767_TURBOSHAKE
+
+static const char *const KAT_SIGN[] = {
+	/*
+	 * Signature tests, TurboSHAKE profile (CURVE9767_TURBOSHAKE).
+	 *
+	 * Same format as the default profile tests below (the seeds and
+	 * messages are the same as the first four default profile
+	 * tests).
+	 */
+
+	"19c2a735ab9eb0d43466ca3b5318d17fd4c5af508191916812e45ad0b9a5d407",
+	"b510f7efb5d3967f78874afedb4697b161ab22ec5b4cfef0880365e1f4c38107",
+	"efa3384d647f296e401edc8caab0ce7ef82b7021ee73744e0b7f795833c01324",
+	"5f698f093ace06b2384903b18549a4c216681eb7385843081498b4c2cf9ba90c",
+	"curve9767-test9:000",
+	"3cde742e386d7f8497969a6999de25ab047fa10d2fc49f7617b68537d0b078639bd46d9b5211efa7ea22911435d607f059297103fea92478c239f7813802d800",
+
+	"710827b9e5848b628f007ccd05877d261ee80e99b7be858e8291812be1bd345a",
+	"463320992f2ed1f4dca096847888e3f03db4f125b4776c571b22627e9a6ad801",
+	"90ac199f4aaf3c7aa24c2d47b86b1320e304bd9d71d91ae8afdb2966d1cc4db7",
+	"5c455a46b3050245a7c0e32460a61778339bed7bb7a6914d7c988a8e9058244d",
+	"curve9767-test9:001",
+	"18d3d5f446798a07fcb57b0513a612ee1b74bc0968bb115fbc8a9351b54f11124760518e63331fd6b0614e6a6954d3dbfec57f8e3c3f96b804bf11eecb679009",
+
+	"d2298ec52f799dfc01eb7fb14ca9f55e8c2fc8290b16a5c4bf97d782ac7d2d0b",
+	"3ed3e9dfb41a3abdc8a631209848b8ce6db4ddeafa6a6e7751b06b72a47c5e07",
+	"012481129fbf7e9b582bee652458b1fc5e12bbd64c16aac61ca1b7817141c398",
+	"125e8945826962250b2b511604f34a30530d47b2601d85b143ead19cd0c3f848",
+	"curve9767-test9:002",
+	"c9c5648a02c229f74fb0a9082cec5e21ce9e251baa7db081dde2de954ab03414411c6803bf651c9b8985095237ac375d826987c0fe1fba148306e3e6e727cd03",
+
+	"4b5147959b1c6efcc143719aab9f66d2052912863aa85dd224213c27f4439e5f",
+	"10cdcbc2045248dc239ac65cb9fe4809ed15cccd121ed5c43dfdf5380e252304",
+	"d4974a82c5c4077da571db92b23968e2a0b6234faaf33a4d2ebf450a532d7c6a",
+	"dbcd4f9d23768dd870ba5562423a107f45431a469fdae4042912216b023bba09",
+	"curve9767-test9:003",
+	"603f3e044c84778685ea0902f54885faab52c7a6228ffbb0de223ec3a13eaf100af7e5553eea24eee47ef908e4f2f58b8b812a5494bea352f274e6ec33b3c70a",
+
+	NULL
+};
+
+#else
+
 static const char *const KAT_SIGN[] = {
 	/*
 	 * Signature tests.
@@ -3901,6 +4286,8 @@ static const char *const KAT_SIGN[] = {
 	NULL
 };
 
+#endif
+
 static void
 test_signature(void)
 {
@@ -3964,31 +4351,1602 @@ test_signature(void)
 	fflush(stdout);
 }
 
-static const char *const KAT_MONTE_CARLO[] = {
+static void
+test_mul_bits(void)
+{
+	static const unsigned nbits_list[] = {
+		0, 1, 2, 3, 4, 5, 64, 127, 128, 129, 200,
+		245, 246, 247, 250, 251, 252, 300
+	};
+	shake_context rng;
+	size_t k;
+
+	printf("Test mul_bits: ");
+	fflush(stdout);
+
 	/*
-	 * Point multiplications are performed repeatedly:
-	 *   1. Set Q <- 2*G
-	 *   2. Set cc <- 0
-	 *   3. Do 10000 times:
-	 *      a. Encode Q to 32 bytes.
-	 *      b. Interpret the bytes as integer k (unsigned big-endian).
-	 *      c. Q <- k*Q
-	 *      d. cc <- cc + 1
-	 *      e. if (cc = 0 mod 1000), print Q
+	 * Short-scalar multiplications must match the full ones with
+	 * the truncated scalars. Scalars are random, or all-ones in
+	 * their low bits (maximal truncated value).
 	 */
-	"432eaed885d53b07dcb0503b91aa29385d4737897113d898230f3c6133399540",
-	"c963e1bf4f8e1054d40c2186c7726989d2515c4547d369b9222e0c65d25a2f0b",
-	"5ccbd1764606b79456223b930940b007746e5a2667ae80885e68500b22973404",
-	"4c0efe3318c511c572152cbc91d44dccf92a6fdaa67eb27103f35be10ee8b944",
-	"35140bd45e0928ab535befa65be1207d5f00db6533498d43b306eb1c4755a21a",
-	"e4ddf214e982880f59ce6826563cb83f401d741a68d2739ba14617bc2fd4710d",
-	"1142556f20d438586c5cc18af030bc0930a6a39961ed324754420154ca381d08",
-	"96b85a956ce699871f0f74717f54109f1f9471df71990627163d9784011ec561",
-	"0b50dd948bb8041837d6fbc4dfd406d656b9e1052213ff500ecd0851d1b4e40a",
-	"2acadae9da9c42dc7bdde5f0dbd3c267f07f5823fb2ed7db07c3088652e2210d",
+	rand_init(&rng, "test_mul_bits", 0);
+	for (k = 0; k < (sizeof nbits_list) / sizeof nbits_list[0]; k ++) {
+		int i;
+
+		for (i = 0; i < 4; i ++) {
+			uint8_t tmp[40], bb1[32], bb2[32];
+			curve9767_scalar s0, s1, s2, t1, t2;
+			curve9767_point Q1, Q3;
+			curve9767_mul_context mc;
+			unsigned nbits, u, num_steps;
+
+			nbits = nbits_list[k];
+			shake_extract(&rng, tmp, sizeof tmp);
+			curve9767_scalar_decode_reduce(&s0, tmp, sizeof tmp);
+			curve9767_point_mulgen(&Q1, &s0);
+			if (i == 3) {
+				curve9767_point_set_neutral(&Q1);
+			}
+			shake_extract(&rng, tmp, sizeof tmp);
+			if (i == 2) {
+				memset(tmp, 0, sizeof tmp);
+				for (u = 0; u < nbits && u < 256; u ++) {
+					tmp[u >> 3] |= (uint8_t)(1u << (u & 7));
+				}
+			}
+			curve9767_scalar_decode_reduce(&s1, tmp, sizeof tmp);
+			if (i == 1) {
+				curve9767_scalar_neg(&s1, &curve9767_scalar_one);
+			}
+			shake_extract(&rng, tmp, sizeof tmp);
+			curve9767_scalar_decode_reduce(&s2, tmp, sizeof tmp);
+
+			/*
+			 * t1 and t2 are the truncated scalars.
+			 */
+			curve9767_scalar_encode(tmp, &s1);
+			for (u = nbits; u < 256; u ++) {
+				tmp[u >> 3] &= (uint8_t)~(1u << (u & 7));
+			}
+			curve9767_scalar_decode_reduce(&t1, tmp, 32);
+			curve9767_scalar_encode(tmp, &s2);
+			for (u = nbits; u < 256; u ++) {
+				tmp[u >> 3] &= (uint8_t)~(1u << (u & 7));
+			}
+			curve9767_scalar_decode_reduce(&t2, tmp, 32);
+
+			curve9767_point_mul(&Q3, &Q1, &t1);
+			curve9767_point_encode(bb1, &Q3);
+			curve9767_point_mul_bits(&Q3, &Q1, &s1, nbits);
+			curve9767_point_encode(bb2, &Q3);
+			check_equals(bb1, bb2, sizeof bb1, "mul_bits");
+
+			curve9767_point_mul_mulgen_add(&Q3, &Q1, &t1, &t2);
+			curve9767_point_encode(bb1, &Q3);
+			curve9767_point_mul_mulgen_add_bits(&Q3,
+				&Q1, &s1, &s2, nbits);
+			curve9767_point_encode(bb2, &Q3);
+			check_equals(bb1, bb2, sizeof bb1, "mul_mulgen_add_bits");
+
+			/*
+			 * Step count depends only on nbits.
+			 */
+			curve9767_point_mul_bits_start(&mc, &Q1, &s1, nbits);
+			num_steps = curve9767_point_mul_step(&mc, 0);
+			u = nbits < 252 ? (nbits + 5) >> 2 : 63;
+			if (num_steps != 7 + (u < 63 ? u : 63)) {
+				fprintf(stderr, "mul_bits: wrong step count\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		printf(".");
+		fflush(stdout);
+	}
 
-	NULL
-};
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_stepwise(void)
+{
+	const char *const *st;
+	shake_context rng;
+	int i;
+
+	printf("Test step-wise: ");
+	fflush(stdout);
+
+	/*
+	 * Point multiplications, with various slice sizes; the result
+	 * must match the monolithic functions.
+	 */
+	rand_init(&rng, "test_stepwise", 0);
+	for (i = 0; i < 20; i ++) {
+		uint8_t tmp[40], bb1[32], bb2[32];
+		curve9767_scalar s0, s1, s2;
+		curve9767_point Q1, Q3;
+		curve9767_mul_context mc;
+		unsigned budget, rem, old_rem;
+
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s0, tmp, sizeof tmp);
+		curve9767_point_mulgen(&Q1, &s0);
+		if (i == 0) {
+			curve9767_point_set_neutral(&Q1);
+		}
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s1, tmp, sizeof tmp);
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s2, tmp, sizeof tmp);
+		budget = (unsigned)i + 1;
+
+		curve9767_point_mul(&Q3, &Q1, &s1);
+		curve9767_point_encode(bb1, &Q3);
+		curve9767_point_mul_start(&mc, &Q1, &s1);
+		old_rem = CURVE9767_MUL_STEPS;
+		if (curve9767_point_mul_step(&mc, 0) != old_rem) {
+			fprintf(stderr, "step-wise: wrong initial step count\n");
+			exit(EXIT_FAILURE);
+		}
+		do {
+			rem = curve9767_point_mul_step(&mc, budget);
+			if (rem != (old_rem > budget ? old_rem - budget : 0)) {
+				fprintf(stderr, "step-wise: wrong step count\n");
+				exit(EXIT_FAILURE);
+			}
+			old_rem = rem;
+		} while (rem != 0);
+		curve9767_point_mul_finish(&Q3, &mc);
+		curve9767_point_encode(bb2, &Q3);
+		check_equals(bb1, bb2, sizeof bb1, "step-wise s*Q");
+
+		/*
+		 * For the combined multiplication, we also test calling
+		 * finish() on an incomplete computation.
+		 */
+		curve9767_point_mul_mulgen_add(&Q3, &Q1, &s1, &s2);
+		curve9767_point_encode(bb1, &Q3);
+		curve9767_point_mul_mulgen_add_start(&mc, &Q1, &s1, &s2);
+		curve9767_point_mul_step(&mc, budget);
+		curve9767_point_mul_finish(&Q3, &mc);
+		curve9767_point_encode(bb2, &Q3);
+		check_equals(bb1, bb2, sizeof bb1, "step-wise s1*Q1+s2*G");
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	/*
+	 * Signature verification.
+	 */
+	st = KAT_SIGN;
+	for (i = 0; *st != NULL; i ++) {
+		uint8_t bQ[32], sig[64], hv[32];
+		const char *msg;
+		curve9767_point Q;
+		curve9767_verify_context vc;
+		sha3_context sc;
+		int j;
+
+		st += 3;
+		HEXTOBIN(bQ, *st ++);
+		msg = *st ++;
+		HEXTOBIN(sig, *st ++);
+		curve9767_point_decode(&Q, bQ);
+		sha3_init(&sc, 256);
+		sha3_update(&sc, msg, strlen(msg));
+		sha3_close(&sc, hv);
+
+		for (j = 0; j < 2; j ++) {
+			curve9767_sign_verify_start(&vc, sig, &Q,
+				CURVE9767_OID_SHA3_256, hv, sizeof hv);
+			while (curve9767_sign_verify_step(&vc,
+				(unsigned)i + 1) != 0);
+			if (curve9767_sign_verify_finish(&vc) != (j == 0)) {
+				fprintf(stderr, "step-wise verification"
+					" failed (%d)\n", j);
+				exit(EXIT_FAILURE);
+			}
+			hv[0] ^= 0x01;
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static unsigned vcache_lock_depth;
+
+static void
+vcache_test_lock(void *lock_ctx, unsigned stripe)
+{
+	(void)lock_ctx;
+	if (stripe >= 4 || vcache_lock_depth != 0) {
+		fprintf(stderr, "vcache: invalid lock call\n");
+		exit(EXIT_FAILURE);
+	}
+	vcache_lock_depth ++;
+}
+
+static void
+vcache_test_unlock(void *lock_ctx, unsigned stripe)
+{
+	(void)lock_ctx;
+	if (stripe >= 4 || vcache_lock_depth != 1) {
+		fprintf(stderr, "vcache: invalid unlock call\n");
+		exit(EXIT_FAILURE);
+	}
+	vcache_lock_depth --;
+}
+
+static void
+test_vcache(void)
+{
+	curve9767_vcache_entry mem[8 * 4];
+	curve9767_vcache vc;
+	curve9767_scalar s;
+	curve9767_point Q;
+	uint8_t t[32], sig[9][64], hv[9][32];
+	int i;
+
+	printf("Test verification cache: ");
+	fflush(stdout);
+
+	curve9767_keygen(&s, t, &Q, "vcache", 6);
+	for (i = 0; i < 9; i ++) {
+		hv[i][0] = (uint8_t)i;
+		memset(hv[i] + 1, 0xA5, sizeof hv[i] - 1);
+		curve9767_sign_generate(sig[i], &s, t, &Q,
+			CURVE9767_OID_SHA3_256, hv[i], sizeof hv[i]);
+	}
+
+	/*
+	 * Too small area, or zero TTL: rejected.
+	 */
+	if (curve9767_vcache_init(&vc, mem, 8 * sizeof mem[0] - 1,
+		10, NULL, 0) != 0
+		|| curve9767_vcache_init(&vc, mem, sizeof mem, 0, NULL, 0) != 0)
+	{
+		fprintf(stderr, "vcache: invalid init not rejected\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Basic operations: positive results are cached, until expiry;
+	 * negative results are not cached.
+	 */
+	if (!curve9767_vcache_init(&vc, mem, sizeof mem, 10, "salt", 4)) {
+		fprintf(stderr, "vcache: init failed\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_vcache_set_locking(&vc, 4,
+		&vcache_test_lock, &vcache_test_unlock, NULL);
+	if (curve9767_vcache_lookup(&vc, 100, sig[0], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 0)
+	{
+		fprintf(stderr, "vcache: entry found in empty cache\n");
+		exit(EXIT_FAILURE);
+	}
+	if (curve9767_sign_verify_cached(&vc, 100, sig[0], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 1
+		|| curve9767_vcache_lookup(&vc, 109, sig[0], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 1
+		|| curve9767_sign_verify_cached(&vc, 109, sig[0], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 1
+		|| curve9767_vcache_lookup(&vc, 110, sig[0], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 0)
+	{
+		fprintf(stderr, "vcache: wrong caching of valid signature\n");
+		exit(EXIT_FAILURE);
+	}
+	printf(".");
+	fflush(stdout);
+
+	if (curve9767_sign_verify_cached(&vc, 100, sig[1], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 0
+		|| curve9767_vcache_lookup(&vc, 100, sig[1], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 0
+		|| curve9767_vcache_lookup(&vc, 100, sig[0], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0] - 1) != 0
+		|| curve9767_vcache_lookup(&vc, 100, sig[0], &Q,
+		CURVE9767_OID_SHA3_512, hv[0], sizeof hv[0]) != 0)
+	{
+		fprintf(stderr, "vcache: wrong caching of invalid signature\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_vcache_clear(&vc);
+	if (curve9767_vcache_lookup(&vc, 100, sig[0], &Q,
+		CURVE9767_OID_SHA3_256, hv[0], sizeof hv[0]) != 0)
+	{
+		fprintf(stderr, "vcache: entry found after clear\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Explicit insertion (no verification).
+	 */
+	curve9767_vcache_insert(&vc, 100, sig[1], &Q,
+		CURVE9767_OID_SHA3_256, hv[1], sizeof hv[1]);
+	if (curve9767_vcache_lookup(&vc, 109, sig[1], &Q,
+		CURVE9767_OID_SHA3_256, hv[1], sizeof hv[1]) != 1
+		|| curve9767_vcache_lookup(&vc, 110, sig[1], &Q,
+		CURVE9767_OID_SHA3_256, hv[1], sizeof hv[1]) != 0)
+	{
+		fprintf(stderr, "vcache: wrong explicit insertion\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_vcache_clear(&vc);
+	if (vcache_lock_depth != 0) {
+		fprintf(stderr, "vcache: unbalanced locking\n");
+		exit(EXIT_FAILURE);
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Eviction: with a single bucket (8 entries), inserting nine
+	 * signatures evicts the one with the earliest expiry time.
+	 */
+	curve9767_vcache_init(&vc, mem, 8 * sizeof mem[0], 1000, NULL, 0);
+	for (i = 0; i < 9; i ++) {
+		if (curve9767_sign_verify_cached(&vc, 100 + i, sig[i], &Q,
+			CURVE9767_OID_SHA3_256, hv[i], sizeof hv[i]) != 1)
+		{
+			fprintf(stderr, "vcache: verification failed\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 0; i < 9; i ++) {
+		if (curve9767_vcache_lookup(&vc, 200, sig[i], &Q,
+			CURVE9767_OID_SHA3_256, hv[i], sizeof hv[i]) != (i != 0))
+		{
+			fprintf(stderr, "vcache: wrong eviction (%d)\n", i);
+			exit(EXIT_FAILURE);
+		}
+	}
+	printf(".");
+	fflush(stdout);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static uint64_t
+tune_fake_clock(void *ctx)
+{
+	uint64_t *t;
+
+	t = ctx;
+	return (*t) += *(t + 1);
+}
+
+static void
+test_tune(void)
+{
+	curve9767_tune_config tc, tc0, tc2;
+	uint8_t buf[CURVE9767_TUNE_ENCODED_SIZE], tmp[40];
+	uint64_t clk[2];
+	shake_context rng;
+	int i;
+
+	printf("Test tuning: ");
+	fflush(stdout);
+
+	/*
+	 * Defaults, configuration from costs, export/import.
+	 */
+	curve9767_tune_default(&tc0);
+	curve9767_tune_get(&tc);
+	check_equals(&tc, &tc0, sizeof tc, "tune default");
+	curve9767_tune_from_costs(&tc, 16, 10, 96);
+	if (tc.mul_jacobian != 0) {
+		fprintf(stderr, "tune: wrong accumulator choice (1)\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_tune_from_costs(&tc, 16, 10, 1000);
+	if (tc.mul_jacobian != 7) {
+		fprintf(stderr, "tune: wrong accumulator choice (2)\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_tune_export(buf, &tc);
+	memset(&tc2, 0, sizeof tc2);
+	if (!curve9767_tune_import(&tc2, buf, sizeof buf)
+		|| curve9767_tune_import(&tc2, buf, sizeof buf - 1))
+	{
+		fprintf(stderr, "tune: import failed\n");
+		exit(EXIT_FAILURE);
+	}
+	check_equals(&tc, &tc2, sizeof tc, "tune import");
+	buf[16] = 8;
+	if (curve9767_tune_import(&tc2, buf, sizeof buf)) {
+		fprintf(stderr, "tune: invalid configuration accepted\n");
+		exit(EXIT_FAILURE);
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Measurement, with a fake clock that advances by a fixed
+	 * amount at each call; a clock that does not advance makes
+	 * the measurement fail.
+	 */
+	clk[0] = 0;
+	clk[1] = 1;
+	if (!curve9767_tune_measure(&tc2, tune_fake_clock, clk)
+		|| tc2.cost_mul != 1 || tc2.cost_sqr != 1 || tc2.cost_inv != 8)
+	{
+		fprintf(stderr, "tune: wrong measurement\n");
+		exit(EXIT_FAILURE);
+	}
+	clk[1] = 0;
+	if (curve9767_tune_measure(&tc2, tune_fake_clock, clk)) {
+		fprintf(stderr, "tune: measurement should have failed\n");
+		exit(EXIT_FAILURE);
+	}
+	check_equals(&tc2, &tc0, sizeof tc, "tune measure fallback");
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Complete mixed addition in Jacobian coordinates, including
+	 * the special cases.
+	 */
+	rand_init(&rng, "test_tune", 0);
+	for (i = 0; i < 20; i ++) {
+		curve9767_scalar s;
+		curve9767_point Q1, Q2, Q3;
+		curve9767_jpoint J;
+		uint8_t bb1[32], bb2[32];
+
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+		curve9767_point_mulgen(&Q1, &s);
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+		curve9767_point_mulgen(&Q2, &s);
+		switch (i) {
+		case 1:
+			Q2 = Q1;
+			break;
+		case 2:
+			curve9767_point_neg(&Q2, &Q1);
+			break;
+		case 3:
+			curve9767_point_set_neutral(&Q1);
+			break;
+		case 4:
+			curve9767_point_set_neutral(&Q2);
+			break;
+		case 5:
+			curve9767_point_set_neutral(&Q1);
+			curve9767_point_set_neutral(&Q2);
+			break;
+		}
+
+		/*
+		 * 4*Q1 + 4*Q2, with J = 4*Q1 in Jacobian coordinates.
+		 */
+		curve9767_point_to_jacobian(&J, &Q1);
+		curve9767_inner_jpoint_double(&J);
+		curve9767_inner_jpoint_double(&J);
+		curve9767_point_mul2k(&Q3, &Q2, 2);
+		curve9767_inner_jpoint_add_affine(&J, &Q3);
+		curve9767_jpoint_normalize_batch(&Q3, &J, 1);
+		curve9767_point_mul2k(&Q1, &Q1, 2);
+		curve9767_point_mul2k(&Q2, &Q2, 2);
+		curve9767_point_add(&Q1, &Q1, &Q2);
+		curve9767_point_encode(bb1, &Q1);
+		curve9767_point_encode(bb2, &Q3);
+		check_equals(bb1, bb2, sizeof bb1, "Jacobian add");
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * All point multiplications must return the same results with
+	 * both accumulators.
+	 */
+	for (i = 0; i < 10; i ++) {
+		curve9767_scalar s0, s1, s2;
+		curve9767_point Q1, Q3;
+		uint8_t bb1[3][32], bb2[3][32];
+		int j;
+
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s0, tmp, sizeof tmp);
+		curve9767_point_mulgen(&Q1, &s0);
+		if (i == 0) {
+			curve9767_point_set_neutral(&Q1);
+		}
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s1, tmp, sizeof tmp);
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s2, tmp, sizeof tmp);
+		if (i == 1) {
+			s1 = curve9767_scalar_zero;
+			s2 = curve9767_scalar_one;
+		}
+		for (j = 0; j < 2; j ++) {
+			uint8_t (*bb)[32];
+
+			tc = tc0;
+			tc.mul_jacobian = j ? 7 : 0;
+			curve9767_tune_set(&tc);
+			bb = j ? bb2 : bb1;
+			curve9767_point_mul(&Q3, &Q1, &s1);
+			curve9767_point_encode(bb[0], &Q3);
+			curve9767_point_mul_mulgen_add(&Q3, &Q1, &s1, &s2);
+			curve9767_point_encode(bb[1], &Q3);
+			curve9767_point_mulgen(&Q3, &s2);
+			curve9767_point_encode(bb[2], &Q3);
+		}
+		check_equals(bb1, bb2, sizeof bb1, "tune accumulators");
+	}
+	curve9767_tune_set(&tc0);
+
+	printf(". done.\n");
+	fflush(stdout);
+}
+
+static void
+test_precomp(void)
+{
+	static uint32_t mem[(CURVE9767_PRECOMP_SIZE >> 2) + 1];
+	const char *const *st;
+	uint8_t *buf;
+	shake_context rng;
+	curve9767_precomp pc, pc2;
+	curve9767_point Q, Q2;
+	const curve9767_precomp *lpc;
+	curve9767_tune_config tc;
+	int i;
+
+	printf("Test precomp: ");
+	fflush(stdout);
+
+	if (sizeof(curve9767_precomp) != CURVE9767_PRECOMP_SIZE) {
+		fprintf(stderr, "precomp: wrong structure size\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Signatures with precomputed keys must match the KAT; the
+	 * object is used in place, after a copy into a raw buffer.
+	 */
+	buf = (uint8_t *)mem;
+	st = KAT_SIGN;
+	for (;;) {
+		uint8_t seed[32], bs[32], t[32], bQ[32], sig[64];
+		uint8_t tmp[64], hv[32];
+		const char *msg;
+		curve9767_scalar s;
+		sha3_context sc;
+
+		if (*st == NULL) {
+			break;
+		}
+		HEXTOBIN(seed, *st ++);
+		HEXTOBIN(bs, *st ++);
+		HEXTOBIN(t, *st ++);
+		HEXTOBIN(bQ, *st ++);
+		msg = *st ++;
+		HEXTOBIN(sig, *st ++);
+
+		curve9767_keygen(&s, t, &Q, seed, sizeof seed);
+		if (!curve9767_precomp_init(&pc, &Q, &s, t)) {
+			fprintf(stderr, "precomp init failed\n");
+			exit(EXIT_FAILURE);
+		}
+		memcpy(buf, &pc, sizeof pc);
+		lpc = curve9767_precomp_load(buf, sizeof pc);
+		if (lpc != (const curve9767_precomp *)(void *)buf) {
+			fprintf(stderr, "precomp load failed\n");
+			exit(EXIT_FAILURE);
+		}
+		check_equals(lpc->encoded_Q, bQ, sizeof bQ, "precomp pubkey");
+		check_equals(lpc->encoded_s, bs, sizeof bs, "precomp secret");
+
+		sha3_init(&sc, 256);
+		sha3_update(&sc, msg, strlen(msg));
+		sha3_close(&sc, hv);
+		if (!curve9767_sign_generate_precomp(tmp, lpc,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv))
+		{
+			fprintf(stderr, "precomp sign failed\n");
+			exit(EXIT_FAILURE);
+		}
+		check_equals(tmp, sig, sizeof sig, "sign (precomp)");
+		if (curve9767_sign_verify_precomp(sig, lpc,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 1)
+		{
+			fprintf(stderr, "Signature verification failed\n");
+			exit(EXIT_FAILURE);
+		}
+		hv[0] ^= 0x01;
+		if (curve9767_sign_verify_precomp(sig, lpc,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 0)
+		{
+			fprintf(stderr, "Bad signature not rejected\n");
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * A public-only object cannot sign.
+		 */
+		curve9767_precomp_init(&pc, &Q, NULL, NULL);
+		if (curve9767_sign_generate_precomp(tmp, &pc,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 0)
+		{
+			fprintf(stderr, "precomp sign without secret\n");
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * The object must not depend on how the point was
+		 * obtained (keygen or decoding), nor on the contents of
+		 * its padding slots.
+		 */
+		curve9767_point_encode(tmp, &Q);
+		if (!curve9767_point_decode(&Q2, tmp)) {
+			fprintf(stderr, "precomp: decode failed\n");
+			exit(EXIT_FAILURE);
+		}
+		Q2.dummy1 = 0xA5A5;
+		Q2.dummy2 = 0x5A5A;
+		curve9767_precomp_init(&pc2, &Q2, NULL, NULL);
+		check_equals(&pc, &pc2, sizeof pc, "precomp determinism");
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	/*
+	 * Multiplications and ECDH must match the generic functions,
+	 * with both accumulators.
+	 */
+	curve9767_tune_get(&tc);
+	rand_init(&rng, "test_precomp", 0);
+	for (i = 0; i < 20; i ++) {
+		uint8_t tmp[40], bb1[32], bb2[32];
+		curve9767_scalar s0, s1, s2;
+		curve9767_point Q3;
+		curve9767_tune_config tc2;
+
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s0, tmp, sizeof tmp);
+		curve9767_point_mulgen(&Q, &s0);
+		curve9767_precomp_init(&pc, &Q, NULL, NULL);
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s1, tmp, sizeof tmp);
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s2, tmp, sizeof tmp);
+		switch (i) {
+		case 0:
+			s1 = curve9767_scalar_zero;
+			break;
+		case 1:
+			curve9767_scalar_neg(&s1, &curve9767_scalar_one);
+			s2 = s1;
+			break;
+		case 2:
+			curve9767_scalar_neg(&s1, &s2);
+			curve9767_point_mulgen(&Q, &curve9767_scalar_one);
+			curve9767_precomp_init(&pc, &Q, NULL, NULL);
+			break;
+		}
+		tc2 = tc;
+		tc2.mul_jacobian = (i & 1) ? CURVE9767_TUNE_JAC_MULGEN : 0;
+		curve9767_tune_set(&tc2);
+
+		curve9767_point_mul(&Q3, &Q, &s1);
+		curve9767_point_encode(bb1, &Q3);
+		curve9767_point_mul_precomp(&Q3, &pc, &s1);
+		curve9767_point_encode(bb2, &Q3);
+		check_equals(bb1, bb2, sizeof bb1, "mul_precomp");
+
+		curve9767_point_mul_mulgen_add(&Q3, &Q, &s1, &s2);
+		curve9767_point_encode(bb1, &Q3);
+		curve9767_point_mul_precomp_mulgen_add(&Q3, &pc, &s1, &s2);
+		curve9767_point_encode(bb2, &Q3);
+		check_equals(bb1, bb2, sizeof bb1, "mul_precomp_mulgen_add");
+
+		curve9767_ecdh_recv(bb1, sizeof bb1, &s2, pc.encoded_Q);
+		curve9767_ecdh_recv_precomp(bb2, sizeof bb2, &s2, &pc);
+		check_equals(bb1, bb2, sizeof bb1, "ecdh_recv_precomp");
+	}
+	curve9767_tune_set(&tc);
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Rejection of invalid objects: neutral point, misaligned or
+	 * short source, wrong version, corrupted window.
+	 */
+	curve9767_point_set_neutral(&Q);
+	if (curve9767_precomp_init(&pc, &Q, NULL, NULL) != 0) {
+		fprintf(stderr, "precomp of neutral not rejected\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_point_mulgen(&Q, &curve9767_scalar_one);
+	curve9767_precomp_init(&pc, &Q, NULL, NULL);
+	memcpy(buf, &pc, sizeof pc);
+	if (curve9767_precomp_load(buf, sizeof pc) == NULL
+		|| curve9767_precomp_load(buf, sizeof pc - 1) != NULL)
+	{
+		fprintf(stderr, "precomp load (length)\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(buf + 1, &pc, sizeof pc);
+	if (curve9767_precomp_load(buf + 1, sizeof pc) != NULL) {
+		fprintf(stderr, "precomp load (alignment)\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(buf, &pc, sizeof pc);
+	((curve9767_precomp *)(void *)buf)->version ++;
+	if (curve9767_precomp_load(buf, sizeof pc) != NULL) {
+		fprintf(stderr, "precomp load (version)\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(buf, &pc, sizeof pc);
+	buf[sizeof pc - 100] ^= 0x04;
+	if (curve9767_precomp_load(buf, sizeof pc) != NULL) {
+		fprintf(stderr, "precomp load (tag)\n");
+		exit(EXIT_FAILURE);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_merkle(void)
+{
+	static const size_t nn[] = { 1, 2, 3, 5, 8, 13, 100 };
+	static uint8_t tree[64 * 100 + 32 * 8];
+	uint8_t hv[100][32], sig[64], proof[CURVE9767_MERKLE_PROOF_MAX];
+	curve9767_vcache_entry mem[8 * 4];
+	curve9767_vcache vc;
+	curve9767_scalar s;
+	curve9767_point Q;
+	uint8_t t[32];
+	size_t k, u;
+
+	printf("Test Merkle: ");
+	fflush(stdout);
+
+	curve9767_keygen(&s, t, &Q, "merkle", 6);
+	for (u = 0; u < 100; u ++) {
+		memset(hv[u], 0x3C, sizeof hv[u]);
+		hv[u][0] = (uint8_t)u;
+	}
+	if (curve9767_merkle_tree_size(0) != 0
+		|| curve9767_merkle_sign(sig, tree, &s, t, &Q,
+			CURVE9767_OID_SHA3_256, hv, 32, 0) != 0)
+	{
+		fprintf(stderr, "Merkle: empty batch accepted\n");
+		exit(EXIT_FAILURE);
+	}
+	curve9767_vcache_init(&vc, mem, sizeof mem, 10, "salt", 4);
+
+	for (k = 0; k < (sizeof nn) / sizeof nn[0]; k ++) {
+		size_t n;
+
+		n = nn[k];
+		if (curve9767_merkle_tree_size(n) > sizeof tree
+			|| !curve9767_merkle_sign(sig, tree, &s, t, &Q,
+				CURVE9767_OID_SHA3_256, hv, 32, n))
+		{
+			fprintf(stderr, "Merkle: signing failed\n");
+			exit(EXIT_FAILURE);
+		}
+		if (curve9767_sign_verify(sig, &Q,
+			CURVE9767_OID_SHA3_256, tree, 32))
+		{
+			fprintf(stderr, "Merkle: root signature accepted"
+				" as a plain signature\n");
+			exit(EXIT_FAILURE);
+		}
+		for (u = 0; u < n; u ++) {
+			size_t len;
+
+			len = curve9767_merkle_proof(proof, sig, tree, n, u);
+			if (len < 72 || len > sizeof proof
+				|| !curve9767_merkle_verify(&vc, 100,
+					proof, len, &Q, CURVE9767_OID_SHA3_256,
+					hv[u], 32))
+			{
+				fprintf(stderr, "Merkle: valid proof"
+					" rejected (n=%lu, i=%lu)\n",
+					(unsigned long)n, (unsigned long)u);
+				exit(EXIT_FAILURE);
+			}
+
+			/*
+			 * Wrong message, truncated or extended proof,
+			 * other hash function: rejected (also with no
+			 * cache for the first messages).
+			 */
+			if (curve9767_merkle_verify(u < 2 ? NULL : &vc, 100,
+				proof, len, &Q, CURVE9767_OID_SHA3_256,
+				hv[(u + 1) % 100], 32)
+				|| curve9767_merkle_verify(&vc, 100,
+				proof, len - 1, &Q, CURVE9767_OID_SHA3_256,
+				hv[u], 32)
+				|| curve9767_merkle_verify(&vc, 100,
+				proof, len + 1, &Q, CURVE9767_OID_SHA3_256,
+				hv[u], 32)
+				|| curve9767_merkle_verify(&vc, 100,
+				proof, len, &Q, CURVE9767_OID_SHA3_512,
+				hv[u], 32))
+			{
+				fprintf(stderr, "Merkle: invalid proof"
+					" accepted (n=%lu, i=%lu)\n",
+					(unsigned long)n, (unsigned long)u);
+				exit(EXIT_FAILURE);
+			}
+		}
+		if (curve9767_merkle_proof(proof, sig, tree, n, n) != 0) {
+			fprintf(stderr, "Merkle: out of range index\n");
+			exit(EXIT_FAILURE);
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_jacobian(void)
+{
+	static const size_t nn[] = { 0, 1, 2, 15, 16, 17, 40 };
+	curve9767_point pts[40], Q[40];
+	curve9767_jpoint jp[40];
+	uint8_t bb1[40 * 32], bb2[40 * 32];
+	shake_context rng;
+	size_t u, k;
+
+	printf("Test Jacobian: ");
+	fflush(stdout);
+
+	/*
+	 * Random points, converted to Jacobian coordinates with a random
+	 * Z. Some points are neutral (with arbitrary coordinates).
+	 */
+	rand_init(&rng, "test_jacobian", 0);
+	for (u = 0; u < 40; u ++) {
+		uint8_t tmp[48];
+		curve9767_scalar s;
+		field_element l, l2;
+
+		shake_extract(&rng, tmp, 40);
+		curve9767_scalar_decode_reduce(&s, tmp, 40);
+		curve9767_point_mulgen(&pts[u], &s);
+		curve9767_point_to_jacobian(&jp[u], &pts[u]);
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_inner_gf_map_to_base(l.v, tmp);
+		curve9767_inner_gf_sqr(l2.v, l.v);
+		curve9767_inner_gf_mul(jp[u].x, jp[u].x, l2.v);
+		curve9767_inner_gf_mul(l2.v, l2.v, l.v);
+		curve9767_inner_gf_mul(jp[u].y, jp[u].y, l2.v);
+		curve9767_inner_gf_mul(jp[u].z, jp[u].z, l.v);
+		if (u % 7 == 3) {
+			curve9767_point_set_neutral(&pts[u]);
+			jp[u].neutral = 1;
+			if (u == 10) {
+				memset(jp[u].z, 0, sizeof jp[u].z);
+			}
+		}
+		curve9767_point_encode(bb1 + (u << 5), &pts[u]);
+	}
+
+	for (k = 0; k < (sizeof nn) / sizeof nn[0]; k ++) {
+		size_t n;
+		int r;
+
+		n = nn[k];
+		curve9767_jpoint_normalize_batch(Q, jp, n);
+		for (u = 0; u < n; u ++) {
+			curve9767_point_encode(bb2 + (u << 5), &Q[u]);
+		}
+		check_equals(bb1, bb2, n << 5, "Jacobian normalize");
+
+		memset(bb2, 0, sizeof bb2);
+		r = curve9767_jpoint_encode_batch(bb2, jp, n);
+		check_equals(bb1, bb2, n << 5, "Jacobian encode");
+		if (r != (n <= 3)) {
+			fprintf(stderr, "Jacobian encode: wrong status\n");
+			exit(EXIT_FAILURE);
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	/*
+	 * Incomplete additions on distinct points (some neutral) must
+	 * match the complete additions.
+	 */
+	for (u = 0; u + 1 < 40; u ++) {
+		curve9767_point P1, P2;
+		curve9767_jpoint J1, J2;
+
+		curve9767_point_add(&P1, &pts[u], &pts[u + 1]);
+		curve9767_inner_point_add_distinct(&P2, &pts[u], &pts[u + 1]);
+		curve9767_point_encode(bb1, &P1);
+		curve9767_point_encode(bb2, &P2);
+		check_equals(bb1, bb2, 32, "point add distinct");
+
+		J1 = jp[u];
+		J2 = jp[u];
+		curve9767_inner_jpoint_add_affine(&J1, &pts[u + 1]);
+		curve9767_inner_jpoint_add_affine_distinct(&J2, &pts[u + 1]);
+		curve9767_jpoint_normalize_batch(&P1, &J1, 1);
+		curve9767_jpoint_normalize_batch(&P2, &J2, 1);
+		curve9767_point_encode(bb1, &P1);
+		curve9767_point_encode(bb2, &P2);
+		check_equals(bb1, bb2, 32, "Jacobian add distinct");
+	}
+	printf(".");
+	fflush(stdout);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static void
+test_msm(void)
+{
+	static curve9767_point pts[200];
+	static uint8_t sc[200 * 32];
+	static uint32_t scratch[100000];
+	static const size_t nn[] = { 0, 1, 2, 3, 10, 50, 200 };
+	shake_context rng;
+	size_t u, k;
+
+	printf("Test MSM: ");
+	fflush(stdout);
+
+	/*
+	 * Random points and scalars, with some special cases: the
+	 * neutral, duplicate points, opposite points, zero and small
+	 * scalars, and scalar n-1.
+	 */
+	rand_init(&rng, "test_msm", 0);
+	for (u = 0; u < 200; u ++) {
+		uint8_t tmp[40];
+		curve9767_scalar s;
+
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+		curve9767_point_mulgen(&pts[u], &s);
+		shake_extract(&rng, tmp, sizeof tmp);
+		curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+		switch (u % 23) {
+		case 3:
+			curve9767_point_set_neutral(&pts[u]);
+			break;
+		case 5:
+			pts[u] = pts[u - 1];
+			break;
+		case 7:
+			curve9767_point_neg(&pts[u], &pts[u - 1]);
+			break;
+		case 11:
+			memset(tmp, 0, sizeof tmp);
+			curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+			break;
+		case 13:
+			memset(tmp, 0, sizeof tmp);
+			tmp[0] = (uint8_t)u;
+			curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+			break;
+		case 17:
+			memset(tmp, 0, sizeof tmp);
+			tmp[0] = 1;
+			curve9767_scalar_decode_reduce(&s, tmp, sizeof tmp);
+			curve9767_scalar_neg(&s, &s);
+			break;
+		}
+		curve9767_scalar_encode(sc + (u << 5), &s);
+	}
+
+	for (k = 0; k < (sizeof nn) / sizeof nn[0]; k ++) {
+		curve9767_point Q, Qr;
+		uint8_t bb1[32], bb2[32];
+		unsigned c;
+		size_t n;
+
+		/*
+		 * Reference: sum of individual point multiplications.
+		 */
+		n = nn[k];
+		curve9767_point_set_neutral(&Qr);
+		for (u = 0; u < n; u ++) {
+			curve9767_scalar s;
+
+			curve9767_scalar_decode_strict(&s, sc + (u << 5), 32);
+			curve9767_point_mul(&Q, &pts[u], &s);
+			curve9767_point_add(&Qr, &Qr, &Q);
+		}
+		curve9767_point_encode(bb1, &Qr);
+
+		if (!curve9767_msm(&Q, pts, sc, n, scratch, sizeof scratch)) {
+			fprintf(stderr, "MSM failed\n");
+			exit(EXIT_FAILURE);
+		}
+		curve9767_point_encode(bb2, &Q);
+		check_equals(bb1, bb2, sizeof bb1, "MSM");
+
+		/*
+		 * Explicit window sizes, with windows processed in
+		 * reverse order.
+		 */
+		for (c = 2; c <= 12; c += 5) {
+			curve9767_msm_context mc;
+			unsigned w;
+
+			if (!curve9767_msm_init(&mc, pts, sc, n, c)) {
+				fprintf(stderr, "MSM init failed\n");
+				exit(EXIT_FAILURE);
+			}
+			for (w = mc.num_windows; w -- > 0;) {
+				curve9767_msm_window(&mc, w, scratch);
+			}
+			curve9767_msm_merge(&Q, &mc);
+			curve9767_point_encode(bb2, &Q);
+			check_equals(bb1, bb2, sizeof bb1, "MSM (window)");
+		}
+
+		printf(".");
+		fflush(stdout);
+	}
+
+	if (curve9767_msm(&pts[0], pts, sc, 10, scratch,
+		curve9767_msm_scratch_size(2) - 1))
+	{
+		fprintf(stderr, "MSM: scratch too small not detected\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Streaming accumulator: finalization after 100 pairs, then
+	 * again (unchanged) and after 100 more pairs; reset.
+	 */
+	for (k = 2; k <= 7; k += 5) {
+		curve9767_msm_accumulator acc;
+		curve9767_point Q;
+		uint8_t bb1[32], bb2[32];
+		size_t len;
+		int i;
+
+		len = curve9767_msm_accumulator_size((unsigned)k);
+		if (len == 0 || len > sizeof scratch
+			|| curve9767_msm_accumulator_init(&acc, (unsigned)k,
+				scratch, len - 1)
+			|| !curve9767_msm_accumulator_init(&acc, (unsigned)k,
+				scratch, len))
+		{
+			fprintf(stderr, "MSM accumulator init failed\n");
+			exit(EXIT_FAILURE);
+		}
+		curve9767_msm_accumulator_add(&acc, &pts[0], sc);
+		curve9767_msm_accumulator_reset(&acc);
+		u = 0;
+		for (i = 0; i < 3; i ++) {
+			size_t n;
+
+			n = (i < 2) ? 100 : 200;
+			for (; u < n; u ++) {
+				curve9767_msm_accumulator_add(&acc,
+					&pts[u], sc + (u << 5));
+			}
+			curve9767_msm(&Q, pts, sc, n, scratch + (len >> 2),
+				sizeof scratch - len);
+			curve9767_point_encode(bb1, &Q);
+			curve9767_msm_accumulator_finalize(&Q, &acc);
+			curve9767_point_encode(bb2, &Q);
+			check_equals(bb1, bb2, sizeof bb1, "MSM accumulator");
+			if (acc.count != n) {
+				fprintf(stderr, "MSM accumulator: wrong count\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		curve9767_msm_accumulator_reset(&acc);
+		curve9767_msm_accumulator_finalize(&Q, &acc);
+		if (!Q.neutral || acc.count != 0) {
+			fprintf(stderr, "MSM accumulator: reset failed\n");
+			exit(EXIT_FAILURE);
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	if (curve9767_msm_accumulator_size(1) != 0
+		|| curve9767_msm_accumulator_size(
+			CURVE9767_MSM_MAX_BITS + 1) != 0)
+	{
+		fprintf(stderr, "MSM accumulator: bad window size accepted\n");
+		exit(EXIT_FAILURE);
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+static const char *const KAT_MONTE_CARLO[] = {
+	/*
+	 * Point multiplications are performed repeatedly:
+	 *   1. Set Q <- 2*G
+	 *   2. Set cc <- 0
+	 *   3. Do 10000 times:
+	 *      a. Encode Q to 32 bytes.
+	 *      b. Interpret the bytes as integer k (unsigned big-endian).
+	 *      c. Q <- k*Q
+	 *      d. cc <- cc + 1
+	 *      e. if (cc = 0 mod 1000), print Q
+	 */
+	"432eaed885d53b07dcb0503b91aa29385d4737897113d898230f3c6133399540",
+	"c963e1bf4f8e1054d40c2186c7726989d2515c4547d369b9222e0c65d25a2f0b",
+	"5ccbd1764606b79456223b930940b007746e5a2667ae80885e68500b22973404",
+	"4c0efe3318c511c572152cbc91d44dccf92a6fdaa67eb27103f35be10ee8b944",
+	"35140bd45e0928ab535befa65be1207d5f00db6533498d43b306eb1c4755a21a",
+	"e4ddf214e982880f59ce6826563cb83f401d741a68d2739ba14617bc2fd4710d",
+	"1142556f20d438586c5cc18af030bc0930a6a39961ed324754420154ca381d08",
+	"96b85a956ce699871f0f74717f54109f1f9471df71990627163d9784011ec561",
+	"0b50dd948bb8041837d6fbc4dfd406d656b9e1052213ff500ecd0851d1b4e40a",
+	"2acadae9da9c42dc7bdde5f0dbd3c267f07f5823fb2ed7db07c3088652e2210d",
+
+	NULL
+};
+
+/*
+ * Record layout for test_verify_strided(): 5-byte header, signature,
+ * public key, length byte, hashed message (up to 64 bytes).
+ */
+#define REC_NUM      37
+#define REC_STRIDE   (5 + 64 + 32 + 1 + 64)
+
+static void
+test_verify_strided(void)
+{
+	static uint8_t recs[REC_NUM * REC_STRIDE];
+	static uint32_t work[(400 * CURVE9767_VERIFY_BATCH_RECORD_SIZE) >> 2];
+	uint8_t res1[(REC_NUM + 7) >> 3], res2[(REC_NUM + 7) >> 3];
+	curve9767_record_layout rl;
+	shake_context rng;
+	int i, all, r;
+
+	printf("Test strided verification: ");
+	fflush(stdout);
+
+	rl.stride = REC_STRIDE;
+	rl.sig_off = 5;
+	rl.Q_off = 5 + 64;
+	rl.hv_len_off = 5 + 64 + 32;
+	rl.hv_off = 5 + 64 + 32 + 1;
+	rl.hv_len = 0;
+
+	/*
+	 * Build records; some are invalid in various ways.
+	 */
+	rand_init(&rng, "test_verify_strided", 0);
+	memset(res1, 0, sizeof res1);
+	all = 1;
+	for (i = 0; i < REC_NUM; i ++) {
+		uint8_t seed[32], t[32];
+		uint8_t *rec, *sig, *bQ, *hv;
+		curve9767_scalar s, s2;
+		curve9767_point Q;
+		size_t hv_len;
+		int ok;
+
+		rec = recs + i * REC_STRIDE;
+		sig = rec + rl.sig_off;
+		bQ = rec + rl.Q_off;
+		hv = rec + rl.hv_off;
+		shake_extract(&rng, rec, REC_STRIDE);
+		hv_len = 16 + (rec[rl.hv_len_off] % 49);
+		rec[rl.hv_len_off] = (uint8_t)hv_len;
+		shake_extract(&rng, seed, sizeof seed);
+		curve9767_keygen(&s, t, &Q, seed, sizeof seed);
+		curve9767_point_encode(bQ, &Q);
+		curve9767_sign_generate(sig, &s, t, &Q,
+			CURVE9767_OID_SHA3_256, hv, hv_len);
+		switch (i % 9) {
+		case 2:
+			hv[0] ^= 0x01;
+			break;
+		case 4:
+			sig[1] ^= 0x10;
+			break;
+		case 5:
+			memset(sig + 32, 0xFF, 32);
+			break;
+		case 7:
+			bQ[3] ^= 0x40;
+			break;
+		case 8:
+			/*
+			 * Valid signature with an encoded point-at-infinity
+			 * as first half (d = e*s).
+			 */
+			memset(sig, 0xFF, 31);
+			sig[31] = 0x7F;
+			curve9767_inner_sign_challenge(&s2, sig, bQ,
+				CURVE9767_OID_SHA3_256, hv, hv_len);
+			curve9767_scalar_mul(&s2, &s2, &s);
+			curve9767_scalar_encode(sig + 32, &s2);
+			break;
+		}
+
+		/*
+		 * Expected result, with the individual verification.
+		 */
+		ok = curve9767_point_decode(&Q, bQ) && curve9767_sign_verify(
+			sig, &Q, CURVE9767_OID_SHA3_256, hv, hv_len);
+		if (i % 9 == 8 && !ok) {
+			fprintf(stderr, "strided: neutral first half\n");
+			exit(EXIT_FAILURE);
+		}
+		res1[i >> 3] |= (uint8_t)(ok << (i & 7));
+		all &= ok;
+	}
+	if (all) {
+		fprintf(stderr, "strided: no invalid record\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Large work area (one chunk), small work area (several chunks),
+	 * and too small work area (individual verification); all valid
+	 * records only; no bitmap.
+	 */
+	r = curve9767_sign_verify_strided(res2, recs, REC_NUM, &rl,
+		CURVE9767_OID_SHA3_256, work, sizeof work);
+	check_equals(res1, res2, sizeof res1, "strided (one chunk)");
+	if (r != 0) {
+		fprintf(stderr, "strided: wrong global result\n");
+		exit(EXIT_FAILURE);
+	}
+	printf(".");
+	fflush(stdout);
+	r = curve9767_sign_verify_strided(res2, recs, REC_NUM, &rl,
+		CURVE9767_OID_SHA3_256,
+		work, 24 * CURVE9767_VERIFY_BATCH_RECORD_SIZE);
+	check_equals(res1, res2, sizeof res1, "strided (chunks)");
+	printf(".");
+	fflush(stdout);
+	r = curve9767_sign_verify_strided(res2, recs, REC_NUM, &rl,
+		CURVE9767_OID_SHA3_256, work, 64);
+	check_equals(res1, res2, sizeof res1, "strided (individual)");
+	printf(".");
+	fflush(stdout);
+	for (i = 0; i < REC_NUM; i ++) {
+		if (((res1[i >> 3] >> (i & 7)) & 1) == 0) {
+			break;
+		}
+	}
+	r = curve9767_sign_verify_strided(res2, recs, (size_t)i, &rl,
+		CURVE9767_OID_SHA3_256, work, sizeof work);
+	if (r != 1 || curve9767_sign_verify_strided(NULL, recs, REC_NUM, &rl,
+		CURVE9767_OID_SHA3_256, work, sizeof work) != 0)
+	{
+		fprintf(stderr, "strided: wrong global result\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Fixed-length messages: all valid records use 32-byte hashed
+	 * messages.
+	 */
+	for (i = 0; i < REC_NUM; i ++) {
+		uint8_t seed[32], t[32];
+		uint8_t *rec;
+		curve9767_scalar s;
+		curve9767_point Q;
+
+		rec = recs + i * REC_STRIDE;
+		shake_extract(&rng, seed, sizeof seed);
+		curve9767_keygen(&s, t, &Q, seed, sizeof seed);
+		curve9767_point_encode(rec + rl.Q_off, &Q);
+		curve9767_sign_generate(rec + rl.sig_off, &s, t, &Q,
+			CURVE9767_OID_SHA3_256, rec + rl.hv_off, 32);
+	}
+	rl.hv_len_off = CURVE9767_RECORD_FIXED_LEN;
+	rl.hv_len = 32;
+	r = curve9767_sign_verify_strided(res2, recs, REC_NUM, &rl,
+		CURVE9767_OID_SHA3_256, work, sizeof work);
+	if (r != 1 || res2[0] != 0xFF || res2[4] != 0x1F) {
+		fprintf(stderr, "strided: fixed-length messages\n");
+		exit(EXIT_FAILURE);
+	}
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+#define FROST_NUM     5
+#define FROST_T       3
+#define FROST_POOL    3
+
+static void
+test_frost(void)
+{
+	static uint32_t work[(16384 + FROST_T * 3 * 128) >> 2];
+	static const unsigned sets[][FROST_T] = {
+		{ 1, 2, 3 }, { 2, 4, 5 }, { 1, 3, 5 }
+	};
+	curve9767_frost_nonce nonces[FROST_NUM][FROST_POOL];
+	curve9767_frost_commitment comm[FROST_NUM][FROST_POOL];
+	curve9767_scalar s, shares[FROST_NUM];
+	curve9767_point Q, Y[FROST_NUM];
+	uint8_t t[32], seed[32], hv[32];
+	shake_context rng;
+	size_t u;
+	int i, j;
+
+	printf("Test FROST: ");
+	fflush(stdout);
+
+	if (curve9767_frost_tmp_size(FROST_T) > sizeof work) {
+		fprintf(stderr, "FROST: work area too small\n");
+		exit(EXIT_FAILURE);
+	}
+	shake_init(&rng, 256);
+	shake_inject(&rng, "frost", 5);
+	shake_flip(&rng);
+	shake_extract(&rng, seed, sizeof seed);
+	curve9767_keygen(&s, t, &Q, seed, sizeof seed);
+	shake_extract(&rng, seed, sizeof seed);
+	if (curve9767_frost_split(shares, &s, FROST_T + 1, FROST_T,
+		seed, sizeof seed))
+	{
+		fprintf(stderr, "FROST: invalid split accepted\n");
+		exit(EXIT_FAILURE);
+	}
+	if (!curve9767_frost_split(shares, &s, FROST_T, FROST_NUM,
+		seed, sizeof seed))
+	{
+		fprintf(stderr, "FROST: split failed\n");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0; i < FROST_NUM; i ++) {
+		curve9767_point_mulgen(&Y[i], &shares[i]);
+		shake_extract(&rng, seed, sizeof seed);
+		if (!curve9767_frost_nonce_generate(nonces[i], comm[i],
+			FROST_POOL, i + 1, &shares[i], seed, sizeof seed))
+		{
+			fprintf(stderr, "FROST: nonce generation failed\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/*
+	 * Each signer set uses the nonces of index u (with and without
+	 * a work area for the MSM), and must produce a valid signature
+	 * for Q.
+	 */
+	for (u = 0; u < FROST_POOL; u ++) {
+		curve9767_frost_session fs;
+		curve9767_frost_commitment sc[FROST_T];
+		curve9767_point Ys[FROST_T];
+		uint8_t zs[FROST_T * 32], sig[64], res[1];
+		void *tmp;
+		size_t tmp_len;
+
+		shake_extract(&rng, hv, sizeof hv);
+		for (j = 0; j < FROST_T; j ++) {
+			sc[j] = comm[sets[u][j] - 1][u];
+			Ys[j] = Y[sets[u][j] - 1];
+		}
+		tmp = u == 1 ? NULL : work;
+		tmp_len = u == 1 ? 0 : sizeof work;
+		if (!curve9767_frost_session_init(&fs, &Q, sc, FROST_T,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv, tmp, tmp_len))
+		{
+			fprintf(stderr, "FROST: session init failed\n");
+			exit(EXIT_FAILURE);
+		}
+		for (j = 0; j < FROST_T; j ++) {
+			unsigned id;
+
+			id = sets[u][j];
+			if (!curve9767_frost_sign_share(zs + (j << 5), &fs, id,
+				&shares[id - 1], &nonces[id - 1][u]))
+			{
+				fprintf(stderr, "FROST: sign share failed\n");
+				exit(EXIT_FAILURE);
+			}
+			if (curve9767_frost_sign_share(zs + (j << 5), &fs, id,
+				&shares[id - 1], &nonces[id - 1][u]))
+			{
+				fprintf(stderr, "FROST: nonce reused\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		if (curve9767_frost_verify_shares(res, &fs, zs, Ys,
+			tmp, tmp_len) != 1 || res[0] != 0x07)
+		{
+			fprintf(stderr, "FROST: valid shares rejected\n");
+			exit(EXIT_FAILURE);
+		}
+		curve9767_frost_aggregate(sig, &fs, zs);
+		if (curve9767_sign_verify(sig, &Q,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv) != 1)
+		{
+			fprintf(stderr, "FROST: signature rejected\n");
+			exit(EXIT_FAILURE);
+		}
+
+		/*
+		 * A corrupted share must be identified.
+		 */
+		zs[32] ^= 0x01;
+		if (curve9767_frost_verify_shares(res, &fs, zs, Ys,
+			tmp, tmp_len) != 0 || res[0] != 0x05
+			|| curve9767_frost_verify_shares(NULL, &fs, zs, Ys,
+			tmp, tmp_len) != 0)
+		{
+			fprintf(stderr, "FROST: bad share not detected\n");
+			exit(EXIT_FAILURE);
+		}
+		printf(".");
+		fflush(stdout);
+	}
+
+	/*
+	 * Invalid sessions: unsorted identifiers, and a nonce whose
+	 * commitment is not the one in the session.
+	 */
+	{
+		curve9767_frost_session fs;
+		curve9767_frost_commitment sc[2];
+		uint8_t z[32];
+
+		sc[0] = comm[1][0];
+		sc[1] = comm[0][0];
+		if (curve9767_frost_session_init(&fs, &Q, sc, 2,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv, NULL, 0))
+		{
+			fprintf(stderr, "FROST: unsorted session accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		sc[0] = comm[0][0];
+		sc[1] = comm[1][1];
+		curve9767_frost_nonce_generate(nonces[0], NULL, 1, 1,
+			&shares[0], "x", 1);
+		if (!curve9767_frost_session_init(&fs, &Q, sc, 2,
+			CURVE9767_OID_SHA3_256, hv, sizeof hv, NULL, 0)
+			|| curve9767_frost_sign_share(z, &fs, 1,
+			&shares[0], &nonces[0][0]))
+		{
+			fprintf(stderr, "FROST: wrong nonce accepted\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	printf(" done.\n");
+	fflush(stdout);
+}
+
+#define GTABLE_NUM   20
+
+static void
+test_gtable(void)
+{
+	static curve9767_gtable gt, gt2;
+	curve9767_scalar s[GTABLE_NUM];
+	curve9767_point Q;
+	curve9767_tune_config tc, tc2;
+	uint8_t ref[GTABLE_NUM][32], bb[32];
+	shake_context rng;
+	int i, j;
+
+	printf("Test gtable: ");
+	fflush(stdout);
+
+	if (sizeof gt != CURVE9767_GTABLE_SIZE) {
+		fprintf(stderr, "gtable: wrong size\n");
+		exit(EXIT_FAILURE);
+	}
+	if (curve9767_gtable_ready()) {
+		fprintf(stderr, "gtable: published before build\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Reference values (built-in windows), including the edge cases
+	 * 0, 1 and -1.
+	 */
+	shake_init(&rng, 256);
+	shake_inject(&rng, "gtable", 6);
+	shake_flip(&rng);
+	for (i = 0; i < GTABLE_NUM; i ++) {
+		uint8_t tmp[48];
+
+		switch (i) {
+		case 0:
+			memset(tmp, 0, sizeof tmp);
+			curve9767_scalar_decode_reduce(&s[i], tmp, sizeof tmp);
+			break;
+		case 1:
+			s[i] = curve9767_scalar_one;
+			break;
+		case 2:
+			curve9767_scalar_neg(&s[i], &curve9767_scalar_one);
+			break;
+		default:
+			shake_extract(&rng, tmp, sizeof tmp);
+			curve9767_scalar_decode_reduce(&s[i], tmp, sizeof tmp);
+			break;
+		}
+		curve9767_point_mul(&Q, &curve9767_generator, &s[i]);
+		curve9767_point_encode(ref[i], &Q);
+		curve9767_point_mulgen(&Q, &s[i]);
+		curve9767_point_encode(bb, &Q);
+		check_equals(bb, ref[i], sizeof bb, "mulgen (built-in)");
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Build the table part by part; it must be published only when
+	 * the last part is done, and a second table must be ignored.
+	 */
+	for (j = 0; j < CURVE9767_GTABLE_PARTS; j ++) {
+		if (curve9767_gtable_ready()) {
+			fprintf(stderr, "gtable: published early\n");
+			exit(EXIT_FAILURE);
+		}
+		if (!curve9767_gtable_build_step(&gt)) {
+			fprintf(stderr, "gtable: build step failed\n");
+			exit(EXIT_FAILURE);
+		}
+		if (curve9767_gtable_build_step(&gt2)) {
+			fprintf(stderr, "gtable: second table accepted\n");
+			exit(EXIT_FAILURE);
+		}
+		if (j == 0) {
+			curve9767_point_mulgen(&Q, &s[3]);
+			curve9767_point_encode(bb, &Q);
+			check_equals(bb, ref[3], sizeof bb, "mulgen (partial)");
+		}
+	}
+	if (!curve9767_gtable_ready() || curve9767_gtable_build_step(&gt)
+		|| !curve9767_gtable_init(&gt))
+	{
+		fprintf(stderr, "gtable: not published\n");
+		exit(EXIT_FAILURE);
+	}
+	printf(".");
+	fflush(stdout);
+
+	/*
+	 * Generator multiplications now use the table, with both
+	 * accumulators.
+	 */
+	curve9767_tune_get(&tc);
+	for (j = 0; j < 2; j ++) {
+		tc2 = tc;
+		tc2.mul_jacobian = j ? CURVE9767_TUNE_JAC_MULGEN : 0;
+		curve9767_tune_set(&tc2);
+		for (i = 0; i < GTABLE_NUM; i ++) {
+			curve9767_point_mulgen(&Q, &s[i]);
+			curve9767_point_encode(bb, &Q);
+			check_equals(bb, ref[i], sizeof bb, "mulgen (gtable)");
+		}
+		printf(".");
+		fflush(stdout);
+	}
+	curve9767_tune_set(&tc);
+
+	printf(" done.\n");
+	fflush(stdout);
+}
 
 static void
 test_monte_carlo(void)
@@ -4033,6 +5991,7 @@ int
 main(void)
 {
 	test_SHAKE();
+	test_TurboSHAKE();
 	test_SHA3();
 	test_gf_add();
 	test_gf_sub();
@@ -4051,6 +6010,17 @@ main(void)
 	test_hash_to_curve();
 	test_ECDH();
 	test_signature();
+	test_mul_bits();
+	test_stepwise();
+	test_vcache();
+	test_merkle();
+	test_jacobian();
+	test_tune();
+	test_precomp();
+	test_msm();
+	test_verify_strided();
+	test_frost();
+	test_gtable();
 	test_monte_carlo();
 	return 0;
 }
@@ -0,0 +1,314 @@
+#include "inner.h"
+
+/*
+ * Algorithm choices are derived from operation counts, with the
+ * relative costs M (multiplication), S (squaring) and I (inversion):
+ *
+ *  - Point multiplication, with k point additions for every four
+ *    doublings (k = 1 for s*Q, 2 for s1*Q+s2*G, 4 for s*G with the
+ *    four precomputed generator windows):
+ *      affine:    multi-doubling 6M+29S+I, k additions 2M+2S+I
+ *      Jacobian:  four doublings 4*(3M+5S), k complete mixed additions
+ *                 (generic formulas and a doubling) 10M+9S
+ *    Relatively to the affine accumulator, the Jacobian accumulator
+ *    saves I+9S-6M on the doublings, and costs 8M+7S-I per addition.
+ *
+ *  - MSM, per bucket: two Jacobian additions (11M+5S each) for the
+ *    running sums; the bucket cost is expressed relatively to a mixed
+ *    addition (7M+4S, which is the cost of adding a point into a
+ *    bucket).
+ *
+ * curve9767_tune_from_costs() applies these formulas. Since they ignore
+ * linear operations and constant-time selections, which are not
+ * negligible on large CPUs, curve9767_tune_measure() makes the
+ * accumulator choices with measurements of the point operations.
+ *
+ * The default configuration uses the costs of the Cortex-M0+
+ * implementation, for which the affine accumulator is better in all
+ * cases; the default MSM bucket cost (3 mixed additions) matches the
+ * fixed cost model used before tuning was introduced.
+ */
+
+curve9767_tune_config curve9767_inner_tune = {
+	16, 10, 96, 0, 48
+};
+
+/* see curve9767.h */
+void
+curve9767_tune_default(curve9767_tune_config *tc)
+{
+	tc->cost_mul = 16;
+	tc->cost_sqr = 10;
+	tc->cost_inv = 96;
+	tc->mul_jacobian = 0;
+	tc->msm_bucket_cost = 48;
+}
+
+/*
+ * Return 1 if the Jacobian accumulator is cheaper than the affine
+ * accumulator, with k additions for every four doublings.
+ */
+static int
+jac_better(uint64_t M, uint64_t S, uint64_t I, unsigned k)
+{
+	return 4 * (3 * M + 5 * S) + k * (10 * M + 9 * S)
+		< (6 * M + 29 * S + I) + k * (2 * M + 2 * S + I);
+}
+
+/* see curve9767.h */
+void
+curve9767_tune_from_costs(curve9767_tune_config *tc,
+	uint32_t cost_mul, uint32_t cost_sqr, uint32_t cost_inv)
+{
+	uint64_t M, S, I, madd, jadd, bc;
+
+	M = cost_mul;
+	S = cost_sqr;
+	I = cost_inv;
+	tc->cost_mul = cost_mul;
+	tc->cost_sqr = cost_sqr;
+	tc->cost_inv = cost_inv;
+	tc->mul_jacobian = 0;
+	if (jac_better(M, S, I, 1)) {
+		tc->mul_jacobian |= CURVE9767_TUNE_JAC_MUL;
+	}
+	if (jac_better(M, S, I, 2)) {
+		tc->mul_jacobian |= CURVE9767_TUNE_JAC_MUL_ADD;
+	}
+	if (jac_better(M, S, I, 4)) {
+		tc->mul_jacobian |= CURVE9767_TUNE_JAC_MULGEN;
+	}
+	madd = 7 * M + 4 * S;
+	jadd = 11 * M + 5 * S;
+	bc = (16 * 2 * jadd + (madd >> 1)) / madd;
+	if (bc < 1) {
+		bc = 1;
+	} else if (bc > 0xFFFF) {
+		bc = 0xFFFF;
+	}
+	tc->msm_bucket_cost = (uint32_t)bc;
+}
+
+/*
+ * Number of operations per measurement, and number of measurements
+ * (the minimum time is used).
+ */
+#define TUNE_NUM_OPS      64
+#define TUNE_NUM_SLOW     8
+#define TUNE_NUM_TRIALS   8
+
+/*
+ * Operations to measure.
+ */
+#define OP_MUL         0
+#define OP_SQR         1
+#define OP_INV         2
+#define OP_AFF_DBL4    3
+#define OP_AFF_ADD     4
+#define OP_JAC_DBL4    5
+#define OP_JAC_ADD     6
+#define OP_AFF_ADDD    7
+#define OP_JAC_ADDD    8
+
+/*
+ * Measure the time of TUNE_NUM_TRIALS runs of num chained operations,
+ * and return the minimum, scaled to TUNE_NUM_OPS operations. OP_AFF_DBL4
+ * and OP_JAC_DBL4 are four point doublings, in affine (multi-doubling)
+ * and Jacobian coordinates; OP_AFF_ADD and OP_JAC_ADD are point
+ * additions, in affine coordinates and as used in the Jacobian
+ * accumulator (complete mixed addition). OP_AFF_ADDD and OP_JAC_ADDD
+ * are the same additions for distinct operands (incomplete).
+ */
+static uint64_t
+measure(int op, unsigned num,
+	uint64_t (*clock_fn)(void *clock_ctx), void *clock_ctx)
+{
+	field_element a, b;
+	curve9767_point Q, T;
+	curve9767_jpoint J;
+	uint64_t best;
+	int t;
+
+	memcpy(a.v, curve9767_generator.x, sizeof curve9767_generator.x);
+	memcpy(b.v, curve9767_generator.y, sizeof curve9767_generator.y);
+	Q = curve9767_generator;
+	curve9767_point_mul2k(&T, &Q, 1);
+	curve9767_point_to_jacobian(&J, &Q);
+	best = (uint64_t)-1;
+	for (t = 0; t < TUNE_NUM_TRIALS; t ++) {
+		uint64_t t0, t1;
+		unsigned u;
+		int k;
+
+		t0 = clock_fn(clock_ctx);
+		for (u = 0; u < num; u ++) {
+			switch (op) {
+			case OP_MUL:
+				curve9767_inner_gf_mul(a.v, a.v, b.v);
+				break;
+			case OP_SQR:
+				curve9767_inner_gf_sqr(a.v, a.v);
+				break;
+			case OP_INV:
+				curve9767_inner_gf_inv(a.v, a.v);
+				break;
+			case OP_AFF_DBL4:
+				curve9767_point_mul2k(&Q, &Q, 4);
+				break;
+			case OP_AFF_ADD:
+				curve9767_point_add(&Q, &Q, &T);
+				break;
+			case OP_JAC_DBL4:
+				for (k = 0; k < 4; k ++) {
+					curve9767_inner_jpoint_double(&J);
+				}
+				break;
+			case OP_AFF_ADDD:
+				curve9767_inner_point_add_distinct(&Q, &Q, &T);
+				break;
+			case OP_JAC_ADDD:
+				curve9767_inner_jpoint_add_affine_distinct(
+					&J, &T);
+				break;
+			default:
+				curve9767_inner_jpoint_add_affine(&J, &T);
+				break;
+			}
+		}
+		t1 = clock_fn(clock_ctx) - t0;
+		if (t1 < best) {
+			best = t1;
+		}
+	}
+	best = best * TUNE_NUM_OPS / num;
+	return best < 0xFFFFFFFF ? best : 0xFFFFFFFF;
+}
+
+/* see curve9767.h */
+int
+curve9767_tune_measure(curve9767_tune_config *tc,
+	uint64_t (*clock_fn)(void *clock_ctx), void *clock_ctx)
+{
+	uint64_t M, S, I, ad, aa, aad, jd, ja, jad;
+	unsigned k;
+
+	/*
+	 * The MSM cost model uses the field operation costs. For point
+	 * multiplications, the model above is only approximate (it
+	 * ignores linear operations and constant-time selections, which
+	 * are not negligible on large CPUs); the actual point operations
+	 * are measured instead.
+	 */
+	M = measure(OP_MUL, TUNE_NUM_OPS, clock_fn, clock_ctx);
+	S = measure(OP_SQR, TUNE_NUM_OPS, clock_fn, clock_ctx);
+	I = measure(OP_INV, TUNE_NUM_SLOW, clock_fn, clock_ctx);
+	ad = measure(OP_AFF_DBL4, TUNE_NUM_SLOW, clock_fn, clock_ctx);
+	aa = measure(OP_AFF_ADD, TUNE_NUM_SLOW, clock_fn, clock_ctx);
+	jd = measure(OP_JAC_DBL4, TUNE_NUM_SLOW, clock_fn, clock_ctx);
+	ja = measure(OP_JAC_ADD, TUNE_NUM_SLOW, clock_fn, clock_ctx);
+	aad = measure(OP_AFF_ADDD, TUNE_NUM_SLOW, clock_fn, clock_ctx);
+	jad = measure(OP_JAC_ADDD, TUNE_NUM_SLOW, clock_fn, clock_ctx);
+	if (M == 0 || S == 0 || I == 0) {
+		curve9767_tune_default(tc);
+		return 0;
+	}
+	curve9767_tune_from_costs(tc, (uint32_t)M, (uint32_t)S, (uint32_t)I);
+	/*
+	 * curve9767_point_mul() (bit 0) uses the incomplete additions
+	 * (operands are provably distinct); the cost model above keeps
+	 * the complete additions, since on ARM the affine incomplete
+	 * addition is the complete one.
+	 */
+	tc->mul_jacobian = 0;
+	if (jd + jad < ad + aad) {
+		tc->mul_jacobian |= CURVE9767_TUNE_JAC_MUL;
+	}
+	for (k = 1; k < 3; k ++) {
+		if (jd + (ja << k) < ad + (aa << k)) {
+			tc->mul_jacobian |= 1u << k;
+		}
+	}
+	return 1;
+}
+
+/* see curve9767.h */
+void
+curve9767_tune_set(const curve9767_tune_config *tc)
+{
+	curve9767_inner_tune = *tc;
+}
+
+/* see curve9767.h */
+void
+curve9767_tune_get(curve9767_tune_config *tc)
+{
+	*tc = curve9767_inner_tune;
+}
+
+static void
+enc32le(uint8_t *buf, uint32_t x)
+{
+	buf[0] = (uint8_t)x;
+	buf[1] = (uint8_t)(x >> 8);
+	buf[2] = (uint8_t)(x >> 16);
+	buf[3] = (uint8_t)(x >> 24);
+}
+
+static uint32_t
+dec32le(const uint8_t *buf)
+{
+	return (uint32_t)buf[0]
+		| ((uint32_t)buf[1] << 8)
+		| ((uint32_t)buf[2] << 16)
+		| ((uint32_t)buf[3] << 24);
+}
+
+/*
+ * Exported format: a 4-byte header "C9T1", then the five configuration
+ * fields, in that order, as 32-bit little-endian integers.
+ */
+static const uint8_t tune_header[] = { 'C', '9', 'T', '1' };
+
+/* see curve9767.h */
+void
+curve9767_tune_export(void *dst, const curve9767_tune_config *tc)
+{
+	uint8_t *buf;
+
+	buf = dst;
+	memcpy(buf, tune_header, sizeof tune_header);
+	enc32le(buf + 4, tc->cost_mul);
+	enc32le(buf + 8, tc->cost_sqr);
+	enc32le(buf + 12, tc->cost_inv);
+	enc32le(buf + 16, tc->mul_jacobian);
+	enc32le(buf + 20, tc->msm_bucket_cost);
+}
+
+/* see curve9767.h */
+int
+curve9767_tune_import(curve9767_tune_config *tc,
+	const void *src, size_t len)
+{
+	const uint8_t *buf;
+	curve9767_tune_config t;
+
+	buf = src;
+	if (len != CURVE9767_TUNE_ENCODED_SIZE
+		|| memcmp(buf, tune_header, sizeof tune_header) != 0)
+	{
+		return 0;
+	}
+	t.cost_mul = dec32le(buf + 4);
+	t.cost_sqr = dec32le(buf + 8);
+	t.cost_inv = dec32le(buf + 12);
+	t.mul_jacobian = dec32le(buf + 16);
+	t.msm_bucket_cost = dec32le(buf + 20);
+	if (t.cost_mul == 0 || t.cost_sqr == 0 || t.cost_inv == 0
+		|| t.mul_jacobian > 7
+		|| t.msm_bucket_cost == 0 || t.msm_bucket_cost > 0xFFFF)
+	{
+		return 0;
+	}
+	*tc = t;
+	return 1;
+}
@@ -0,0 +1,284 @@
+#include "inner.h"
+
+#define DOM_VCACHE        CURVE9767_DOM("vcache:")
+#define DOM_VCACHE_SALT   CURVE9767_DOM("vcache-salt:")
+
+/*
+ * Number of entries per bucket.
+ */
+#define BUCKET_SIZE   8
+
+static uint64_t
+dec64le(const uint8_t *buf)
+{
+	return (uint64_t)buf[0]
+		| ((uint64_t)buf[1] << 8)
+		| ((uint64_t)buf[2] << 16)
+		| ((uint64_t)buf[3] << 24)
+		| ((uint64_t)buf[4] << 32)
+		| ((uint64_t)buf[5] << 40)
+		| ((uint64_t)buf[6] << 48)
+		| ((uint64_t)buf[7] << 56);
+}
+
+/*
+ * Compute the digest of a (signature, public key, hash identifier,
+ * hashed message) tuple. The 128-bit key is written in key[]; the
+ * bucket index is returned.
+ */
+static size_t
+make_key(const curve9767_vcache *vc, uint64_t *key,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	shake_context sc;
+	uint8_t tmp[32];
+
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_VCACHE, strlen(DOM_VCACHE));
+	shake_inject(&sc, vc->salt, sizeof vc->salt);
+	shake_inject(&sc, sig, 64);
+	curve9767_point_encode(tmp, Q);
+	shake_inject(&sc, tmp, 32);
+	shake_inject(&sc, hash_oid, strlen(hash_oid));
+	shake_inject(&sc, ":", 1);
+	shake_inject(&sc, hv, hv_len);
+	shake_flip(&sc);
+	shake_extract(&sc, tmp, 24);
+	key[0] = dec64le(tmp);
+	key[1] = dec64le(tmp + 8);
+
+	/*
+	 * num_buckets is a power of two.
+	 */
+	return (size_t)dec64le(tmp + 16) & (vc->num_buckets - 1);
+}
+
+/*
+ * Stripe locking. Stripes are interleaved over buckets (bucket b is
+ * in stripe b mod num_stripes), so that a small number of stripes
+ * still spreads contention.
+ */
+static void
+bucket_lock(const curve9767_vcache *vc, size_t b)
+{
+	if (vc->lock != NULL) {
+		vc->lock(vc->lock_ctx, (unsigned)b & (vc->num_stripes - 1));
+	}
+}
+
+static void
+bucket_unlock(const curve9767_vcache *vc, size_t b)
+{
+	if (vc->unlock != NULL) {
+		vc->unlock(vc->lock_ctx, (unsigned)b & (vc->num_stripes - 1));
+	}
+}
+
+/* see curve9767.h */
+int
+curve9767_vcache_init(curve9767_vcache *vc, void *mem, size_t mem_len,
+	uint64_t ttl, const void *salt, size_t salt_len)
+{
+	shake_context sc;
+	size_t n;
+
+	n = mem_len / (BUCKET_SIZE * sizeof(curve9767_vcache_entry));
+	if (n == 0 || ttl == 0) {
+		return 0;
+	}
+	while ((n & (n - 1)) != 0) {
+		n &= n - 1;
+	}
+	vc->entries = mem;
+	vc->num_buckets = n;
+	vc->ttl = ttl;
+	curve9767_inner_kdf_init(&sc);
+	shake_inject(&sc, DOM_VCACHE_SALT, strlen(DOM_VCACHE_SALT));
+	shake_inject(&sc, salt, salt_len);
+	shake_flip(&sc);
+	shake_extract(&sc, vc->salt, sizeof vc->salt);
+	vc->num_stripes = 1;
+	vc->lock = NULL;
+	vc->unlock = NULL;
+	vc->lock_ctx = NULL;
+	curve9767_vcache_clear(vc);
+	return 1;
+}
+
+/* see curve9767.h */
+void
+curve9767_vcache_set_locking(curve9767_vcache *vc, unsigned num_stripes,
+	void (*lock)(void *lock_ctx, unsigned stripe),
+	void (*unlock)(void *lock_ctx, unsigned stripe),
+	void *lock_ctx)
+{
+	if (lock == NULL || unlock == NULL || num_stripes == 0) {
+		vc->num_stripes = 1;
+		vc->lock = NULL;
+		vc->unlock = NULL;
+		vc->lock_ctx = NULL;
+		return;
+	}
+	if (num_stripes > vc->num_buckets) {
+		num_stripes = (unsigned)vc->num_buckets;
+	}
+	vc->num_stripes = num_stripes;
+	vc->lock = lock;
+	vc->unlock = unlock;
+	vc->lock_ctx = lock_ctx;
+}
+
+/* see curve9767.h */
+void
+curve9767_vcache_clear(curve9767_vcache *vc)
+{
+	size_t b;
+
+	/*
+	 * An entry with expiry time 0 is free. We clear bucket by
+	 * bucket, with the stripe lock, so that this function can be
+	 * called while the cache is in use.
+	 */
+	for (b = 0; b < vc->num_buckets; b ++) {
+		bucket_lock(vc, b);
+		memset(vc->entries + b * BUCKET_SIZE, 0,
+			BUCKET_SIZE * sizeof(curve9767_vcache_entry));
+		bucket_unlock(vc, b);
+	}
+}
+
+/*
+ * Find the entry for the provided key in bucket b, with the lock held.
+ * Returned value is 1 if a non-expired entry is found, 0 otherwise.
+ */
+static int
+bucket_find(const curve9767_vcache *vc, size_t b,
+	const uint64_t *key, uint64_t now)
+{
+	const curve9767_vcache_entry *e;
+	int i;
+
+	e = vc->entries + b * BUCKET_SIZE;
+	for (i = 0; i < BUCKET_SIZE; i ++) {
+		if (e[i].key[0] == key[0] && e[i].key[1] == key[1]
+			&& e[i].expiry > now)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Insert an entry in bucket b, with the lock held. If the key is
+ * already present, then its expiry time is updated. Otherwise, the
+ * entry with the lowest expiry time (free and expired entries come
+ * first) is replaced.
+ */
+static void
+bucket_insert(curve9767_vcache *vc, size_t b,
+	const uint64_t *key, uint64_t expiry)
+{
+	curve9767_vcache_entry *e;
+	int i, j;
+
+	e = vc->entries + b * BUCKET_SIZE;
+	j = 0;
+	for (i = 0; i < BUCKET_SIZE; i ++) {
+		if (e[i].key[0] == key[0] && e[i].key[1] == key[1]) {
+			if (e[i].expiry < expiry) {
+				e[i].expiry = expiry;
+			}
+			return;
+		}
+		if (e[i].expiry < e[j].expiry) {
+			j = i;
+		}
+	}
+	e[j].key[0] = key[0];
+	e[j].key[1] = key[1];
+	e[j].expiry = expiry;
+}
+
+/*
+ * Record a key (in bucket b) as valid, with expiry time now + ttl
+ * (saturated).
+ */
+static void
+insert_key(curve9767_vcache *vc, size_t b, const uint64_t *key,
+	uint64_t now)
+{
+	uint64_t expiry;
+
+	expiry = now + vc->ttl;
+	if (expiry < now) {
+		expiry = (uint64_t)-1;
+	}
+	bucket_lock(vc, b);
+	bucket_insert(vc, b, key, expiry);
+	bucket_unlock(vc, b);
+}
+
+/* see curve9767.h */
+int
+curve9767_vcache_lookup(curve9767_vcache *vc, uint64_t now,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	uint64_t key[2];
+	size_t b;
+	int r;
+
+	b = make_key(vc, key, sig, Q, hash_oid, hv, hv_len);
+	bucket_lock(vc, b);
+	r = bucket_find(vc, b, key, now);
+	bucket_unlock(vc, b);
+	return r;
+}
+
+/* see curve9767.h */
+int
+curve9767_sign_verify_cached(curve9767_vcache *vc, uint64_t now,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	uint64_t key[2];
+	size_t b;
+	int r;
+
+	if (vc == NULL) {
+		return curve9767_sign_verify(sig, Q, hash_oid, hv, hv_len);
+	}
+	b = make_key(vc, key, sig, Q, hash_oid, hv, hv_len);
+	bucket_lock(vc, b);
+	r = bucket_find(vc, b, key, now);
+	bucket_unlock(vc, b);
+	if (r) {
+		return 1;
+	}
+
+	/*
+	 * Cache miss: the verification is done without holding the
+	 * lock. Two threads may verify the same signature concurrently;
+	 * both then insert it, which is harmless.
+	 */
+	if (!curve9767_sign_verify(sig, Q, hash_oid, hv, hv_len)) {
+		return 0;
+	}
+	insert_key(vc, b, key, now);
+	return 1;
+}
+
+/* see curve9767.h */
+void
+curve9767_vcache_insert(curve9767_vcache *vc, uint64_t now,
+	const void *sig, const curve9767_point *Q,
+	const char *hash_oid, const void *hv, size_t hv_len)
+{
+	uint64_t key[2];
+	size_t b;
+
+	b = make_key(vc, key, sig, Q, hash_oid, hv, hv_len);
+	insert_key(vc, b, key, now);
+}